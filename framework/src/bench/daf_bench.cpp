@@ -0,0 +1,486 @@
+#include "../common/daf_types.h"
+#include "../common/daf_utils.h"
+#include "../common/input_split.h"
+#include "../common/plugin_loader.h"
+#include "../worker/shuffle_buffer.h"
+#include "../worker/shuffle_run.h"
+#include "../worker/task_arena.h"
+#include "../worker/task_context.h"
+#ifdef DAF_BENCH_REDIS
+#include "../storage/redis_client_production.h"
+#endif
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// DAF benchmark suite
+//
+// Micro benchmarks of the map/reduce hot paths and a local multi-worker job,
+// all over one generated input of NeRF samples ("x,y,z,r,g,b,density"
+// lines, the format the NeRF avatar plugin maps). Results come from Google
+// Benchmark, so --benchmark_out=FILE --benchmark_out_format=json writes them
+// machine-readable, and its tools/compare.py diffs two such files.
+//
+// Flags on top of Google Benchmark's:
+//   --records=N         samples in the generated input (default 1000000)
+//   --work_dir=DIR      input, map output runs and job output (default /tmp/daf_bench)
+//   --plugin=PATH       also benchmark MapMain/CombineMain/ReduceMain of this plugin
+//   --redis=HOST:PORT   run the Redis client benchmarks against this server
+
+using namespace daf;
+
+namespace {
+
+constexpr uint32_t BENCH_PARTITIONS = 4;
+constexpr int BENCH_REDIS_KEYS = 1024;   // Keys the Redis benchmarks cycle through
+
+struct BenchConfig {
+    uint64_t records = 1000000;
+    std::string work_dir = "/tmp/daf_bench";
+    std::string plugin_path;
+    std::string redis_host;
+    int redis_port = 6379;
+};
+
+BenchConfig config;
+
+// Map, combine and reduce entry points of one job
+struct JobFunctions {
+    std::string name;
+    MapFunction map;
+    CombineFunction combine;   // May be null
+    ReduceFunction reduce;
+};
+
+// Built-in job, so the suite runs without a plugin: counts samples per cell
+// of a 16^3 grid over [-1, 1]^3
+void DAF_API_CALL cell_count_map(MapContext* context) {
+    static const std::string one = "1";
+    std::string key;
+    std::string_view record;
+    while (context->read_record(record)) {
+        key.assign("cell");
+        for (int axis = 0; axis < 3; ++axis) {
+            size_t comma = std::min(record.find(','), record.size());
+            float coordinate = 0.0f;
+            std::from_chars(record.data(), record.data() + comma, coordinate);
+            key += '_';
+            key += std::to_string(static_cast<int>((coordinate + 1.0f) * 8.0f));
+            record.remove_prefix(std::min(comma + 1, record.size()));
+        }
+        context->emit(key, one);
+    }
+}
+
+void DAF_API_CALL cell_count_reduce(const char* key, ReduceContext* context) {
+    uint64_t count = 0;
+    std::string_view value;
+    while (context->next_value(value)) {
+        count++;
+    }
+    context->emit(std::string(key) + "\t" + std::to_string(count));
+}
+
+std::string work_path(const std::string& name) {
+    return config.work_dir + "/" + name;
+}
+
+void remove_run(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove(RunIndex::path_for(path).c_str());
+}
+
+const std::string& input_path() {
+    static const std::string path = []() {
+        std::string path = work_path("samples.csv");
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        char line[128];
+        for (uint64_t i = 0; i < config.records; ++i) {
+            float x = coordinate(rng), y = coordinate(rng), z = coordinate(rng);
+            float r = unit(rng), g = unit(rng), b = unit(rng), density = unit(rng);
+            int length = std::snprintf(line, sizeof(line), "%.4f,%.4f,%.4f,%.3f,%.3f,%.3f,%.3f\n",
+                                       x, y, z, r, g, b, density);
+            out.write(line, length);
+        }
+        return path;
+    }();
+    return path;
+}
+
+uint64_t input_bytes() {
+    static const uint64_t bytes = split_size_bytes(InputSplit{input_path()});
+    return bytes;
+}
+
+const std::map<std::string, std::string>& job_parameters() {
+    static const std::map<std::string, std::string> parameters = {
+        {"num_reduce_tasks", std::to_string(BENCH_PARTITIONS)}
+    };
+    return parameters;
+}
+
+ShuffleBuffer::Options map_options(const std::string& output_path, uint32_t partitions = BENCH_PARTITIONS) {
+    ShuffleBuffer::Options options;
+    options.num_partitions = partitions;
+    options.spill_prefix = output_path;
+    return options;
+}
+
+// Reduces one partition of the map output runs like a reduce task whose
+// runs are all local: merge, group by key, stream each group to ReduceMain
+bool reduce_partition(const JobFunctions& job, const std::vector<std::string>& runs,
+                      uint32_t partition, const std::string& output_path, uint64_t& keys) {
+    TaskArenaScope arena;
+    RunMerger merger;
+    for (const auto& run : runs) {
+        auto reader = std::make_unique<RunReader>();
+        if (!reader->open(run, partition)) {
+            return false;
+        }
+        merger.add_source(std::move(reader));
+    }
+
+    std::vector<char> out_buffer(DEFAULT_BUFFER_SIZE);
+    std::ofstream out;
+    out.rdbuf()->pubsetbuf(out_buffer.data(), static_cast<std::streamsize>(out_buffer.size()));
+    out.open(output_path, std::ios::binary | std::ios::trunc);
+
+    KeyGroupReader groups(merger);
+    ReduceContextImpl context({}, job_parameters(), arena.resource());
+    context.set_output(&out);
+    while (groups.next_group()) {
+        context.reset(groups.key(), &groups);
+        job.reduce(groups.key().c_str(), &context);
+        keys++;
+    }
+    out.close();
+    return !out.fail() && !merger.failed();
+}
+
+// MapContextImpl::read_record over the whole input, parameter input_mode
+void BM_ReadRecord(benchmark::State& state, const std::string& input_mode) {
+    std::map<std::string, std::string> parameters = {{"input_mode", input_mode}};
+    uint64_t records = 0;
+    for (auto _ : state) {
+        TaskArenaScope arena;
+        MapContextImpl context({InputSplit{input_path()}}, parameters, map_options(work_path("read")),
+                               arena.resource());
+        std::string_view record;
+        while (context.read_record(record)) {
+            benchmark::DoNotOptimize(record.data());
+            records++;
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(records));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input_bytes()));
+}
+
+// One MapContextImpl::emit / emit_binary per iteration into the shuffle
+// buffer, spills included once it fills up
+void BM_Emit(benchmark::State& state, bool binary) {
+    std::string output = work_path(binary ? "emit_binary" : "emit");
+    std::vector<std::string> keys;
+    for (int i = 0; i < 4096; ++i) {
+        keys.push_back("cell_" + std::to_string(i % 16) + "_" + std::to_string(i / 16 % 16) + "_" +
+                       std::to_string(i / 256));
+    }
+    const std::string value = "0.5000,0.2500,0.1250,0.900,0.800,0.700,0.600";
+
+    TaskArenaScope arena;
+    MapContextImpl context({}, job_parameters(), map_options(output), arena.resource());
+    uint64_t i = 0;
+    for (auto _ : state) {
+        if (binary) {
+            context.emit_binary(i * 0x9E3779B97F4A7C15ull, value.data(), value.size());
+        } else {
+            context.emit(keys[i % keys.size()], value);
+        }
+        i++;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+
+    context.finish_output(output);
+    remove_run(output);
+}
+
+// A whole map task: MapMain over the input, combiner, sort and final run
+void BM_MapMain(benchmark::State& state, const JobFunctions& job) {
+    std::string output = work_path("map." + job.name);
+    for (auto _ : state) {
+        if (!run_map_splits(job.map, job.combine, {InputSplit{input_path()}}, job_parameters(),
+                            map_options(output), output)) {
+            state.SkipWithError("map task failed");
+            break;
+        }
+    }
+    remove_run(output);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * config.records));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input_bytes()));
+}
+
+// Every partition of one map task's output through ReduceMain
+void BM_ReduceMain(benchmark::State& state, const JobFunctions& job) {
+    std::string run = work_path("reduce_input." + job.name);
+    if (!run_map_splits(job.map, job.combine, {InputSplit{input_path()}}, job_parameters(),
+                        map_options(run), run)) {
+        state.SkipWithError("map task for the reduce input failed");
+        return;
+    }
+
+    uint64_t keys = 0;
+    for (auto _ : state) {
+        for (uint32_t partition = 0; partition < BENCH_PARTITIONS; ++partition) {
+            if (!reduce_partition(job, {run}, partition, work_path("reduce.out"), keys)) {
+                state.SkipWithError("reduce failed");
+                break;
+            }
+        }
+    }
+    remove_run(run);
+    std::remove(work_path("reduce.out").c_str());
+    state.SetItemsProcessed(static_cast<int64_t>(keys));
+    state.counters["keys"] = benchmark::Counter(static_cast<double>(keys) / state.iterations());
+}
+
+// Local job on state.range(0) workers: two map tasks per worker over input
+// splits, then one reduce task per worker over the runs they wrote. Workers
+// take tasks in order like they take them off the task queue; the runs are
+// on this host, so reduce tasks read them in place as co-located workers do.
+void BM_EndToEnd(benchmark::State& state, const JobFunctions& job) {
+    size_t workers = static_cast<size_t>(state.range(0));
+    uint32_t partitions = static_cast<uint32_t>(workers);
+    size_t map_tasks = workers * 2;
+    auto splits = cut_input_split(InputSplit{input_path()}, (input_bytes() + map_tasks - 1) / map_tasks);
+
+    std::vector<std::string> runs;
+    for (size_t i = 0; i < splits.size(); ++i) {
+        runs.push_back(work_path("e2e.map" + std::to_string(i)));
+    }
+
+    // Run tasks [0, count) on the workers; false once any task failed
+    auto run_stage = [workers](size_t count, const std::function<bool(size_t)>& task) {
+        std::atomic<size_t> next{0};
+        std::atomic<bool> ok{true};
+        std::vector<std::thread> threads;
+        for (size_t w = 0; w < workers; ++w) {
+            threads.emplace_back([&]() {
+                for (size_t i = next++; i < count; i = next++) {
+                    if (!task(i)) {
+                        ok = false;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        return ok.load();
+    };
+
+    uint64_t keys = 0;
+    for (auto _ : state) {
+        bool mapped = run_stage(splits.size(), [&](size_t i) {
+            ShuffleBuffer::Options options = map_options(runs[i], partitions);
+            options.memory_limit_bytes = std::max<size_t>(options.memory_limit_bytes / workers,
+                                                          DEFAULT_BUFFER_SIZE);
+            return run_map_splits(job.map, job.combine, {splits[i]}, job_parameters(), options, runs[i]);
+        });
+
+        std::vector<uint64_t> partition_keys(partitions, 0);
+        bool reduced = mapped && run_stage(partitions, [&](size_t partition) {
+            return reduce_partition(job, runs, static_cast<uint32_t>(partition),
+                                    work_path("e2e.out" + std::to_string(partition)),
+                                    partition_keys[partition]);
+        });
+        if (!reduced) {
+            state.SkipWithError("job failed");
+            break;
+        }
+        for (uint64_t count : partition_keys) {
+            keys += count;
+        }
+    }
+
+    for (uint32_t partition = 0; partition < partitions; ++partition) {
+        std::remove(work_path("e2e.out" + std::to_string(partition)).c_str());
+    }
+    for (const auto& run : runs) {
+        remove_run(run);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * config.records));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input_bytes()));
+    state.counters["keys"] = benchmark::Counter(static_cast<double>(keys) / state.iterations());
+}
+
+#ifdef DAF_BENCH_REDIS
+// SET or GET of a 64-byte value; batch 1 is one round trip per command,
+// larger batches go through a RedisPipeline
+void BM_Redis(benchmark::State& state, const std::string& command) {
+    size_t batch = static_cast<size_t>(state.range(0));
+    RedisClientProduction redis;
+    if (!redis.Connect(config.redis_host, config.redis_port)) {
+        state.SkipWithError("cannot connect to Redis");
+        return;
+    }
+
+    std::vector<std::string> keys;
+    for (int i = 0; i < BENCH_REDIS_KEYS; ++i) {
+        keys.push_back("daf_bench:" + std::to_string(i));
+    }
+    const std::string value(64, 'v');
+    for (const auto& key : keys) {
+        redis.Set(key, value);
+    }
+
+    size_t next = 0;
+    std::string reply;
+    for (auto _ : state) {
+        bool ok = true;
+        if (batch == 1) {
+            const std::string& key = keys[next++ % keys.size()];
+            ok = command == "SET" ? redis.Set(key, value) : redis.Get(key, reply);
+        } else {
+            RedisPipeline pipeline(redis);
+            for (size_t i = 0; i < batch; ++i) {
+                const std::string& key = keys[next++ % keys.size()];
+                if (command == "SET") {
+                    pipeline.Add({"SET", key, value});
+                } else {
+                    pipeline.Add({"GET", key});
+                }
+            }
+            ok = pipeline.Execute();
+        }
+        if (!ok) {
+            state.SkipWithError("Redis command failed");
+            break;
+        }
+    }
+
+    for (const auto& key : keys) {
+        redis.Delete(key);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * batch));
+}
+#endif
+
+bool parse_flags(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value_of = [&arg](const char* flag, std::string& value) {
+            size_t length = std::strlen(flag);
+            if (arg.compare(0, length, flag) != 0) {
+                return false;
+            }
+            value = arg.substr(length);
+            return true;
+        };
+
+        std::string value;
+        if (value_of("--records=", value)) {
+            config.records = std::max<uint64_t>(1, std::strtoull(value.c_str(), nullptr, 10));
+        } else if (value_of("--work_dir=", value)) {
+            config.work_dir = value;
+        } else if (value_of("--plugin=", value)) {
+            config.plugin_path = value;
+        } else if (value_of("--redis=", value)) {
+            size_t colon = value.rfind(':');
+            config.redis_host = value.substr(0, colon);
+            if (colon != std::string::npos) {
+                config.redis_port = std::atoi(value.c_str() + colon + 1);
+            }
+        } else {
+            std::cerr << "Unknown flag: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (!parse_flags(argc, argv)) {
+        return 1;
+    }
+    Logger::set_level(Logger::Level::WARNING);
+
+    if (!Utils::create_directory(config.work_dir)) {
+        std::cerr << "Cannot create work directory: " << config.work_dir << std::endl;
+        return 1;
+    }
+    input_path();
+    benchmark::AddCustomContext("daf_records", std::to_string(config.records));
+    benchmark::AddCustomContext("daf_input_bytes", std::to_string(input_bytes()));
+
+    std::vector<JobFunctions> jobs = {{"builtin", cell_count_map, nullptr, cell_count_reduce}};
+    if (!config.plugin_path.empty()) {
+        auto& plugin_loader = PluginLoader::getInstance();
+        if (!plugin_loader.loadPlugin(config.plugin_path, "bench_plugin")) {
+            std::cerr << "Cannot load plugin: " << config.plugin_path << std::endl;
+            return 1;
+        }
+        auto map_function = reinterpret_cast<MapFunction>(plugin_loader.getSymbol("bench_plugin", "MapMain"));
+        auto combine_function = reinterpret_cast<CombineFunction>(
+            plugin_loader.getSymbol("bench_plugin", "CombineMain"));
+        auto reduce_function = reinterpret_cast<ReduceFunction>(
+            plugin_loader.getSymbol("bench_plugin", "ReduceMain"));
+        if (!map_function || !reduce_function) {
+            std::cerr << "Plugin does not export MapMain and ReduceMain: " << config.plugin_path << std::endl;
+            return 1;
+        }
+        jobs.push_back({"plugin", map_function, combine_function, reduce_function});
+        benchmark::AddCustomContext("daf_plugin", config.plugin_path);
+    }
+
+    for (const char* mode : {"stream", "mmap"}) {
+        benchmark::RegisterBenchmark((std::string("BM_ReadRecord/") + mode).c_str(), BM_ReadRecord,
+                                     std::string(mode))->Unit(benchmark::kMillisecond);
+    }
+    benchmark::RegisterBenchmark("BM_Emit/text", BM_Emit, false);
+    benchmark::RegisterBenchmark("BM_Emit/binary", BM_Emit, true);
+    for (const auto& job : jobs) {
+        benchmark::RegisterBenchmark(("BM_MapMain/" + job.name).c_str(), BM_MapMain, job)
+            ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("BM_ReduceMain/" + job.name).c_str(), BM_ReduceMain, job)
+            ->Unit(benchmark::kMillisecond);
+    }
+    for (const auto& job : jobs) {
+        benchmark::RegisterBenchmark(("BM_EndToEnd/" + job.name).c_str(), BM_EndToEnd, job)
+            ->ArgName("workers")->RangeMultiplier(2)->Range(1, 8)
+            ->UseRealTime()->Unit(benchmark::kMillisecond);
+    }
+#ifdef DAF_BENCH_REDIS
+    if (!config.redis_host.empty()) {
+        for (const char* command : {"SET", "GET"}) {
+            benchmark::RegisterBenchmark((std::string("BM_Redis/") + command).c_str(), BM_Redis,
+                                         std::string(command))
+                ->ArgName("batch")->Arg(1)->Arg(16)->Arg(128)->UseRealTime();
+        }
+    }
+#else
+    if (!config.redis_host.empty()) {
+        std::cerr << "Built without hiredis, skipping the Redis benchmarks" << std::endl;
+    }
+#endif
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    PluginLoader::getInstance().shutdown();
+    return 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+namespace daf {
+
+// Fixed-width binary shuffle keys
+//
+// emit_binary() keys travel through the shuffle as 8 big-endian bytes, so the
+// byte-wise ordering used by sort and merge is the numeric ordering of the
+// 64-bit key and the shuffle buffer can radix sort them. Each record also
+// carries a flag saying its key is binary: an 8-byte text key is just as
+// BINARY_KEY_SIZE bytes long.
+constexpr size_t BINARY_KEY_SIZE = sizeof(uint64_t);
+
+inline void encode_binary_key(uint64_t key, char* bytes) {
+    for (size_t i = 0; i < BINARY_KEY_SIZE; ++i) {
+        bytes[i] = static_cast<char>(key >> (8 * (BINARY_KEY_SIZE - 1 - i)));
+    }
+}
+
+inline bool decode_binary_key(std::string_view bytes, uint64_t& key) {
+    if (bytes.size() != BINARY_KEY_SIZE) {
+        return false;
+    }
+
+    key = 0;
+    for (size_t i = 0; i < BINARY_KEY_SIZE; ++i) {
+        key = (key << 8) | static_cast<unsigned char>(bytes[i]);
+    }
+    return true;
+}
+
+} // namespace daf
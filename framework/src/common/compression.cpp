@@ -0,0 +1,202 @@
+#include "compression.h"
+
+#ifdef DAF_HAVE_LZ4
+#include <lz4.h>
+#include <lz4frame.h>
+#endif
+#ifdef DAF_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <climits>
+
+namespace daf {
+
+bool parse_compression_codec(const std::string& name, CompressionCodec& codec) {
+    if (name == "none") {
+        codec = CompressionCodec::NONE;
+    } else if (name == "lz4") {
+        codec = CompressionCodec::LZ4;
+    } else if (name == "zstd") {
+        codec = CompressionCodec::ZSTD;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* compression_codec_name(CompressionCodec codec) {
+    switch (codec) {
+        case CompressionCodec::LZ4: return "lz4";
+        case CompressionCodec::ZSTD: return "zstd";
+        default: return "none";
+    }
+}
+
+bool compression_available(CompressionCodec codec) {
+    switch (codec) {
+        case CompressionCodec::NONE:
+            return true;
+#ifdef DAF_HAVE_LZ4
+        case CompressionCodec::LZ4:
+            return true;
+#endif
+#ifdef DAF_HAVE_ZSTD
+        case CompressionCodec::ZSTD:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+CompressionCodec compression_codec_for(const std::string& name) {
+    CompressionCodec codec = CompressionCodec::NONE;
+    if (!parse_compression_codec(name, codec) || !compression_available(codec)) {
+        return CompressionCodec::NONE;
+    }
+    return codec;
+}
+
+bool compress_block(CompressionCodec codec, const char* data, size_t size,
+                    std::vector<char>& out, int level) {
+    if (size == 0 || size > static_cast<size_t>(INT_MAX)) {
+        return false;
+    }
+
+    switch (codec) {
+#ifdef DAF_HAVE_LZ4
+        case CompressionCodec::LZ4: {
+            // Anything that does not fit in size - 1 bytes is not worth keeping
+            out.resize(size - 1);
+            int written = LZ4_compress_default(data, out.data(), static_cast<int>(size),
+                                               static_cast<int>(out.size()));
+            if (written <= 0) {
+                return false;
+            }
+            out.resize(static_cast<size_t>(written));
+            return true;
+        }
+#endif
+#ifdef DAF_HAVE_ZSTD
+        case CompressionCodec::ZSTD: {
+            out.resize(size - 1);
+            size_t written = ZSTD_compress(out.data(), out.size(), data, size,
+                                           level > 0 ? level : ZSTD_CLEVEL_DEFAULT);
+            if (ZSTD_isError(written)) {
+                return false;
+            }
+            out.resize(written);
+            return true;
+        }
+#endif
+        default:
+            (void)data;
+            (void)out;
+            (void)level;
+            return false;
+    }
+}
+
+bool decompress_block(CompressionCodec codec, const char* data, size_t size,
+                      char* out, size_t raw_size) {
+    if (size > static_cast<size_t>(INT_MAX) || raw_size > static_cast<size_t>(INT_MAX)) {
+        return false;
+    }
+
+    switch (codec) {
+#ifdef DAF_HAVE_LZ4
+        case CompressionCodec::LZ4:
+            return LZ4_decompress_safe(data, out, static_cast<int>(size),
+                                       static_cast<int>(raw_size)) == static_cast<int>(raw_size);
+#endif
+#ifdef DAF_HAVE_ZSTD
+        case CompressionCodec::ZSTD: {
+            size_t written = ZSTD_decompress(out, raw_size, data, size);
+            return !ZSTD_isError(written) && written == raw_size;
+        }
+#endif
+        default:
+            (void)data;
+            (void)out;
+            return false;
+    }
+}
+
+// FrameOutputBuffer implementation
+FrameOutputBuffer::FrameOutputBuffer(std::ostream& sink, CompressionCodec codec, int level,
+                                     size_t frame_size)
+    : sink_(sink), codec_(compression_available(codec) ? codec : CompressionCodec::NONE),
+      level_(level), buffer_(frame_size > 0 ? frame_size : DEFAULT_FRAME_SIZE) {
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+FrameOutputBuffer::~FrameOutputBuffer() {
+    finish();
+}
+
+bool FrameOutputBuffer::finish() {
+    return write_frame() && !failed_;
+}
+
+FrameOutputBuffer::int_type FrameOutputBuffer::overflow(int_type ch) {
+    if (!write_frame()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int FrameOutputBuffer::sync() {
+    return write_frame() ? 0 : -1;
+}
+
+bool FrameOutputBuffer::write_frame() {
+    size_t size = static_cast<size_t>(pptr() - pbase());
+    if (size == 0 || failed_) {
+        return !failed_;
+    }
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+    raw_bytes_ += size;
+
+    const char* data = buffer_.data();
+    size_t length = size;
+    switch (codec_) {
+#ifdef DAF_HAVE_LZ4
+        case CompressionCodec::LZ4: {
+            frame_.resize(LZ4F_compressFrameBound(size, nullptr));
+            size_t written = LZ4F_compressFrame(frame_.data(), frame_.size(), data, size, nullptr);
+            failed_ = LZ4F_isError(written);
+            data = frame_.data();
+            length = written;
+            break;
+        }
+#endif
+#ifdef DAF_HAVE_ZSTD
+        case CompressionCodec::ZSTD: {
+            frame_.resize(ZSTD_compressBound(size));
+            size_t written = ZSTD_compress(frame_.data(), frame_.size(), data, size,
+                                           level_ > 0 ? level_ : ZSTD_CLEVEL_DEFAULT);
+            failed_ = ZSTD_isError(written);
+            data = frame_.data();
+            length = written;
+            break;
+        }
+#endif
+        default:
+            break;
+    }
+    if (failed_) {
+        return false;
+    }
+
+    sink_.write(data, static_cast<std::streamsize>(length));
+    compressed_bytes_ += length;
+    failed_ = !sink_;
+    return !failed_;
+}
+
+} // namespace daf
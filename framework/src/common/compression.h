@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace daf {
+
+// Block compression for intermediate data and job output
+//
+// LZ4 is cheap enough to leave on for spills and shuffle traffic, Zstd
+// trades CPU for ratio. Each codec is compiled in when its library is found
+// (DAF_HAVE_LZ4 / DAF_HAVE_ZSTD); asking for a missing one falls back to NONE.
+enum class CompressionCodec : uint32_t {
+    NONE = 0,
+    LZ4 = 1,
+    ZSTD = 2
+};
+
+// "none", "lz4" or "zstd"; false for anything else
+bool parse_compression_codec(const std::string& name, CompressionCodec& codec);
+const char* compression_codec_name(CompressionCodec codec);
+bool compression_available(CompressionCodec codec);
+
+// Codec named by a task parameter, NONE if it is unset, unknown or not compiled in
+CompressionCodec compression_codec_for(const std::string& name);
+
+// Compresses one block into out (raw LZ4 block or Zstd frame). Returns
+// false when the codec is unavailable or the result would not be smaller,
+// in which case callers store the block uncompressed. level 0 picks the
+// codec's default.
+bool compress_block(CompressionCodec codec, const char* data, size_t size,
+                    std::vector<char>& out, int level = 0);
+// raw_size must be the exact uncompressed size
+bool decompress_block(CompressionCodec codec, const char* data, size_t size,
+                      char* out, size_t raw_size);
+
+// Stream buffer writing independent .lz4 / .zst frames to a sink, so the
+// file decompresses with the stock command line tools
+class FrameOutputBuffer : public std::streambuf {
+public:
+    static constexpr size_t DEFAULT_FRAME_SIZE = 1024 * 1024;
+
+    FrameOutputBuffer(std::ostream& sink, CompressionCodec codec, int level = 0,
+                      size_t frame_size = DEFAULT_FRAME_SIZE);
+    ~FrameOutputBuffer() override;
+
+    FrameOutputBuffer(const FrameOutputBuffer&) = delete;
+    FrameOutputBuffer& operator=(const FrameOutputBuffer&) = delete;
+
+    // Writes out what is buffered; false if compressing or the sink failed
+    bool finish();
+
+    uint64_t raw_bytes() const { return raw_bytes_; }
+    uint64_t compressed_bytes() const { return compressed_bytes_; }
+
+protected:
+    int_type overflow(int_type ch) override;
+    int sync() override;
+
+private:
+    bool write_frame();
+
+    std::ostream& sink_;
+    CompressionCodec codec_;
+    int level_;
+    std::vector<char> buffer_;
+    std::vector<char> frame_;
+    uint64_t raw_bytes_ = 0;
+    uint64_t compressed_bytes_ = 0;
+    bool failed_ = false;
+};
+
+} // namespace daf
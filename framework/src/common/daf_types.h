@@ -32,6 +32,10 @@ class ReduceContext;
 // Plugin function signatures
 typedef void (DAF_API_CALL *MapFunction)(MapContext* context);
 typedef void (DAF_API_CALL *ReduceFunction)(const char* key, ReduceContext* context);
+// Optional map-side combiner (exported as CombineMain). Same shape as
+// ReduceFunction: it consumes values of one key and emits partial aggregates
+// that are shuffled in place of the raw values, so ReduceMain must accept both.
+typedef void (DAF_API_CALL *CombineFunction)(const char* key, ReduceContext* context);
 
 // Error codes
 enum class ErrorCode {
@@ -96,7 +100,9 @@ struct JobConfig {
     std::map<std::string, std::string> parameters;
 };
 
-// Task data structures for plugin processing
+// Task data structures for plugin processing. Part of the version 1
+// plugin ABI (IPlugin::process), so their layout must not change: the task
+// arena is reached through MapContext / ReduceContext::get_task_memory().
 struct TaskData {
     std::string task_id;
     std::string data_type;
@@ -120,5 +126,7 @@ struct TaskResult {
 constexpr size_t MAX_MEMORY_MB = 400; // Leave 112MB for system overhead
 constexpr size_t MAX_BUFFER_SIZE = 64 * 1024 * 1024; // 64MB max buffer
 constexpr size_t DEFAULT_BUFFER_SIZE = 4 * 1024 * 1024; // 4MB default buffer
+constexpr size_t MIN_SUB_SPLIT_SIZE = 4 * 1024 * 1024; // Smallest map sub-split handed to the worker pool
+constexpr size_t DEFAULT_MAP_SPLIT_SIZE = 16 * DEFAULT_BUFFER_SIZE; // Input bytes per map task when the job sets no task count
 
 } // namespace daf
\ No newline at end of file
@@ -7,6 +7,10 @@
 #include <cctype>
 #include <iomanip>
 #include <cstdlib>
+#include <cstdio>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #ifdef _WIN32
     #include <windows.h>
@@ -60,6 +64,19 @@ size_t Utils::get_file_size(const std::string& path) {
     return static_cast<size_t>(file.tellg());
 }
 
+std::string Utils::get_file_identity(const std::string& path) {
+#ifdef _WIN32
+    (void)path;
+    return "";
+#else
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return "";
+    }
+    return std::to_string(info.st_dev) + ":" + std::to_string(info.st_ino);
+#endif
+}
+
 std::vector<std::string> Utils::split(const std::string& str, char delimiter) {
     std::vector<std::string> tokens;
     std::stringstream ss(str);
@@ -103,16 +120,32 @@ std::string Utils::format_timestamp(int64_t timestamp_ms) {
 }
 
 size_t Utils::get_memory_usage() {
+    return get_resident_memory_bytes() / (1024 * 1024);
+}
+
+size_t Utils::get_resident_memory_bytes() {
 #ifdef _WIN32
     PROCESS_MEMORY_COUNTERS_EX pmc;
     if (GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&pmc, sizeof(pmc))) {
-        return pmc.WorkingSetSize / (1024 * 1024); // Convert to MB
+        return pmc.WorkingSetSize;
     }
     return 0;
 #else
+    // The second field of statm is the current RSS in pages; ru_maxrss is
+    // only the peak, so it is the fallback where /proc is missing
+    FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (statm) {
+        unsigned long size_pages = 0;
+        unsigned long resident_pages = 0;
+        int fields = std::fscanf(statm, "%lu %lu", &size_pages, &resident_pages);
+        std::fclose(statm);
+        if (fields == 2) {
+            return static_cast<size_t>(resident_pages) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        }
+    }
     struct rusage usage;
     if (getrusage(RUSAGE_SELF, &usage) == 0) {
-        return usage.ru_maxrss / 1024; // Convert to MB (Linux reports in KB)
+        return static_cast<size_t>(usage.ru_maxrss) * 1024; // Linux reports in KB
     }
     return 0;
 #endif
@@ -133,6 +166,26 @@ size_t Utils::get_available_memory() {
 #endif
 }
 
+int64_t Utils::get_process_cpu_time_ms() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        auto to_100ns = [](const FILETIME& time) {
+            return (static_cast<int64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+        };
+        return (to_100ns(kernel) + to_100ns(user)) / 10000;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return static_cast<int64_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000 +
+               (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+    }
+    return 0;
+#endif
+}
+
 bool Utils::is_port_available(int port) {
 #ifdef _WIN32
     WSADATA wsaData;
@@ -224,37 +277,247 @@ std::string Utils::getenv_or_default(const std::string& var_name, const std::str
 }
 
 // Logger implementation
-Logger::Level Logger::current_level_ = Logger::Level::INFO;
+std::atomic<Logger::Level> Logger::current_level_{Logger::Level::INFO};
+
+// Bounded multi-producer ring (Vyukov): a slot's sequence says whether it is
+// free for the producer at that position or holds a line for the consumer.
+// Only the writer thread pops.
+class LogWriter {
+public:
+    LogWriter() : slots_(Logger::RING_SIZE) {
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        thread_ = std::thread(&LogWriter::run, this);
+    }
+    
+    // Runs at exit, or when a plugin library that logged is unloaded
+    ~LogWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        ready_.notify_one();
+        thread_.join();
+        gone().store(true);
+    }
+    
+    // False once the writer has shut down
+    static std::atomic<bool>& gone() {
+        static std::atomic<bool> flag{false};
+        return flag;
+    }
+    
+    void submit(Logger::Level level, int64_t timestamp_ms, std::string&& message) {
+        while (!try_push(level, timestamp_ms, std::move(message))) {
+            if (level < Logger::Level::WARNING) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            wake();
+            std::this_thread::yield();
+        }
+        wake();
+        if (level == Logger::Level::ERR) {
+            flush();
+        }
+    }
+    
+    void flush() {
+        uint64_t target = tail_.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(mutex_);
+        flush_waiters_++;
+        auto written = [&]() { return written_ >= target || stopping_; };
+        while (!written()) {
+            ready_.notify_one();
+            flushed_.wait_for(lock, std::chrono::milliseconds(10), written);
+        }
+        flush_waiters_--;
+    }
+    
+    static void write_line(std::string& out, Logger::Level level, const std::string& stamp,
+                           const std::string& message) {
+        out += '[';
+        out += stamp;
+        out += "] [";
+        out += Logger::level_to_string(level);
+        out += "] ";
+        out += message;
+        out += '\n';
+    }
+    
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        Logger::Level level = Logger::Level::INFO;
+        int64_t timestamp_ms = 0;
+        std::string message;
+    };
+    
+    bool try_push(Logger::Level level, int64_t timestamp_ms, std::string&& message) {
+        uint64_t position = tail_.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots_[position & (slots_.size() - 1)];
+            uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->level = level;
+        slot->timestamp_ms = timestamp_ms;
+        slot->message = std::move(message);
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+    
+    bool has_line() const {
+        const Slot& slot = slots_[head_ & (slots_.size() - 1)];
+        return slot.sequence.load(std::memory_order_acquire) == head_ + 1;
+    }
+    
+    // Only wakes a sleeping writer, so a busy one costs producers nothing
+    void wake() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready_.notify_one();
+        }
+    }
+    
+    void run() {
+        constexpr size_t MAX_BATCH_BYTES = 64 * 1024;
+        std::string batch;
+        int64_t stamp_second = -1;
+        std::string stamp;
+        
+        while (true) {
+            uint64_t lines = 0;
+            while (has_line()) {
+                Slot& slot = slots_[head_ & (slots_.size() - 1)];
+                // Timestamps are formatted here, once per second of log output
+                if (slot.timestamp_ms / 1000 != stamp_second) {
+                    stamp_second = slot.timestamp_ms / 1000;
+                    stamp = Utils::format_timestamp(slot.timestamp_ms);
+                }
+                write_line(batch, slot.level, stamp, slot.message);
+                slot.message.clear();
+                slot.sequence.store(head_ + slots_.size(), std::memory_order_release);
+                head_++;
+                lines++;
+                if (batch.size() >= MAX_BATCH_BYTES) {
+                    std::fwrite(batch.data(), 1, batch.size(), stdout);
+                    batch.clear();
+                }
+            }
+            
+            uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+            if (dropped > 0) {
+                write_line(batch, Logger::Level::WARNING, stamp.empty() ?
+                           Utils::format_timestamp(Utils::get_timestamp_ms()) : stamp,
+                           std::to_string(dropped) + " log lines dropped, logging faster than stdout drains");
+            }
+            if (!batch.empty()) {
+                std::fwrite(batch.data(), 1, batch.size(), stdout);
+                batch.clear();
+            }
+            if (lines > 0 || dropped > 0) {
+                std::fflush(stdout);
+            }
+            
+            std::unique_lock<std::mutex> lock(mutex_);
+            written_ = head_;
+            if (flush_waiters_ > 0) {
+                flushed_.notify_all();
+            }
+            if (lines > 0) {
+                continue;
+            }
+            if (stopping_ && !has_line()) {
+                break;
+            }
+            
+            sleeping_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            ready_.wait_for(lock, std::chrono::milliseconds(100),
+                            [this]() { return stopping_ || has_line(); });
+            sleeping_.store(false, std::memory_order_relaxed);
+        }
+    }
+    
+    std::vector<Slot> slots_;
+    std::atomic<uint64_t> tail_{0};      // Next position for producers
+    uint64_t head_ = 0;                  // Next position for the writer
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<bool> sleeping_{false};
+    
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::condition_variable flushed_;
+    uint64_t written_ = 0;
+    size_t flush_waiters_ = 0;
+    bool stopping_ = false;
+    
+    std::thread thread_;
+};
+
+static LogWriter* log_writer() {
+    if (LogWriter::gone().load()) {
+        return nullptr;
+    }
+    static LogWriter writer;
+    return &writer;
+}
 
 void Logger::set_level(Level level) {
-    current_level_ = level;
+    current_level_.store(level, std::memory_order_relaxed);
 }
 
-void Logger::log(Level level, const std::string& message) {
-    if (level < current_level_) {
+void Logger::log(Level level, std::string message) {
+    if (!enabled(level)) {
         return;
     }
     
     auto timestamp = Utils::get_timestamp_ms();
-    std::cout << "[" << Utils::format_timestamp(timestamp) << "] "
-              << "[" << level_to_string(level) << "] "
-              << message << std::endl;
+    LogWriter* writer = log_writer();
+    if (!writer) {
+        // Logging from static destructors after the writer stopped
+        std::string line;
+        LogWriter::write_line(line, level, Utils::format_timestamp(timestamp), message);
+        std::fwrite(line.data(), 1, line.size(), stdout);
+        std::fflush(stdout);
+        return;
+    }
+    writer->submit(level, timestamp, std::move(message));
+}
+
+void Logger::debug(std::string message) {
+    log(Level::DEBUG, std::move(message));
 }
 
-void Logger::debug(const std::string& message) {
-    log(Level::DEBUG, message);
+void Logger::info(std::string message) {
+    log(Level::INFO, std::move(message));
 }
 
-void Logger::info(const std::string& message) {
-    log(Level::INFO, message);
+void Logger::warning(std::string message) {
+    log(Level::WARNING, std::move(message));
 }
 
-void Logger::warning(const std::string& message) {
-    log(Level::WARNING, message);
+void Logger::error(std::string message) {
+    log(Level::ERR, std::move(message));
 }
 
-void Logger::error(const std::string& message) {
-    log(Level::ERR, message);
+void Logger::flush() {
+    if (LogWriter* writer = log_writer()) {
+        writer->flush();
+    }
 }
 
 std::string Logger::level_to_string(Level level) {
@@ -1,9 +1,14 @@
 #pragma once
 
 #include "daf_types.h"
+#include "sample_format.h"
+#include "binary_key.h"
 #include <vector>
 #include <string>
+#include <string_view>
 #include <cstdint>
+#include <memory_resource>
+#include <atomic>
 
 namespace daf {
 
@@ -26,6 +31,22 @@ public:
     // Memory management
     virtual size_t get_memory_usage() const = 0;
     virtual size_t get_memory_limit() const = 0;
+    
+    // Batch input from binary sample files (see sample_format.h).
+    // Returns false once every sample input has been consumed.
+    virtual bool read_samples(SampleBatch& batch) = 0;
+    
+    // Zero-copy text input: the view stays valid until the next read.
+    // Returns false once every text input has been consumed.
+    virtual bool read_record(std::string_view& record) = 0;
+    
+    // Fixed-width key and raw value bytes (see binary_key.h), so the hot path
+    // does no string formatting. The value is copied before the call returns.
+    virtual void emit_binary(uint64_t key, const void* value, size_t size) = 0;
+    
+    // Scratch memory released all at once when the task ends, for
+    // std::pmr containers the plugin keeps while the task runs
+    virtual std::pmr::memory_resource* get_task_memory() = 0;
 };
 
 class ReduceContext {
@@ -46,6 +67,20 @@ public:
     // Memory management
     virtual size_t get_memory_usage() const = 0;
     virtual size_t get_memory_limit() const = 0;
+    
+    // Current key if it was emitted with MapContext::emit_binary
+    virtual bool get_binary_key(uint64_t& key) const = 0;
+    
+    // Raw output record, stored length-prefixed instead of as a text line
+    virtual void emit_binary(const void* value, size_t size) = 0;
+    
+    // Streams the key's values without materializing them; the view stays
+    // valid until the next call. get_values() returns what is left unread.
+    virtual bool next_value(std::string_view& value) = 0;
+    
+    // Scratch memory released all at once when the task ends; do not keep
+    // per-key data in it across a whole reduce task
+    virtual std::pmr::memory_resource* get_task_memory() = 0;
 };
 
 // Utility functions
@@ -56,6 +91,9 @@ public:
     static bool create_directory(const std::string& path);
     static bool delete_file(const std::string& path);
     static size_t get_file_size(const std::string& path);
+    // Device and inode of a file, empty if it does not exist (or on Windows):
+    // tells a file apart from another one renamed over the same path
+    static std::string get_file_identity(const std::string& path);
     
     // String operations
     static std::vector<std::string> split(const std::string& str, char delimiter);
@@ -67,8 +105,12 @@ public:
     static std::string format_timestamp(int64_t timestamp_ms);
     
     // Memory operations
+    // Live resident set size, in MB and in bytes
     static size_t get_memory_usage();
+    static size_t get_resident_memory_bytes();
     static size_t get_available_memory();
+    // User plus system CPU time consumed by this process
+    static int64_t get_process_cpu_time_ms();
     
     // Production network operations
     static bool is_port_available(int port);
@@ -78,7 +120,13 @@ public:
     static std::string getenv_or_default(const std::string& var_name, const std::string& default_value);
 };
 
-// Simple logging
+// Asynchronous logging
+//
+// log() stamps the message and pushes it into a lock-free ring; a
+// background thread formats the timestamp and writes lines in batches, with
+// one flush per batch instead of one per line. When the ring is full, DEBUG
+// and INFO lines are dropped (and counted) rather than blocking the caller,
+// warnings wait for room, and errors are written before log() returns.
 class Logger {
 public:
     enum class Level {
@@ -88,16 +136,43 @@ public:
         ERR = 3  // Changed from ERROR to avoid Windows macro conflict
     };
     
+    static constexpr size_t RING_SIZE = 8192;   // Lines in flight, power of two
+    
     static void set_level(Level level);
-    static void log(Level level, const std::string& message);
-    static void debug(const std::string& message);
-    static void info(const std::string& message);
-    static void warning(const std::string& message);
-    static void error(const std::string& message);
+    static bool enabled(Level level) { return level >= current_level_.load(std::memory_order_relaxed); }
+    static void log(Level level, std::string message);
+    static void debug(std::string message);
+    static void info(std::string message);
+    static void warning(std::string message);
+    static void error(std::string message);
+    
+    // Blocks until every line logged so far has been written
+    static void flush();
     
 private:
-    static Level current_level_;
+    static std::atomic<Level> current_level_;
     static std::string level_to_string(Level level);
+    
+    friend class LogWriter;
 };
 
-} // namespace daf
\ No newline at end of file
+} // namespace daf
+
+// Debug logging is compiled out of release (NDEBUG) builds unless
+// DAF_ENABLE_DEBUG_LOG is defined to 1
+#ifndef DAF_ENABLE_DEBUG_LOG
+#ifdef NDEBUG
+#define DAF_ENABLE_DEBUG_LOG 0
+#else
+#define DAF_ENABLE_DEBUG_LOG 1
+#endif
+#endif
+
+// Hot-path debug logging: the message expression is evaluated only when
+// debug logging is compiled in and enabled
+#define DAF_LOG_DEBUG(message) \
+    do { \
+        if (DAF_ENABLE_DEBUG_LOG && daf::Logger::enabled(daf::Logger::Level::DEBUG)) { \
+            daf::Logger::debug(message); \
+        } \
+    } while (0)
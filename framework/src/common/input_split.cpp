@@ -0,0 +1,113 @@
+#include "input_split.h"
+#include "sample_format.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+
+#ifdef min
+#undef min
+#endif
+#ifdef max
+#undef max
+#endif
+
+namespace daf {
+
+namespace {
+
+bool parse_uint64(const std::string& text, uint64_t& value) {
+    if (text.empty() || text.size() > 20) {
+        return false;
+    }
+    for (char c : text) {
+        if (!std::isdigit(static_cast<unsigned char>(c))) {
+            return false;
+        }
+    }
+    try {
+        value = std::stoull(text);
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::string InputSplit::to_string() const {
+    if (is_whole_file()) {
+        return path;
+    }
+    return path + "@" + std::to_string(offset) + "+" + std::to_string(length);
+}
+
+InputSplit InputSplit::parse(const std::string& spec) {
+    InputSplit split;
+    split.path = spec;
+
+    size_t at = spec.rfind('@');
+    if (at == std::string::npos) {
+        return split;
+    }
+    size_t plus = spec.find('+', at);
+    if (plus == std::string::npos) {
+        return split;
+    }
+
+    uint64_t offset = 0;
+    uint64_t length = 0;
+    if (!parse_uint64(spec.substr(at + 1, plus - at - 1), offset) ||
+        !parse_uint64(spec.substr(plus + 1), length)) {
+        return split;
+    }
+
+    split.path = spec.substr(0, at);
+    split.offset = offset;
+    split.length = length;
+    return split;
+}
+
+uint64_t split_size_bytes(const InputSplit& split) {
+    std::error_code error;
+    uint64_t file_size = std::filesystem::file_size(split.path, error);
+    if (error || split.offset >= file_size) {
+        return 0;
+    }
+    return std::min(split.end(), file_size) - split.offset;
+}
+
+std::vector<InputSplit> cut_input_split(const InputSplit& split, uint64_t target_bytes) {
+    std::error_code error;
+    uint64_t file_size = std::filesystem::file_size(split.path, error);
+    if (error || target_bytes == 0) {
+        return {split};
+    }
+
+    uint64_t begin = split.offset;
+    uint64_t end = std::min(split.end(), file_size);
+    if (begin >= end || end - begin <= target_bytes) {
+        return {split};
+    }
+
+    // Keep DAFS pieces a whole number of blocks so they come out the same size
+    std::ifstream file(split.path, std::ios::binary);
+    SampleFileHeader header{};
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+        header.magic == SAMPLE_FILE_MAGIC && header.block_capacity > 0) {
+        uint64_t block_bytes = sample_block_bytes(header.block_capacity);
+        target_bytes = std::max<uint64_t>(1, (target_bytes + block_bytes / 2) / block_bytes) * block_bytes;
+    }
+
+    std::vector<InputSplit> pieces;
+    for (uint64_t offset = begin; offset < end; offset += target_bytes) {
+        InputSplit piece;
+        piece.path = split.path;
+        piece.offset = offset;
+        piece.length = std::min(target_bytes, end - offset);
+        pieces.push_back(std::move(piece));
+    }
+    return pieces;
+}
+
+} // namespace daf
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace daf {
+
+// Byte range of one input file handed to a map task
+//
+// Text splits own every line that starts inside [offset, end()): a reader
+// skips the partial line at its start (unless offset is 0) and finishes the
+// line that crosses its end. DAFS splits own the blocks whose first byte
+// falls inside the range. Either way adjacent splits never lose or repeat a
+// record, wherever the cut points are.
+struct InputSplit {
+    static constexpr uint64_t WHOLE_FILE = UINT64_MAX;
+
+    std::string path;
+    uint64_t offset = 0;
+    uint64_t length = WHOLE_FILE;
+
+    bool is_whole_file() const { return offset == 0 && length == WHOLE_FILE; }
+    uint64_t end() const {
+        return length > WHOLE_FILE - offset ? WHOLE_FILE : offset + length;
+    }
+
+    // "path" for whole files, "path@offset+length" otherwise
+    std::string to_string() const;
+
+    // Accepts both forms; a suffix that is not a valid range is part of the path
+    static InputSplit parse(const std::string& spec);
+};
+
+// Bytes of the file the split covers, or 0 if the file cannot be read
+uint64_t split_size_bytes(const InputSplit& split);
+
+// Cuts a split into pieces of about target_bytes, clamped to the file size.
+// DAFS pieces are rounded to whole blocks. target_bytes == 0 or an
+// unreadable file returns the split unchanged.
+std::vector<InputSplit> cut_input_split(const InputSplit& split, uint64_t target_bytes);
+
+} // namespace daf
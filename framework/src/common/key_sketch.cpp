@@ -0,0 +1,208 @@
+#include "key_sketch.h"
+#include "varint.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <unordered_map>
+
+namespace daf {
+
+namespace {
+
+using Candidate = std::pair<uint64_t, std::string>;
+using CandidateOrder = std::greater<Candidate>;   // Min-heap by count
+
+// FNV-1a, split into the two halves of double hashing (one per row)
+std::pair<uint64_t, uint64_t> key_hashes(std::string_view key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return {hash & 0xffffffffULL, (hash >> 32) | 1};
+}
+
+size_t counter_index(const std::pair<uint64_t, uint64_t>& hashes, size_t row) {
+    return row * KEY_SKETCH_WIDTH + static_cast<size_t>((hashes.first + row * hashes.second) % KEY_SKETCH_WIDTH);
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+KeySketch::KeySketch() : counters_(KEY_SKETCH_DEPTH * KEY_SKETCH_WIDTH, 0), total_(0) {
+}
+
+void KeySketch::add(std::string_view key, uint64_t records) {
+    auto hashes = key_hashes(key);
+    for (size_t row = 0; row < KEY_SKETCH_DEPTH; ++row) {
+        counters_[counter_index(hashes, row)] += records;
+    }
+    total_ += records;
+
+    if (candidates_.size() < KEY_SKETCH_CANDIDATES) {
+        candidates_.emplace_back(records, std::string(key));
+        std::push_heap(candidates_.begin(), candidates_.end(), CandidateOrder());
+    } else if (records > candidates_.front().first) {
+        std::pop_heap(candidates_.begin(), candidates_.end(), CandidateOrder());
+        candidates_.back() = Candidate(records, std::string(key));
+        std::push_heap(candidates_.begin(), candidates_.end(), CandidateOrder());
+    }
+}
+
+void KeySketch::merge(const KeySketch& other) {
+    for (size_t i = 0; i < counters_.size(); ++i) {
+        counters_[i] += other.counters_[i];
+    }
+    total_ += other.total_;
+
+    // Keep every run's candidates; their counts are only used within a run
+    std::unordered_map<std::string, uint64_t> merged;
+    for (const auto& candidate : candidates_) {
+        merged[candidate.second] = std::max(merged[candidate.second], candidate.first);
+    }
+    for (const auto& candidate : other.candidates_) {
+        merged[candidate.second] = std::max(merged[candidate.second], candidate.first);
+    }
+    candidates_.clear();
+    for (auto& [key, records] : merged) {
+        candidates_.emplace_back(records, key);
+    }
+    std::make_heap(candidates_.begin(), candidates_.end(), CandidateOrder());
+}
+
+uint64_t KeySketch::estimate(std::string_view key) const {
+    auto hashes = key_hashes(key);
+    uint64_t estimate = UINT64_MAX;
+    for (size_t row = 0; row < KEY_SKETCH_DEPTH; ++row) {
+        estimate = std::min(estimate, counters_[counter_index(hashes, row)]);
+    }
+    return estimate;
+}
+
+std::vector<std::pair<std::string, uint64_t>> KeySketch::heavy_keys(uint64_t threshold) const {
+    std::vector<std::pair<std::string, uint64_t>> heavy;
+    for (const auto& candidate : candidates_) {
+        uint64_t records = estimate(candidate.second);
+        if (records >= threshold) {
+            heavy.emplace_back(candidate.second, records);
+        }
+    }
+    std::sort(heavy.begin(), heavy.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    return heavy;
+}
+
+std::string KeySketch::encode() const {
+    // [u8 version][varint depth][varint width][varint total][varint candidates]
+    // (str key, varint count)... varint counter...
+    std::string out;
+    out.reserve(16 + counters_.size() * 2);
+    out += static_cast<char>(KEY_SKETCH_VERSION);
+    put_varint(out, KEY_SKETCH_DEPTH);
+    put_varint(out, KEY_SKETCH_WIDTH);
+    put_varint(out, total_);
+    put_varint(out, candidates_.size());
+    for (const auto& candidate : candidates_) {
+        put_string(out, candidate.second);
+        put_varint(out, candidate.first);
+    }
+    for (uint64_t counter : counters_) {
+        put_varint(out, counter);
+    }
+    return out;
+}
+
+bool KeySketch::decode(const std::string& encoded, KeySketch& sketch) {
+    if (encoded.empty() || static_cast<uint8_t>(encoded[0]) != KEY_SKETCH_VERSION) {
+        return false;
+    }
+
+    VarintReader reader(encoded);
+    reader.skip(1);
+    uint64_t depth = 0, width = 0, total = 0, candidates = 0;
+    if (!reader.varint(depth) || !reader.varint(width) || !reader.varint(total) ||
+        depth != KEY_SKETCH_DEPTH || width != KEY_SKETCH_WIDTH || !reader.count(candidates, 2)) {
+        return false;
+    }
+
+    KeySketch decoded;
+    decoded.total_ = total;
+    for (uint64_t i = 0; i < candidates; ++i) {
+        std::string key;
+        uint64_t records = 0;
+        if (!reader.string(key) || !reader.varint(records)) {
+            return false;
+        }
+        decoded.candidates_.emplace_back(records, std::move(key));
+    }
+    std::make_heap(decoded.candidates_.begin(), decoded.candidates_.end(), CandidateOrder());
+    for (auto& counter : decoded.counters_) {
+        if (!reader.varint(counter)) {
+            return false;
+        }
+    }
+
+    sketch = std::move(decoded);
+    return true;
+}
+
+std::vector<HotKey> find_hot_keys(const KeySketch& sketch, uint32_t reduce_tasks,
+                                  double fraction, uint32_t max_salts) {
+    std::vector<HotKey> hot;
+    if (reduce_tasks <= 1 || max_salts <= 1 || sketch.total() == 0 || fraction <= 0.0) {
+        return hot;
+    }
+
+    double share = static_cast<double>(sketch.total()) / reduce_tasks * fraction;
+    uint64_t threshold = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(share)));
+    for (auto& [key, records] : sketch.heavy_keys(threshold)) {
+        if (key.empty()) {
+            continue;   // Cannot be named in task parameters
+        }
+        HotKey hot_key;
+        hot_key.key = key;
+        hot_key.records = records;
+        uint64_t pieces = (records + threshold - 1) / threshold;
+        hot_key.salts = static_cast<uint32_t>(std::clamp<uint64_t>(pieces, 2, max_salts));
+        hot.push_back(std::move(hot_key));
+    }
+    return hot;
+}
+
+std::string hex_encode_key(std::string_view key) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(key.size() * 2);
+    for (unsigned char c : key) {
+        hex += digits[c >> 4];
+        hex += digits[c & 0x0f];
+    }
+    return hex;
+}
+
+bool hex_decode_key(std::string_view hex, std::string& key) {
+    if (hex.size() % 2 != 0) {
+        return false;
+    }
+    key.clear();
+    key.reserve(hex.size() / 2);
+    for (size_t i = 0; i < hex.size(); i += 2) {
+        int high = hex_value(hex[i]);
+        int low = hex_value(hex[i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        key += static_cast<char>((high << 4) | low);
+    }
+    return true;
+}
+
+} // namespace daf
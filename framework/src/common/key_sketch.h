@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace daf {
+
+// Key frequency sketch of map output
+//
+// A count-min sketch over every key group of a map output run, weighted by
+// the group's records, plus that run's heaviest keys with their exact
+// counts as hot-key candidates. Runs are sorted, so a map task sees each key
+// once with its whole count. The sketches of a job's map tasks merge by
+// adding the counters; hot keys are the candidates the merged sketch still
+// estimates as heavy, so a key that is moderate in every run but heavy
+// overall is found as long as it stands out in at least one run.
+constexpr size_t KEY_SKETCH_DEPTH = 4;
+constexpr size_t KEY_SKETCH_WIDTH = 1024;      // Overestimate under total * e / width
+constexpr size_t KEY_SKETCH_CANDIDATES = 16;   // Heaviest keys kept per run
+constexpr uint8_t KEY_SKETCH_VERSION = 1;      // First byte of encode()
+
+class KeySketch {
+public:
+    KeySketch();
+
+    void add(std::string_view key, uint64_t records);
+    void merge(const KeySketch& other);
+
+    // Never below the key's true count
+    uint64_t estimate(std::string_view key) const;
+    uint64_t total() const { return total_; }
+
+    // Candidates estimated at threshold records or more, heaviest first
+    std::vector<std::pair<std::string, uint64_t>> heavy_keys(uint64_t threshold) const;
+
+    // Compact binary form (varints) for a task result
+    std::string encode() const;
+    static bool decode(const std::string& encoded, KeySketch& sketch);
+
+private:
+    std::vector<uint64_t> counters_;   // KEY_SKETCH_DEPTH rows of KEY_SKETCH_WIDTH
+    uint64_t total_;
+    // Min-heap by count while a single run is added, a plain list after merges
+    std::vector<std::pair<uint64_t, std::string>> candidates_;
+};
+
+// Hot keys of a job: keys that alone carry at least `fraction` of an
+// average reducer's records, each with how many reducers to salt it across
+// (one per `fraction` of a reducer's share, at most max_salts)
+struct HotKey {
+    std::string key;
+    uint64_t records = 0;
+    uint32_t salts = 1;
+};
+
+std::vector<HotKey> find_hot_keys(const KeySketch& sketch, uint32_t reduce_tasks,
+                                  double fraction, uint32_t max_salts);
+
+// Keys in task parameters: binary-safe hex, lists comma-separated
+std::string hex_encode_key(std::string_view key);
+bool hex_decode_key(std::string_view hex, std::string& key);
+
+} // namespace daf
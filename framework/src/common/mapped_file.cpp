@@ -0,0 +1,232 @@
+#include "mapped_file.h"
+#include <algorithm>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+#ifdef min
+#undef min
+#endif
+
+namespace daf {
+
+namespace {
+
+size_t page_size() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return static_cast<size_t>(info.dwAllocationGranularity);
+#else
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGE_SIZE));
+    return size;
+#endif
+}
+
+} // namespace
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    move_from(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        move_from(other);
+    }
+    return *this;
+}
+
+void MappedFile::move_from(MappedFile& other) noexcept {
+    data_ = other.data_;
+    size_ = other.size_;
+    open_ = other.open_;
+#ifdef _WIN32
+    file_handle_ = other.file_handle_;
+    mapping_handle_ = other.mapping_handle_;
+    other.file_handle_ = nullptr;
+    other.mapping_handle_ = nullptr;
+#else
+    fd_ = other.fd_;
+    other.fd_ = -1;
+#endif
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.open_ = false;
+}
+
+bool MappedFile::open(const std::string& path, Access access) {
+    close();
+
+#ifdef _WIN32
+    DWORD flags = access == Access::SEQUENTIAL ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    file_handle_ = file;
+    size_ = static_cast<size_t>(file_size.QuadPart);
+    open_ = true;
+    if (size_ == 0) {
+        return true; // Nothing to map
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        close();
+        return false;
+    }
+    mapping_handle_ = mapping;
+
+    data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!data_) {
+        close();
+        return false;
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    fd_ = fd;
+    size_ = static_cast<size_t>(st.st_size);
+    open_ = true;
+    if (size_ == 0) {
+        return true; // mmap rejects zero-length mappings
+    }
+
+    void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (mapping == MAP_FAILED) {
+        close();
+        return false;
+    }
+    data_ = static_cast<const char*>(mapping);
+
+    if (access == Access::SEQUENTIAL) {
+        madvise(mapping, size_, MADV_SEQUENTIAL);
+#ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    } else {
+        madvise(mapping, size_, MADV_RANDOM);
+    }
+#endif
+
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_handle_) {
+        CloseHandle(static_cast<HANDLE>(mapping_handle_));
+        mapping_handle_ = nullptr;
+    }
+    if (file_handle_) {
+        CloseHandle(static_cast<HANDLE>(file_handle_));
+        file_handle_ = nullptr;
+    }
+#else
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
+
+void MappedFile::prefetch(size_t offset, size_t length) const {
+    if (!data_ || offset >= size_) {
+        return;
+    }
+    length = std::min(length, size_ - offset);
+
+#ifndef _WIN32
+    size_t aligned = offset - offset % page_size();
+    madvise(const_cast<char*>(data_) + aligned, length + (offset - aligned), MADV_WILLNEED);
+#ifdef POSIX_FADV_WILLNEED
+    posix_fadvise(fd_, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+#endif
+#endif
+}
+
+void MappedFile::release(size_t offset, size_t length) const {
+    if (!data_ || offset >= size_) {
+        return;
+    }
+    length = std::min(length, size_ - offset);
+
+    // Only whole pages inside the range can be dropped
+    size_t page = page_size();
+    size_t begin = (offset + page - 1) / page * page;
+    size_t end = (offset + length) / page * page;
+    if (end <= begin) {
+        return;
+    }
+
+#ifdef _WIN32
+    VirtualUnlock(const_cast<char*>(data_) + begin, end - begin);
+#else
+    madvise(const_cast<char*>(data_) + begin, end - begin, MADV_DONTNEED);
+#endif
+}
+
+// MappedReadahead implementation
+void MappedReadahead::advance(const MappedFile& file, size_t offset) {
+    if (offset < next_window_) {
+        return;
+    }
+
+    // Keep two windows in flight ahead of the reader, one under memory pressure
+    bool pressure = MemoryGovernor::instance().should_spill();
+    size_t window_start = offset - offset % window_;
+    size_t ahead = pressure ? window_ : 2 * window_;
+    file.prefetch(window_start, ahead);
+    next_window_ = window_start + window_;
+
+    // Drop everything older than one window behind the reader (all of it
+    // under pressure)
+    size_t behind = pressure ? 0 : window_;
+    if (window_start > released_ + behind) {
+        size_t release_end = window_start - behind;
+        file.release(released_, release_end - released_);
+        released_ = release_end;
+    }
+
+    size_t held_end = std::min(file.size(), window_start + ahead);
+    charge_.set(held_end > released_ ? held_end - released_ : 0);
+}
+
+} // namespace daf
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "daf_types.h"
+#include "memory_governor.h"
+#include <string>
+#include <cstddef>
+
+namespace daf {
+
+// Read-only memory mapping of a whole file.
+// Records handed out from data() point straight into the page cache, so
+// readers can walk multi-GB inputs without copying them into user buffers.
+class MappedFile {
+public:
+    enum class Access {
+        SEQUENTIAL = 0,  // Aggressive readahead, pages dropped behind the reader
+        RANDOM = 1
+    };
+
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const std::string& path, Access access = Access::SEQUENTIAL);
+    void close();
+
+    bool is_open() const { return open_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    // Hint the kernel to start reading [offset, offset + length) now
+    void prefetch(size_t offset, size_t length) const;
+
+    // Drop already consumed pages from our working set
+    void release(size_t offset, size_t length) const;
+
+private:
+    void move_from(MappedFile& other) noexcept;
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool open_ = false;
+#ifdef _WIN32
+    void* file_handle_ = nullptr;
+    void* mapping_handle_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
+
+// Keeps the kernel one window ahead of a sequential reader over a MappedFile.
+// The pages between the release point and the end of the readahead are
+// charged to MemoryPool::INPUT; while the governor asks for spills the
+// reader only keeps one window in flight and drops pages right behind it.
+class MappedReadahead {
+public:
+    explicit MappedReadahead(size_t window = 4 * DEFAULT_BUFFER_SIZE) : window_(window) {}
+
+    void reset() { next_window_ = 0; released_ = 0; charge_.set(0); }
+
+    // Called with the reader's current offset; issues hints at window boundaries
+    void advance(const MappedFile& file, size_t offset);
+
+private:
+    size_t window_;
+    size_t next_window_ = 0;
+    size_t released_ = 0;
+    MemoryCharge charge_{MemoryPool::INPUT};
+};
+
+} // namespace daf
@@ -0,0 +1,87 @@
+#include "memory_governor.h"
+#include "daf_utils.h"
+#include <algorithm>
+#include <thread>
+
+namespace daf {
+
+namespace {
+
+constexpr std::chrono::milliseconds HEADROOM_POLL_INTERVAL{10};
+
+int64_t steady_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+MemoryGovernor::MemoryGovernor() : budget_(MAX_MEMORY_MB * 1024 * 1024) {
+    for (auto& pool : pools_) {
+        pool.store(0, std::memory_order_relaxed);
+    }
+}
+
+MemoryGovernor& MemoryGovernor::instance() {
+    static MemoryGovernor governor;
+    return governor;
+}
+
+size_t MemoryGovernor::pool_bytes(MemoryPool pool) const {
+    // Releases can land before the matching charge on another thread
+    int64_t bytes = pools_[static_cast<size_t>(pool)].load(std::memory_order_relaxed);
+    return bytes > 0 ? static_cast<size_t>(bytes) : 0;
+}
+
+size_t MemoryGovernor::accounted_bytes() const {
+    int64_t total = 0;
+    for (const auto& pool : pools_) {
+        total += pool.load(std::memory_order_relaxed);
+    }
+    return total > 0 ? static_cast<size_t>(total) : 0;
+}
+
+size_t MemoryGovernor::rss_bytes() {
+    // Racing samplers both read /proc; either result is fresh enough
+    int64_t now = steady_ms();
+    if (now - rss_sampled_ms_.load(std::memory_order_relaxed) >= RSS_SAMPLE_INTERVAL.count()) {
+        rss_sampled_ms_.store(now, std::memory_order_relaxed);
+        rss_bytes_.store(Utils::get_resident_memory_bytes(), std::memory_order_relaxed);
+    }
+    return rss_bytes_.load(std::memory_order_relaxed);
+}
+
+bool MemoryGovernor::over_budget() {
+    return std::max(accounted_bytes(), rss_bytes()) > budget();
+}
+
+bool MemoryGovernor::wait_for_headroom(std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (accounted_bytes() > budget()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(HEADROOM_POLL_INTERVAL);
+    }
+    return true;
+}
+
+// MemoryCharge implementation
+MemoryCharge& MemoryCharge::operator=(MemoryCharge&& other) noexcept {
+    if (this != &other) {
+        set(0);
+        pool_ = other.pool_;
+        bytes_ = other.bytes_;
+        other.bytes_ = 0;
+    }
+    return *this;
+}
+
+void MemoryCharge::set(size_t bytes) {
+    if (bytes != bytes_) {
+        MemoryGovernor::instance().charge(pool_, static_cast<int64_t>(bytes) - static_cast<int64_t>(bytes_));
+        bytes_ = bytes;
+    }
+}
+
+} // namespace daf
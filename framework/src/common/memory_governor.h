@@ -0,0 +1,98 @@
+#pragma once
+
+#include "daf_types.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace daf {
+
+// Process-wide memory accounting for the MAX_MEMORY_MB budget
+//
+// The big consumers of a worker charge what they hold to a pool: shuffle
+// buffers their arena chunks and index, task arenas their blocks, and
+// sequential readers the input pages they keep mapped ahead of (and just
+// behind) themselves. Charges are relaxed atomic adds, made when memory is
+// actually taken from or given back to the heap, never per record.
+//
+// The governor answers three questions from that:
+//   should_spill()        accounted bytes are past the soft limit: shuffle
+//                         buffers spill and give their chunks back, readers
+//                         stop reading ahead
+//   wait_for_headroom()   accounted bytes are past the budget: map sub-splits
+//                         hold off reading more input for a while
+//   over_budget()         the larger of accounted bytes and the live RSS is
+//                         past the budget: the worker takes no new tasks
+// Only admission looks at the RSS, which sees everything else (plugins,
+// stacks, memory the allocator keeps after a free). Spills and waits go by
+// what is accounted, which drops as soon as a buffer spills, so a heap that
+// never shrinks cannot make every buffer spill tiny runs or stall readers.
+enum class MemoryPool : size_t {
+    SHUFFLE = 0,   // Shuffle buffer arenas and indexes
+    ARENA,         // Task arena blocks, including the ones cached between tasks
+    INPUT,         // Input pages held by sequential readers
+    COUNT
+};
+
+class MemoryGovernor {
+public:
+    static constexpr size_t SOFT_LIMIT_PERCENT = 80;
+    static constexpr std::chrono::milliseconds RSS_SAMPLE_INTERVAL{100};
+
+    static MemoryGovernor& instance();
+
+    void set_budget(size_t bytes) { budget_.store(bytes, std::memory_order_relaxed); }
+    size_t budget() const { return budget_.load(std::memory_order_relaxed); }
+    size_t soft_limit() const { return budget() / 100 * SOFT_LIMIT_PERCENT; }
+
+    // Negative charges give memory back
+    void charge(MemoryPool pool, int64_t bytes) {
+        pools_[static_cast<size_t>(pool)].fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    size_t pool_bytes(MemoryPool pool) const;
+    size_t accounted_bytes() const;
+
+    // Resident set size, re-read at most every RSS_SAMPLE_INTERVAL
+    size_t rss_bytes();
+
+    bool should_spill() const { return accounted_bytes() > soft_limit(); }
+    bool over_budget();
+
+    // Waits while accounted bytes are over budget, up to timeout; false if
+    // they still are
+    bool wait_for_headroom(std::chrono::milliseconds timeout);
+
+private:
+    MemoryGovernor();
+
+    std::array<std::atomic<int64_t>, static_cast<size_t>(MemoryPool::COUNT)> pools_;
+    std::atomic<size_t> budget_;
+    std::atomic<size_t> rss_bytes_{0};
+    std::atomic<int64_t> rss_sampled_ms_{0};
+};
+
+// Bytes one owner holds in a pool; set() charges the difference and the
+// destructor gives everything back. Move-only, so a charge is never
+// released twice.
+class MemoryCharge {
+public:
+    explicit MemoryCharge(MemoryPool pool) : pool_(pool) {}
+    ~MemoryCharge() { set(0); }
+
+    MemoryCharge(const MemoryCharge&) = delete;
+    MemoryCharge& operator=(const MemoryCharge&) = delete;
+    MemoryCharge(MemoryCharge&& other) noexcept : pool_(other.pool_), bytes_(other.bytes_) { other.bytes_ = 0; }
+    MemoryCharge& operator=(MemoryCharge&& other) noexcept;
+
+    void set(size_t bytes);
+    size_t bytes() const { return bytes_; }
+
+private:
+    MemoryPool pool_;
+    size_t bytes_ = 0;
+};
+
+} // namespace daf
@@ -0,0 +1,279 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace daf {
+
+namespace {
+
+struct MetricInfo {
+    const char* name;
+    const char* help;
+};
+
+// Indexed by Stage
+const MetricInfo STAGE_INFO[] = {
+    {"daf_map_parse_seconds", "Time to read one map input record or sample batch (sampled)"},
+    {"daf_map_emit_seconds", "Time of one map emit into the shuffle buffer (sampled)"},
+    {"daf_spill_seconds", "Time to sort and write one spill or map output run"},
+    {"daf_shuffle_fetch_seconds", "Time to fetch one map output segment"},
+    {"daf_reduce_seconds", "Time to reduce one key group"},
+    {"daf_redis_round_trip_seconds", "Latency of one Redis command or pipeline"},
+    {"daf_http_request_seconds", "Latency of one coordinator HTTP handler"},
+};
+static_assert(sizeof(STAGE_INFO) / sizeof(STAGE_INFO[0]) == static_cast<size_t>(Stage::COUNT),
+              "every stage needs a name");
+
+// Indexed by CounterId
+const MetricInfo COUNTER_INFO[] = {
+    {"daf_map_records_read_total", "Map input records and sample batches read"},
+    {"daf_map_records_emitted_total", "Key/value pairs emitted by map functions"},
+    {"daf_spilled_bytes_total", "Bytes written to spills and map output runs"},
+    {"daf_shuffle_fetched_bytes_total", "Map output bytes fetched from other workers"},
+    {"daf_reduce_keys_total", "Key groups reduced"},
+    {"daf_redis_errors_total", "Failed Redis operations"},
+    {"daf_tasks_completed_total", "Tasks that completed"},
+    {"daf_tasks_failed_total", "Tasks that failed"},
+};
+static_assert(sizeof(COUNTER_INFO) / sizeof(COUNTER_INFO[0]) == static_cast<size_t>(CounterId::COUNT),
+              "every counter needs a name");
+
+constexpr size_t EXPORTED_BUCKETS = HISTOGRAM_BOUNDS_SECONDS.size() + 1;
+
+size_t shard_index() {
+    static std::atomic<size_t> next_shard{0};
+    thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    return shard;
+}
+
+// Exported bucket of every internal bucket
+const std::array<uint8_t, HISTOGRAM_BUCKETS>& exported_bucket_of() {
+    static const std::array<uint8_t, HISTOGRAM_BUCKETS> table = []() {
+        std::array<uint8_t, HISTOGRAM_BUCKETS> mapping{};
+        for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+            double upper_seconds = static_cast<double>(Histogram::bucket_upper_ns(i)) / 1e9;
+            size_t bound = 0;
+            while (bound < HISTOGRAM_BOUNDS_SECONDS.size() && HISTOGRAM_BOUNDS_SECONDS[bound] < upper_seconds) {
+                bound++;
+            }
+            mapping[i] = static_cast<uint8_t>(bound);
+        }
+        return mapping;
+    }();
+    return table;
+}
+
+std::string escape_label(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+std::string format_bound(double seconds) {
+    std::ostringstream out;
+    out << seconds;
+    return out.str();
+}
+
+} // namespace
+
+// Counter implementation
+void Counter::add(uint64_t value) {
+    shards_[shard_index()].value.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+// Histogram implementation
+size_t Histogram::bucket_index(uint64_t nanoseconds) {
+    if (nanoseconds < HISTOGRAM_SUB_BUCKETS) {
+        return static_cast<size_t>(nanoseconds);
+    }
+    size_t power = 63 - static_cast<size_t>(__builtin_clzll(nanoseconds));
+    size_t sub = static_cast<size_t>(nanoseconds >> (power - 3)) & (HISTOGRAM_SUB_BUCKETS - 1);
+    size_t index = (power - 2) * HISTOGRAM_SUB_BUCKETS + sub;
+    return index < HISTOGRAM_BUCKETS ? index : HISTOGRAM_BUCKETS - 1;
+}
+
+uint64_t Histogram::bucket_upper_ns(size_t index) {
+    if (index < HISTOGRAM_SUB_BUCKETS) {
+        return index;
+    }
+    size_t power = index / HISTOGRAM_SUB_BUCKETS + 2;
+    uint64_t sub = index % HISTOGRAM_SUB_BUCKETS;
+    return ((HISTOGRAM_SUB_BUCKETS + sub + 1) << (power - 3)) - 1;
+}
+
+void Histogram::record_ns(uint64_t nanoseconds) {
+    Shard& shard = shards_[shard_index()];
+    shard.buckets[bucket_index(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    shard.count.fetch_add(1, std::memory_order_relaxed);
+    shard.sum_ns.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+void Histogram::record(std::chrono::steady_clock::duration elapsed) {
+    auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    record_ns(nanoseconds > 0 ? static_cast<uint64_t>(nanoseconds) : 0);
+}
+
+std::vector<uint64_t> Histogram::bucket_counts() const {
+    const auto& exported = exported_bucket_of();
+    std::vector<uint64_t> counts(EXPORTED_BUCKETS, 0);
+    for (const auto& shard : shards_) {
+        for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+            counts[exported[i]] += shard.buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+    return counts;
+}
+
+uint64_t Histogram::count() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t Histogram::sum_ns() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.sum_ns.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+// MetricsSnapshot implementation
+std::string MetricsSnapshot::encode() const {
+    // "1 <counters> c... <histograms> (<buckets> b... count sum)..."
+    std::ostringstream out;
+    out << 1 << ' ' << counters.size();
+    for (uint64_t value : counters) {
+        out << ' ' << value;
+    }
+    out << ' ' << histograms.size();
+    for (size_t i = 0; i < histograms.size(); ++i) {
+        out << ' ' << histograms[i].size();
+        for (uint64_t value : histograms[i]) {
+            out << ' ' << value;
+        }
+        out << ' ' << histogram_counts[i] << ' ' << histogram_sums_ns[i];
+    }
+    return out.str();
+}
+
+bool MetricsSnapshot::decode(const std::string& encoded, MetricsSnapshot& snapshot) {
+    std::istringstream in(encoded);
+    size_t version = 0, counters = 0, histograms = 0;
+    if (!(in >> version >> counters) || version != 1 ||
+        counters != static_cast<size_t>(CounterId::COUNT)) {
+        return false;
+    }
+
+    snapshot.counters.assign(counters, 0);
+    for (auto& value : snapshot.counters) {
+        in >> value;
+    }
+    if (!(in >> histograms) || histograms != static_cast<size_t>(Stage::COUNT)) {
+        return false;
+    }
+
+    snapshot.histograms.assign(histograms, {});
+    snapshot.histogram_counts.assign(histograms, 0);
+    snapshot.histogram_sums_ns.assign(histograms, 0);
+    for (size_t i = 0; i < histograms; ++i) {
+        size_t buckets = 0;
+        if (!(in >> buckets) || buckets != EXPORTED_BUCKETS) {
+            return false;
+        }
+        snapshot.histograms[i].assign(buckets, 0);
+        for (auto& value : snapshot.histograms[i]) {
+            in >> value;
+        }
+        in >> snapshot.histogram_counts[i] >> snapshot.histogram_sums_ns[i];
+    }
+    return !in.fail();
+}
+
+// Metrics implementation
+Counter& Metrics::counter(CounterId id) {
+    static std::array<Counter, static_cast<size_t>(CounterId::COUNT)> counters;
+    return counters[static_cast<size_t>(id)];
+}
+
+Histogram& Metrics::stage(Stage stage) {
+    static std::array<Histogram, static_cast<size_t>(Stage::COUNT)> histograms;
+    return histograms[static_cast<size_t>(stage)];
+}
+
+MetricsSnapshot Metrics::snapshot() {
+    MetricsSnapshot snapshot;
+    for (size_t i = 0; i < static_cast<size_t>(CounterId::COUNT); ++i) {
+        snapshot.counters.push_back(counter(static_cast<CounterId>(i)).value());
+    }
+    for (size_t i = 0; i < static_cast<size_t>(Stage::COUNT); ++i) {
+        const Histogram& histogram = stage(static_cast<Stage>(i));
+        snapshot.histograms.push_back(histogram.bucket_counts());
+        snapshot.histogram_counts.push_back(histogram.count());
+        snapshot.histogram_sums_ns.push_back(histogram.sum_ns());
+    }
+    return snapshot;
+}
+
+std::string Metrics::render_prometheus(
+    const std::vector<std::pair<std::pair<std::string, std::string>, MetricsSnapshot>>& sources) {
+    std::ostringstream out;
+    auto label = [](const std::pair<std::string, std::string>& source) {
+        return source.first + "=\"" + escape_label(source.second) + "\"";
+    };
+
+    for (size_t i = 0; i < static_cast<size_t>(CounterId::COUNT); ++i) {
+        out << "# HELP " << COUNTER_INFO[i].name << ' ' << COUNTER_INFO[i].help << '\n'
+            << "# TYPE " << COUNTER_INFO[i].name << " counter\n";
+        for (const auto& source : sources) {
+            out << COUNTER_INFO[i].name << '{' << label(source.first) << "} "
+                << source.second.counters[i] << '\n';
+        }
+    }
+
+    for (size_t i = 0; i < static_cast<size_t>(Stage::COUNT); ++i) {
+        const char* name = STAGE_INFO[i].name;
+        out << "# HELP " << name << ' ' << STAGE_INFO[i].help << '\n'
+            << "# TYPE " << name << " histogram\n";
+        for (const auto& source : sources) {
+            std::string labels = label(source.first);
+            const auto& buckets = source.second.histograms[i];
+            uint64_t cumulative = 0;
+            for (size_t bound = 0; bound < HISTOGRAM_BOUNDS_SECONDS.size(); ++bound) {
+                cumulative += buckets[bound];
+                out << name << "_bucket{" << labels << ",le=\""
+                    << format_bound(HISTOGRAM_BOUNDS_SECONDS[bound]) << "\"} " << cumulative << '\n';
+            }
+            // Shards are read one after another, so keep +Inf and _count consistent
+            uint64_t total = std::max(cumulative + buckets.back(), source.second.histogram_counts[i]);
+            out << name << "_bucket{" << labels << ",le=\"+Inf\"} " << total << '\n'
+                << name << "_sum{" << labels << "} "
+                << static_cast<double>(source.second.histogram_sums_ns[i]) / 1e9 << '\n'
+                << name << "_count{" << labels << "} " << total << '\n';
+        }
+    }
+    return out.str();
+}
+
+} // namespace daf
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace daf {
+
+// Process-wide counters and latency histograms
+//
+// Every metric is sharded: a thread always records into the same shard,
+// with a relaxed atomic add on memory other threads rarely touch, and
+// readers sum the shards. Histograms keep HDR-style log-linear buckets over
+// nanoseconds (8 sub-buckets per power of two, under 12.5% relative
+// error). Snapshots reduce them to the fixed Prometheus bounds below, so a
+// snapshot is small enough to ship with a worker heartbeat.
+constexpr size_t METRIC_SHARDS = 16;
+constexpr size_t HISTOGRAM_SUB_BUCKETS = 8;
+constexpr size_t HISTOGRAM_BUCKETS = 41 * HISTOGRAM_SUB_BUCKETS;   // Up to 2^43 ns, about 2.4 hours
+
+// Upper bounds of the exported buckets, in seconds (+Inf is implied)
+constexpr std::array<double, 18> HISTOGRAM_BOUNDS_SECONDS = {
+    0.00001, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+    0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 10.0, 60.0, 600.0
+};
+
+enum class Stage : size_t {
+    MAP_PARSE = 0,       // Reading one input record or sample batch (sampled)
+    MAP_EMIT,            // One emit into the shuffle buffer (sampled)
+    SPILL,               // Sorting and writing one spill or map output run
+    SHUFFLE_FETCH,       // Fetching one map output segment from a worker
+    REDUCE,              // Reducing one key group
+    REDIS_ROUND_TRIP,    // One Redis command or pipeline
+    HTTP_REQUEST,        // One coordinator HTTP request, until its reply
+    COUNT
+};
+
+enum class CounterId : size_t {
+    MAP_RECORDS_READ = 0,
+    MAP_RECORDS_EMITTED,
+    SPILLED_BYTES,
+    SHUFFLE_FETCHED_BYTES,
+    REDUCE_KEYS,
+    REDIS_ERRORS,
+    TASKS_COMPLETED,
+    TASKS_FAILED,
+    COUNT
+};
+
+class Counter {
+public:
+    void add(uint64_t value = 1);
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Shard, METRIC_SHARDS> shards_;
+};
+
+class Histogram {
+public:
+    void record_ns(uint64_t nanoseconds);
+    void record(std::chrono::steady_clock::duration elapsed);
+
+    // Counts per exported bound (not cumulative, the last one is +Inf)
+    std::vector<uint64_t> bucket_counts() const;
+    uint64_t count() const;
+    uint64_t sum_ns() const;
+
+    static size_t bucket_index(uint64_t nanoseconds);
+    static uint64_t bucket_upper_ns(size_t index);
+
+private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS> buckets{};
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sum_ns{0};
+    };
+    std::array<Shard, METRIC_SHARDS> shards_;
+};
+
+// Point-in-time copy of one process's metrics
+struct MetricsSnapshot {
+    std::vector<uint64_t> counters;                    // By CounterId
+    std::vector<std::vector<uint64_t>> histograms;     // By Stage, counts per exported bound
+    std::vector<uint64_t> histogram_counts;
+    std::vector<uint64_t> histogram_sums_ns;
+
+    // Compact single-line form for worker heartbeats
+    std::string encode() const;
+    static bool decode(const std::string& encoded, MetricsSnapshot& snapshot);
+};
+
+class Metrics {
+public:
+    static Counter& counter(CounterId id);
+    static Histogram& stage(Stage stage);
+
+    static MetricsSnapshot snapshot();
+
+    // Prometheus text exposition of several processes' snapshots, each
+    // sample labelled with its source (e.g. {"process", "coordinator"})
+    static std::string render_prometheus(
+        const std::vector<std::pair<std::pair<std::string, std::string>, MetricsSnapshot>>& sources);
+};
+
+// Records the scope's duration into a stage histogram; inactive timers
+// (e.g. unsampled calls) do not read the clock
+class ScopedStageTimer {
+public:
+    explicit ScopedStageTimer(Stage stage, bool active = true)
+        : histogram_(active ? &Metrics::stage(stage) : nullptr),
+          start_(active ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point()) {}
+    ~ScopedStageTimer() {
+        if (histogram_) {
+            histogram_->record(std::chrono::steady_clock::now() - start_);
+        }
+    }
+
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+    Histogram* histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Per-call hot paths time one call in METRIC_SAMPLE_INTERVAL
+constexpr uint32_t METRIC_SAMPLE_INTERVAL = 64;
+
+} // namespace daf
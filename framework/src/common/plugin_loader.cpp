@@ -6,19 +6,59 @@
 
 namespace daf {
 
+namespace {
+
+// Resolved when a library is loaded so tasks never go through dlsym
+const char* const ENTRY_POINTS[] = {"MapMain", "CombineMain", "ReduceMain"};
+
+// Instances created by getPlugin(PER_THREAD), keyed by plugin name
+struct ThreadInstance {
+    uint64_t generation;
+    std::shared_ptr<IPlugin> instance;
+};
+thread_local std::unordered_map<std::string, ThreadInstance> thread_instances;
+
+} // namespace
+
 PluginLoader& PluginLoader::getInstance() {
     static PluginLoader instance;
     return instance;
 }
 
+PluginLoader::PluginLoader() : plugins_(std::make_shared<const PluginTable>()) {
+}
+
 PluginLoader::~PluginLoader() {
     shutdown();
 }
 
-bool PluginLoader::loadPlugin(const std::string& pluginPath, const std::string& pluginName) {
+std::shared_ptr<const PluginLoader::PluginTable> PluginLoader::snapshot() const {
+#ifdef __cpp_lib_atomic_shared_ptr
+    return plugins_.load(std::memory_order_acquire);
+#else
+    return std::atomic_load_explicit(&plugins_, std::memory_order_acquire);
+#endif
+}
+
+std::shared_ptr<const PluginLoader::PluginInfo> PluginLoader::find(const std::string& pluginName) const {
+    auto table = snapshot();
+    auto it = table->find(pluginName);
+    return it != table->end() ? it->second : nullptr;
+}
+
+void PluginLoader::publish(std::shared_ptr<const PluginTable> table) {
+#ifdef __cpp_lib_atomic_shared_ptr
+    plugins_.store(std::move(table), std::memory_order_release);
+#else
+    std::atomic_store_explicit(&plugins_, std::move(table), std::memory_order_release);
+#endif
+}
+
+bool PluginLoader::loadPlugin(const std::string& pluginPath, const std::string& pluginName,
+                              const std::string& config) {
     std::lock_guard<std::mutex> lock(pluginsMutex_);
     
-    if (plugins_.find(pluginName) != plugins_.end()) {
+    if (find(pluginName)) {
         std::cout << "Plugin " << pluginName << " already loaded" << std::endl;
         return true;
     }
@@ -34,6 +74,7 @@ bool PluginLoader::loadPlugin(const std::string& pluginPath, const std::string&
         std::cerr << "Cannot load plugin " << pluginPath << ": " << dlerror() << std::endl;
         return false;
     }
+    std::shared_ptr<void> library(handle, dlclose);
     
     // Clear any existing error
     dlerror();
@@ -45,7 +86,6 @@ bool PluginLoader::loadPlugin(const std::string& pluginPath, const std::string&
     const char* dlsym_error = dlerror();
     if (dlsym_error) {
         std::cerr << "Cannot load symbol createPlugin: " << dlsym_error << std::endl;
-        dlclose(handle);
         return false;
     }
     
@@ -56,45 +96,134 @@ bool PluginLoader::loadPlugin(const std::string& pluginPath, const std::string&
     dlsym_error = dlerror();
     if (dlsym_error) {
         std::cerr << "Cannot load symbol destroyPlugin: " << dlsym_error << std::endl;
-        dlclose(handle);
         return false;
     }
     
+    // Optional: plugins built before the streaming ABI do not export it.
+    // They run through process(), whose TaskData / TaskResult layout is frozen.
+    typedef int (*getPluginAbiVersion_t)();
+    getPluginAbiVersion_t getPluginAbiVersion =
+        (getPluginAbiVersion_t) dlsym(handle, "getPluginAbiVersion");
+    dlerror();
+    int abiVersion = getPluginAbiVersion ? getPluginAbiVersion() : PLUGIN_ABI_VERSION;
+    
+    // Every instance keeps the library loaded until it is destroyed
+    PluginFactoryFunc factory = [createPlugin, destroyPlugin, library]() {
+        IPlugin* raw = createPlugin();
+        if (!raw) {
+            return std::shared_ptr<IPlugin>();
+        }
+        return std::shared_ptr<IPlugin>(raw, [destroyPlugin, library](IPlugin* plugin) {
+            destroyPlugin(plugin);
+        });
+    };
+    
     // Create plugin instance
-    std::shared_ptr<IPlugin> plugin(createPlugin(), destroyPlugin);
+    std::shared_ptr<IPlugin> plugin = factory();
     if (!plugin) {
         std::cerr << "Failed to create plugin instance" << std::endl;
-        dlclose(handle);
+        return false;
+    }
+    if (!plugin->initialize(config)) {
+        std::cerr << "Failed to initialize plugin: " << pluginName << std::endl;
         return false;
     }
     
     // Store plugin info
-    PluginInfo info;
-    info.instance = plugin;
-    info.libraryHandle = handle;
-    info.factory = nullptr;
+    auto info = std::make_shared<PluginInfo>();
+    info->instance = plugin;
+    info->library = library;
+    info->factory = factory;
+    info->config = config;
+    info->abiVersion = abiVersion;
+    info->generation = nextGeneration_++;
+    for (const char* entry : ENTRY_POINTS) {
+        void* symbol = dlsym(handle, entry);
+        if (!dlerror() && symbol) {
+            info->symbols[entry] = symbol;
+        }
+    }
     
-    plugins_[pluginName] = std::move(info);
+    auto table = std::make_shared<PluginTable>(*snapshot());
+    (*table)[pluginName] = std::move(info);
+    publish(std::move(table));
     
-    std::cout << "Successfully loaded plugin: " << pluginName << std::endl;
+    std::cout << "Successfully loaded plugin: " << pluginName << " (ABI v" << abiVersion << ")" << std::endl;
     return true;
 }
 
-std::shared_ptr<IPlugin> PluginLoader::getPlugin(const std::string& pluginName) {
-    std::lock_guard<std::mutex> lock(pluginsMutex_);
-    
-    auto it = plugins_.find(pluginName);
-    if (it != plugins_.end()) {
+bool PluginLoader::isLoaded(const std::string& pluginName) const {
+    return find(pluginName) != nullptr;
+}
+
+std::shared_ptr<IPlugin> PluginLoader::threadInstance(const std::shared_ptr<const PluginInfo>& info,
+                                                      const std::string& pluginName) {
+    auto it = thread_instances.find(pluginName);
+    if (it != thread_instances.end() && it->second.generation == info->generation) {
         return it->second.instance;
     }
     
-    return nullptr;
+    // First use on this thread, or the plugin was reloaded since
+    std::shared_ptr<IPlugin> created = info->factory();
+    if (!created || !created->initialize(info->config)) {
+        std::cerr << "Failed to create thread instance of plugin: " << pluginName << std::endl;
+        return nullptr;
+    }
+    std::shared_ptr<IPlugin> instance(created.get(), [created](IPlugin* plugin) {
+        plugin->shutdown();
+    });
+    thread_instances[pluginName] = ThreadInstance{info->generation, instance};
+    return instance;
+}
+
+std::shared_ptr<IPlugin> PluginLoader::getPlugin(const std::string& pluginName, PluginInstance mode) {
+    auto info = find(pluginName);
+    if (!info) {
+        return nullptr;
+    }
+    if (mode == PluginInstance::PER_THREAD && info->factory) {
+        return threadInstance(info, pluginName);
+    }
+    return info->instance;
+}
+
+std::shared_ptr<IStreamingPlugin> PluginLoader::getStreamingPlugin(const std::string& pluginName,
+                                                                   PluginInstance mode) {
+    auto info = find(pluginName);
+    if (!info || info->abiVersion < STREAMING_PLUGIN_ABI_VERSION) {
+        return nullptr;
+    }
+    
+    // REGISTER_STREAMING_PLUGIN only accepts IStreamingPlugin classes
+    return std::static_pointer_cast<IStreamingPlugin>(getPlugin(pluginName, mode));
+}
+
+void* PluginLoader::getSymbol(const std::string& pluginName, const std::string& symbolName) {
+    auto info = find(pluginName);
+    if (!info || !info->library) {
+        return nullptr;
+    }
+    
+    auto cached = info->symbols.find(symbolName);
+    if (cached != info->symbols.end()) {
+        return cached->second;
+    }
+    for (const char* entry : ENTRY_POINTS) {
+        if (symbolName == entry) {
+            return nullptr; // Looked up at load time, the plugin does not export it
+        }
+    }
+    
+    // Clear any existing error; a missing symbol is not an error for optional entry points
+    dlerror();
+    void* symbol = dlsym(info->library.get(), symbolName.c_str());
+    return dlerror() ? nullptr : symbol;
 }
 
 bool PluginLoader::registerPlugin(const std::string& pluginName, PluginFactoryFunc factory) {
     std::lock_guard<std::mutex> lock(pluginsMutex_);
     
-    if (plugins_.find(pluginName) != plugins_.end()) {
+    if (find(pluginName)) {
         std::cout << "Plugin " << pluginName << " already registered" << std::endl;
         return true;
     }
@@ -107,22 +236,26 @@ bool PluginLoader::registerPlugin(const std::string& pluginName, PluginFactoryFu
     }
     
     // Store plugin info
-    PluginInfo info;
-    info.instance = plugin;
-    info.libraryHandle = nullptr;
-    info.factory = factory;
+    auto info = std::make_shared<PluginInfo>();
+    info->instance = plugin;
+    info->factory = factory;
+    info->abiVersion = std::dynamic_pointer_cast<IStreamingPlugin>(plugin) ?
+        STREAMING_PLUGIN_ABI_VERSION : PLUGIN_ABI_VERSION;
+    info->generation = nextGeneration_++;
     
-    plugins_[pluginName] = std::move(info);
+    auto table = std::make_shared<PluginTable>(*snapshot());
+    (*table)[pluginName] = std::move(info);
+    publish(std::move(table));
     
     std::cout << "Successfully registered plugin: " << pluginName << std::endl;
     return true;
 }
 
 std::vector<std::string> PluginLoader::getLoadedPlugins() const {
-    std::lock_guard<std::mutex> lock(pluginsMutex_);
+    auto table = snapshot();
     
     std::vector<std::string> pluginNames;
-    for (const auto& pair : plugins_) {
+    for (const auto& pair : *table) {
         pluginNames.push_back(pair.first);
     }
     
@@ -132,23 +265,21 @@ std::vector<std::string> PluginLoader::getLoadedPlugins() const {
 bool PluginLoader::unloadPlugin(const std::string& pluginName) {
     std::lock_guard<std::mutex> lock(pluginsMutex_);
     
-    auto it = plugins_.find(pluginName);
-    if (it == plugins_.end()) {
+    auto info = find(pluginName);
+    if (!info) {
         return false;
     }
     
-    // Shutdown plugin if it exists
-    if (it->second.instance) {
-        it->second.instance->shutdown();
-        it->second.instance.reset();
-    }
+    auto table = std::make_shared<PluginTable>(*snapshot());
+    table->erase(pluginName);
+    publish(std::move(table));
     
-    // Close library handle if it was dynamically loaded
-    if (it->second.libraryHandle) {
-        dlclose(it->second.libraryHandle);
+    // Shutdown the shared instance; the library closes with its last instance
+    if (info->instance) {
+        info->instance->shutdown();
     }
+    thread_instances.erase(pluginName);
     
-    plugins_.erase(it);
     std::cout << "Successfully unloaded plugin: " << pluginName << std::endl;
     return true;
 }
@@ -156,19 +287,16 @@ bool PluginLoader::unloadPlugin(const std::string& pluginName) {
 void PluginLoader::shutdown() {
     std::lock_guard<std::mutex> lock(pluginsMutex_);
     
-    for (auto& pair : plugins_) {
-        if (pair.second.instance) {
-            pair.second.instance->shutdown();
-            pair.second.instance.reset();
-        }
-        
-        if (pair.second.libraryHandle) {
-            dlclose(pair.second.libraryHandle);
+    auto table = snapshot();
+    publish(std::make_shared<const PluginTable>());
+    
+    for (const auto& pair : *table) {
+        if (pair.second->instance) {
+            pair.second->instance->shutdown();
         }
     }
     
-    plugins_.clear();
     std::cout << "All plugins shut down" << std::endl;
 }
 
-}
\ No newline at end of file
+}
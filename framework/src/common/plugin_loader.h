@@ -2,10 +2,15 @@
 
 #include <string>
 #include <memory>
+#include <atomic>
 #include <unordered_map>
 #include <functional>
 #include <vector>
 #include <mutex>
+#include <map>
+#include <string_view>
+#include <cstdint>
+#include <type_traits>
 #include "daf_types.h"
 
 namespace daf {
@@ -20,19 +25,80 @@ namespace daf {
         virtual std::string getVersion() const = 0;
     };
 
+    // Zero-copy plugin ABI
+    //
+    // Version 1 plugins fill TaskResult::output_data, which the worker then
+    // writes out. Version 2 plugins get the task's input split as a read-only
+    // view of the mapped file and write their output through a sink that goes
+    // straight to the task's output file, so neither side holds a full copy.
+    // A plugin opts in by deriving from IStreamingPlugin and registering with
+    // REGISTER_STREAMING_PLUGIN; version 1 plugins keep loading unchanged.
+    constexpr int PLUGIN_ABI_VERSION = 1;
+    constexpr int STREAMING_PLUGIN_ABI_VERSION = 2;
+
+    // Valid only for the duration of processStream()
+    struct TaskInput {
+        std::string_view taskId;
+        std::string_view dataType;
+        std::string_view inputPath;
+        const uint8_t* data;    // The input split, nullptr when there is none
+        size_t size;
+        const std::map<std::string, std::string>& parameters;
+    };
+
+    class TaskOutput {
+    public:
+        virtual ~TaskOutput() = default;
+        // Appends to the task output; false once the sink has failed
+        virtual bool write(const void* data, size_t size) = 0;
+        virtual uint64_t bytesWritten() const = 0;
+        virtual void setError(const std::string& message) = 0;
+    };
+
+    class IStreamingPlugin : public IPlugin {
+    public:
+        virtual bool processStream(const TaskInput& input, TaskOutput& output) = 0;
+    };
+
     // Plugin factory function type
     using PluginFactoryFunc = std::function<std::shared_ptr<IPlugin>()>;
 
+    // Which instance getPlugin() hands out
+    enum class PluginInstance {
+        SHARED = 0,      // One instance for every thread
+        PER_THREAD = 1   // Each calling thread gets, and keeps, its own instance
+    };
+
     // Plugin loader class
+    //
+    // Lookups never take the loader mutex: loaded plugins live in an
+    // immutable table that load/register/unload replace wholesale, so the
+    // per-task path is a snapshot of the table pointer and a hash lookup.
+    // The snapshot is std::atomic<std::shared_ptr> where the library has it
+    // (C++20), else the deprecated std::atomic_load. libstdc++ guards the
+    // pointer copy with a short internal lock in both, so readers take no
+    // plugin-loader lock but are not strictly lock-free. The usual entry
+    // points (MapMain, CombineMain, ReduceMain) are resolved once at load.
     class PluginLoader {
     public:
         static PluginLoader& getInstance();
         
-        // Load plugin from shared library
-        bool loadPlugin(const std::string& pluginPath, const std::string& pluginName);
+        // Load plugin from shared library and initialize it with config
+        bool loadPlugin(const std::string& pluginPath, const std::string& pluginName,
+                        const std::string& config = "");
+        
+        bool isLoaded(const std::string& pluginName) const;
         
         // Get plugin instance
-        std::shared_ptr<IPlugin> getPlugin(const std::string& pluginName);
+        std::shared_ptr<IPlugin> getPlugin(const std::string& pluginName,
+                                           PluginInstance mode = PluginInstance::SHARED);
+        
+        // Plugin instance if it implements the streaming ABI, nullptr otherwise
+        std::shared_ptr<IStreamingPlugin> getStreamingPlugin(const std::string& pluginName,
+                                                             PluginInstance mode = PluginInstance::SHARED);
+        
+        // Resolve an exported symbol (e.g. MapMain) from a loaded plugin library
+        void* getSymbol(const std::string& pluginName, const std::string& symbolName);
         
         // Register plugin factory (for static linking)
         bool registerPlugin(const std::string& pluginName, PluginFactoryFunc factory);
@@ -40,37 +106,67 @@ namespace daf {
         // List all loaded plugins
         std::vector<std::string> getLoadedPlugins() const;
         
-        // Unload plugin
+        // Unload plugin. Per-thread instances and the library itself stay
+        // alive until the threads holding them let go.
         bool unloadPlugin(const std::string& pluginName);
         
         // Shutdown all plugins
         void shutdown();
         
     private:
-        PluginLoader() = default;
+        PluginLoader();
         ~PluginLoader();
         
         struct PluginInfo {
             std::shared_ptr<IPlugin> instance;
-            void* libraryHandle;
-            PluginFactoryFunc factory;
+            std::shared_ptr<void> library;   // dlclose()d with the last instance
+            PluginFactoryFunc factory;       // Creates further instances
+            std::string config;
+            int abiVersion;
+            uint64_t generation;             // Tells a reloaded plugin from its predecessor
+            std::unordered_map<std::string, void*> symbols;
         };
+        using PluginTable = std::unordered_map<std::string, std::shared_ptr<const PluginInfo>>;
         
-        std::unordered_map<std::string, PluginInfo> plugins_;
-        mutable std::mutex pluginsMutex_;
+        std::shared_ptr<const PluginInfo> find(const std::string& pluginName) const;
+        std::shared_ptr<IPlugin> threadInstance(const std::shared_ptr<const PluginInfo>& info,
+                                                const std::string& pluginName);
+        std::shared_ptr<const PluginTable> snapshot() const;
+        // Caller holds pluginsMutex_
+        void publish(std::shared_ptr<const PluginTable> table);
+        
+#ifdef __cpp_lib_atomic_shared_ptr
+        std::atomic<std::shared_ptr<const PluginTable>> plugins_;
+#else
+        std::shared_ptr<const PluginTable> plugins_;   // Read with std::atomic_load
+#endif
+        uint64_t nextGeneration_ = 1;
+        mutable std::mutex pluginsMutex_;              // Serializes writers
     };
 }
 
-// Macro for plugin registration
+// Macro for plugin registration. The functions are exported explicitly, so
+// plugins built with hidden visibility still work.
 #define REGISTER_PLUGIN(pluginName, pluginClass) \
     extern "C" { \
-        daf::IPlugin* createPlugin() { \
+        DAF_EXPORT daf::IPlugin* createPlugin() { \
             return new pluginClass(); \
         } \
-        void destroyPlugin(daf::IPlugin* plugin) { \
+        DAF_EXPORT void destroyPlugin(daf::IPlugin* plugin) { \
             delete plugin; \
         } \
-        const char* getPluginName() { \
+        DAF_EXPORT const char* getPluginName() { \
             return #pluginName; \
         } \
-    }
\ No newline at end of file
+    }
+
+// Registers a plugin implementing IStreamingPlugin
+#define REGISTER_STREAMING_PLUGIN(pluginName, pluginClass) \
+    static_assert(std::is_base_of<daf::IStreamingPlugin, pluginClass>::value, \
+                  #pluginClass " must implement daf::IStreamingPlugin"); \
+    REGISTER_PLUGIN(pluginName, pluginClass) \
+    extern "C" { \
+        DAF_EXPORT int getPluginAbiVersion() { \
+            return daf::STREAMING_PLUGIN_ABI_VERSION; \
+        } \
+    }
@@ -0,0 +1,228 @@
+#include "sample_format.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef min
+#undef min
+#endif
+
+namespace daf {
+
+namespace {
+
+bool header_is_valid(const SampleFileHeader& header) {
+    return header.magic == SAMPLE_FILE_MAGIC &&
+           header.version == SAMPLE_FILE_VERSION &&
+           header.channels == SAMPLE_CHANNELS &&
+           header.block_capacity > 0;
+}
+
+void bind_columns(SampleBatch& batch, const float* columns, uint32_t block_capacity, size_t count) {
+    batch.count = count;
+    batch.x = columns;
+    batch.y = columns + block_capacity;
+    batch.z = columns + 2 * static_cast<size_t>(block_capacity);
+    batch.r = columns + 3 * static_cast<size_t>(block_capacity);
+    batch.g = columns + 4 * static_cast<size_t>(block_capacity);
+    batch.b = columns + 5 * static_cast<size_t>(block_capacity);
+    batch.density = columns + 6 * static_cast<size_t>(block_capacity);
+}
+
+} // namespace
+
+// SampleFileWriter implementation
+SampleFileWriter::~SampleFileWriter() {
+    close();
+}
+
+bool SampleFileWriter::open(const std::string& path, uint32_t block_capacity) {
+    close();
+    if (block_capacity == 0) {
+        return false;
+    }
+
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) {
+        return false;
+    }
+
+    block_capacity_ = block_capacity;
+    block_fill_ = 0;
+    sample_count_ = 0;
+    block_.assign(static_cast<size_t>(SAMPLE_CHANNELS) * block_capacity_, 0.0f);
+
+    // Placeholder header, rewritten with the final count on close()
+    SampleFileHeader header{SAMPLE_FILE_MAGIC, SAMPLE_FILE_VERSION, SAMPLE_CHANNELS,
+                            block_capacity_, 0, 0};
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return file_.good();
+}
+
+void SampleFileWriter::add(float x, float y, float z, float r, float g, float b, float density) {
+    const float values[SAMPLE_CHANNELS] = {x, y, z, r, g, b, density};
+    for (uint32_t c = 0; c < SAMPLE_CHANNELS; ++c) {
+        block_[static_cast<size_t>(c) * block_capacity_ + block_fill_] = values[c];
+    }
+
+    sample_count_++;
+    if (++block_fill_ == block_capacity_) {
+        flush_block();
+    }
+}
+
+void SampleFileWriter::flush_block() {
+    if (block_fill_ == 0) {
+        return;
+    }
+
+    SampleBlockHeader block_header{block_fill_, 0};
+    file_.write(reinterpret_cast<const char*>(&block_header), sizeof(block_header));
+    file_.write(reinterpret_cast<const char*>(block_.data()), block_.size() * sizeof(float));
+
+    std::fill(block_.begin(), block_.end(), 0.0f);
+    block_fill_ = 0;
+}
+
+bool SampleFileWriter::close() {
+    if (!file_.is_open()) {
+        return true;
+    }
+
+    flush_block();
+
+    SampleFileHeader header{SAMPLE_FILE_MAGIC, SAMPLE_FILE_VERSION, SAMPLE_CHANNELS,
+                            block_capacity_, sample_count_, 0};
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    bool ok = file_.good();
+    file_.close();
+    return ok;
+}
+
+// SampleFileReader implementation
+bool SampleFileReader::open(const std::string& path, bool memory_mapped,
+                            uint64_t offset, uint64_t length) {
+    close();
+
+    if (memory_mapped) {
+        if (!mapped_.open(path, MappedFile::Access::SEQUENTIAL) || mapped_.size() < sizeof(header_)) {
+            close();
+            return false;
+        }
+
+        std::memcpy(&header_, mapped_.data(), sizeof(header_));
+        if (!header_is_valid(header_)) {
+            close();
+            return false;
+        }
+
+        mapped_offset_ = static_cast<size_t>(select_blocks(offset, length));
+        readahead_.reset();
+        return true;
+    }
+
+    file_.open(path, std::ios::binary);
+    if (!file_.is_open()) {
+        return false;
+    }
+
+    if (!file_.read(reinterpret_cast<char*>(&header_), sizeof(header_)) || !header_is_valid(header_)) {
+        close();
+        return false;
+    }
+
+    uint64_t data_offset = select_blocks(offset, length);
+    if (data_offset != sizeof(header_) && !file_.seekg(static_cast<std::streamoff>(data_offset))) {
+        close();
+        return false;
+    }
+    block_.resize(static_cast<size_t>(SAMPLE_CHANNELS) * header_.block_capacity);
+    return true;
+}
+
+uint64_t SampleFileReader::select_blocks(uint64_t offset, uint64_t length) {
+    // Block i starts at sizeof(header) + i * block_bytes; selects those starting
+    // in [offset, end) and returns the byte offset of the first one
+    uint64_t block_bytes = sample_block_bytes(header_.block_capacity);
+    uint64_t end = length > UINT64_MAX - offset ? UINT64_MAX : offset + length;
+    auto first_block_at = [&](uint64_t position) -> uint64_t {
+        if (position <= sizeof(header_)) {
+            return 0;
+        }
+        uint64_t data = position - sizeof(header_);
+        return data / block_bytes + (data % block_bytes != 0 ? 1 : 0);
+    };
+
+    uint64_t capacity = header_.block_capacity;
+    uint64_t block_count = (header_.sample_count + capacity - 1) / capacity;
+    uint64_t first = std::min(first_block_at(offset), block_count);
+    uint64_t last = std::min(first_block_at(end), block_count);
+
+    // Only the final block can be partial
+    samples_remaining_ = first < last ?
+        std::min(header_.sample_count, last * capacity) - first * capacity : 0;
+    return sizeof(header_) + first * block_bytes;
+}
+
+bool SampleFileReader::next(SampleBatch& batch) {
+    if (mapped_.is_open()) {
+        return next_mapped(batch);
+    }
+
+    if (!file_.is_open() || samples_remaining_ == 0) {
+        return false;
+    }
+
+    SampleBlockHeader block_header{};
+    if (!file_.read(reinterpret_cast<char*>(&block_header), sizeof(block_header)) ||
+        !file_.read(reinterpret_cast<char*>(block_.data()), block_.size() * sizeof(float))) {
+        samples_remaining_ = 0;
+        return false;
+    }
+
+    size_t count = std::min<uint64_t>({block_header.sample_count, header_.block_capacity, samples_remaining_});
+    samples_remaining_ -= count;
+    bind_columns(batch, block_.data(), header_.block_capacity, count);
+    return count > 0;
+}
+
+bool SampleFileReader::next_mapped(SampleBatch& batch) {
+    size_t block_bytes = sample_block_bytes(header_.block_capacity);
+    if (samples_remaining_ == 0 || mapped_offset_ + block_bytes > mapped_.size()) {
+        samples_remaining_ = 0;
+        return false;
+    }
+
+    readahead_.advance(mapped_, mapped_offset_);
+
+    SampleBlockHeader block_header{};
+    std::memcpy(&block_header, mapped_.data() + mapped_offset_, sizeof(block_header));
+    const float* columns = reinterpret_cast<const float*>(
+        mapped_.data() + mapped_offset_ + sizeof(block_header));
+    mapped_offset_ += block_bytes;
+
+    size_t count = std::min<uint64_t>({block_header.sample_count, header_.block_capacity, samples_remaining_});
+    samples_remaining_ -= count;
+    bind_columns(batch, columns, header_.block_capacity, count);
+    return count > 0;
+}
+
+void SampleFileReader::close() {
+    if (file_.is_open()) {
+        file_.close();
+    }
+    mapped_.close();
+    mapped_offset_ = 0;
+    file_.clear();
+    header_ = SampleFileHeader{};
+    samples_remaining_ = 0;
+}
+
+bool SampleFileReader::is_sample_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    SampleFileHeader header{};
+    return file.read(reinterpret_cast<char*>(&header), sizeof(header)) && header_is_valid(header);
+}
+
+} // namespace daf
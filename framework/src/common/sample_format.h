@@ -0,0 +1,115 @@
+#pragma once
+
+#include "mapped_file.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+
+namespace daf {
+
+// Packed binary sample format ("DAFS")
+//
+// A sample file is a SampleFileHeader followed by fixed-capacity blocks.
+// Every block is a SampleBlockHeader plus seven float32 columns
+// (x, y, z, r, g, b, density) of block_capacity entries each, so map kernels
+// consume samples as structure-of-arrays without any text parsing. The last
+// block is zero padded. All fields are little-endian.
+constexpr uint32_t SAMPLE_FILE_MAGIC = 0x53464144; // "DAFS"
+constexpr uint32_t SAMPLE_FILE_VERSION = 1;
+constexpr uint32_t SAMPLE_CHANNELS = 7;
+constexpr uint32_t DEFAULT_SAMPLE_BLOCK_CAPACITY = 4096;
+
+struct SampleFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t channels;
+    uint32_t block_capacity;
+    uint64_t sample_count;
+    uint64_t reserved;
+};
+
+struct SampleBlockHeader {
+    uint32_t sample_count;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(SampleFileHeader) == 32, "SampleFileHeader must stay packed");
+static_assert(sizeof(SampleBlockHeader) == 8, "SampleBlockHeader must stay packed");
+
+// Size in bytes of one block on disk
+inline size_t sample_block_bytes(uint32_t block_capacity) {
+    return sizeof(SampleBlockHeader) +
+           static_cast<size_t>(SAMPLE_CHANNELS) * block_capacity * sizeof(float);
+}
+
+// Typed view over one block of samples. Pointers stay valid until the next
+// read from the context or reader that produced the batch.
+struct SampleBatch {
+    size_t count = 0;
+    const float* x = nullptr;
+    const float* y = nullptr;
+    const float* z = nullptr;
+    const float* r = nullptr;
+    const float* g = nullptr;
+    const float* b = nullptr;
+    const float* density = nullptr;
+};
+
+// Streams samples into a DAFS file block by block
+class SampleFileWriter {
+public:
+    SampleFileWriter() = default;
+    ~SampleFileWriter();
+
+    SampleFileWriter(const SampleFileWriter&) = delete;
+    SampleFileWriter& operator=(const SampleFileWriter&) = delete;
+
+    bool open(const std::string& path, uint32_t block_capacity = DEFAULT_SAMPLE_BLOCK_CAPACITY);
+    void add(float x, float y, float z, float r, float g, float b, float density);
+    bool close();
+
+    uint64_t sample_count() const { return sample_count_; }
+
+private:
+    void flush_block();
+
+    std::ofstream file_;
+    uint32_t block_capacity_ = 0;
+    uint32_t block_fill_ = 0;
+    uint64_t sample_count_ = 0;
+    std::vector<float> block_;
+};
+
+// Reads a DAFS file one block at a time. In memory-mapped mode batches point
+// straight into the mapping instead of a private block buffer. A byte range
+// restricts the reader to the blocks that start inside it (see InputSplit).
+class SampleFileReader {
+public:
+    bool open(const std::string& path, bool memory_mapped = false,
+              uint64_t offset = 0, uint64_t length = UINT64_MAX);
+    bool next(SampleBatch& batch);
+    void close();
+
+    const SampleFileHeader& header() const { return header_; }
+
+    // True if the file starts with a valid DAFS header
+    static bool is_sample_file(const std::string& path);
+
+private:
+    bool next_mapped(SampleBatch& batch);
+    uint64_t select_blocks(uint64_t offset, uint64_t length);
+
+    std::ifstream file_;
+    SampleFileHeader header_{};
+    uint64_t samples_remaining_ = 0;
+    std::vector<float> block_;
+
+    // Memory-mapped mode
+    MappedFile mapped_;
+    MappedReadahead readahead_;
+    size_t mapped_offset_ = 0;
+};
+
+} // namespace daf
@@ -0,0 +1,50 @@
+#include "shuffle_location.h"
+#include <cctype>
+
+namespace daf {
+
+namespace {
+
+const std::string SHUFFLE_SCHEME = "shuffle://";
+
+} // namespace
+
+std::string ShuffleLocation::to_string() const {
+    if (!is_remote()) {
+        return path;
+    }
+    return SHUFFLE_SCHEME + host + ":" + std::to_string(port) + path;
+}
+
+ShuffleLocation ShuffleLocation::parse(const std::string& spec) {
+    ShuffleLocation location;
+    location.path = spec;
+
+    if (spec.compare(0, SHUFFLE_SCHEME.size(), SHUFFLE_SCHEME) != 0) {
+        return location;
+    }
+    size_t slash = spec.find('/', SHUFFLE_SCHEME.size());
+    size_t colon = spec.rfind(':', slash);
+    if (slash == std::string::npos || colon == std::string::npos || colon <= SHUFFLE_SCHEME.size() ||
+        colon + 1 == slash || slash - colon > 6) {
+        return location;
+    }
+
+    int port = 0;
+    for (size_t i = colon + 1; i < slash; ++i) {
+        if (!std::isdigit(static_cast<unsigned char>(spec[i]))) {
+            return location;
+        }
+        port = port * 10 + (spec[i] - '0');
+    }
+    if (port == 0 || port > 65535) {
+        return location;
+    }
+
+    location.host = spec.substr(SHUFFLE_SCHEME.size(), colon - SHUFFLE_SCHEME.size());
+    location.port = port;
+    location.path = spec.substr(slash);
+    return location;
+}
+
+} // namespace daf
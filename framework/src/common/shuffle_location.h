@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+
+namespace daf {
+
+// Where a reduce task finds one map output run
+//
+// "shuffle://host:port/path/to/run" names a run served by the worker that
+// wrote it (see worker/shuffle_service.h); a bare path is a run on a local
+// or shared filesystem.
+struct ShuffleLocation {
+    std::string host;   // Empty for a bare path
+    int port = 0;
+    std::string path;
+
+    bool is_remote() const { return !host.empty(); }
+
+    std::string to_string() const;
+
+    // Anything that is not a well-formed shuffle URI is taken as a bare path
+    static ShuffleLocation parse(const std::string& spec);
+};
+
+} // namespace daf
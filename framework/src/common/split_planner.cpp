@@ -0,0 +1,74 @@
+#include "split_planner.h"
+#include <algorithm>
+#include <filesystem>
+
+#ifdef min
+#undef min
+#endif
+#ifdef max
+#undef max
+#endif
+
+namespace daf {
+
+uint64_t map_split_target(uint64_t total_bytes, int num_map_tasks) {
+    if (num_map_tasks <= 0) {
+        return DEFAULT_MAP_SPLIT_SIZE;
+    }
+    
+    uint64_t tasks = static_cast<uint64_t>(num_map_tasks);
+    uint64_t target = (total_bytes + tasks - 1) / tasks;
+    uint64_t units = std::max<uint64_t>(1, (target + DEFAULT_BUFFER_SIZE - 1) / DEFAULT_BUFFER_SIZE);
+    return units * DEFAULT_BUFFER_SIZE;
+}
+
+uint32_t plan_reduce_tasks(int num_reduce_tasks, size_t worker_count) {
+    if (num_reduce_tasks > 0) {
+        return static_cast<uint32_t>(num_reduce_tasks);
+    }
+    return static_cast<uint32_t>(std::max<size_t>(1, worker_count));
+}
+
+JobPlan plan_job(const JobConfig& config, size_t worker_count) {
+    JobPlan plan;
+    plan.num_reduce_tasks = plan_reduce_tasks(config.num_reduce_tasks, worker_count);
+    
+    std::vector<InputSplit> inputs;
+    std::vector<uint64_t> input_bytes;
+    for (const auto& spec : config.input_files) {
+        InputSplit split = InputSplit::parse(spec);
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(split.path, ec)) {
+            plan.unreadable_inputs.push_back(spec);
+            continue;
+        }
+        inputs.push_back(split);
+        input_bytes.push_back(split_size_bytes(split));
+        plan.total_bytes += input_bytes.back();
+    }
+    
+    uint64_t target = map_split_target(plan.total_bytes, config.num_map_tasks);
+    
+    // Greedy packing in input order keeps each task's reads sequential
+    std::vector<InputSplit> current;
+    uint64_t current_bytes = 0;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        for (const auto& piece : cut_input_split(inputs[i], target)) {
+            uint64_t bytes = split_size_bytes(piece);
+            if (!current.empty() && current_bytes + bytes > target) {
+                plan.map_tasks.push_back(std::move(current));
+                current.clear();
+                current_bytes = 0;
+            }
+            current.push_back(piece);
+            current_bytes += bytes;
+        }
+    }
+    if (!current.empty()) {
+        plan.map_tasks.push_back(std::move(current));
+    }
+    
+    return plan;
+}
+
+} // namespace daf
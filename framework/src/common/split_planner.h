@@ -0,0 +1,36 @@
+#pragma once
+
+#include "daf_types.h"
+#include "input_split.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace daf {
+
+// Map and reduce layout of one job
+//
+// Inputs are cut into byte-range splits of about the target size and packed
+// into map tasks of about the same size, so a large file fans out over many
+// tasks and many small files share one. Cutting never has to find record
+// boundaries: readers realign text splits to lines and DAFS splits to
+// blocks (see input_split.h).
+struct JobPlan {
+    std::vector<std::vector<InputSplit>> map_tasks;
+    uint32_t num_reduce_tasks = 1;
+    uint64_t total_bytes = 0;
+    std::vector<std::string> unreadable_inputs;
+};
+
+// JobConfig::num_map_tasks and num_reduce_tasks are used when positive;
+// otherwise splits are DEFAULT_MAP_SPLIT_SIZE and there is one reducer per
+// active worker
+JobPlan plan_job(const JobConfig& config, size_t worker_count);
+
+// Bytes per map task: total_bytes / num_map_tasks rounded up to whole
+// DEFAULT_BUFFER_SIZE units, or DEFAULT_MAP_SPLIT_SIZE if num_map_tasks <= 0
+uint64_t map_split_target(uint64_t total_bytes, int num_map_tasks);
+
+uint32_t plan_reduce_tasks(int num_reduce_tasks, size_t worker_count);
+
+} // namespace daf
@@ -0,0 +1,241 @@
+#include "task_cache.h"
+#include "daf_utils.h"
+#include "input_split.h"
+#include "key_sketch.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <system_error>
+
+namespace daf {
+
+namespace {
+
+// Parameters that only steer scheduling or the cache itself
+const std::set<std::string> UNCACHED_PARAMETERS = {
+    "cache_key_base", "input_hosts", "plugin_instances", "shuffle_parallel_fetches", "task_cache_dir"
+};
+
+constexpr uint64_t HASH_K1 = 0x87c37b91114253d5ULL;
+constexpr uint64_t HASH_K2 = 0x4cf5ad432745937fULL;
+
+uint64_t rotate_left(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// MurmurHash3 finaliser
+uint64_t final_mix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+void append_hex(std::string& out, uint64_t value) {
+    static const char digits[] = "0123456789abcdef";
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        out += digits[(value >> shift) & 0xf];
+    }
+}
+
+} // namespace
+
+void ContentHash::update(const void* data, size_t size) {
+    // Bytes go into little-endian words, whatever the chunking
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    size_t i = 0;
+    for (; i < size && pending_size_ != 0; ++i) {
+        add_byte(bytes[i]);
+    }
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word = 0;
+        for (int b = 0; b < 8; ++b) {
+            word |= static_cast<uint64_t>(bytes[i + b]) << (8 * b);   // One load on little-endian CPUs
+        }
+        add_word(word);
+    }
+    for (; i < size; ++i) {
+        add_byte(bytes[i]);
+    }
+    length_ += size;
+}
+
+void ContentHash::add_byte(unsigned char byte) {
+    pending_ |= static_cast<uint64_t>(byte) << (8 * pending_size_);
+    if (++pending_size_ == 8) {
+        add_word(pending_);
+        pending_ = 0;
+        pending_size_ = 0;
+    }
+}
+
+void ContentHash::add_word(uint64_t word) {
+    low_ = rotate_left(low_ ^ (word * HASH_K1), 31) * HASH_K2;
+    high_ = rotate_left(high_ + word, 27) * HASH_K1 + low_;
+}
+
+void ContentHash::update_field(std::string_view field) {
+    uint64_t length = field.size();
+    unsigned char prefix[8];
+    for (int i = 0; i < 8; ++i) {
+        prefix[i] = static_cast<unsigned char>(length >> (8 * i));
+    }
+    update(prefix, sizeof(prefix));
+    update(field.data(), field.size());
+}
+
+std::string ContentHash::hex() const {
+    uint64_t low = low_ ^ final_mix(pending_ ^ (static_cast<uint64_t>(pending_size_) << 56));
+    uint64_t high = high_ ^ length_;
+    low += high;
+    high += low;
+    low = final_mix(low);
+    high = final_mix(high);
+    low += high;
+    high += low;
+
+    std::string hex;
+    hex.reserve(32);
+    append_hex(hex, high);
+    append_hex(hex, low);
+    return hex;
+}
+
+std::string TaskCache::base_key(const std::string& plugin_name, TaskType type,
+                                const std::map<std::string, std::string>& parameters,
+                                const std::vector<std::string>& input_digests) {
+    ContentHash hash;
+    hash.update_field("daf-task-cache-1");
+    hash.update_field(plugin_name);
+    hash.update_field(std::to_string(static_cast<int>(type)));
+    for (const auto& [name, value] : parameters) {
+        if (UNCACHED_PARAMETERS.count(name) == 0) {
+            hash.update_field(name);
+            hash.update_field(value);
+        }
+    }
+    hash.update_field(std::to_string(input_digests.size()));
+    for (const auto& digest : input_digests) {
+        hash.update_field(digest);
+    }
+    return hash.hex();
+}
+
+std::string TaskCache::versioned_key(const std::string& base_key, const std::string& plugin_version) {
+    ContentHash hash;
+    hash.update_field(base_key);
+    hash.update_field(plugin_version);
+    return hash.hex();
+}
+
+bool TaskCache::lookup(const std::string& key, TaskCacheEntry& entry) const {
+    std::string entry_dir = directory_ + "/" + key;
+    std::ifstream manifest(entry_dir + "/manifest");
+    if (!manifest.is_open()) {
+        return false;
+    }
+
+    TaskCacheEntry loaded;
+    std::string line;
+    while (std::getline(manifest, line)) {
+        size_t space = line.find(' ');
+        std::string field = line.substr(0, space);
+        std::string value = space == std::string::npos ? "" : line.substr(space + 1);
+        if (field == "output") {
+            loaded.output = entry_dir + "/" + value;
+        } else if (field == "result" && !hex_decode_key(value, loaded.result)) {
+            return false;
+        } else if (field == "digests") {
+            loaded.digests = Utils::split(value, ' ');
+        }
+    }
+    if (loaded.output.empty() || !Utils::file_exists(loaded.output)) {
+        return false;
+    }
+    entry = std::move(loaded);
+    return true;
+}
+
+bool TaskCache::publish(const std::string& key, const std::vector<std::string>& files,
+                        const TaskCacheEntry& entry) const {
+    namespace fs = std::filesystem;
+    if (files.empty()) {
+        return false;
+    }
+
+    std::error_code ec;
+    fs::path final_dir = fs::path(directory_) / key;
+    if (fs::exists(final_dir / "manifest", ec)) {
+        return true;
+    }
+    fs::create_directories(directory_, ec);
+    fs::path temp_dir = fs::path(directory_) /
+        (key + ".tmp-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    if (!fs::create_directory(temp_dir, ec)) {
+        return false;
+    }
+
+    bool ok = true;
+    for (const auto& file : files) {
+        ok = ok && link_or_copy(file, (temp_dir / fs::path(file).filename()).string());
+    }
+    if (ok) {
+        std::ofstream manifest(temp_dir / "manifest", std::ios::trunc);
+        manifest << "output " << fs::path(files.front()).filename().string() << "\n";
+        manifest << "result " << hex_encode_key(entry.result) << "\n";   // Results may be binary
+        manifest << "digests";
+        for (const auto& digest : entry.digests) {
+            manifest << ' ' << digest;
+        }
+        manifest << "\n";
+        manifest.close();
+        ok = !manifest.fail();
+    }
+
+    // Losing the rename race to another publisher is fine: same content
+    if (ok) {
+        fs::rename(temp_dir, final_dir, ec);
+        if (!ec) {
+            return true;
+        }
+        ok = fs::exists(final_dir / "manifest", ec);
+    }
+    fs::remove_all(temp_dir, ec);
+    return ok;
+}
+
+bool TaskCache::link_or_copy(const std::string& from, const std::string& to) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::remove(to, ec);
+    fs::create_hard_link(from, to, ec);
+    if (!ec) {
+        return true;
+    }
+    return fs::copy_file(from, to, fs::copy_options::overwrite_existing, ec) && !ec;
+}
+
+std::string input_split_digest(const std::string& split) {
+    namespace fs = std::filesystem;
+    InputSplit input = InputSplit::parse(split);
+    std::error_code ec;
+    uint64_t size = fs::file_size(input.path, ec);
+    if (ec) {
+        return "";
+    }
+    auto modified = fs::last_write_time(input.path, ec);
+    if (ec) {
+        return "";
+    }
+
+    ContentHash hash;
+    hash.update_field(input.to_string());
+    hash.update_field(std::to_string(size));
+    hash.update_field(std::to_string(modified.time_since_epoch().count()));
+    return hash.hex();
+}
+
+} // namespace daf
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "daf_types.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace daf {
+
+// Content-addressed task output cache
+//
+// A cache directory (job parameter task_cache_dir, on storage shared by the
+// coordinator and every worker) holds one entry per task output, named by a
+// hash of everything the output depends on: the plugin and its version, the
+// task parameters and a digest of every input. Only workers load plugins,
+// so the coordinator hands each task its base key (everything but the
+// version); the worker that completes it publishes the output under the
+// versioned key and records the plugin version in Redis, and later runs of
+// the job skip every task whose entry exists.
+//
+//   <task_cache_dir>/<key>/manifest   "output <file>", "result <hex>", "digests <hex>..."
+//   <task_cache_dir>/<key>/<file>     the output, plus its .index for map runs
+//
+// Entries are written under a temporary name and renamed into place, so a
+// visible entry is always complete; the first publisher of a key wins.
+// Files are hard-linked in and out of entries where possible, so task
+// outputs are always replaced, never rewritten in place.
+
+// 128-bit streaming hash for cache keys and content digests. Fast and well
+// mixed, but not meant to resist deliberate collisions: the cache directory
+// has to be trusted like the job's output directory.
+class ContentHash {
+public:
+    void update(const void* data, size_t size);
+    // Length-prefixed, so field boundaries are part of the hash
+    void update_field(std::string_view field);
+    std::string hex() const;
+
+private:
+    void add_byte(unsigned char byte);
+    void add_word(uint64_t word);
+
+    uint64_t low_ = 0x9e3779b97f4a7c15ULL;
+    uint64_t high_ = 0xc2b2ae3d27d4eb4fULL;
+    uint64_t length_ = 0;
+    uint64_t pending_ = 0;       // Bytes of the word being filled
+    size_t pending_size_ = 0;
+};
+
+struct TaskCacheEntry {
+    std::string output;                 // Path of the cached output file
+    std::string result;                 // Task result reported when the output was made
+    std::vector<std::string> digests;   // Map runs: digest of every partition's records
+};
+
+class TaskCache {
+public:
+    explicit TaskCache(const std::string& directory) : directory_(directory) {}
+
+    // Scheduling-only parameters (input_hosts, the cache settings, ...) are
+    // left out, so they never invalidate an entry
+    static std::string base_key(const std::string& plugin_name, TaskType type,
+                                const std::map<std::string, std::string>& parameters,
+                                const std::vector<std::string>& input_digests);
+    static std::string versioned_key(const std::string& base_key, const std::string& plugin_version);
+
+    bool lookup(const std::string& key, TaskCacheEntry& entry) const;
+    // Output files are hard-linked into the entry when the filesystem
+    // allows, copied otherwise; entry.output names the first file
+    bool publish(const std::string& key, const std::vector<std::string>& files, const TaskCacheEntry& entry) const;
+
+    static bool link_or_copy(const std::string& from, const std::string& to);
+
+private:
+    std::string directory_;
+};
+
+// Digest of an input split ("path" or "path@offset+length") from the
+// range and the file's size and modification time, the way make decides
+// what to rebuild; empty if the file cannot be read
+std::string input_split_digest(const std::string& split);
+
+} // namespace daf
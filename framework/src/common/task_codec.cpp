@@ -0,0 +1,107 @@
+#include "task_codec.h"
+#include "varint.h"
+#include <cstring>
+
+namespace daf {
+
+namespace {
+
+constexpr size_t HEADER_SIZE = sizeof(TASK_CODEC_MAGIC) + 1;
+
+void reset_task(Task& task) {
+    task = Task{};
+    task.type = TaskType::MAP;
+    task.status = TaskStatus::PENDING;
+    task.created_time = 0;
+    task.started_time = 0;
+    task.completed_time = 0;
+}
+
+bool valid_type(int64_t type) {
+    return type >= static_cast<int>(TaskType::MAP) && type <= static_cast<int>(TaskType::SHUFFLE);
+}
+
+bool decode_binary_task(std::string_view data, Task& task) {
+    if (static_cast<uint8_t>(data[sizeof(TASK_CODEC_MAGIC)]) != TASK_CODEC_VERSION) {
+        return false;
+    }
+
+    VarintReader reader(data);
+    reader.skip(HEADER_SIZE);
+    uint64_t type;
+    uint64_t created;
+    uint64_t inputs;
+    uint64_t parameters;
+    if (!reader.varint(type) || !valid_type(static_cast<int64_t>(type)) ||
+        !reader.string(task.id) || !reader.string(task.plugin_name) || !reader.string(task.output_file) ||
+        !reader.varint(created) || !reader.count(inputs, 1)) {
+        return false;
+    }
+    task.type = static_cast<TaskType>(type);
+    task.created_time = unzigzag(created);
+
+    task.input_files.resize(static_cast<size_t>(inputs));
+    for (auto& input : task.input_files) {
+        if (!reader.string(input)) {
+            return false;
+        }
+    }
+    if (!reader.count(parameters, 2)) {
+        return false;
+    }
+    std::string name;
+    std::string value;
+    for (uint64_t i = 0; i < parameters; ++i) {
+        if (!reader.string(name) || !reader.string(value)) {
+            return false;
+        }
+        task.parameters[name] = std::move(value);
+    }
+    return !task.id.empty();
+}
+
+} // namespace
+
+std::string encode_task(const Task& task) {
+    // Sized up front: one allocation per task
+    size_t size = HEADER_SIZE + varint_size(static_cast<uint64_t>(task.type)) + string_size(task.id) +
+                  string_size(task.plugin_name) + string_size(task.output_file) +
+                  varint_size(zigzag(task.created_time)) + varint_size(task.input_files.size()) +
+                  varint_size(task.parameters.size());
+    for (const auto& input : task.input_files) {
+        size += string_size(input);
+    }
+    for (const auto& [name, value] : task.parameters) {
+        size += string_size(name) + string_size(value);
+    }
+
+    std::string out;
+    out.reserve(size);
+    out.append(TASK_CODEC_MAGIC, sizeof(TASK_CODEC_MAGIC));
+    out += static_cast<char>(TASK_CODEC_VERSION);
+    put_varint(out, static_cast<uint64_t>(task.type));
+    put_string(out, task.id);
+    put_string(out, task.plugin_name);
+    put_string(out, task.output_file);
+    put_varint(out, zigzag(task.created_time));
+    put_varint(out, task.input_files.size());
+    for (const auto& input : task.input_files) {
+        put_string(out, input);
+    }
+    put_varint(out, task.parameters.size());
+    for (const auto& [name, value] : task.parameters) {
+        put_string(out, name);
+        put_string(out, value);
+    }
+    return out;
+}
+
+bool decode_task(std::string_view data, Task& task) {
+    reset_task(task);
+    if (data.size() < HEADER_SIZE || std::memcmp(data.data(), TASK_CODEC_MAGIC, sizeof(TASK_CODEC_MAGIC)) != 0) {
+        return false;
+    }
+    return decode_binary_task(data, task);
+}
+
+} // namespace daf
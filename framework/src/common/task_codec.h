@@ -0,0 +1,28 @@
+#pragma once
+
+#include "daf_types.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace daf {
+
+// Wire form of a Task as stored in the "data" field of a task:<id> hash
+//
+// A compact binary record: TASK_CODEC_MAGIC, the format version, then
+//   varint type | str id | str plugin | str output | zigzag varint created |
+//   varint input count, str input... | varint parameter count, (str name, str value)...
+// where str is a varint length followed by the bytes. Later revisions only
+// append fields, which older readers skip, so coordinator and worker
+// versions can differ; the version byte changes only for incompatible
+// layouts.
+constexpr char TASK_CODEC_MAGIC[3] = {'\0', 'D', 'T'};
+constexpr uint8_t TASK_CODEC_VERSION = 1;
+
+std::string encode_task(const Task& task);
+
+// False if the data is not an encoded task, is truncated, has no id or an
+// unknown task type
+bool decode_task(std::string_view data, Task& task);
+
+} // namespace daf
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace daf {
+
+// LEB128-style varints for compact binary records (task codec, key
+// sketches): 7 bits per byte, low bits first, high bit set on every byte
+// but the last. Strings are a varint length followed by the bytes.
+inline size_t varint_size(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+inline void put_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+inline size_t string_size(std::string_view value) {
+    return varint_size(value.size()) + value.size();
+}
+
+inline void put_string(std::string& out, std::string_view value) {
+    put_varint(out, value.size());
+    out.append(value.data(), value.size());
+}
+
+// Signed values with small magnitudes stay short
+inline uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Bounds-checked cursor over an encoded record; any read past the end fails
+// the whole decode
+class VarintReader {
+public:
+    explicit VarintReader(std::string_view data) : data_(data) {}
+
+    bool varint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && pos_ < data_.size(); shift += 7) {
+            uint8_t byte = static_cast<uint8_t>(data_[pos_++]);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool string(std::string& value) {
+        uint64_t size;
+        if (!varint(size) || size > data_.size() - pos_) {
+            return false;
+        }
+        value.assign(data_.data() + pos_, static_cast<size_t>(size));
+        pos_ += static_cast<size_t>(size);
+        return true;
+    }
+
+    // A count of items that each take at least min_size bytes
+    bool count(uint64_t& value, size_t min_size) {
+        return varint(value) && value <= (data_.size() - pos_) / min_size;
+    }
+
+    void skip(size_t size) { pos_ += size; }
+
+private:
+    std::string_view data_;
+    size_t pos_ = 0;
+};
+
+} // namespace daf
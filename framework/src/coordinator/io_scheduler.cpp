@@ -0,0 +1,65 @@
+#include "io_scheduler.h"
+#include <algorithm>
+
+namespace daf {
+
+IoScheduler::IoScheduler(size_t thread_count) {
+    thread_count = std::max<size_t>(1, thread_count);
+    threads_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back(&IoScheduler::Run, this);
+    }
+}
+
+IoScheduler::~IoScheduler() {
+    Shutdown();
+}
+
+void IoScheduler::schedule(pplx::TaskProc_t proc, void* param) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stopping_) {
+            queue_.emplace_back(proc, param);
+            ready_.notify_one();
+            return;
+        }
+    }
+    // pplx expects every scheduled task to run exactly once
+    proc(param);
+}
+
+void IoScheduler::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    ready_.notify_all();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+size_t IoScheduler::Pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+void IoScheduler::Run() {
+    while (true) {
+        std::pair<pplx::TaskProc_t, void*> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            task = queue_.front();
+            queue_.pop_front();
+        }
+        task.first(task.second);
+    }
+}
+
+} // namespace daf
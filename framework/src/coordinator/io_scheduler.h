@@ -0,0 +1,46 @@
+#pragma once
+
+#include <pplx/pplxtasks.h>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace daf {
+
+/**
+ * pplx scheduler running tasks on a fixed set of dedicated threads
+ * By default pplx tasks share cpprestsdk's thread pool with the HTTP
+ * listener, so a handler that waits on Redis there holds up every other
+ * request. Tasks created with this scheduler (and their continuations)
+ * run here instead. Tasks still queued at Shutdown() are run before the
+ * threads exit; tasks scheduled after it run on the calling thread.
+ */
+class IoScheduler : public pplx::scheduler_interface {
+public:
+    explicit IoScheduler(size_t thread_count);
+    ~IoScheduler() override;
+    
+    IoScheduler(const IoScheduler&) = delete;
+    IoScheduler& operator=(const IoScheduler&) = delete;
+    
+    void schedule(pplx::TaskProc_t proc, void* param) override;
+    void Shutdown();
+    
+    size_t ThreadCount() const { return threads_.size(); }
+    size_t Pending() const;
+    
+private:
+    void Run();
+    
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::pair<pplx::TaskProc_t, void*>> queue_;
+    std::vector<std::thread> threads_;
+    bool stopping_ = false;
+};
+
+} // namespace daf
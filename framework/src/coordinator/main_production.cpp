@@ -2,6 +2,7 @@
 #include <iostream>
 #include <signal.h>
 #include <memory>
+#include <algorithm>
 
 // Global coordinator instance for signal handling
 std::unique_ptr<daf::ProductionCoordinator> g_coordinator;
@@ -27,6 +28,7 @@ int main(int argc, char* argv[]) {
     int grpc_port = 50051;
     std::string redis_host = "redis"; // Default for Docker
     int redis_port = 6379;
+    size_t redis_pool_size = daf::RedisConnectionPool::DEFAULT_POOL_SIZE;
     
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
@@ -39,6 +41,8 @@ int main(int argc, char* argv[]) {
             redis_host = argv[++i];
         } else if (arg == "--redis-port" && i + 1 < argc) {
             redis_port = std::stoi(argv[++i]);
+        } else if (arg == "--redis-pool-size" && i + 1 < argc) {
+            redis_pool_size = static_cast<size_t>(std::max(1, std::stoi(argv[++i])));
         } else if (arg == "--help" || arg == "-h") {
             std::cout << "Usage: " << argv[0] << " [options]" << std::endl;
             std::cout << "Options:" << std::endl;
@@ -46,6 +50,8 @@ int main(int argc, char* argv[]) {
             std::cout << "  --grpc-port PORT    gRPC API port (default: 50051)" << std::endl;
             std::cout << "  --redis-host HOST   Redis host (default: redis)" << std::endl;
             std::cout << "  --redis-port PORT   Redis port (default: 6379)" << std::endl;
+            std::cout << "  --redis-pool-size N Redis connections shared by API and scheduler threads (default: "
+                      << daf::RedisConnectionPool::DEFAULT_POOL_SIZE << ")" << std::endl;
             std::cout << "  --help, -h          Show this help message" << std::endl;
             return 0;
         }
@@ -56,16 +62,19 @@ int main(int argc, char* argv[]) {
     const char* env_redis_port = std::getenv("REDIS_PORT");
     const char* env_http_port = std::getenv("HTTP_PORT");
     const char* env_grpc_port = std::getenv("GRPC_PORT");
+    const char* env_redis_pool_size = std::getenv("REDIS_POOL_SIZE");
     
     if (env_redis_host) redis_host = env_redis_host;
     if (env_redis_port) redis_port = std::stoi(env_redis_port);
     if (env_http_port) http_port = std::stoi(env_http_port);
     if (env_grpc_port) grpc_port = std::stoi(env_grpc_port);
+    if (env_redis_pool_size) redis_pool_size = static_cast<size_t>(std::max(1, std::stoi(env_redis_pool_size)));
     
     std::cout << "[INFO] Configuration:" << std::endl;
     std::cout << "[INFO]   HTTP API: 0.0.0.0:" << http_port << std::endl;
     std::cout << "[INFO]   gRPC API: 0.0.0.0:" << grpc_port << std::endl;
-    std::cout << "[INFO]   Redis: " << redis_host << ":" << redis_port << std::endl;
+    std::cout << "[INFO]   Redis: " << redis_host << ":" << redis_port
+              << " (pool of " << redis_pool_size << ")" << std::endl;
     
     // Install signal handlers for graceful shutdown
     signal(SIGINT, SignalHandler);
@@ -75,6 +84,7 @@ int main(int argc, char* argv[]) {
         // Create and configure coordinator
         g_coordinator = std::make_unique<daf::ProductionCoordinator>(http_port, grpc_port);
         g_coordinator->SetRedisConnection(redis_host, redis_port);
+        g_coordinator->SetRedisPoolSize(redis_pool_size);
         g_coordinator->SetWorkerTimeout(300); // 5 minutes
         g_coordinator->SetJobProcessingInterval(2); // 2 seconds
         
@@ -1,10 +1,20 @@
 #include "production_coordinator.h"
+#include "io_scheduler.h"
+#include "../common/daf_utils.h"
+#include "../common/key_sketch.h"
+#include "../common/metrics.h"
+#include "../common/split_planner.h"
+#include "../common/shuffle_location.h"
+#include "../common/task_cache.h"
+#include "../common/task_codec.h"
 #include <cpprest/http_listener.h>
 #include <cpprest/json.h>
+#include <filesystem>
 #include <iostream>
 #include <random>
 #include <chrono>
 #include <sstream>
+#include <unordered_set>
 
 using namespace web;
 using namespace web::http;
@@ -12,12 +22,139 @@ using namespace web::http::experimental::listener;
 
 namespace daf {
 
+// Longest a blocking queue read holds its connection; bounds Stop() latency
+static constexpr int JOB_QUEUE_WAIT_SECONDS = 1;
+
+// Worker metrics are reloaded at most this often while tasks are dispatched
+static constexpr std::chrono::seconds SCHEDULER_REFRESH_INTERVAL(1);
+
+// How often running tasks are compared against their stage's median runtime
+static constexpr std::chrono::seconds STRAGGLER_CHECK_INTERVAL(5);
+
+// Longest a cached worker list is served before it is reloaded
+static constexpr std::chrono::seconds WORKER_CACHE_TTL(1);
+
+// Largest job batch one POST /api/jobs:batch or GET /api/jobs/status takes
+static constexpr size_t MAX_BATCH_JOBS = 10000;
+
+static const std::string BACKUP_SUFFIX = "_backup";
+
+// Original and backup attempt of a task name each other
+static std::string OtherAttemptId(const std::string& task_id, const std::string& attempt_id) {
+    return attempt_id == task_id ? task_id + BACKUP_SUFFIX : task_id;
+}
+
+// Task parameter "input_hosts": host=count pairs of where the inputs were produced
+static std::string EncodeInputHosts(const std::unordered_map<std::string, size_t>& hosts) {
+    std::string encoded;
+    for (const auto& [host, count] : hosts) {
+        if (!encoded.empty()) encoded += ",";
+        encoded += host + "=" + std::to_string(count);
+    }
+    return encoded;
+}
+
+static std::unordered_map<std::string, size_t> DecodeInputHosts(const std::string& encoded) {
+    std::unordered_map<std::string, size_t> hosts;
+    for (const auto& entry : Utils::split(encoded, ',')) {
+        size_t equals = entry.rfind('=');
+        if (equals != std::string::npos && equals > 0) {
+            hosts[entry.substr(0, equals)] += static_cast<size_t>(std::max(0, std::atoi(entry.c_str() + equals + 1)));
+        }
+    }
+    return hosts;
+}
+
+// A hot key is split across at most this many partial reduce tasks
+static constexpr uint32_t MAX_KEY_SALTS = 16;
+
+// Hot keys of a job from the key sketches its map tasks reported. Parameter
+// hot_key_fraction is the share of an average reducer's records that makes
+// a key hot (0.5 by default), skew_salting=false turns salting off.
+static std::vector<HotKey> FindJobHotKeys(const JobConfig& config,
+                                          std::vector<std::unordered_map<std::string, std::string>>& map_results,
+                                          int reduce_tasks) {
+    auto salting = config.parameters.find("skew_salting");
+    if (salting != config.parameters.end() && salting->second == "false") {
+        return {};
+    }
+    auto fraction_param = config.parameters.find("hot_key_fraction");
+    double fraction = fraction_param == config.parameters.end() ? 0.5 : std::atof(fraction_param->second.c_str());
+    
+    // Map tasks without a combiner send no sketch, and then nothing is salted
+    KeySketch merged;
+    size_t sketches = 0;
+    for (auto& result : map_results) {
+        KeySketch sketch;
+        if (KeySketch::decode(result["winner_result"], sketch)) {
+            merged.merge(sketch);
+            sketches++;
+        }
+    }
+    if (sketches == 0) {
+        return {};
+    }
+    uint32_t max_salts = std::min<uint32_t>(MAX_KEY_SALTS, static_cast<uint32_t>(map_results.size()));
+    return find_hot_keys(merged, static_cast<uint32_t>(reduce_tasks), fraction, max_salts);
+}
+
+// Job config as stored for the job processor, from a submission
+// {"plugin_name": ..., "config": {...}}
+static bool PrepareJobSubmission(json::value body, std::string& plugin_name, std::string& config,
+                                 std::string& error) {
+    if (!body.is_object() || !body.has_string_field("plugin_name") || !body.has_field("config")) {
+        error = "Missing required fields: plugin_name, config";
+        return false;
+    }
+    plugin_name = body["plugin_name"].as_string();
+    
+    // The job processor reads the plugin from the stored config
+    json::value config_json = body["config"];
+    if (config_json.is_object()) {
+        config_json["plugin_name"] = json::value::string(plugin_name);
+    }
+    config = config_json.serialize();
+    return true;
+}
+
+static const std::vector<std::string> JOB_STATUS_FIELDS = {"status", "created_at", "completed_at", "progress", "error"};
+
+// Status response of a job from its JOB_STATUS_FIELDS
+static json::value JobStatusJson(const std::string& job_id, const std::unordered_map<std::string, std::string>& job) {
+    json::value response = json::value::object();
+    response["job_id"] = json::value::string(job_id);
+    response["status"] = json::value::string(job.at("status"));
+    
+    auto created_at = job.find("created_at");
+    if (created_at != job.end()) {
+        response["created_at"] = json::value::number(static_cast<int64_t>(std::stoll(created_at->second)));
+    }
+    
+    auto completed_at = job.find("completed_at");
+    if (completed_at != job.end()) {
+        response["completed_at"] = json::value::number(static_cast<int64_t>(std::stoll(completed_at->second)));
+    }
+    
+    // Get progress information
+    auto progress = job.find("progress");
+    if (progress != job.end()) {
+        response["progress_percent"] = json::value::number(std::stoi(progress->second));
+    }
+    
+    auto error = job.find("error");
+    if (error != job.end()) {
+        response["error"] = json::value::string(error->second);
+    }
+    return response;
+}
+
 ProductionCoordinator::ProductionCoordinator(int http_port, int grpc_port)
     : http_port_(http_port), grpc_port_(grpc_port),
       redis_host_("localhost"), redis_port_(6379),
-      worker_timeout_(300), job_processing_interval_(5),
+      redis_pool_size_(RedisConnectionPool::DEFAULT_POOL_SIZE), worker_timeout_(300), job_processing_interval_(5),
       running_(false), stopping_(false),
-      total_jobs_(0), completed_jobs_(0), failed_jobs_(0), active_workers_(0) {
+      total_jobs_(0), completed_jobs_(0), failed_jobs_(0), active_workers_(0),
+      start_time_(std::chrono::steady_clock::now()) {
 }
 
 ProductionCoordinator::~ProductionCoordinator() {
@@ -27,21 +164,35 @@ ProductionCoordinator::~ProductionCoordinator() {
 bool ProductionCoordinator::Initialize() {
     std::cout << "[INFO] Initializing Production Coordinator..." << std::endl;
     
-    // Initialize Redis connection
-    redis_ = std::make_unique<RedisClientProduction>();
-    if (!redis_->Connect(redis_host_, redis_port_)) {
+    // Initialize Redis connection pool
+    redis_pool_ = std::make_unique<RedisConnectionPool>(redis_host_, redis_port_, redis_pool_size_);
+    if (!redis_pool_->Initialize()) {
         std::cerr << "[ERROR] Failed to connect to Redis at " << redis_host_ << ":" << redis_port_ << std::endl;
         return false;
     }
     
     // Test Redis connection
-    if (!redis_->Ping()) {
-        std::cerr << "[ERROR] Redis ping test failed" << std::endl;
-        return false;
+    {
+        auto redis = redis_pool_->Acquire();
+        if (!redis || !redis->Ping()) {
+            std::cerr << "[ERROR] Redis ping test failed" << std::endl;
+            return false;
+        }
+        
+        // Jobs and task events a previous coordinator took but never finished
+        auto recovered = redis->RequeueAll("job_processing", "job_queue");
+        if (!recovered.empty()) {
+            std::cout << "[INFO] Requeued " << recovered.size() << " unfinished jobs" << std::endl;
+        }
+        redis->RequeueAll("task_events_processing", RedisClientProduction::TASK_EVENT_QUEUE);
+        redis->RequeueAll("task_dispatching", "task_queue");
     }
     
     std::cout << "[INFO] Redis connection established" << std::endl;
     
+    // One I/O thread per connection: more would only wait for a lease
+    redis_io_ = std::make_shared<IoScheduler>(redis_pool_size_);
+    
     // Initialize HTTP listener
     std::ostringstream address_builder;
     address_builder << "http://0.0.0.0:" << http_port_;
@@ -54,10 +205,14 @@ bool ProductionCoordinator::Initialize() {
         std::string path = request.relative_uri().path();
         if (path == "/api/status") {
             HandleGetStatus(request);
+        } else if (path == "/api/jobs/status") {
+            HandleGetJobsStatus(request);
         } else if (path.find("/api/jobs/") == 0 && path.find("/status") != std::string::npos) {
             HandleGetJobStatus(request);
         } else if (path == "/api/workers") {
             HandleGetWorkers(request);
+        } else if (path == "/api/metrics") {
+            HandleGetMetrics(request);
         } else {
             request.reply(status_codes::NotFound, CreateErrorResponse("Endpoint not found"));
         }
@@ -67,6 +222,8 @@ bool ProductionCoordinator::Initialize() {
         std::string path = request.relative_uri().path();
         if (path == "/api/jobs") {
             HandlePostJobs(request);
+        } else if (path == "/api/jobs:batch") {
+            HandlePostJobsBatch(request);
         } else {
             request.reply(status_codes::NotFound, CreateErrorResponse("Endpoint not found"));
         }
@@ -107,6 +264,8 @@ bool ProductionCoordinator::Start() {
     
     // Start background threads
     job_processing_thread_ = std::thread(&ProductionCoordinator::JobProcessingLoop, this);
+    task_event_thread_ = std::thread(&ProductionCoordinator::TaskEventLoop, this);
+    task_dispatch_thread_ = std::thread(&ProductionCoordinator::TaskDispatchLoop, this);
     worker_monitoring_thread_ = std::thread(&ProductionCoordinator::WorkerMonitoringLoop, this);
     cleanup_thread_ = std::thread(&ProductionCoordinator::CleanupLoop, this);
     
@@ -114,8 +273,11 @@ bool ProductionCoordinator::Start() {
     std::cout << "[INFO] API endpoints:" << std::endl;
     std::cout << "[INFO]   GET    /api/status" << std::endl;
     std::cout << "[INFO]   POST   /api/jobs" << std::endl;
+    std::cout << "[INFO]   POST   /api/jobs:batch" << std::endl;
     std::cout << "[INFO]   GET    /api/jobs/{job_id}/status" << std::endl;
+    std::cout << "[INFO]   GET    /api/jobs/status?ids=..." << std::endl;
     std::cout << "[INFO]   GET    /api/workers" << std::endl;
+    std::cout << "[INFO]   GET    /api/metrics" << std::endl;
     std::cout << "[INFO]   DELETE /api/jobs/{job_id}" << std::endl;
     
     return true;
@@ -140,6 +302,12 @@ void ProductionCoordinator::Stop() {
     if (job_processing_thread_.joinable()) {
         job_processing_thread_.join();
     }
+    if (task_event_thread_.joinable()) {
+        task_event_thread_.join();
+    }
+    if (task_dispatch_thread_.joinable()) {
+        task_dispatch_thread_.join();
+    }
     if (worker_monitoring_thread_.joinable()) {
         worker_monitoring_thread_.join();
     }
@@ -147,9 +315,14 @@ void ProductionCoordinator::Stop() {
         cleanup_thread_.join();
     }
     
+    // Requests in flight finish before their connections go away
+    if (redis_io_) {
+        redis_io_->Shutdown();
+    }
+    
     // Disconnect from Redis
-    if (redis_) {
-        redis_->Disconnect();
+    if (redis_pool_) {
+        redis_pool_->Shutdown();
     }
     
     running_ = false;
@@ -168,14 +341,21 @@ void ProductionCoordinator::HandleGetStatus(http_request request) {
     json::value response = json::value::object();
     response["status"] = json::value::string("online");
     response["version"] = json::value::string("1.0.0-production");
-    response["uptime"] = json::value::number(std::time(nullptr));
+    auto uptime = std::chrono::steady_clock::now() - start_time_;
+    response["uptime"] = json::value::number(static_cast<int64_t>(
+        std::chrono::duration_cast<std::chrono::seconds>(uptime).count()));
     response["total_jobs"] = json::value::number(total_jobs_.load());
     response["completed_jobs"] = json::value::number(completed_jobs_.load());
     response["failed_jobs"] = json::value::number(failed_jobs_.load());
     response["active_workers"] = json::value::number(active_workers_.load());
-    response["redis_connected"] = json::value::boolean(redis_ && redis_->IsConnected());
     
-    request.reply(status_codes::OK, CreateSuccessResponse(response));
+    WithRedis(request, [this, request, response](RedisClientProduction& redis) mutable {
+        response["redis_connected"] = json::value::boolean(redis.IsConnected());
+        response["redis_pool_size"] = json::value::number(static_cast<int>(redis_pool_->Size()));
+        response["redis_pool_available"] = json::value::number(static_cast<int>(redis_pool_->Available()));
+        response["redis_io_pending"] = json::value::number(static_cast<int>(redis_io_->Pending()));
+        request.reply(status_codes::OK, CreateSuccessResponse(response));
+    });
 }
 
 void ProductionCoordinator::HandlePostJobs(http_request request) {
@@ -183,22 +363,22 @@ void ProductionCoordinator::HandlePostJobs(http_request request) {
     
     request.extract_json().then([=](pplx::task<json::value> task) {
         try {
-            json::value body = task.get();
-            
-            // Validate required fields
-            if (!body.has_field("plugin_name") || !body.has_field("config")) {
-                request.reply(status_codes::BadRequest, 
-                    CreateErrorResponse("Missing required fields: plugin_name, config"));
+            std::string plugin_name;
+            std::string config;
+            std::string error;
+            if (!PrepareJobSubmission(task.get(), plugin_name, config, error)) {
+                request.reply(status_codes::BadRequest, CreateErrorResponse(error));
                 return;
             }
             
-            std::string plugin_name = body["plugin_name"].as_string();
-            std::string config = body["config"].serialize();
-            
             // Generate job ID and submit to Redis
             std::string job_id = GenerateJobId();
-            
-            if (redis_->SubmitJob(job_id, config)) {
+            WithRedis(request, [this, request, job_id, config, plugin_name](RedisClientProduction& redis) {
+                if (!redis.SubmitJob(job_id, config)) {
+                    request.reply(status_codes::InternalError,
+                        CreateErrorResponse("Failed to submit job to Redis"));
+                    return;
+                }
                 total_jobs_++;
                 
                 json::value response = json::value::object();
@@ -209,11 +389,77 @@ void ProductionCoordinator::HandlePostJobs(http_request request) {
                 request.reply(status_codes::Created, CreateSuccessResponse(response));
                 
                 std::cout << "[INFO] Job submitted: " << job_id << " (plugin: " << plugin_name << ")" << std::endl;
-            } else {
-                request.reply(status_codes::InternalError,
-                    CreateErrorResponse("Failed to submit job to Redis"));
+            });
+            
+        } catch (const std::exception& e) {
+            request.reply(status_codes::BadRequest,
+                CreateErrorResponse("Invalid JSON payload: " + std::string(e.what())));
+        }
+    });
+}
+
+void ProductionCoordinator::HandlePostJobsBatch(http_request request) {
+    LogRequest(request);
+    
+    // {"jobs": [<POST /api/jobs body>, ...]}: the valid jobs are submitted in
+    // one transaction, the others are reported by index
+    request.extract_json().then([=](pplx::task<json::value> task) {
+        try {
+            json::value body = task.get();
+            if (!body.is_object() || !body.has_array_field("jobs")) {
+                request.reply(status_codes::BadRequest, CreateErrorResponse("Missing required field: jobs"));
+                return;
+            }
+            const auto& entries = body.at("jobs").as_array();
+            if (entries.size() > MAX_BATCH_JOBS) {
+                request.reply(status_codes::BadRequest, CreateErrorResponse(
+                    "At most " + std::to_string(MAX_BATCH_JOBS) + " jobs per batch"));
+                return;
             }
             
+            std::vector<std::pair<std::string, std::string>> jobs;
+            json::value results = json::value::array(entries.size());
+            std::unordered_set<std::string> job_ids;
+            for (size_t i = 0; i < entries.size(); ++i) {
+                std::string plugin_name;
+                std::string config;
+                std::string error;
+                json::value result = json::value::object();
+                result["index"] = json::value::number(static_cast<int64_t>(i));
+                if (!PrepareJobSubmission(entries.at(i), plugin_name, config, error)) {
+                    result["error"] = json::value::string(error);
+                    results[i] = result;
+                    continue;
+                }
+                
+                std::string job_id = GenerateJobId();
+                while (!job_ids.insert(job_id).second) {
+                    job_id = GenerateJobId();
+                }
+                result["job_id"] = json::value::string(job_id);
+                result["status"] = json::value::string("submitted");
+                results[i] = result;
+                jobs.emplace_back(job_id, std::move(config));
+            }
+            
+            WithRedis(request, [this, request, jobs, results](RedisClientProduction& redis) {
+                if (!redis.SubmitJobs(jobs)) {
+                    request.reply(status_codes::InternalError,
+                        CreateErrorResponse("Failed to submit jobs to Redis"));
+                    return;
+                }
+                total_jobs_ += static_cast<int>(jobs.size());
+                
+                json::value response = json::value::object();
+                response["jobs"] = results;
+                response["submitted"] = json::value::number(static_cast<int64_t>(jobs.size()));
+                response["created_at"] = json::value::number(std::time(nullptr));
+                
+                request.reply(status_codes::Created, CreateSuccessResponse(response));
+                
+                std::cout << "[INFO] Batch of " << jobs.size() << " jobs submitted" << std::endl;
+            });
+            
         } catch (const std::exception& e) {
             request.reply(status_codes::BadRequest,
                 CreateErrorResponse("Invalid JSON payload: " + std::string(e.what())));
@@ -221,6 +467,55 @@ void ProductionCoordinator::HandlePostJobs(http_request request) {
     });
 }
 
+void ProductionCoordinator::HandleGetJobsStatus(http_request request) {
+    LogRequest(request);
+    
+    // /api/jobs/status?ids=<job_id>,<job_id>,...
+    auto query = uri::split_query(request.relative_uri().query());
+    auto ids = query.find("ids");
+    std::vector<std::string> job_ids;
+    if (ids != query.end()) {
+        for (const auto& job_id : Utils::split(uri::decode(ids->second), ',')) {
+            if (!job_id.empty()) {
+                job_ids.push_back(job_id);
+            }
+        }
+    }
+    if (job_ids.empty() || job_ids.size() > MAX_BATCH_JOBS) {
+        request.reply(status_codes::BadRequest, CreateErrorResponse(
+            "Parameter ids must list 1 to " + std::to_string(MAX_BATCH_JOBS) + " job IDs"));
+        return;
+    }
+    
+    WithRedis(request, [this, request, job_ids](RedisClientProduction& redis) {
+        std::vector<std::string> keys;
+        keys.reserve(job_ids.size());
+        for (const auto& job_id : job_ids) {
+            keys.push_back("job:" + job_id);
+        }
+        auto jobs = redis.GetHashesFields(keys, JOB_STATUS_FIELDS);
+        
+        json::value statuses = json::value::array(job_ids.size());
+        size_t found = 0;
+        for (size_t i = 0; i < job_ids.size(); ++i) {
+            if (jobs[i].count("status") == 0) {
+                json::value missing = json::value::object();
+                missing["job_id"] = json::value::string(job_ids[i]);
+                missing["error"] = json::value::string("Job not found");
+                statuses[i] = missing;
+                continue;
+            }
+            statuses[i] = JobStatusJson(job_ids[i], jobs[i]);
+            found++;
+        }
+        
+        json::value response = json::value::object();
+        response["jobs"] = statuses;
+        response["count"] = json::value::number(static_cast<int64_t>(found));
+        request.reply(status_codes::OK, CreateSuccessResponse(response));
+    });
+}
+
 void ProductionCoordinator::HandleGetJobStatus(http_request request) {
     LogRequest(request);
     
@@ -242,70 +537,74 @@ void ProductionCoordinator::HandleGetJobStatus(http_request request) {
     
     std::string job_id = path.substr(job_start, job_end - job_start);
     
-    // Get job status from Redis
-    std::string status, created_at, completed_at;
-    if (redis_->GetHash("job:" + job_id, "status", status)) {
-        json::value response = json::value::object();
-        response["job_id"] = json::value::string(job_id);
-        response["status"] = json::value::string(status);
-        
-        if (redis_->GetHash("job:" + job_id, "created_at", created_at)) {
-            response["created_at"] = json::value::number(static_cast<int64_t>(std::stoll(created_at)));
-        }
-        
-        if (redis_->GetHash("job:" + job_id, "completed_at", completed_at)) {
-            response["completed_at"] = json::value::number(static_cast<int64_t>(std::stoll(completed_at)));
+    WithRedis(request, [this, request, job_id](RedisClientProduction& redis) {
+        // Get job status from Redis, all fields in one round trip
+        auto job = redis.GetHashFields("job:" + job_id, JOB_STATUS_FIELDS);
+        if (job.count("status") == 0) {
+            request.reply(status_codes::NotFound, CreateErrorResponse("Job not found"));
+            return;
         }
+        request.reply(status_codes::OK, CreateSuccessResponse(JobStatusJson(job_id, job)));
+    });
+}
+
+void ProductionCoordinator::HandleGetWorkers(http_request request) {
+    LogRequest(request);
+    
+    WithRedis(request, [this, request](RedisClientProduction& redis) {
+        json::value workers_array = json::value::array();
+        int index = 0;
         
-        // Get progress information
-        std::string progress, error;
-        if (redis_->GetHash("job:" + job_id, "progress", progress)) {
-            response["progress_percent"] = json::value::number(std::stoi(progress));
+        for (const auto& worker : *CachedWorkers(redis)) {
+            if (IsWorkerActive(worker)) {
+                json::value worker_info = json::value::object();
+                worker_info["worker_id"] = json::value::string(worker.worker_id);
+                
+                auto field = [&worker](const char* name) {
+                    auto it = worker.fields.find(name);
+                    return it != worker.fields.end() ? it->second : std::string();
+                };
+                std::string port = field("port");
+                
+                worker_info["host"] = json::value::string(field("host"));
+                worker_info["port"] = json::value::number(port.empty() ? 0 : std::stoi(port));
+                worker_info["status"] = json::value::string(field("status"));
+                worker_info["last_heartbeat"] = json::value::number(static_cast<int64_t>(std::stoll(field("last_heartbeat"))));
+                worker_info["memory_mb"] = json::value::number(std::atoi(field("memory_mb").c_str()));
+                worker_info["cpu_percent"] = json::value::number(std::atoi(field("cpu_percent").c_str()));
+                worker_info["active_tasks"] = json::value::number(std::atoi(field("active_tasks").c_str()));
+                worker_info["task_slots"] = json::value::number(std::atoi(field("task_slots").c_str()));
+                
+                workers_array[index++] = worker_info;
+            }
         }
         
-        if (redis_->GetHash("job:" + job_id, "error", error)) {
-            response["error"] = json::value::string(error);
-        }
+        json::value response = json::value::object();
+        response["workers"] = workers_array;
+        response["count"] = json::value::number(index);
         
         request.reply(status_codes::OK, CreateSuccessResponse(response));
-    } else {
-        request.reply(status_codes::NotFound, CreateErrorResponse("Job not found"));
-    }
+    });
 }
 
-void ProductionCoordinator::HandleGetWorkers(http_request request) {
+void ProductionCoordinator::HandleGetMetrics(http_request request) {
     LogRequest(request);
     
-    std::vector<std::string> workers = redis_->GetActiveWorkers();
+    // Workers report their snapshot with every heartbeat
+    std::vector<std::pair<std::pair<std::string, std::string>, MetricsSnapshot>> sources;
+    sources.push_back({{"process", "coordinator"}, Metrics::snapshot()});
     
-    json::value workers_array = json::value::array();
-    int index = 0;
-    
-    for (const auto& worker_id : workers) {
-        if (IsWorkerActive(worker_id)) {
-            json::value worker_info = json::value::object();
-            worker_info["worker_id"] = json::value::string(worker_id);
-            
-            std::string host, port, status, last_heartbeat;
-            redis_->GetHash("worker:" + worker_id, "host", host);
-            redis_->GetHash("worker:" + worker_id, "port", port);
-            redis_->GetHash("worker:" + worker_id, "status", status);
-            redis_->GetHash("worker:" + worker_id, "last_heartbeat", last_heartbeat);
-            
-            worker_info["host"] = json::value::string(host);
-            worker_info["port"] = json::value::number(std::stoi(port));
-            worker_info["status"] = json::value::string(status);
-            worker_info["last_heartbeat"] = json::value::number(static_cast<int64_t>(std::stoll(last_heartbeat)));
-            
-            workers_array[index++] = worker_info;
+    WithRedis(request, [this, request, sources](RedisClientProduction& redis) mutable {
+        for (const auto& worker : *CachedWorkers(redis)) {
+            auto it = worker.fields.find("metrics");
+            MetricsSnapshot snapshot;
+            if (IsWorkerActive(worker) && it != worker.fields.end() &&
+                MetricsSnapshot::decode(it->second, snapshot)) {
+                sources.push_back({{"worker", worker.worker_id}, std::move(snapshot)});
+            }
         }
-    }
-    
-    json::value response = json::value::object();
-    response["workers"] = workers_array;
-    response["count"] = json::value::number(index);
-    
-    request.reply(status_codes::OK, CreateSuccessResponse(response));
+        request.reply(status_codes::OK, Metrics::render_prometheus(sources), "text/plain; version=0.0.4");
+    });
 }
 
 void ProductionCoordinator::HandleDeleteJob(http_request request) {
@@ -323,11 +622,17 @@ void ProductionCoordinator::HandleDeleteJob(http_request request) {
     size_t job_start = jobs_pos + 10; // Length of "/api/jobs/"
     std::string job_id = path.substr(job_start);
     
-    // Check if job exists
-    if (redis_->Exists("job:" + job_id)) {
+    WithRedis(request, [this, request, job_id](RedisClientProduction& redis) {
+        if (!redis.Exists("job:" + job_id)) {
+            request.reply(status_codes::NotFound, CreateErrorResponse("Job not found"));
+            return;
+        }
+        
         // Mark job as cancelled
-        redis_->SetHash("job:" + job_id, "status", "cancelled");
-        redis_->SetHash("job:" + job_id, "cancelled_at", std::to_string(std::time(nullptr)));
+        redis.SetHashFields("job:" + job_id, {{"status", "cancelled"},
+                                              {"cancelled_at", std::to_string(std::time(nullptr))}});
+        redis.RemoveFromSet("active_jobs", job_id);
+        ForgetJob(job_id);
         
         json::value response = json::value::object();
         response["job_id"] = json::value::string(job_id);
@@ -336,9 +641,7 @@ void ProductionCoordinator::HandleDeleteJob(http_request request) {
         request.reply(status_codes::OK, CreateSuccessResponse(response));
         
         std::cout << "[INFO] Job cancelled: " << job_id << std::endl;
-    } else {
-        request.reply(status_codes::NotFound, CreateErrorResponse("Job not found"));
-    }
+    });
 }
 
 // Background processing loops
@@ -346,18 +649,61 @@ void ProductionCoordinator::JobProcessingLoop() {
     std::cout << "[INFO] Job processing loop started" << std::endl;
     
     while (!stopping_) {
+        // ProcessPendingJobs blocks on the job queue itself, the interval is
+        // only a back-off when no progress can be made
+        bool progressed = false;
         try {
-            ProcessPendingJobs();
+            progressed = ProcessPendingJobs();
         } catch (const std::exception& e) {
             std::cerr << "[ERROR] Job processing error: " << e.what() << std::endl;
         }
         
-        std::this_thread::sleep_for(std::chrono::seconds(job_processing_interval_));
+        if (!progressed && !stopping_) {
+            std::this_thread::sleep_for(std::chrono::seconds(job_processing_interval_));
+        }
     }
     
     std::cout << "[INFO] Job processing loop stopped" << std::endl;
 }
 
+void ProductionCoordinator::TaskEventLoop() {
+    std::cout << "[INFO] Task event loop started" << std::endl;
+    
+    while (!stopping_) {
+        bool progressed = false;
+        try {
+            progressed = ProcessTaskEvents();
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] Task event error: " << e.what() << std::endl;
+        }
+        
+        if (!progressed && !stopping_) {
+            std::this_thread::sleep_for(std::chrono::seconds(job_processing_interval_));
+        }
+    }
+    
+    std::cout << "[INFO] Task event loop stopped" << std::endl;
+}
+
+void ProductionCoordinator::TaskDispatchLoop() {
+    std::cout << "[INFO] Task dispatch loop started" << std::endl;
+    
+    while (!stopping_) {
+        bool progressed = false;
+        try {
+            progressed = DispatchPendingTasks();
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] Task dispatch error: " << e.what() << std::endl;
+        }
+        
+        if (!progressed && !stopping_) {
+            std::this_thread::sleep_for(std::chrono::seconds(job_processing_interval_));
+        }
+    }
+    
+    std::cout << "[INFO] Task dispatch loop stopped" << std::endl;
+}
+
 void ProductionCoordinator::WorkerMonitoringLoop() {
     std::cout << "[INFO] Worker monitoring loop started" << std::endl;
     
@@ -394,9 +740,12 @@ void ProductionCoordinator::CleanupLoop() {
 
 // Helper methods
 std::string ProductionCoordinator::GenerateJobId() {
+    // Called from every HTTP thread
+    static std::mutex mutex;
     static std::random_device rd;
     static std::mt19937 gen(rd());
     static std::uniform_int_distribution<> dis(100000, 999999);
+    std::lock_guard<std::mutex> lock(mutex);
     
     auto now = std::chrono::system_clock::now();
     auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
@@ -405,87 +754,957 @@ std::string ProductionCoordinator::GenerateJobId() {
 }
 
 bool ProductionCoordinator::ProcessPendingJobs() {
-    // Get pending jobs from Redis queue
-    int queue_length = redis_->GetListLength("job_queue");
-    if (queue_length <= 0) return true;
-    
-    std::cout << "[DEBUG] Processing " << queue_length << " pending jobs" << std::endl;
+    auto redis = redis_pool_->Acquire();
+    if (!redis) return false;
     
-    // Process jobs one by one
+    // Wakes as soon as a job is submitted. The job stays on job_processing
+    // until its tasks are queued, so a coordinator crash cannot lose it.
     std::string job_id;
-    while (redis_->PopLeft("job_queue", job_id)) {
-        // Check if we have available workers
-        std::vector<std::string> workers = GetAvailableWorkers();
-        if (workers.empty()) {
-            // Put job back in queue if no workers available
-            redis_->PushLeft("job_queue", job_id);
-            break;
+    if (!redis->BlockingMove("job_queue", "job_processing", job_id, JOB_QUEUE_WAIT_SECONDS)) {
+        return redis->IsConnected();
+    }
+    
+    // Check if we have available workers
+    std::vector<std::string> workers = GetAvailableWorkers(*redis);
+    if (workers.empty()) {
+        // Back to the consumer end so the job keeps its place
+        RedisPipeline requeue(*redis, true);
+        requeue.Add({"LREM", "job_processing", "1", job_id});
+        requeue.Add({"RPUSH", "job_queue", job_id});
+        requeue.Execute();
+        return false;
+    }
+    
+    JobConfig config;
+    if (!LoadJobConfig(*redis, job_id, config)) {
+        FailJob(*redis, job_id, "Invalid job configuration");
+        redis->RemoveFromList("job_processing", 1, job_id);
+        return true;
+    }
+    
+    // Map parallelism follows the input size, reduce fan-out the cluster size
+    JobPlan plan = plan_job(config, workers.size());
+    std::string error;
+    if (!plan.unreadable_inputs.empty()) {
+        error = "Cannot read input: " + plan.unreadable_inputs.front();
+    } else if (plan.map_tasks.empty()) {
+        error = "Job has no input files";
+    } else {
+        std::error_code ec;
+        std::filesystem::create_directories(config.output_directory, ec);
+        if (ec) {
+            error = "Cannot create output directory: " + config.output_directory;
+        }
+    }
+    if (!error.empty()) {
+        FailJob(*redis, job_id, error);
+        redis->RemoveFromList("job_processing", 1, job_id);
+        return true;
+    }
+    
+    std::vector<Task> tasks;
+    for (size_t i = 0; i < plan.map_tasks.size(); ++i) {
+        Task task{};
+        task.id = job_id + "_map_" + std::to_string(i);
+        task.type = TaskType::MAP;
+        task.status = TaskStatus::PENDING;
+        task.plugin_name = config.plugin_name;
+        for (const auto& split : plan.map_tasks[i]) {
+            task.input_files.push_back(split.to_string());
+        }
+        task.output_file = config.output_directory + "/" + task.id;
+        task.parameters = config.parameters;
+        task.parameters["num_reduce_tasks"] = std::to_string(plan.num_reduce_tasks);
+        task.created_time = Utils::get_timestamp_ms();
+        tasks.push_back(std::move(task));
+    }
+    
+    // Cache keys of map tasks cover their input splits as they are now
+    if (config.parameters.count("task_cache_dir") > 0) {
+        for (auto& task : tasks) {
+            std::vector<std::string> digests;
+            for (const auto& split : task.input_files) {
+                digests.push_back(input_split_digest(split));
+            }
+            task.parameters["cache_key_base"] = TaskCache::base_key(config.plugin_name, TaskType::MAP,
+                                                                    task.parameters, digests);
+        }
+    }
+    size_t map_tasks = tasks.size();
+    
+    // Update job status to processing
+    redis->AddToSet("active_jobs", job_id);
+    redis->SetHashFields("job:" + job_id, {{"status", "processing"},
+                                            {"phase", "map"},
+                                            {"map_tasks", std::to_string(map_tasks)},
+                                            {"reduce_tasks", std::to_string(plan.num_reduce_tasks)},
+                                            {"progress", "0"},
+                                            {"started_at", std::to_string(std::time(nullptr))}});
+    
+    size_t cached = CompleteCachedTasks(*redis, job_id, config, tasks);
+    if (!QueueTasks(*redis, job_id, tasks)) {
+        // Still on job_processing; requeued when the coordinator restarts
+        std::cerr << "[ERROR] Failed to queue map tasks for job " << job_id << std::endl;
+        return false;
+    }
+    redis->RemoveFromList("job_processing", 1, job_id);
+    
+    std::cout << "[INFO] Job " << job_id << " started processing: " << map_tasks << " map tasks";
+    if (cached > 0) {
+        std::cout << " (" << cached << " cached)";
+    }
+    std::cout << " over " << plan.total_bytes << " bytes, " << plan.num_reduce_tasks << " reduce tasks, "
+              << workers.size() << " workers" << std::endl;
+    
+    // With every map output cached no task event will start the reduce phase
+    if (tasks.empty()) {
+        CheckJobCompletion(*redis, job_id);
+    }
+    return true;
+}
+
+bool ProductionCoordinator::ProcessTaskEvents() {
+    auto redis = redis_pool_->Acquire();
+    if (!redis) return false;
+    
+    // Timeouts bound the wait, so stragglers are checked even when idle
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_straggler_check_ >= STRAGGLER_CHECK_INTERVAL) {
+        last_straggler_check_ = now;
+        CheckStragglers(*redis);
+    }
+    
+    std::string task_id;
+    if (!redis->BlockingMove(RedisClientProduction::TASK_EVENT_QUEUE, "task_events_processing",
+                             task_id, JOB_QUEUE_WAIT_SECONDS)) {
+        return redis->IsConnected();
+    }
+    
+    HandleTaskEvent(*redis, task_id);
+    redis->RemoveFromList("task_events_processing", 1, task_id);
+    return true;
+}
+
+bool ProductionCoordinator::DispatchPendingTasks() {
+    auto redis = redis_pool_->Acquire();
+    if (!redis) return false;
+    
+    std::string task_id;
+    if (!redis->BlockingMove("task_queue", "task_dispatching", task_id, JOB_QUEUE_WAIT_SECONDS)) {
+        return redis->IsConnected();
+    }
+    
+    auto now = std::chrono::steady_clock::now();
+    if (scheduler_.Empty() || now - scheduler_refreshed_ >= SCHEDULER_REFRESH_INTERVAL) {
+        scheduler_.Refresh(LoadWorkerLoads(*redis));
+        scheduler_refreshed_ = now;
+    }
+    
+    auto fields = redis->GetHashFields("task:" + task_id, {"data", "status"});
+    if (fields["status"] == "cancelled") {
+        // A speculative attempt that lost before it was placed
+        redis->RemoveFromList("task_dispatching", 1, task_id);
+        return true;
+    }
+    
+    // A task whose data cannot be decoded is still placed, just without locality
+    Task task;
+    decode_task(fields["data"], task);
+    
+    std::string worker_id = scheduler_.SelectWorker(task.input_files,
+                                                    DecodeInputHosts(task.parameters["input_hosts"]),
+                                                    task.parameters["avoid_worker"]);
+    if (worker_id.empty()) {
+        // No live worker; back to the consumer end until one registers
+        RedisPipeline requeue(*redis, true);
+        requeue.Add({"LREM", "task_dispatching", "1", task_id});
+        requeue.Add({"RPUSH", "task_queue", task_id});
+        requeue.Execute();
+        return false;
+    }
+    
+    return redis->AssignTask(task_id, worker_id, "task_dispatching");
+}
+
+bool ProductionCoordinator::ParseJobConfig(const std::string& job_id, const std::string& config_json,
+                                           JobConfig& config) {
+    try {
+        json::value body = json::value::parse(config_json);
+        if (!body.is_object() || !body.has_array_field("input_files") ||
+            !body.has_string_field("output_directory")) {
+            return false;
+        }
+        
+        config = JobConfig{};
+        config.job_id = job_id;
+        config.plugin_name = body.has_string_field("plugin_name") ? body.at("plugin_name").as_string() : "";
+        for (const auto& input : body.at("input_files").as_array()) {
+            config.input_files.push_back(input.as_string());
+        }
+        config.output_directory = body.at("output_directory").as_string();
+        config.num_map_tasks = body.has_integer_field("num_map_tasks") ? body.at("num_map_tasks").as_integer() : 0;
+        config.num_reduce_tasks = body.has_integer_field("num_reduce_tasks") ? body.at("num_reduce_tasks").as_integer() : 0;
+        
+        if (body.has_field("parameters") && body.at("parameters").is_object()) {
+            for (const auto& parameter : body.at("parameters").as_object()) {
+                config.parameters[parameter.first] = parameter.second.is_string()
+                    ? parameter.second.as_string() : parameter.second.serialize();
+            }
+        }
+        return !config.plugin_name.empty() && !config.output_directory.empty();
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] Invalid config for job " << job_id << ": " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool ProductionCoordinator::LoadJobConfig(RedisClientProduction& redis, const std::string& job_id,
+                                          JobConfig& config) {
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        auto cached = job_configs_.find(job_id);
+        if (cached != job_configs_.end()) {
+            config = cached->second;
+            return true;
+        }
+    }
+    
+    std::string config_json;
+    if (!redis.GetHash("job:" + job_id, "config", config_json) || !ParseJobConfig(job_id, config_json, config)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    job_configs_.emplace(job_id, config);
+    return true;
+}
+
+void ProductionCoordinator::ForgetJob(const std::string& job_id) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    job_configs_.erase(job_id);
+}
+
+bool ProductionCoordinator::QueueTasks(RedisClientProduction& redis, const std::string& job_id,
+                                       const std::vector<Task>& tasks) {
+    std::vector<std::pair<std::string, std::string>> encoded;
+    encoded.reserve(tasks.size());
+    for (const auto& task : tasks) {
+        encoded.emplace_back(task.id, encode_task(task));
+    }
+    return redis.AddTasks(job_id, encoded);
+}
+
+std::vector<std::string> ProductionCoordinator::ShuffleInputs(
+    RedisClientProduction& redis, std::vector<std::unordered_map<std::string, std::string>>& results,
+    const std::vector<std::string>& default_outputs, std::string& encoded_hosts) {
+    std::unordered_map<std::string, size_t> worker_outputs;
+    for (auto& result : results) {
+        if (!result["winner_worker"].empty()) {
+            worker_outputs[result["winner_worker"]]++;
+        }
+    }
+    
+    // Readers fetch each run from the worker that wrote it, and prefer the
+    // hosts that wrote most of their input
+    std::unordered_map<std::string, std::unordered_map<std::string, std::string>> worker_addresses;
+    std::unordered_map<std::string, size_t> input_hosts;
+    for (const auto& [worker_id, count] : worker_outputs) {
+        auto address = redis.GetHashFields("worker:" + worker_id, {"host", "port"});
+        if (!address["host"].empty()) {
+            input_hosts[address["host"]] += count;
+        }
+        worker_addresses[worker_id] = std::move(address);
+    }
+    encoded_hosts = EncodeInputHosts(input_hosts);
+    
+    // A run whose writer is unknown has to be on a shared filesystem
+    std::vector<std::string> inputs;
+    for (size_t i = 0; i < results.size(); ++i) {
+        auto& result = results[i];
+        ShuffleLocation input;
+        input.path = result.count("output") ? result["output"] : default_outputs[i];
+        auto address = worker_addresses.find(result["winner_worker"]);
+        if (address != worker_addresses.end() && !address->second["host"].empty() &&
+            std::atoi(address->second["port"].c_str()) > 0) {
+            input.host = address->second["host"];
+            input.port = std::atoi(address->second["port"].c_str());
+        }
+        inputs.push_back(input.to_string());
+    }
+    return inputs;
+}
+
+size_t ProductionCoordinator::CompleteCachedTasks(RedisClientProduction& redis, const std::string& job_id,
+                                                  const JobConfig& config, std::vector<Task>& tasks) {
+    // No version is recorded until a worker has published an output of the plugin
+    auto cache_dir = config.parameters.find("task_cache_dir");
+    std::string version;
+    if (cache_dir == config.parameters.end() ||
+        !redis.GetHash("plugin_versions", config.plugin_name, version) || version.empty()) {
+        return 0;
+    }
+    
+    TaskCache cache(cache_dir->second);
+    std::string now = std::to_string(std::time(nullptr));
+    RedisPipeline record(redis, true);
+    std::vector<Task> uncached;
+    std::vector<Task> cached;
+    for (auto& task : tasks) {
+        auto base_key = task.parameters.find("cache_key_base");
+        TaskCacheEntry entry;
+        if (base_key == task.parameters.end() ||
+            !cache.lookup(TaskCache::versioned_key(base_key->second, version), entry)) {
+            uncached.push_back(std::move(task));
+            continue;
+        }
+        
+        // Map runs are read straight from the cache; reduce outputs belong
+        // in the job's output directory
+        std::string output = entry.output;
+        if (task.type == TaskType::REDUCE) {
+            if (!TaskCache::link_or_copy(entry.output, task.output_file)) {
+                uncached.push_back(std::move(task));
+                continue;
+            }
+            output = task.output_file;
+        }
+        record.Add({"HMSET", "task:" + task.id,
+                    "job_id", job_id,
+                    "data", encode_task(task),
+                    "status", "completed",
+                    "created_at", now,
+                    "winner", task.id,
+                    "output", output,
+                    "winner_result", entry.result,
+                    "cached", "1"});
+        record.Add({"SADD", "job:" + job_id + ":tasks", task.id});
+        record.Add({"SADD", "job:" + job_id + (task.type == TaskType::MAP ? ":map_done" : ":reduce_done"), task.id});
+        cached.push_back(std::move(task));
+    }
+    
+    if (!cached.empty() && !record.Execute()) {
+        // Nothing was recorded, so the tasks simply run
+        std::cerr << "[ERROR] Failed to record cached tasks of job " << job_id << std::endl;
+        uncached.insert(uncached.end(), std::make_move_iterator(cached.begin()),
+                        std::make_move_iterator(cached.end()));
+        cached.clear();
+    }
+    tasks = std::move(uncached);
+    return cached.size();
+}
+
+bool ProductionCoordinator::LoadMapDigests(RedisClientProduction& redis, const JobConfig& config,
+                                           std::vector<std::unordered_map<std::string, std::string>>& map_results,
+                                           int reduce_tasks, std::vector<std::vector<std::string>>& digests) {
+    auto cache_dir = config.parameters.find("task_cache_dir");
+    std::string version;
+    if (cache_dir == config.parameters.end() ||
+        !redis.GetHash("plugin_versions", config.plugin_name, version) || version.empty()) {
+        return false;
+    }
+    
+    // Computed map outputs were published by their workers by the time they reported
+    TaskCache cache(cache_dir->second);
+    digests.clear();
+    for (auto& result : map_results) {
+        Task map_task;
+        TaskCacheEntry entry;
+        if (!decode_task(result["data"], map_task) || map_task.parameters["cache_key_base"].empty() ||
+            !cache.lookup(TaskCache::versioned_key(map_task.parameters["cache_key_base"], version), entry) ||
+            entry.digests.size() != static_cast<size_t>(reduce_tasks)) {
+            return false;
+        }
+        digests.push_back(std::move(entry.digests));
+    }
+    return true;
+}
+
+bool ProductionCoordinator::StartReducePhase(RedisClientProduction& redis, const std::string& job_id) {
+    auto job = redis.GetHashFields("job:" + job_id, {"map_tasks", "reduce_tasks"});
+    JobConfig config;
+    if (!LoadJobConfig(redis, job_id, config)) {
+        FailJob(redis, job_id, "Invalid job configuration");
+        return false;
+    }
+    
+    int map_tasks = std::atoi(job["map_tasks"].c_str());
+    int reduce_tasks = std::max(1, std::atoi(job["reduce_tasks"].c_str()));
+    
+    // Every reducer merges its partition out of the winning attempt of every map task
+    std::vector<std::string> map_task_keys;
+    std::vector<std::string> default_outputs;
+    for (int i = 0; i < map_tasks; ++i) {
+        map_task_keys.push_back("task:" + job_id + "_map_" + std::to_string(i));
+        default_outputs.push_back(config.output_directory + "/" + job_id + "_map_" + std::to_string(i));
+    }
+    // Only what ShuffleInputs, FindJobHotKeys and LoadMapDigests read
+    auto map_results = redis.GetHashesFields(map_task_keys, {"output", "winner_worker", "winner_result", "data"});
+    std::string encoded_hosts;
+    std::vector<std::string> map_inputs = ShuffleInputs(redis, map_results, default_outputs, encoded_hosts);
+    std::vector<HotKey> hot_keys = FindJobHotKeys(config, map_results, reduce_tasks);
+    
+    std::string skip_keys;
+    for (const auto& hot_key : hot_keys) {
+        skip_keys += (skip_keys.empty() ? "" : ",") + hex_encode_key(hot_key.key);
+    }
+    
+    std::vector<Task> tasks;
+    for (int r = 0; r < reduce_tasks; ++r) {
+        Task task{};
+        task.id = job_id + "_reduce_" + std::to_string(r);
+        task.type = TaskType::REDUCE;
+        task.status = TaskStatus::PENDING;
+        task.plugin_name = config.plugin_name;
+        task.input_files = map_inputs;
+        task.output_file = config.output_directory + "/part-" + std::to_string(r);
+        task.parameters = config.parameters;
+        task.parameters["num_reduce_tasks"] = std::to_string(reduce_tasks);
+        task.parameters["reduce_partition"] = std::to_string(r);
+        if (!skip_keys.empty()) {
+            task.parameters["skip_keys"] = skip_keys;
+        }
+        if (!encoded_hosts.empty()) {
+            task.parameters["input_hosts"] = encoded_hosts;
+        }
+        task.created_time = Utils::get_timestamp_ms();
+        tasks.push_back(std::move(task));
+    }
+    
+    // A partition reducer's cache key covers its partition of every map
+    // output; the salted tasks are not cached
+    std::vector<std::vector<std::string>> map_digests;
+    if (LoadMapDigests(redis, config, map_results, reduce_tasks, map_digests)) {
+        for (int r = 0; r < reduce_tasks; ++r) {
+            std::vector<std::string> digests;
+            for (const auto& partitions : map_digests) {
+                digests.push_back(partitions[r]);
+            }
+            tasks[r].parameters["cache_key_base"] = TaskCache::base_key(config.plugin_name, TaskType::REDUCE,
+                                                                        tasks[r].parameters, digests);
+        }
+    }
+    
+    // Salt s of a hot key reads the map outputs i with i % salts == s
+    size_t partial_tasks = 0;
+    for (const auto& hot_key : hot_keys) {
+        for (uint32_t salt = 0; salt < hot_key.salts; ++salt) {
+            Task task{};
+            task.id = job_id + "_reduce_" + std::to_string(reduce_tasks + partial_tasks);
+            task.type = TaskType::REDUCE;
+            task.status = TaskStatus::PENDING;
+            task.plugin_name = config.plugin_name;
+            for (size_t i = salt; i < map_inputs.size(); i += hot_key.salts) {
+                task.input_files.push_back(map_inputs[i]);
+            }
+            task.output_file = config.output_directory + "/" + job_id + "_partial_" + std::to_string(partial_tasks);
+            task.parameters = config.parameters;
+            task.parameters["num_reduce_tasks"] = std::to_string(reduce_tasks);
+            task.parameters["reduce_key"] = hex_encode_key(hot_key.key);
+            if (!encoded_hosts.empty()) {
+                task.parameters["input_hosts"] = encoded_hosts;
+            }
+            task.created_time = Utils::get_timestamp_ms();
+            tasks.push_back(std::move(task));
+            partial_tasks++;
+        }
+        std::cout << "[INFO] Job " << job_id << " salting hot key " << hex_encode_key(hot_key.key) << " (~"
+                  << hot_key.records << " records) across " << hot_key.salts << " reducers" << std::endl;
+    }
+    
+    redis.SetHashFields("job:" + job_id, {{"phase", "reduce"},
+                                           {"reduce_tasks", std::to_string(tasks.size())},
+                                           {"reduce_partitions", std::to_string(reduce_tasks)},
+                                           {"partial_tasks", std::to_string(partial_tasks)}});
+    size_t cached = CompleteCachedTasks(redis, job_id, config, tasks);
+    if (!QueueTasks(redis, job_id, tasks)) {
+        FailJob(redis, job_id, "Failed to queue reduce tasks");
+        return false;
+    }
+    
+    std::cout << "[INFO] Job " << job_id << " map phase done, queued " << (reduce_tasks - static_cast<int>(cached)) << " reduce tasks";
+    if (partial_tasks > 0) {
+        std::cout << " and " << partial_tasks << " partial reduce tasks";
+    }
+    if (cached > 0) {
+        std::cout << ", " << cached << " reduce outputs cached";
+    }
+    std::cout << std::endl;
+    
+    // Queued tasks report in and complete the job; without any, nothing would
+    if (tasks.empty()) {
+        CheckJobCompletion(redis, job_id);
+    }
+    return true;
+}
+
+bool ProductionCoordinator::StartMergePhase(RedisClientProduction& redis, const std::string& job_id) {
+    auto job = redis.GetHashFields("job:" + job_id, {"reduce_tasks", "partial_tasks"});
+    JobConfig config;
+    if (!LoadJobConfig(redis, job_id, config)) {
+        FailJob(redis, job_id, "Invalid job configuration");
+        return false;
+    }
+    
+    // The partial reduce tasks are the last ones queued
+    int reduce_tasks = std::atoi(job["reduce_tasks"].c_str());
+    int partial_tasks = std::atoi(job["partial_tasks"].c_str());
+    std::vector<std::string> partial_task_keys;
+    std::vector<std::string> default_outputs;
+    for (int k = 0; k < partial_tasks; ++k) {
+        partial_task_keys.push_back("task:" + job_id + "_reduce_" + std::to_string(reduce_tasks - partial_tasks + k));
+        default_outputs.push_back(config.output_directory + "/" + job_id + "_partial_" + std::to_string(k));
+    }
+    auto partial_results = redis.GetHashesFields(partial_task_keys, {"output", "winner_worker"});
+    
+    // Partial runs have a single partition holding only the hot keys
+    Task task{};
+    task.id = job_id + "_reduce_" + std::to_string(reduce_tasks);
+    task.type = TaskType::REDUCE;
+    task.status = TaskStatus::PENDING;
+    task.plugin_name = config.plugin_name;
+    std::string encoded_hosts;
+    task.input_files = ShuffleInputs(redis, partial_results, default_outputs, encoded_hosts);
+    task.output_file = config.output_directory + "/part-" + std::to_string(reduce_tasks - partial_tasks);
+    task.parameters = config.parameters;
+    task.parameters["num_reduce_tasks"] = "1";
+    task.parameters["reduce_partition"] = "0";
+    if (!encoded_hosts.empty()) {
+        task.parameters["input_hosts"] = encoded_hosts;
+    }
+    task.created_time = Utils::get_timestamp_ms();
+    
+    redis.SetHashFields("job:" + job_id, {{"phase", "merge"},
+                                           {"reduce_tasks", std::to_string(reduce_tasks + 1)}});
+    if (!QueueTasks(redis, job_id, {task})) {
+        FailJob(redis, job_id, "Failed to queue merge task");
+        return false;
+    }
+    
+    std::cout << "[INFO] Job " << job_id << " reduce phase done, merging " << partial_tasks
+              << " partial reduce outputs" << std::endl;
+    return true;
+}
+
+void ProductionCoordinator::HandleTaskEvent(RedisClientProduction& redis, const std::string& attempt_id) {
+    auto attempt = redis.GetHashFields("task:" + attempt_id,
+                                       {"job_id", "status", "data", "error", "attempt_of", "worker",
+                                        "started_at", "completed_at", "result", "attempt_output"});
+    const std::string& job_id = attempt["job_id"];
+    if (job_id.empty()) {
+        return;
+    }
+    
+    // A backup attempt reports on behalf of the task it duplicates
+    std::string task_id = attempt["attempt_of"].empty() ? attempt_id : attempt["attempt_of"];
+    Task decoded;
+    bool has_data = decode_task(attempt["data"], decoded);
+    
+    if (attempt["status"] == "completed") {
+        // Workers claim before they report and remove a losing attempt's
+        // output themselves; for the winner this claim is a no-op
+        bool won = false;
+        if (!redis.ClaimTask(task_id, attempt_id, won) || !won) {
+            return;
+        }
+        
+        // A winning backup reports where it moved its output to
+        std::string output = !attempt["attempt_output"].empty() ? attempt["attempt_output"]
+                             : has_data ? decoded.output_file : "";
+        int64_t runtime = std::atoll(attempt["completed_at"].c_str()) - std::atoll(attempt["started_at"].c_str());
+        redis.SetHashFields("task:" + task_id, {{"output", output},
+                                                 {"winner_worker", attempt["worker"]},
+                                                 {"winner_result", attempt["result"]},
+                                                 {"runtime", std::to_string(std::max<int64_t>(0, runtime))}});
+        CancelAttempt(redis, OtherAttemptId(task_id, attempt_id));
+    }
+    
+    // Late results of cancelled or failed jobs are dropped
+    std::string job_status;
+    if (!redis.GetHash("job:" + job_id, "status", job_status) || job_status != "processing") {
+        return;
+    }
+    
+    if (attempt["status"] == "failed") {
+        // Either attempt succeeding is enough
+        std::string winner;
+        if (redis.GetHash("task:" + task_id, "winner", winner) ||
+            IsAttemptAlive(redis, OtherAttemptId(task_id, attempt_id))) {
+            return;
+        }
+        FailJob(redis, job_id, "Task " + task_id + " failed: " + attempt["error"]);
+        return;
+    }
+    
+    if (attempt["status"] != "completed" || !has_data) {
+        return;
+    }
+    
+    // Set membership makes a result reported twice count once
+    std::string done_key = "job:" + job_id + (decoded.type == TaskType::MAP ? ":map_done" : ":reduce_done");
+    RedisPipeline record(redis);
+    size_t added = record.Add({"SADD", done_key, task_id});
+    if (record.Execute() && record.GetInteger(added) == 1) {
+        CheckJobCompletion(redis, job_id);
+    }
+}
+
+bool ProductionCoordinator::CheckJobCompletion(RedisClientProduction& redis, const std::string& job_id) {
+    auto job = redis.GetHashFields("job:" + job_id, {"phase", "map_tasks", "reduce_tasks",
+                                                       "reduce_partitions", "partial_tasks"});
+    long long map_tasks = std::atoll(job["map_tasks"].c_str());
+    long long reduce_tasks = std::atoll(job["reduce_tasks"].c_str());
+    long long partial_tasks = std::atoll(job["partial_tasks"].c_str());
+    
+    RedisPipeline counts(redis);
+    size_t maps = counts.Add({"SCARD", "job:" + job_id + ":map_done"});
+    size_t reduces = counts.Add({"SCARD", "job:" + job_id + ":reduce_done"});
+    if (!counts.Execute()) {
+        return false;
+    }
+    long long maps_done = counts.GetInteger(maps);
+    long long reduces_done = counts.GetInteger(reduces);
+    
+    long long total = std::max<long long>(1, map_tasks + reduce_tasks);
+    redis.SetHash("job:" + job_id, "progress", std::to_string((maps_done + reduces_done) * 100 / total));
+    
+    if (job["phase"] == "map" && maps_done >= map_tasks) {
+        StartReducePhase(redis, job_id);
+        return false;
+    }
+    if (job["phase"] == "reduce" && reduces_done >= reduce_tasks && partial_tasks > 0) {
+        StartMergePhase(redis, job_id);
+        return false;
+    }
+    if ((job["phase"] == "reduce" || job["phase"] == "merge") && reduces_done >= reduce_tasks) {
+        // Winning reduce attempts, which may be backups: the partition
+        // reducers, then the merge task if hot keys were salted
+        std::vector<long long> output_tasks;
+        long long partitions = job["reduce_partitions"].empty() ? reduce_tasks
+                               : std::atoll(job["reduce_partitions"].c_str());
+        for (long long r = 0; r < partitions; ++r) {
+            output_tasks.push_back(r);
+        }
+        if (partial_tasks > 0) {
+            output_tasks.push_back(reduce_tasks - 1);
+        }
+        RedisPipeline outputs(redis);
+        for (long long r : output_tasks) {
+            outputs.Add({"HGET", "task:" + job_id + "_reduce_" + std::to_string(r), "output"});
+        }
+        std::string output_list;
+        if (outputs.Execute()) {
+            for (size_t r = 0; r < output_tasks.size(); ++r) {
+                std::string output;
+                outputs.GetString(r, output);
+                output_list += (r > 0 ? "," : "") + output;
+            }
+        }
+        
+        redis.SetHashFields("job:" + job_id, {{"status", "completed"},
+                                               {"progress", "100"},
+                                               {"outputs", output_list},
+                                               {"completed_at", std::to_string(std::time(nullptr))}});
+        redis.RemoveFromSet("active_jobs", job_id);
+        ForgetJob(job_id);
+        completed_jobs_++;
+        std::cout << "[INFO] Job " << job_id << " completed" << std::endl;
+        return true;
+    }
+    return false;
+}
+
+void ProductionCoordinator::FailJob(RedisClientProduction& redis, const std::string& job_id,
+                                    const std::string& error) {
+    redis.SetHashFields("job:" + job_id, {{"status", "failed"},
+                                           {"error", error},
+                                           {"completed_at", std::to_string(std::time(nullptr))}});
+    redis.RemoveFromSet("active_jobs", job_id);
+    ForgetJob(job_id);
+    failed_jobs_++;
+    std::cerr << "[ERROR] Job " << job_id << " failed: " << error << std::endl;
+}
+
+void ProductionCoordinator::CheckStragglers(RedisClientProduction& redis) {
+    int64_t now = std::time(nullptr);
+    
+    for (const auto& job_id : redis.GetSetMembers("active_jobs")) {
+        auto job = redis.GetHashFields("job:" + job_id, {"status", "phase", "map_tasks", "reduce_tasks"});
+        if (job["status"] != "processing") {
+            redis.RemoveFromSet("active_jobs", job_id);
+            speculation_policies_.erase(job_id);
+            ForgetJob(job_id);
+            continue;
+        }
+        
+        auto policy = speculation_policies_.find(job_id);
+        if (policy == speculation_policies_.end()) {
+            JobConfig config;
+            LoadJobConfig(redis, job_id, config);
+            policy = speculation_policies_.emplace(job_id, SpeculationPolicy::FromParameters(config.parameters)).first;
+        }
+        if (!policy->second.enabled) {
+            continue;
         }
         
-        // Update job status to processing
-        redis_->SetHash("job:" + job_id, "status", "processing");
-        redis_->SetHash("job:" + job_id, "started_at", std::to_string(std::time(nullptr)));
+        // Only the tasks of the running stage are compared with each other
+        bool map_phase = job["phase"] == "map";
+        int count = std::atoi((map_phase ? job["map_tasks"] : job["reduce_tasks"]).c_str());
+        std::string prefix = job_id + (map_phase ? "_map_" : "_reduce_");
         
-        // Create production tasks for the job using enterprise task distribution
-        for (int i = 0; i < 5; ++i) {
-            std::string task_id = job_id + "_task_" + std::to_string(i);
-            std::string task_data = "task_data_" + std::to_string(i);
-            redis_->AddTask(job_id, task_id, task_data);
+        std::vector<std::string> keys;
+        for (int i = 0; i < count; ++i) {
+            keys.push_back("task:" + prefix + std::to_string(i));
         }
+        auto tasks = redis.GetAllHashes(keys);
         
-        std::cout << "[INFO] Job " << job_id << " started processing with " << workers.size() << " workers" << std::endl;
+        // Tasks restored from the task cache never ran here: their runtime
+        // would drag the median to zero
+        std::vector<TaskTiming> timings;
+        for (int i = 0; i < count; ++i) {
+            auto& task = tasks[i];
+            if (task["cached"] == "1" || (task.count("winner") && task["runtime"].empty())) {
+                continue;
+            }
+            TaskTiming timing;
+            timing.task_id = prefix + std::to_string(i);
+            timing.started_at = task["status"] == "running" || task.count("winner")
+                                    ? std::atoll(task["started_at"].c_str()) : 0;
+            timing.runtime_seconds = task.count("winner") ? std::atoll(task["runtime"].c_str()) : -1;
+            timing.has_backup = task.count("backup") > 0;
+            timings.push_back(timing);
+        }
+        
+        for (const auto& task_id : FindStragglers(timings, policy->second, now)) {
+            LaunchBackupAttempt(redis, task_id);
+        }
+    }
+}
+
+bool ProductionCoordinator::LaunchBackupAttempt(RedisClientProduction& redis, const std::string& task_id) {
+    auto original = redis.GetHashFields("task:" + task_id, {"job_id", "data", "worker"});
+    Task task;
+    if (!decode_task(original["data"], task)) {
+        return false;
+    }
+    
+    // Own output path, so the attempts never write the same file; a winning
+    // backup moves its output to final_output
+    std::string backup_id = task_id + BACKUP_SUFFIX;
+    task.id = backup_id;
+    task.parameters["attempt_of"] = task_id;
+    task.parameters["final_output"] = task.output_file;
+    task.output_file += ".backup";
+    task.parameters["avoid_worker"] = original["worker"];
+    
+    redis.SetHash("task:" + task_id, "backup", backup_id);
+    redis.SetHash("task:" + backup_id, "attempt_of", task_id);
+    if (!QueueTasks(redis, original["job_id"], {task})) {
+        return false;
     }
     
+    std::cout << "[INFO] Task " << task_id << " is straggling on " << original["worker"]
+              << ", launched backup attempt" << std::endl;
     return true;
 }
 
-bool ProductionCoordinator::IsWorkerActive(const std::string& worker_id) {
+void ProductionCoordinator::CancelAttempt(RedisClientProduction& redis, const std::string& attempt_id) {
+    auto attempt = redis.GetHashFields("task:" + attempt_id, {"status", "worker"});
+    const std::string& status = attempt["status"];
+    if (status != "pending" && status != "assigned" && status != "running") {
+        return;
+    }
+    
+    // Queued attempts are pulled off the queues; a running one finishes
+    // and loses the winner claim
+    RedisPipeline cancel(redis);
+    cancel.Add({"HSET", "task:" + attempt_id, "status", "cancelled"});
+    cancel.Add({"LREM", "task_queue", "0", attempt_id});
+    if (!attempt["worker"].empty()) {
+        cancel.Add({"LREM", RedisClientProduction::WorkerQueueKey(attempt["worker"]), "0", attempt_id});
+    }
+    cancel.Execute();
+}
+
+bool ProductionCoordinator::IsAttemptAlive(RedisClientProduction& redis, const std::string& attempt_id) {
+    std::string status;
+    if (!redis.GetHash("task:" + attempt_id, "status", status)) {
+        return false;
+    }
+    return status == "pending" || status == "assigned" || status == "running";
+}
+
+ProductionCoordinator::WorkerList ProductionCoordinator::LoadWorkers(RedisClientProduction& redis) {
+    std::vector<std::string> worker_ids = redis.GetActiveWorkers();
+    
+    std::vector<std::string> keys;
+    for (const auto& worker_id : worker_ids) {
+        keys.push_back("worker:" + worker_id);
+    }
+    auto hashes = redis.GetAllHashes(keys);
+    
+    auto workers = std::make_shared<std::vector<WorkerSnapshot>>();
+    for (size_t i = 0; i < worker_ids.size(); ++i) {
+        workers->push_back({worker_ids[i], std::move(hashes[i])});
+    }
+    
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    worker_cache_ = workers;
+    worker_cache_loaded_ = std::chrono::steady_clock::now();
+    return workers;
+}
+
+ProductionCoordinator::WorkerList ProductionCoordinator::CachedWorkers(RedisClientProduction& redis) {
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        if (worker_cache_ && (worker_cache_loading_ ||
+                              std::chrono::steady_clock::now() - worker_cache_loaded_ < WORKER_CACHE_TTL)) {
+            return worker_cache_;
+        }
+        worker_cache_loading_ = true;
+    }
+    
+    WorkerList workers;
+    try {
+        workers = LoadWorkers(redis);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        worker_cache_loading_ = false;
+        throw;
+    }
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    worker_cache_loading_ = false;
+    return workers;
+}
+
+bool ProductionCoordinator::IsWorkerActive(RedisClientProduction& redis, const std::string& worker_id) {
     std::string last_heartbeat_str;
-    if (!redis_->GetHash("worker:" + worker_id, "last_heartbeat", last_heartbeat_str)) {
+    if (!redis.GetHash("worker:" + worker_id, "last_heartbeat", last_heartbeat_str)) {
         return false;
     }
     
-    time_t last_heartbeat = std::stoll(last_heartbeat_str);
+    return IsWorkerActive(WorkerSnapshot{worker_id, {{"last_heartbeat", last_heartbeat_str}}});
+}
+
+bool ProductionCoordinator::IsWorkerActive(const WorkerSnapshot& worker) const {
+    auto last_heartbeat_str = worker.fields.find("last_heartbeat");
+    if (last_heartbeat_str == worker.fields.end() || last_heartbeat_str->second.empty()) {
+        return false;
+    }
+    
+    time_t last_heartbeat = std::stoll(last_heartbeat_str->second);
     time_t now = std::time(nullptr);
     
     return (now - last_heartbeat) < worker_timeout_;
 }
 
 void ProductionCoordinator::RemoveInactiveWorkers() {
-    std::vector<std::string> workers = redis_->GetActiveWorkers();
+    auto redis = redis_pool_->Acquire();
+    if (!redis) return;
+    
     int active_count = 0;
     
-    for (const auto& worker_id : workers) {
-        if (IsWorkerActive(worker_id)) {
+    // Evictions for the whole sweep go out as one pipelined batch
+    RedisPipeline evictions(*redis);
+    std::vector<std::string> evicted;
+    
+    for (const auto& worker : *LoadWorkers(*redis)) {
+        if (IsWorkerActive(worker)) {
             active_count++;
         } else {
-            // Remove inactive worker
-            redis_->RemoveFromSet("active_workers", worker_id);
-            redis_->SetHash("worker:" + worker_id, "status", "inactive");
-            
+            evictions.Add({"SREM", "active_workers", worker.worker_id});
+            evictions.Add({"HSET", "worker:" + worker.worker_id, "status", "inactive"});
+            evicted.push_back(worker.worker_id);
+        }
+    }
+    
+    if (!evicted.empty() && evictions.Execute()) {
+        for (const auto& worker_id : evicted) {
             std::cout << "[INFO] Removed inactive worker: " << worker_id << std::endl;
+            // Tasks it had taken go back on the queue for the others
+            redis->RecoverWorkerTasks(worker_id);
         }
     }
     
     active_workers_ = active_count;
 }
 
-std::vector<std::string> ProductionCoordinator::GetAvailableWorkers() {
-    std::vector<std::string> all_workers = redis_->GetActiveWorkers();
+std::vector<std::string> ProductionCoordinator::GetAvailableWorkers(RedisClientProduction& redis) {
     std::vector<std::string> available_workers;
     
-    for (const auto& worker_id : all_workers) {
-        if (IsWorkerActive(worker_id)) {
-            std::string status;
-            if (redis_->GetHash("worker:" + worker_id, "status", status) && status == "active") {
-                available_workers.push_back(worker_id);
-            }
+    for (const auto& worker : *CachedWorkers(redis)) {
+        auto status = worker.fields.find("status");
+        if (IsWorkerActive(worker) && status != worker.fields.end() && status->second == "active") {
+            available_workers.push_back(worker.worker_id);
         }
     }
     
     return available_workers;
 }
 
+std::vector<TaskScheduler::WorkerLoad> ProductionCoordinator::LoadWorkerLoads(RedisClientProduction& redis) {
+    std::vector<WorkerSnapshot> workers;
+    for (const auto& worker : *CachedWorkers(redis)) {
+        if (IsWorkerActive(worker)) {
+            workers.push_back(worker);
+        }
+    }
+    
+    // Tasks queued on or running at each worker, in one round trip
+    RedisPipeline depths(redis);
+    for (const auto& worker : workers) {
+        depths.Add({"LLEN", RedisClientProduction::WorkerQueueKey(worker.worker_id)});
+        depths.Add({"LLEN", RedisClientProduction::ProcessingListKey(worker.worker_id)});
+    }
+    depths.Execute();
+    
+    std::vector<TaskScheduler::WorkerLoad> loads;
+    for (size_t i = 0; i < workers.size(); ++i) {
+        const auto& fields = workers[i].fields;
+        auto field = [&fields](const char* name) {
+            auto it = fields.find(name);
+            return it != fields.end() ? it->second : std::string();
+        };
+        
+        TaskScheduler::WorkerLoad load;
+        load.info.id = workers[i].worker_id;
+        load.info.host = field("host");
+        load.info.port = std::atoi(field("port").c_str());
+        load.info.is_available = true;
+        load.info.last_heartbeat = std::atoll(field("last_heartbeat").c_str());
+        load.info.memory_usage_mb = std::atoi(field("memory_mb").c_str());
+        load.info.cpu_usage_percent = std::atoi(field("cpu_percent").c_str());
+        load.task_slots = std::atoi(field("task_slots").c_str());
+        load.assigned_tasks = static_cast<int>(depths.GetInteger(2 * i, 0) + depths.GetInteger(2 * i + 1, 0));
+        for (const auto& path : Utils::split(field("local_paths"), ':')) {
+            if (!path.empty()) {
+                load.local_paths.push_back(path);
+            }
+        }
+        loads.push_back(std::move(load));
+    }
+    return loads;
+}
+
+pplx::task<void> ProductionCoordinator::WithRedis(http_request request,
+                                                  std::function<void(RedisClientProduction&)> work) {
+    auto received = std::chrono::steady_clock::now();
+    return pplx::create_task([this, request, work]() {
+        auto redis = redis_pool_->Acquire();
+        if (!redis) {
+            request.reply(status_codes::ServiceUnavailable, CreateErrorResponse("No Redis connection available"));
+            return;
+        }
+        work(*redis);
+    }, pplx::task_options(redis_io_)).then([this, request, received](pplx::task<void> done) {
+        try {
+            done.get();
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] HTTP handler failed: " << e.what() << std::endl;
+            request.reply(status_codes::InternalError, CreateErrorResponse("Internal error"));
+        }
+        Metrics::stage(Stage::HTTP_REQUEST).record(std::chrono::steady_clock::now() - received);
+    });
+}
+
 json::value ProductionCoordinator::CreateErrorResponse(const std::string& message) {
     json::value response = json::value::object();
     response["success"] = json::value::boolean(false);
@@ -503,8 +1722,9 @@ json::value ProductionCoordinator::CreateSuccessResponse(const json::value& data
 }
 
 void ProductionCoordinator::LogRequest(const http_request& request) {
-    std::cout << "[HTTP] " << request.method() << " " << request.relative_uri().path() 
-              << " from " << request.remote_address() << std::endl;
+    // Every request passes through here, so this goes through the asynchronous logger
+    Logger::info("[HTTP] " + request.method() + " " + request.relative_uri().path() +
+                 " from " + request.remote_address());
 }
 
 } // namespace daf
\ No newline at end of file
@@ -1,17 +1,24 @@
 #pragma once
 
-#include "../storage/redis_client_production.h"
+#include "../storage/redis_connection_pool.h"
+#include "../common/daf_types.h"
+#include "task_scheduler.h"
+#include "speculation.h"
 #include <cpprest/http_listener.h>
 #include <cpprest/json.h>
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <chrono>
 
 namespace daf {
 
+class IoScheduler;
+
 /**
  * Production Coordinator with real HTTP server and Redis backend
  * Replaces all simulation/simplified components with production-grade implementations
@@ -29,6 +36,7 @@ public:
     
     // Configuration
     void SetRedisConnection(const std::string& host, int port);
+    void SetRedisPoolSize(size_t size) { redis_pool_size_ = size; }
     void SetWorkerTimeout(int seconds) { worker_timeout_ = seconds; }
     void SetJobProcessingInterval(int seconds) { job_processing_interval_ = seconds; }
     
@@ -36,25 +44,99 @@ private:
     // HTTP API handlers
     void HandleGetStatus(web::http::http_request request);
     void HandlePostJobs(web::http::http_request request);
+    void HandlePostJobsBatch(web::http::http_request request);
     void HandleGetJobStatus(web::http::http_request request);
+    void HandleGetJobsStatus(web::http::http_request request);
     void HandleGetWorkers(web::http::http_request request);
+    void HandleGetMetrics(web::http::http_request request);
     void HandleDeleteJob(web::http::http_request request);
     
     // Background processing
     void JobProcessingLoop();
+    void TaskEventLoop();
+    void TaskDispatchLoop();
     void WorkerMonitoringLoop();
     void CleanupLoop();
     
     // Job management
+    //
+    // A job runs in two phases: ProcessPendingJobs plans and queues its map
+    // tasks, and once the last map task reports in, StartReducePhase queues
+    // one reduce task per partition over all map outputs. Task results
+    // arrive through the task event queue.
+    //
+    // Hot keys found in the map tasks' key sketches are salted: the
+    // partition reducers skip them, partial reduce tasks combine each one
+    // over a subset of the map outputs, and StartMergePhase queues one more
+    // reduce task over the partial runs once the reduce phase is done.
     std::string GenerateJobId();
     bool ProcessPendingJobs();
-    bool DistributeTask(const std::string& job_id, const std::string& task_data);
-    bool CheckJobCompletion(const std::string& job_id);
+    bool ProcessTaskEvents();
+    bool DispatchPendingTasks();
+    bool ParseJobConfig(const std::string& job_id, const std::string& config_json, JobConfig& config);
+    // A job's config never changes once submitted, so it is parsed once and
+    // kept until the job completes, fails or is cancelled
+    bool LoadJobConfig(RedisClientProduction& redis, const std::string& job_id, JobConfig& config);
+    void ForgetJob(const std::string& job_id);
+    bool QueueTasks(RedisClientProduction& redis, const std::string& job_id, const std::vector<Task>& tasks);
+    bool StartReducePhase(RedisClientProduction& redis, const std::string& job_id);
+    bool StartMergePhase(RedisClientProduction& redis, const std::string& job_id);
+    // Shuffle locations of the winning outputs of tasks from their task
+    // hashes, with the input_hosts parameter of the tasks reading them
+    std::vector<std::string> ShuffleInputs(RedisClientProduction& redis,
+                                           std::vector<std::unordered_map<std::string, std::string>>& results,
+                                           const std::vector<std::string>& default_outputs,
+                                           std::string& encoded_hosts);
+    // Task cache (job parameter task_cache_dir): tasks whose output is
+    // already cached are recorded as completed and taken out of tasks.
+    // Returns how many were.
+    size_t CompleteCachedTasks(RedisClientProduction& redis, const std::string& job_id,
+                               const JobConfig& config, std::vector<Task>& tasks);
+    // Partition digests of every map output of a job, if all are cached
+    bool LoadMapDigests(RedisClientProduction& redis, const JobConfig& config,
+                        std::vector<std::unordered_map<std::string, std::string>>& map_results,
+                        int reduce_tasks, std::vector<std::vector<std::string>>& digests);
+    void HandleTaskEvent(RedisClientProduction& redis, const std::string& task_id);
+    // Advances the job when its current phase is done; true once it completed
+    bool CheckJobCompletion(RedisClientProduction& redis, const std::string& job_id);
+    void FailJob(RedisClientProduction& redis, const std::string& job_id, const std::string& error);
+    
+    // Speculative execution: a straggler gets one backup attempt
+    // "<task_id>_backup" writing "<output>.backup". The first attempt to
+    // complete claims the task as its winner. A winning backup's worker
+    // moves the output back to "<output>". The other attempt is cancelled;
+    // if it finishes anyway, its worker deletes its output.
+    void CheckStragglers(RedisClientProduction& redis);
+    bool LaunchBackupAttempt(RedisClientProduction& redis, const std::string& task_id);
+    void CancelAttempt(RedisClientProduction& redis, const std::string& attempt_id);
+    bool IsAttemptAlive(RedisClientProduction& redis, const std::string& attempt_id);
     
     // Worker management
-    bool IsWorkerActive(const std::string& worker_id);
+    struct WorkerSnapshot {
+        std::string worker_id;
+        std::unordered_map<std::string, std::string> fields;
+    };
+    
+    using WorkerList = std::shared_ptr<const std::vector<WorkerSnapshot>>;
+    
+    // Every registered worker with its hash, in two round trips
+    WorkerList LoadWorkers(RedisClientProduction& redis);
+    // The last worker list if it is younger than WORKER_CACHE_TTL (or
+    // another thread is reloading it), else a freshly loaded one. Heartbeats
+    // are far apart, so HTTP polls and job planning share one read.
+    WorkerList CachedWorkers(RedisClientProduction& redis);
+    bool IsWorkerActive(RedisClientProduction& redis, const std::string& worker_id);
+    bool IsWorkerActive(const WorkerSnapshot& worker) const;
     void RemoveInactiveWorkers();
-    std::vector<std::string> GetAvailableWorkers();
+    std::vector<std::string> GetAvailableWorkers(RedisClientProduction& redis);
+    // Heartbeat metrics and queue depth of every live worker, for the scheduler
+    std::vector<TaskScheduler::WorkerLoad> LoadWorkerLoads(RedisClientProduction& redis);
+    
+    // Handlers run their Redis work, and reply, on redis_io_ rather than a
+    // listener thread; errors and a failed connection checkout are replied
+    // to here. The HTTP_REQUEST stage times the request until its reply.
+    pplx::task<void> WithRedis(web::http::http_request request,
+                               std::function<void(RedisClientProduction&)> work);
     
     // Utility methods
     web::json::value CreateErrorResponse(const std::string& message);
@@ -66,18 +148,38 @@ private:
     int grpc_port_;
     std::string redis_host_;
     int redis_port_;
+    size_t redis_pool_size_;
     int worker_timeout_;
     int job_processing_interval_;
     
-    // Core components
-    std::unique_ptr<RedisClientProduction> redis_;
+    // Core components; HTTP handler threads and the background loops each
+    // check out their own Redis connection
+    std::unique_ptr<RedisConnectionPool> redis_pool_;
+    std::shared_ptr<IoScheduler> redis_io_;
     std::unique_ptr<web::http::experimental::listener::http_listener> http_listener_;
     
     // Background threads
     std::thread job_processing_thread_;
+    std::thread task_event_thread_;
+    std::thread task_dispatch_thread_;
+    
+    // Only touched by the dispatch thread
+    TaskScheduler scheduler_;
+    std::chrono::steady_clock::time_point scheduler_refreshed_;
+    
+    // Only touched by the task event thread
+    std::unordered_map<std::string, SpeculationPolicy> speculation_policies_;
+    std::chrono::steady_clock::time_point last_straggler_check_;
     std::thread worker_monitoring_thread_;
     std::thread cleanup_thread_;
     
+    // Read-through caches, shared by every thread
+    mutable std::mutex cache_mutex_;
+    WorkerList worker_cache_;
+    std::chrono::steady_clock::time_point worker_cache_loaded_;
+    bool worker_cache_loading_ = false;
+    std::unordered_map<std::string, JobConfig> job_configs_;
+    
     // State management
     std::atomic<bool> running_;
     std::atomic<bool> stopping_;
@@ -88,6 +190,7 @@ private:
     std::atomic<int> completed_jobs_;
     std::atomic<int> failed_jobs_;
     std::atomic<int> active_workers_;
+    std::chrono::steady_clock::time_point start_time_;
 };
 
 } // namespace daf
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "speculation.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace daf {
+
+SpeculationPolicy SpeculationPolicy::FromParameters(const std::map<std::string, std::string>& parameters) {
+    SpeculationPolicy policy;
+    auto value = [&parameters](const char* name) -> const std::string* {
+        auto it = parameters.find(name);
+        return it != parameters.end() && !it->second.empty() ? &it->second : nullptr;
+    };
+    
+    if (auto enabled = value("speculative")) {
+        policy.enabled = *enabled == "true" || *enabled == "1";
+    }
+    if (auto slowdown = value("speculative_slowdown")) {
+        policy.slowdown = std::max(1.0, std::atof(slowdown->c_str()));
+    }
+    if (auto min_runtime = value("speculative_min_runtime_s")) {
+        policy.min_runtime_seconds = std::max<int64_t>(0, std::atoll(min_runtime->c_str()));
+    }
+    if (auto min_completed = value("speculative_min_completed")) {
+        policy.min_completed = std::clamp(std::atof(min_completed->c_str()), 0.0, 1.0);
+    }
+    return policy;
+}
+
+std::vector<std::string> FindStragglers(const std::vector<TaskTiming>& tasks,
+                                        const SpeculationPolicy& policy, int64_t now) {
+    std::vector<std::string> stragglers;
+    if (!policy.enabled || tasks.empty()) {
+        return stragglers;
+    }
+    
+    std::vector<int64_t> runtimes;
+    for (const auto& task : tasks) {
+        if (task.runtime_seconds >= 0) {
+            runtimes.push_back(task.runtime_seconds);
+        }
+    }
+    if (runtimes.empty() ||
+        static_cast<double>(runtimes.size()) < policy.min_completed * static_cast<double>(tasks.size())) {
+        return stragglers;
+    }
+    
+    auto middle = runtimes.begin() + runtimes.size() / 2;
+    std::nth_element(runtimes.begin(), middle, runtimes.end());
+    double threshold = std::max(static_cast<double>(policy.min_runtime_seconds),
+                                policy.slowdown * static_cast<double>(*middle));
+    
+    for (const auto& task : tasks) {
+        if (task.started_at > 0 && task.runtime_seconds < 0 && !task.has_backup &&
+            static_cast<double>(now - task.started_at) > threshold) {
+            stragglers.push_back(task.task_id);
+        }
+    }
+    return stragglers;
+}
+
+} // namespace daf
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace daf {
+
+/**
+ * Straggler detection for speculative execution
+ * A running task becomes a straggler once it has run for slowdown times the
+ * median runtime of the finished tasks of the same job and stage, and at
+ * least min_runtime_seconds, after min_completed of the stage has finished.
+ * Each straggler gets at most one backup attempt; the coordinator keeps the
+ * attempt that finishes first and cancels the other.
+ */
+struct SpeculationPolicy {
+    bool enabled = true;
+    double slowdown = 1.5;
+    int64_t min_runtime_seconds = 30;
+    double min_completed = 0.25;
+    
+    // Job parameters: speculative (true/false), speculative_slowdown,
+    // speculative_min_runtime_s, speculative_min_completed
+    static SpeculationPolicy FromParameters(const std::map<std::string, std::string>& parameters);
+};
+
+struct TaskTiming {
+    std::string task_id;
+    int64_t started_at = 0;         // 0 while queued
+    int64_t runtime_seconds = -1;   // Of the winning attempt, -1 until one finished
+    bool has_backup = false;
+};
+
+// Running tasks of one stage that should get a backup attempt
+std::vector<std::string> FindStragglers(const std::vector<TaskTiming>& tasks,
+                                        const SpeculationPolicy& policy, int64_t now);
+
+} // namespace daf
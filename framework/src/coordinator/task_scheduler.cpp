@@ -0,0 +1,76 @@
+#include "task_scheduler.h"
+#include "../common/input_split.h"
+#include <algorithm>
+#include <limits>
+
+namespace daf {
+
+void TaskScheduler::Refresh(std::vector<WorkerLoad> workers) {
+    workers_ = std::move(workers);
+    for (auto& worker : workers_) {
+        worker.task_slots = std::max(1, worker.task_slots);
+    }
+}
+
+double TaskScheduler::Locality(const WorkerLoad& worker,
+                               const std::vector<std::string>& input_paths,
+                               const std::unordered_map<std::string, size_t>& input_hosts) {
+    if (input_paths.empty()) {
+        return 0.0;
+    }
+    
+    size_t local = 0;
+    for (const auto& input : input_paths) {
+        std::string path = InputSplit::parse(input).path;
+        for (const auto& prefix : worker.local_paths) {
+            if (!prefix.empty() && path.compare(0, prefix.size(), prefix) == 0) {
+                local++;
+                break;
+            }
+        }
+    }
+    auto produced = input_hosts.find(worker.info.host);
+    if (produced != input_hosts.end()) {
+        local += produced->second;
+    }
+    
+    return std::min(1.0, static_cast<double>(local) / static_cast<double>(input_paths.size()));
+}
+
+std::string TaskScheduler::SelectWorker(const std::vector<std::string>& input_paths,
+                                        const std::unordered_map<std::string, size_t>& input_hosts,
+                                        const std::string& avoid_worker) {
+    auto candidate = [&avoid_worker, this](const WorkerLoad& worker) {
+        return workers_.size() == 1 || worker.info.id != avoid_worker;
+    };
+    bool any_below_watermark = std::any_of(workers_.begin(), workers_.end(), [&](const WorkerLoad& worker) {
+        return candidate(worker) && worker.info.memory_usage_mb < MEMORY_HIGH_WATERMARK * MAX_MEMORY_MB;
+    });
+    
+    WorkerLoad* best = nullptr;
+    double best_score = std::numeric_limits<double>::max();
+    for (auto& worker : workers_) {
+        double memory_ratio = static_cast<double>(worker.info.memory_usage_mb) / MAX_MEMORY_MB;
+        if (!candidate(worker) || (any_below_watermark && memory_ratio >= MEMORY_HIGH_WATERMARK)) {
+            continue;
+        }
+        
+        double score = static_cast<double>(worker.assigned_tasks) / worker.task_slots
+                     + CPU_WEIGHT * worker.info.cpu_usage_percent / 100.0
+                     + MEMORY_WEIGHT * memory_ratio
+                     - LOCALITY_WEIGHT * Locality(worker, input_paths, input_hosts);
+        if (!best || score < best_score ||
+            (score == best_score && worker.assigned_tasks < best->assigned_tasks)) {
+            best = &worker;
+            best_score = score;
+        }
+    }
+    
+    if (!best) {
+        return "";
+    }
+    best->assigned_tasks++;
+    return best->info.id;
+}
+
+} // namespace daf
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../common/daf_types.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace daf {
+
+/**
+ * Picks the worker for each queued task from the workers' heartbeat metrics
+ * Every candidate is scored by its queue depth per task slot, reported CPU
+ * and memory use relative to MAX_MEMORY_MB, minus a bonus for data locality:
+ * the share of the task's inputs below one of the worker's local data paths
+ * or produced on its host. Lowest score wins. Workers above the memory high
+ * watermark only get work when every worker is above it. Assignments are
+ * counted locally between refreshes so a burst of tasks spreads out instead
+ * of landing on whichever worker looked idlest at the last heartbeat.
+ */
+class TaskScheduler {
+public:
+    struct WorkerLoad {
+        WorkerInfo info{};
+        int task_slots = 1;
+        int assigned_tasks = 0;                 // Queued on or running at the worker
+        std::vector<std::string> local_paths;   // Data directories on the worker's disks
+    };
+    
+    static constexpr double CPU_WEIGHT = 0.5;
+    static constexpr double MEMORY_WEIGHT = 0.5;
+    static constexpr double LOCALITY_WEIGHT = 1.0;
+    static constexpr double MEMORY_HIGH_WATERMARK = 0.9;
+    
+    void Refresh(std::vector<WorkerLoad> workers);
+    bool Empty() const { return workers_.empty(); }
+    
+    // Worker id for a task, or "" if no worker is known. input_hosts counts
+    // the inputs each host produced, e.g. where the prior map tasks ran.
+    // avoid_worker is only picked when it is the sole candidate.
+    std::string SelectWorker(const std::vector<std::string>& input_paths,
+                             const std::unordered_map<std::string, size_t>& input_hosts,
+                             const std::string& avoid_worker = "");
+    
+    // Share in [0, 1] of the task's inputs that are local to the worker
+    static double Locality(const WorkerLoad& worker,
+                           const std::vector<std::string>& input_paths,
+                           const std::unordered_map<std::string, size_t>& input_hosts);
+    
+private:
+    std::vector<WorkerLoad> workers_;
+};
+
+} // namespace daf
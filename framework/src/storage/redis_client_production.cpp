@@ -1,15 +1,18 @@
 #include "redis_client_production.h"
+#include "../common/metrics.h"
 #include <hiredis/hiredis.h>
 #include <iostream>
 #include <sstream>
 #include <cstdarg>
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
 namespace daf {
 
 RedisClientProduction::RedisClientProduction() 
-    : context_(nullptr), host_("localhost"), port_(6379), connected_(false) {
+    : context_(nullptr), host_("localhost"), port_(6379), connected_(false),
+      blmove_supported_(true) {
 }
 
 RedisClientProduction::~RedisClientProduction() {
@@ -162,6 +165,99 @@ bool RedisClientProduction::GetHash(const std::string& key, const std::string& f
     return success;
 }
 
+// Multi-field hash operations
+bool RedisClientProduction::SetHashFields(const std::string& key,
+                                          const std::vector<std::pair<std::string, std::string>>& fields) {
+    if (fields.empty()) return true;
+    
+    std::vector<std::string> args = {"HMSET", key};
+    for (const auto& field : fields) {
+        args.push_back(field.first);
+        args.push_back(field.second);
+    }
+    
+    redisReply* reply = ExecuteCommandArgv(args);
+    if (!reply) return false;
+    
+    bool success = (reply->type == REDIS_REPLY_STATUS);
+    FreeReply(reply);
+    return success;
+}
+
+std::unordered_map<std::string, std::string> RedisClientProduction::GetHashFields(
+    const std::string& key, const std::vector<std::string>& fields) {
+    std::unordered_map<std::string, std::string> result;
+    if (fields.empty()) return result;
+    
+    std::vector<std::string> args = {"HMGET", key};
+    args.insert(args.end(), fields.begin(), fields.end());
+    
+    redisReply* reply = ExecuteCommandArgv(args);
+    if (!reply) return result;
+    
+    if (reply->type == REDIS_REPLY_ARRAY && reply->elements == fields.size()) {
+        for (size_t i = 0; i < reply->elements; ++i) {
+            if (reply->element[i]->type == REDIS_REPLY_STRING) {
+                result[fields[i]] = std::string(reply->element[i]->str, reply->element[i]->len);
+            }
+        }
+    }
+    
+    FreeReply(reply);
+    return result;
+}
+
+std::vector<std::unordered_map<std::string, std::string>> RedisClientProduction::GetAllHashes(
+    const std::vector<std::string>& keys) {
+    std::vector<std::unordered_map<std::string, std::string>> result(keys.size());
+    if (keys.empty()) return result;
+    
+    RedisPipeline pipeline(*this);
+    for (const auto& key : keys) {
+        pipeline.Add({"HGETALL", key});
+    }
+    if (!pipeline.Execute()) {
+        LogError("GetAllHashes", "Pipelined HGETALL failed");
+        return result;
+    }
+    
+    for (size_t i = 0; i < keys.size(); ++i) {
+        result[i] = pipeline.GetHashReply(i);
+    }
+    return result;
+}
+
+std::vector<std::unordered_map<std::string, std::string>> RedisClientProduction::GetHashesFields(
+    const std::vector<std::string>& keys, const std::vector<std::string>& fields) {
+    std::vector<std::unordered_map<std::string, std::string>> result(keys.size());
+    if (keys.empty() || fields.empty()) return result;
+    
+    RedisPipeline pipeline(*this);
+    for (const auto& key : keys) {
+        std::vector<std::string> args = {"HMGET", key};
+        args.insert(args.end(), fields.begin(), fields.end());
+        pipeline.Add(std::move(args));
+    }
+    if (!pipeline.Execute()) {
+        LogError("GetHashesFields", "Pipelined HMGET failed");
+        return result;
+    }
+    
+    // Missing fields come back as nil and are left out
+    for (size_t i = 0; i < keys.size(); ++i) {
+        redisReply* reply = pipeline.Reply(i);
+        if (!reply || reply->type != REDIS_REPLY_ARRAY || reply->elements != fields.size()) {
+            continue;
+        }
+        for (size_t f = 0; f < fields.size(); ++f) {
+            if (reply->element[f]->type == REDIS_REPLY_STRING) {
+                result[i][fields[f]] = std::string(reply->element[f]->str, reply->element[f]->len);
+            }
+        }
+    }
+    return result;
+}
+
 // List operations  
 bool RedisClientProduction::PushLeft(const std::string& key, const std::string& value) {
     redisReply* reply = ExecuteCommand("LPUSH %s %s", key.c_str(), value.c_str());
@@ -202,34 +298,231 @@ int RedisClientProduction::GetListLength(const std::string& key) {
     return length;
 }
 
+bool RedisClientProduction::BlockingMove(const std::string& source, const std::string& destination,
+                                         std::string& value, int timeout_seconds) {
+    // A zero timeout would block forever and keep shutdown waiting
+    std::string timeout = std::to_string(std::max(1, timeout_seconds));
+    
+    redisReply* reply = nullptr;
+    if (blmove_supported_) {
+        reply = ExecuteCommandArgv({"BLMOVE", source, destination, "RIGHT", "LEFT", timeout});
+        if (reply && reply->type == REDIS_REPLY_ERROR &&
+            std::string(reply->str, reply->len).find("unknown command") != std::string::npos) {
+            std::cout << "[INFO] Redis server lacks BLMOVE, using BRPOPLPUSH" << std::endl;
+            blmove_supported_ = false;
+            FreeReply(reply);
+            reply = nullptr;
+        }
+    }
+    if (!blmove_supported_) {
+        reply = ExecuteCommandArgv({"BRPOPLPUSH", source, destination, timeout});
+    }
+    if (!reply) return false;
+    
+    bool success = false;
+    if (reply->type == REDIS_REPLY_STRING) {
+        value.assign(reply->str, reply->len);
+        success = true;
+    } else if (reply->type == REDIS_REPLY_ERROR) {
+        LogError("BlockingMove", std::string(reply->str, reply->len));
+    }
+    
+    FreeReply(reply);
+    return success;
+}
+
+std::vector<std::string> RedisClientProduction::RequeueAll(const std::string& source,
+                                                           const std::string& destination) {
+    std::vector<std::string> moved;
+    while (true) {
+        redisReply* reply = ExecuteCommandArgv({"RPOPLPUSH", source, destination});
+        if (!reply) break;
+        
+        bool more = (reply->type == REDIS_REPLY_STRING);
+        if (more) {
+            moved.emplace_back(reply->str, reply->len);
+        }
+        FreeReply(reply);
+        if (!more) break;
+    }
+    return moved;
+}
+
 // High-level DAF operations
+std::string RedisClientProduction::WorkerQueueKey(const std::string& worker_id) {
+    return "worker:" + worker_id + ":queue";
+}
+
+std::string RedisClientProduction::ProcessingListKey(const std::string& worker_id) {
+    return "worker:" + worker_id + ":processing";
+}
+
 bool RedisClientProduction::RegisterWorker(const std::string& worker_id, const std::string& host, int port) {
-    // Store worker info in hash
-    if (!SetHash("worker:" + worker_id, "host", host)) return false;
-    if (!SetHash("worker:" + worker_id, "port", std::to_string(port))) return false;
-    if (!SetHash("worker:" + worker_id, "status", "active")) return false;
-    if (!SetHash("worker:" + worker_id, "last_heartbeat", std::to_string(std::time(nullptr)))) return false;
-    
-    // Add to active workers set
-    return AddToSet("active_workers", worker_id);
+    // Worker hash and active set membership in one atomic round trip
+    RedisPipeline pipeline(*this, true);
+    pipeline.Add({"HMSET", "worker:" + worker_id,
+                  "host", host,
+                  "port", std::to_string(port),
+                  "status", "active",
+                  "last_heartbeat", std::to_string(std::time(nullptr))});
+    pipeline.Add({"SADD", "active_workers", worker_id});
+    return pipeline.Execute();
 }
 
 bool RedisClientProduction::SubmitJob(const std::string& job_id, const std::string& job_config) {
-    // Store job config
-    if (!SetHash("job:" + job_id, "config", job_config)) return false;
-    if (!SetHash("job:" + job_id, "status", "pending")) return false;
-    if (!SetHash("job:" + job_id, "created_at", std::to_string(std::time(nullptr)))) return false;
+    return SubmitJobs({{job_id, job_config}});
+}
+
+bool RedisClientProduction::SubmitJobs(const std::vector<std::pair<std::string, std::string>>& jobs) {
+    if (jobs.empty()) return true;
     
-    // Add to job queue
-    return PushLeft("job_queue", job_id);
+    // Job hashes and queue entries in one atomic round trip, so a queued
+    // job always has its config
+    std::string now = std::to_string(std::time(nullptr));
+    RedisPipeline pipeline(*this, true);
+    for (const auto& [job_id, job_config] : jobs) {
+        pipeline.Add({"HMSET", "job:" + job_id,
+                      "config", job_config,
+                      "status", "pending",
+                      "created_at", now});
+        pipeline.Add({"LPUSH", "job_queue", job_id});
+        pipeline.Add({"PUBLISH", JOB_CHANNEL, job_id});
+    }
+    return pipeline.Execute();
+}
+
+bool RedisClientProduction::AddTask(const std::string& job_id, const std::string& task_id,
+                                    const std::string& task_data) {
+    return AddTasks(job_id, {{task_id, task_data}});
+}
+
+bool RedisClientProduction::AddTasks(const std::string& job_id,
+                                     const std::vector<std::pair<std::string, std::string>>& tasks) {
+    if (tasks.empty()) return true;
+    
+    std::string now = std::to_string(std::time(nullptr));
+    RedisPipeline pipeline(*this, true);
+    for (const auto& [task_id, task_data] : tasks) {
+        pipeline.Add({"HMSET", "task:" + task_id,
+                      "job_id", job_id,
+                      "data", task_data,
+                      "status", "pending",
+                      "created_at", now});
+        pipeline.Add({"SADD", "job:" + job_id + ":tasks", task_id});
+        pipeline.Add({"LPUSH", "task_queue", task_id});
+    }
+    pipeline.Add({"PUBLISH", TASK_CHANNEL, job_id});
+    return pipeline.Execute();
+}
+
+bool RedisClientProduction::GetNextTask(const std::string& worker_id, std::string& task_id,
+                                        std::string& task_data, int timeout_seconds) {
+    // The task stays on the worker's processing list until it is completed
+    // or failed, so it survives a worker crash
+    if (!BlockingMove(WorkerQueueKey(worker_id), ProcessingListKey(worker_id), task_id, timeout_seconds)) {
+        return false;
+    }
+    
+    auto fields = GetHashFields("task:" + task_id, {"data", "status"});
+    if (fields["status"] == "cancelled") {
+        // The other attempt of a speculated task already finished
+        RemoveFromList(ProcessingListKey(worker_id), 1, task_id);
+        return false;
+    }
+    if (fields["data"].empty()) {
+        FailTask(worker_id, task_id, "task has no data");
+        return false;
+    }
+    task_data = fields["data"];
+    
+    return SetHashFields("task:" + task_id, {{"status", "running"},
+                                             {"worker", worker_id},
+                                             {"started_at", std::to_string(std::time(nullptr))}});
+}
+
+bool RedisClientProduction::AssignTask(const std::string& task_id, const std::string& worker_id,
+                                       const std::string& source_list) {
+    RedisPipeline pipeline(*this, true);
+    pipeline.Add({"LREM", source_list, "1", task_id});
+    pipeline.Add({"LPUSH", WorkerQueueKey(worker_id), task_id});
+    pipeline.Add({"HMSET", "task:" + task_id,
+                  "status", "assigned",
+                  "worker", worker_id});
+    return pipeline.Execute();
+}
+
+bool RedisClientProduction::CompleteTask(const std::string& worker_id, const std::string& task_id,
+                                         const std::string& result, const std::string& output) {
+    std::vector<std::string> fields = {"HMSET", "task:" + task_id,
+                                       "status", "completed",
+                                       "result", result,
+                                       "completed_at", std::to_string(std::time(nullptr))};
+    if (!output.empty()) {
+        // Not "output": the original attempt shares the task's hash, whose
+        // "output" is the winner's
+        fields.insert(fields.end(), {"attempt_output", output});
+    }
+    
+    RedisPipeline pipeline(*this, true);
+    pipeline.Add({"LREM", ProcessingListKey(worker_id), "1", task_id});
+    pipeline.Add(std::move(fields));
+    pipeline.Add({"LPUSH", TASK_EVENT_QUEUE, task_id});
+    return pipeline.Execute();
+}
+
+bool RedisClientProduction::FailTask(const std::string& worker_id, const std::string& task_id,
+                                     const std::string& error) {
+    RedisPipeline pipeline(*this, true);
+    pipeline.Add({"LREM", ProcessingListKey(worker_id), "1", task_id});
+    pipeline.Add({"HMSET", "task:" + task_id,
+                  "status", "failed",
+                  "error", error,
+                  "completed_at", std::to_string(std::time(nullptr))});
+    pipeline.Add({"LPUSH", TASK_EVENT_QUEUE, task_id});
+    return pipeline.Execute();
+}
+
+bool RedisClientProduction::ClaimTask(const std::string& task_id, const std::string& attempt_id, bool& won) {
+    // The winner never changes once set, so reading it back after the
+    // HSETNX tells both a first claim and a repeated one apart from a loss
+    RedisPipeline pipeline(*this);
+    pipeline.Add({"HSETNX", "task:" + task_id, "winner", attempt_id});
+    size_t winner = pipeline.Add({"HGET", "task:" + task_id, "winner"});
+    if (!pipeline.Execute()) {
+        return false;
+    }
+    std::string current;
+    won = pipeline.GetString(winner, current) && current == attempt_id;
+    return true;
+}
+
+int RedisClientProduction::RecoverWorkerTasks(const std::string& worker_id) {
+    std::vector<std::string> recovered = RequeueAll(ProcessingListKey(worker_id), "task_queue");
+    std::vector<std::string> assigned = RequeueAll(WorkerQueueKey(worker_id), "task_queue");
+    recovered.insert(recovered.end(), assigned.begin(), assigned.end());
+    if (recovered.empty()) return 0;
+    
+    RedisPipeline pipeline(*this);
+    for (const auto& task_id : recovered) {
+        pipeline.Add({"HSET", "task:" + task_id, "status", "pending"});
+    }
+    pipeline.Execute();
+    
+    std::cout << "[INFO] Recovered " << recovered.size() << " tasks from worker " << worker_id << std::endl;
+    return static_cast<int>(recovered.size());
 }
 
 // Private helper methods
-redisReply* RedisClientProduction::ExecuteCommand(const char* format, ...) {
+bool RedisClientProduction::EnsureConnected() {
     if (!IsConnected()) {
-        if (!Reconnect()) {
-            return nullptr;
-        }
+        return Reconnect();
+    }
+    return true;
+}
+
+redisReply* RedisClientProduction::ExecuteCommand(const char* format, ...) {
+    if (!EnsureConnected()) {
+        return nullptr;
     }
     
     va_list args;
@@ -248,6 +541,35 @@ redisReply* RedisClientProduction::ExecuteCommand(const char* format, ...) {
     return reply;
 }
 
+redisReply* RedisClientProduction::ExecuteCommandArgv(const std::vector<std::string>& args) {
+    if (!EnsureConnected()) {
+        return nullptr;
+    }
+    
+    std::vector<const char*> argv;
+    std::vector<size_t> lengths;
+    for (const auto& arg : args) {
+        argv.push_back(arg.data());
+        lengths.push_back(arg.size());
+    }
+    
+    // Blocking queue waits would only measure how long the queue was empty
+    bool blocking = !args.empty() && (args[0] == "BLMOVE" || args[0] == "BRPOPLPUSH");
+    ScopedStageTimer timer(Stage::REDIS_ROUND_TRIP, !blocking);
+    redisReply* reply = static_cast<redisReply*>(
+        redisCommandArgv(context_, static_cast<int>(argv.size()), argv.data(), lengths.data()));
+    
+    if (!reply) {
+        LogError("ExecuteCommandArgv", "Failed to execute Redis command");
+        if (context_->err) {
+            LogError("ExecuteCommandArgv", context_->errstr);
+            connected_ = false;
+        }
+    }
+    
+    return reply;
+}
+
 void RedisClientProduction::FreeReply(redisReply* reply) {
     if (reply) {
         freeReplyObject(reply);
@@ -255,11 +577,13 @@ void RedisClientProduction::FreeReply(redisReply* reply) {
 }
 
 void RedisClientProduction::LogError(const std::string& operation, const std::string& error) {
+    Metrics::counter(CounterId::REDIS_ERRORS).add();
     std::cerr << "[ERROR] Redis " << operation << ": " << error << std::endl;
 }
 
 // Production implementations for all Redis operations
 bool RedisClientProduction::DeleteHashField(const std::string& key, const std::string& field) {
+    ScopedStageTimer timer(Stage::REDIS_ROUND_TRIP);
     redisReply* reply = (redisReply*)redisCommand(context_, "HDEL %s %s", key.c_str(), field.c_str());
     bool success = (reply && reply->type == REDIS_REPLY_INTEGER && reply->integer > 0);
     if (reply) freeReplyObject(reply);
@@ -267,6 +591,7 @@ bool RedisClientProduction::DeleteHashField(const std::string& key, const std::s
 }
 
 bool RedisClientProduction::HashExists(const std::string& key, const std::string& field) {
+    ScopedStageTimer timer(Stage::REDIS_ROUND_TRIP);
     redisReply* reply = (redisReply*)redisCommand(context_, "HEXISTS %s %s", key.c_str(), field.c_str());
     bool exists = (reply && reply->type == REDIS_REPLY_INTEGER && reply->integer == 1);
     if (reply) freeReplyObject(reply);
@@ -275,6 +600,7 @@ bool RedisClientProduction::HashExists(const std::string& key, const std::string
 
 std::vector<std::string> RedisClientProduction::GetHashKeys(const std::string& key) {
     std::vector<std::string> keys;
+    ScopedStageTimer timer(Stage::REDIS_ROUND_TRIP);
     redisReply* reply = (redisReply*)redisCommand(context_, "HKEYS %s", key.c_str());
     if (reply && reply->type == REDIS_REPLY_ARRAY) {
         for (size_t i = 0; i < reply->elements; ++i) {
@@ -289,6 +615,7 @@ std::vector<std::string> RedisClientProduction::GetHashKeys(const std::string& k
 
 std::unordered_map<std::string, std::string> RedisClientProduction::GetAllHash(const std::string& key) {
     std::unordered_map<std::string, std::string> result;
+    ScopedStageTimer timer(Stage::REDIS_ROUND_TRIP);
     redisReply* reply = (redisReply*)redisCommand(context_, "HGETALL %s", key.c_str());
     if (reply && reply->type == REDIS_REPLY_ARRAY && reply->elements % 2 == 0) {
         for (size_t i = 0; i < reply->elements; i += 2) {
@@ -305,6 +632,7 @@ std::unordered_map<std::string, std::string> RedisClientProduction::GetAllHash(c
 }
 
 bool RedisClientProduction::PushRight(const std::string& key, const std::string& value) {
+    ScopedStageTimer timer(Stage::REDIS_ROUND_TRIP);
     redisReply* reply = (redisReply*)redisCommand(context_, "RPUSH %s %s", key.c_str(), value.c_str());
     bool success = (reply && reply->type == REDIS_REPLY_INTEGER);
     if (reply) freeReplyObject(reply);
@@ -312,6 +640,7 @@ bool RedisClientProduction::PushRight(const std::string& key, const std::string&
 }
 
 bool RedisClientProduction::PopRight(const std::string& key, std::string& value) {
+    ScopedStageTimer timer(Stage::REDIS_ROUND_TRIP);
     redisReply* reply = (redisReply*)redisCommand(context_, "RPOP %s", key.c_str());
     if (reply && reply->type == REDIS_REPLY_STRING) {
         value.assign(reply->str, reply->len);
@@ -324,6 +653,7 @@ bool RedisClientProduction::PopRight(const std::string& key, std::string& value)
 
 std::vector<std::string> RedisClientProduction::GetListRange(const std::string& key, int start, int stop) {
     std::vector<std::string> result;
+    ScopedStageTimer timer(Stage::REDIS_ROUND_TRIP);
     redisReply* reply = (redisReply*)redisCommand(context_, "LRANGE %s %d %d", key.c_str(), start, stop);
     if (reply && reply->type == REDIS_REPLY_ARRAY) {
         for (size_t i = 0; i < reply->elements; ++i) {
@@ -337,6 +667,7 @@ std::vector<std::string> RedisClientProduction::GetListRange(const std::string&
 }
 
 bool RedisClientProduction::RemoveFromList(const std::string& key, int count, const std::string& value) {
+    ScopedStageTimer timer(Stage::REDIS_ROUND_TRIP);
     redisReply* reply = (redisReply*)redisCommand(context_, "LREM %s %d %s", key.c_str(), count, value.c_str());
     bool success = (reply && reply->type == REDIS_REPLY_INTEGER);
     if (reply) freeReplyObject(reply);
@@ -344,19 +675,50 @@ bool RedisClientProduction::RemoveFromList(const std::string& key, int count, co
 }
 
 bool RedisClientProduction::AddToSet(const std::string& key, const std::string& member) {
+    ScopedStageTimer timer(Stage::REDIS_ROUND_TRIP);
     redisReply* reply = (redisReply*)redisCommand(context_, "SADD %s %s", key.c_str(), member.c_str());
     bool success = (reply && reply->type == REDIS_REPLY_INTEGER);
     if (reply) freeReplyObject(reply);
     return success;
 }
-bool RedisClientProduction::RemoveFromSet(const std::string& key, const std::string& member) { return false; }
+bool RedisClientProduction::RemoveFromSet(const std::string& key, const std::string& member) {
+    redisReply* reply = ExecuteCommandArgv({"SREM", key, member});
+    bool success = (reply && reply->type == REDIS_REPLY_INTEGER);
+    if (reply) freeReplyObject(reply);
+    return success;
+}
+
 bool RedisClientProduction::IsMemberOfSet(const std::string& key, const std::string& member) { return false; }
-std::vector<std::string> RedisClientProduction::GetSetMembers(const std::string& key) { return {}; }
-int RedisClientProduction::GetSetSize(const std::string& key) { return -1; }
+
+std::vector<std::string> RedisClientProduction::GetSetMembers(const std::string& key) {
+    std::vector<std::string> members;
+    redisReply* reply = ExecuteCommandArgv({"SMEMBERS", key});
+    if (reply && reply->type == REDIS_REPLY_ARRAY) {
+        for (size_t i = 0; i < reply->elements; ++i) {
+            if (reply->element[i]->type == REDIS_REPLY_STRING) {
+                members.emplace_back(reply->element[i]->str, reply->element[i]->len);
+            }
+        }
+    }
+    if (reply) freeReplyObject(reply);
+    return members;
+}
+
+int RedisClientProduction::GetSetSize(const std::string& key) {
+    redisReply* reply = ExecuteCommandArgv({"SCARD", key});
+    int size = (reply && reply->type == REDIS_REPLY_INTEGER) ? static_cast<int>(reply->integer) : -1;
+    FreeReply(reply);
+    return size;
+}
 int RedisClientProduction::Increment(const std::string& key) { return -1; }
 int RedisClientProduction::Decrement(const std::string& key) { return -1; }
 int RedisClientProduction::IncrementBy(const std::string& key, int value) { return -1; }
-bool RedisClientProduction::Publish(const std::string& channel, const std::string& message) { return false; }
+bool RedisClientProduction::Publish(const std::string& channel, const std::string& message) {
+    redisReply* reply = ExecuteCommandArgv({"PUBLISH", channel, message});
+    bool success = (reply && reply->type == REDIS_REPLY_INTEGER);
+    FreeReply(reply);
+    return success;
+}
 bool RedisClientProduction::Subscribe(const std::string& channel) { return false; }
 bool RedisClientProduction::Unsubscribe(const std::string& channel) { return false; }
 bool RedisClientProduction::StartTransaction() { return false; }
@@ -367,13 +729,169 @@ bool RedisClientProduction::FlushDatabase() { return false; }
 bool RedisClientProduction::FlushAll() { return false; }
 std::string RedisClientProduction::GetConnectionInfo() const { return ""; }
 std::string RedisClientProduction::GetServerInfo() const { return ""; }
-bool RedisClientProduction::UpdateWorkerHeartbeat(const std::string& worker_id) { return false; }
-std::vector<std::string> RedisClientProduction::GetActiveWorkers() { return {}; }
-bool RedisClientProduction::AddTask(const std::string& job_id, const std::string& task_id, const std::string& task_data) { return false; }
-bool RedisClientProduction::GetNextTask(const std::string& worker_id, std::string& task_data) { return false; }
-bool RedisClientProduction::CompleteTask(const std::string& task_id, const std::string& result) { return false; }
-bool RedisClientProduction::FailTask(const std::string& task_id, const std::string& error) { return false; }
+bool RedisClientProduction::UpdateWorkerHeartbeat(const std::string& worker_id,
+                                                  const std::unordered_map<std::string, std::string>& metrics) {
+    std::vector<std::string> hmset = {"HMSET", "worker:" + worker_id,
+                                      "status", "active",
+                                      "last_heartbeat", std::to_string(std::time(nullptr))};
+    for (const auto& [field, value] : metrics) {
+        hmset.push_back(field);
+        hmset.push_back(value);
+    }
+    
+    // Re-adds a worker that was evicted while it was unreachable
+    RedisPipeline pipeline(*this, true);
+    pipeline.Add(std::move(hmset));
+    pipeline.Add({"SADD", "active_workers", worker_id});
+    return pipeline.Execute();
+}
+std::vector<std::string> RedisClientProduction::GetActiveWorkers() {
+    return GetSetMembers("active_workers");
+}
 bool RedisClientProduction::CheckReplyType(redisReply* reply, int expected_type) { return false; }
 bool RedisClientProduction::HandleConnectionError() { return false; }
 
+// RedisPipeline implementation
+RedisPipeline::RedisPipeline(RedisClientProduction& client, bool transactional)
+    : client_(client), transactional_(transactional) {
+}
+
+RedisPipeline::~RedisPipeline() {
+    FreeReplies();
+}
+
+size_t RedisPipeline::Add(std::vector<std::string> args) {
+    commands_.push_back(std::move(args));
+    return commands_.size() - 1;
+}
+
+bool RedisPipeline::Execute() {
+    FreeReplies();
+    if (commands_.empty()) {
+        return true;
+    }
+    if (!client_.EnsureConnected()) {
+        return false;
+    }
+    
+    redisContext* context = client_.context_;
+    auto append = [context](const std::vector<std::string>& args) {
+        std::vector<const char*> argv;
+        std::vector<size_t> lengths;
+        for (const auto& arg : args) {
+            argv.push_back(arg.data());
+            lengths.push_back(arg.size());
+        }
+        return redisAppendCommandArgv(context, static_cast<int>(argv.size()),
+                                      argv.data(), lengths.data()) == REDIS_OK;
+    };
+    
+    // Everything is buffered locally and flushed by the first redisGetReply
+    ScopedStageTimer timer(Stage::REDIS_ROUND_TRIP);
+    bool queued = !transactional_ || append({"MULTI"});
+    for (size_t i = 0; queued && i < commands_.size(); ++i) {
+        queued = append(commands_[i]);
+    }
+    if (queued && transactional_) {
+        queued = append({"EXEC"});
+    }
+    if (!queued) {
+        // A partially buffered batch leaves the context unusable
+        client_.LogError("Pipeline", "Failed to queue commands");
+        client_.connected_ = false;
+        return false;
+    }
+    
+    size_t expected = commands_.size() + (transactional_ ? 2 : 0);
+    for (size_t i = 0; i < expected; ++i) {
+        void* reply = nullptr;
+        if (redisGetReply(context, &reply) != REDIS_OK) {
+            client_.LogError("Pipeline", context->errstr);
+            client_.connected_ = false;
+            FreeReplies();
+            return false;
+        }
+        owned_replies_.push_back(static_cast<redisReply*>(reply));
+    }
+    
+    if (transactional_) {
+        redisReply* exec = owned_replies_.back();
+        if (!exec || exec->type != REDIS_REPLY_ARRAY || exec->elements != commands_.size()) {
+            client_.LogError("Pipeline", "Transaction aborted");
+            return false;
+        }
+        replies_.assign(exec->element, exec->element + exec->elements);
+    } else {
+        replies_ = owned_replies_;
+    }
+    
+    for (auto* reply : replies_) {
+        if (!reply || reply->type == REDIS_REPLY_ERROR) {
+            client_.LogError("Pipeline", reply ? std::string(reply->str, reply->len) : "Missing reply");
+            return false;
+        }
+    }
+    return true;
+}
+
+redisReply* RedisPipeline::Reply(size_t index) const {
+    return index < replies_.size() ? replies_[index] : nullptr;
+}
+
+bool RedisPipeline::IsError(size_t index) const {
+    redisReply* reply = Reply(index);
+    return !reply || reply->type == REDIS_REPLY_ERROR;
+}
+
+bool RedisPipeline::GetString(size_t index, std::string& value) const {
+    redisReply* reply = Reply(index);
+    if (reply && (reply->type == REDIS_REPLY_STRING || reply->type == REDIS_REPLY_STATUS)) {
+        value.assign(reply->str, reply->len);
+        return true;
+    }
+    value.clear();
+    return false;
+}
+
+long long RedisPipeline::GetInteger(size_t index, long long default_value) const {
+    redisReply* reply = Reply(index);
+    return (reply && reply->type == REDIS_REPLY_INTEGER) ? reply->integer : default_value;
+}
+
+std::vector<std::string> RedisPipeline::GetStringArray(size_t index) const {
+    std::vector<std::string> values;
+    redisReply* reply = Reply(index);
+    if (reply && reply->type == REDIS_REPLY_ARRAY) {
+        for (size_t i = 0; i < reply->elements; ++i) {
+            if (reply->element[i]->type == REDIS_REPLY_STRING) {
+                values.emplace_back(reply->element[i]->str, reply->element[i]->len);
+            }
+        }
+    }
+    return values;
+}
+
+std::unordered_map<std::string, std::string> RedisPipeline::GetHashReply(size_t index) const {
+    std::unordered_map<std::string, std::string> result;
+    redisReply* reply = Reply(index);
+    if (reply && reply->type == REDIS_REPLY_ARRAY && reply->elements % 2 == 0) {
+        for (size_t i = 0; i < reply->elements; i += 2) {
+            if (reply->element[i]->type == REDIS_REPLY_STRING &&
+                reply->element[i+1]->type == REDIS_REPLY_STRING) {
+                result[std::string(reply->element[i]->str, reply->element[i]->len)] =
+                    std::string(reply->element[i+1]->str, reply->element[i+1]->len);
+            }
+        }
+    }
+    return result;
+}
+
+void RedisPipeline::FreeReplies() {
+    for (auto* reply : owned_replies_) {
+        if (reply) freeReplyObject(reply);
+    }
+    owned_replies_.clear();
+    replies_.clear();
+}
+
 } // namespace daf
\ No newline at end of file
@@ -11,6 +11,8 @@ struct redisReply;
 
 namespace daf {
 
+class RedisPipeline;
+
 /**
  * Production Redis Client using hiredis library
  * This replaces all simulation code with real Redis connectivity
@@ -46,6 +48,18 @@ public:
     std::vector<std::string> GetHashKeys(const std::string& key);
     std::unordered_map<std::string, std::string> GetAllHash(const std::string& key);
     
+    // Multi-field hash operations, one round trip each
+    bool SetHashFields(const std::string& key,
+                       const std::vector<std::pair<std::string, std::string>>& fields);
+    // Only fields that exist are returned
+    std::unordered_map<std::string, std::string> GetHashFields(const std::string& key,
+                                                               const std::vector<std::string>& fields);
+    // HGETALL for every key in a single pipelined round trip, in key order
+    std::vector<std::unordered_map<std::string, std::string>> GetAllHashes(const std::vector<std::string>& keys);
+    // HMGET of the same fields from every key, pipelined like GetAllHashes
+    std::vector<std::unordered_map<std::string, std::string>> GetHashesFields(const std::vector<std::string>& keys,
+                                                                              const std::vector<std::string>& fields);
+    
     // List operations (for task queues)
     bool PushLeft(const std::string& key, const std::string& value);
     bool PushRight(const std::string& key, const std::string& value);
@@ -55,6 +69,14 @@ public:
     std::vector<std::string> GetListRange(const std::string& key, int start, int stop);
     bool RemoveFromList(const std::string& key, int count, const std::string& value);
     
+    // Reliable queue primitives: pop the oldest entry of source (right end)
+    // onto destination, blocking up to timeout_seconds. Uses BLMOVE and falls
+    // back to BRPOPLPUSH on servers older than 6.2.
+    bool BlockingMove(const std::string& source, const std::string& destination,
+                      std::string& value, int timeout_seconds);
+    // Moves every entry of source onto destination; returns the moved entries
+    std::vector<std::string> RequeueAll(const std::string& source, const std::string& destination);
+    
     // Set operations
     bool AddToSet(const std::string& key, const std::string& member);
     bool RemoveFromSet(const std::string& key, const std::string& member);
@@ -87,23 +109,60 @@ public:
     std::string GetServerInfo() const;
     
     // High-level DAF operations
+    //
+    // Jobs and tasks are queued by id on "job_queue" / "task_queue" (pushed
+    // left, consumed right). The coordinator's scheduler moves each task from
+    // task_queue onto the chosen worker's queue, and the worker moves it on to
+    // its processing list while it runs, so the tasks of a worker that dies
+    // can be put back with RecoverWorkerTasks(). Finished and failed task ids are pushed on
+    // TASK_EVENT_QUEUE for the coordinator. New jobs and tasks are also
+    // announced on the JOB_CHANNEL / TASK_CHANNEL pub/sub channels.
+    static constexpr const char* JOB_CHANNEL = "daf:jobs";
+    static constexpr const char* TASK_CHANNEL = "daf:tasks";
+    static constexpr const char* TASK_EVENT_QUEUE = "task_events";
+    static std::string WorkerQueueKey(const std::string& worker_id);
+    static std::string ProcessingListKey(const std::string& worker_id);
+    
     bool RegisterWorker(const std::string& worker_id, const std::string& host, int port);
-    bool UpdateWorkerHeartbeat(const std::string& worker_id);
+    // Metrics are stored as extra worker hash fields
+    bool UpdateWorkerHeartbeat(const std::string& worker_id,
+                               const std::unordered_map<std::string, std::string>& metrics = {});
     std::vector<std::string> GetActiveWorkers();
     bool SubmitJob(const std::string& job_id, const std::string& job_config);
+    // Stores and queues (job_id, job_config) pairs in one transaction
+    bool SubmitJobs(const std::vector<std::pair<std::string, std::string>>& jobs);
     bool AddTask(const std::string& job_id, const std::string& task_id, const std::string& task_data);
-    bool GetNextTask(const std::string& worker_id, std::string& task_data);
-    bool CompleteTask(const std::string& task_id, const std::string& result);
-    bool FailTask(const std::string& task_id, const std::string& error);
+    // Queues (task_id, task_data) pairs in one transaction
+    bool AddTasks(const std::string& job_id,
+                  const std::vector<std::pair<std::string, std::string>>& tasks);
+    // Moves a task from source_list onto the worker's queue
+    bool AssignTask(const std::string& task_id, const std::string& worker_id, const std::string& source_list);
+    // Blocks up to timeout_seconds for the next task assigned to the worker
+    bool GetNextTask(const std::string& worker_id, std::string& task_id, std::string& task_data,
+                     int timeout_seconds = 1);
+    // output is where the task's output ended up, if not its output_file
+    bool CompleteTask(const std::string& worker_id, const std::string& task_id, const std::string& result,
+                      const std::string& output = "");
+    bool FailTask(const std::string& worker_id, const std::string& task_id, const std::string& error);
+    // Claims task_id's output for one of its attempts (HSETNX of "winner");
+    // won is also set when attempt_id had already claimed it
+    bool ClaimTask(const std::string& task_id, const std::string& attempt_id, bool& won);
+    // Requeues a worker's assigned and in-flight tasks; returns how many were recovered
+    int RecoverWorkerTasks(const std::string& worker_id);
     
 private:
+    friend class RedisPipeline;
+    
     redisContext* context_;
     std::string host_;
     int port_;
     bool connected_;
+    bool blmove_supported_;
     
     // Helper methods
     redisReply* ExecuteCommand(const char* format, ...);
+    redisReply* ExecuteCommandArgv(const std::vector<std::string>& args);
+    bool EnsureConnected();
     void FreeReply(redisReply* reply);
     bool CheckReplyType(redisReply* reply, int expected_type);
     
@@ -112,4 +171,45 @@ private:
     bool HandleConnectionError();
 };
 
+/**
+ * Batch of Redis commands sent in one round trip
+ * Commands are queued with redisAppendCommandArgv and every reply is read
+ * back with redisGetReply on Execute(). A transactional pipeline wraps the
+ * batch in MULTI/EXEC so it is applied atomically; replies are then the
+ * elements of the EXEC reply, indexed the same way.
+ */
+class RedisPipeline {
+public:
+    explicit RedisPipeline(RedisClientProduction& client, bool transactional = false);
+    ~RedisPipeline();
+    
+    RedisPipeline(const RedisPipeline&) = delete;
+    RedisPipeline& operator=(const RedisPipeline&) = delete;
+    
+    // Queue one command (binary-safe arguments); returns its reply index
+    size_t Add(std::vector<std::string> args);
+    size_t Size() const { return commands_.size(); }
+    
+    // Send everything and collect the replies. False on connection errors,
+    // an aborted transaction or any error reply.
+    bool Execute();
+    
+    // Reply accessors, valid after Execute() until the pipeline is destroyed
+    redisReply* Reply(size_t index) const;
+    bool IsError(size_t index) const;
+    bool GetString(size_t index, std::string& value) const;
+    long long GetInteger(size_t index, long long default_value = -1) const;
+    std::vector<std::string> GetStringArray(size_t index) const;
+    std::unordered_map<std::string, std::string> GetHashReply(size_t index) const;
+    
+private:
+    void FreeReplies();
+    
+    RedisClientProduction& client_;
+    bool transactional_;
+    std::vector<std::vector<std::string>> commands_;
+    std::vector<redisReply*> owned_replies_;
+    std::vector<redisReply*> replies_;
+};
+
 } // namespace daf
@@ -0,0 +1,144 @@
+#include "redis_connection_pool.h"
+#include <algorithm>
+#include <iostream>
+
+namespace daf {
+
+// Lease implementation
+RedisConnectionPool::Lease::~Lease() {
+    Release();
+}
+
+RedisConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_), client_(std::move(other.client_)) {
+    other.pool_ = nullptr;
+}
+
+RedisConnectionPool::Lease& RedisConnectionPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        Release();
+        pool_ = other.pool_;
+        client_ = std::move(other.client_);
+        other.pool_ = nullptr;
+    }
+    return *this;
+}
+
+void RedisConnectionPool::Lease::Release() {
+    if (pool_ && client_) {
+        pool_->Return(std::move(client_));
+    }
+    pool_ = nullptr;
+    client_.reset();
+}
+
+// RedisConnectionPool implementation
+RedisConnectionPool::RedisConnectionPool(const std::string& host, int port, size_t size)
+    : host_(host), port_(port), size_(std::max<size_t>(1, size)),
+      health_check_interval_(30), shutdown_(false) {
+}
+
+RedisConnectionPool::~RedisConnectionPool() {
+    Shutdown();
+}
+
+bool RedisConnectionPool::Initialize() {
+    size_t connected = 0;
+    std::vector<IdleConnection> connections;
+
+    for (size_t i = 0; i < size_; ++i) {
+        auto client = std::make_unique<RedisClientProduction>();
+        if (client->Connect(host_, port_)) {
+            connected++;
+        }
+        // Failed connections stay in the pool and reconnect on checkout
+        connections.push_back({std::move(client), std::chrono::steady_clock::now()});
+    }
+
+    if (connected == 0) {
+        std::cerr << "[ERROR] Redis pool could not open any connection to "
+                  << host_ << ":" << port_ << std::endl;
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_ = std::move(connections);
+        shutdown_ = false;
+    }
+    available_.notify_all();
+
+    std::cout << "[INFO] Redis connection pool ready: " << connected << "/" << size_
+              << " connections to " << host_ << ":" << port_ << std::endl;
+    return true;
+}
+
+void RedisConnectionPool::Shutdown() {
+    std::vector<IdleConnection> connections;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutdown_ = true;
+        connections.swap(idle_);
+    }
+    available_.notify_all();
+
+    for (auto& connection : connections) {
+        connection.client->Disconnect();
+    }
+}
+
+RedisConnectionPool::Lease RedisConnectionPool::Acquire(std::chrono::milliseconds timeout) {
+    IdleConnection connection;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!available_.wait_for(lock, timeout, [this]() { return shutdown_ || !idle_.empty(); }) ||
+            shutdown_) {
+            std::cerr << "[ERROR] Redis pool: no connection available" << std::endl;
+            return Lease();
+        }
+
+        // Most recently returned first, it is the least likely to be stale
+        connection = std::move(idle_.back());
+        idle_.pop_back();
+    }
+
+    // Network round trips happen outside the pool lock
+    CheckHealth(connection);
+    return Lease(this, std::move(connection.client));
+}
+
+size_t RedisConnectionPool::Available() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_.size();
+}
+
+void RedisConnectionPool::Return(std::unique_ptr<RedisClientProduction> client) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!shutdown_) {
+            idle_.push_back({std::move(client), std::chrono::steady_clock::now()});
+        }
+    }
+    available_.notify_one();
+
+    // After shutdown the connection is simply closed
+    if (client) {
+        client->Disconnect();
+    }
+}
+
+void RedisConnectionPool::CheckHealth(IdleConnection& connection) {
+    auto& client = *connection.client;
+    if (!client.IsConnected()) {
+        client.Connect(host_, port_);
+        return;
+    }
+
+    auto idle_for = std::chrono::steady_clock::now() - connection.last_used;
+    if (idle_for >= health_check_interval_ && !client.Ping()) {
+        std::cout << "[WARN] Redis pool: stale connection, reconnecting" << std::endl;
+        client.Connect(host_, port_);
+    }
+}
+
+} // namespace daf
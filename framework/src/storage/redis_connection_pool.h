@@ -0,0 +1,88 @@
+#pragma once
+
+#include "redis_client_production.h"
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace daf {
+
+/**
+ * Thread-safe pool of Redis connections
+ * Each RedisClientProduction owns one redisContext, which must not be used
+ * from two threads at once. Threads check a connection out with Acquire(),
+ * use it exclusively and hand it back when the lease goes out of scope.
+ * Connections that sat idle longer than the health-check interval are
+ * pinged on checkout and reconnected if the ping fails. Leases must be
+ * returned before the pool is destroyed.
+ */
+class RedisConnectionPool {
+public:
+    static constexpr size_t DEFAULT_POOL_SIZE = 8;
+
+    class Lease {
+    public:
+        Lease() = default;
+        ~Lease();
+
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        explicit operator bool() const { return client_ != nullptr; }
+        RedisClientProduction* operator->() const { return client_.get(); }
+        RedisClientProduction& operator*() const { return *client_; }
+
+    private:
+        friend class RedisConnectionPool;
+        Lease(RedisConnectionPool* pool, std::unique_ptr<RedisClientProduction> client)
+            : pool_(pool), client_(std::move(client)) {}
+        void Release();
+
+        RedisConnectionPool* pool_ = nullptr;
+        std::unique_ptr<RedisClientProduction> client_;
+    };
+
+    RedisConnectionPool(const std::string& host, int port, size_t size = DEFAULT_POOL_SIZE);
+    ~RedisConnectionPool();
+
+    RedisConnectionPool(const RedisConnectionPool&) = delete;
+    RedisConnectionPool& operator=(const RedisConnectionPool&) = delete;
+
+    // Opens every connection; fails only if none could be established
+    bool Initialize();
+    void Shutdown();
+
+    // Blocks until a connection is free; an empty lease on timeout or shutdown
+    Lease Acquire(std::chrono::milliseconds timeout = std::chrono::milliseconds(5000));
+
+    void SetHealthCheckInterval(std::chrono::seconds interval) { health_check_interval_ = interval; }
+
+    size_t Size() const { return size_; }
+    size_t Available() const;
+
+private:
+    struct IdleConnection {
+        std::unique_ptr<RedisClientProduction> client;
+        std::chrono::steady_clock::time_point last_used;
+    };
+
+    void Return(std::unique_ptr<RedisClientProduction> client);
+    void CheckHealth(IdleConnection& connection);
+
+    std::string host_;
+    int port_;
+    size_t size_;
+    std::chrono::seconds health_check_interval_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+    std::vector<IdleConnection> idle_;
+    bool shutdown_;
+};
+
+} // namespace daf
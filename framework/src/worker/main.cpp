@@ -1,91 +1,99 @@
 #include "../common/daf_types.h"
 #include "../common/daf_utils.h"
 #include "../common/plugin_loader.h"
+#include "../common/input_split.h"
+#include "../common/task_codec.h"
+#include "../common/compression.h"
+#include "../common/key_sketch.h"
+#include "../common/metrics.h"
+#include "../common/task_cache.h"
+#include "../common/memory_governor.h"
+#ifdef USE_REAL_REDIS
+#include "../storage/redis_connection_pool.h"
+#endif
+#include "shuffle_buffer.h"
+#include "shuffle_service.h"
+#include "task_context.h"
+#include "task_arena.h"
+#include "thread_pool.h"
 #include <iostream>
 #include <thread>
 #include <chrono>
 #include <fstream>
 #include <sstream>
 #include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_set>
 
 namespace daf {
 
-class MapContextImpl : public MapContext {
+// Streaming plugin sink writing straight to the task's output file; large
+// writes (e.g. regions of the mapped input) bypass the stream buffer
+class FileTaskOutput : public TaskOutput {
 public:
-    MapContextImpl(const std::vector<std::string>& input_files, 
-                   const std::map<std::string, std::string>& parameters);
-    ~MapContextImpl();
-    
-    // MapContext interface
-    std::string read_input() override;
-    bool has_more_input() override;
-    void emit(const std::string& key, const std::string& value) override;
-    std::string get_parameter(const std::string& key) const override;
-    void set_status(const std::string& status) override;
-    size_t get_memory_usage() const override;
-    size_t get_memory_limit() const override;
-    
-    // Get emitted data
-    const std::map<std::string, std::vector<std::string>>& get_emitted_data() const;
+    explicit FileTaskOutput(const std::string& path);
     
-private:
-    std::vector<std::string> input_files_;
-    std::map<std::string, std::string> parameters_;
-    std::map<std::string, std::vector<std::string>> emitted_data_;
-    size_t current_file_index_;
-    std::ifstream current_file_;
-    std::string current_line_;
-    std::string status_;
-};
-
-class ReduceContextImpl : public ReduceContext {
-public:
-    ReduceContextImpl(const std::vector<std::string>& values,
-                      const std::map<std::string, std::string>& parameters);
-    ~ReduceContextImpl();
-    
-    // ReduceContext interface
-    std::vector<std::string> get_values() override;
-    bool has_more_values() override;
-    void emit(const std::string& value) override;
-    std::string get_parameter(const std::string& key) const override;
-    void set_status(const std::string& status) override;
-    size_t get_memory_usage() const override;
-    size_t get_memory_limit() const override;
-    
-    // Get emitted data
-    const std::vector<std::string>& get_emitted_data() const;
+    bool is_open() const { return out_.is_open(); }
+    bool close();
+    const std::string& error() const { return error_; }
+    
+    // TaskOutput interface
+    bool write(const void* data, size_t size) override;
+    uint64_t bytesWritten() const override { return bytes_written_; }
+    void setError(const std::string& message) override { error_ = message; }
     
 private:
-    std::vector<std::string> values_;
-    std::map<std::string, std::string> parameters_;
-    std::vector<std::string> emitted_data_;
-    size_t current_value_index_;
-    std::string status_;
+    std::vector<char> buffer_;
+    std::ofstream out_;
+    uint64_t bytes_written_;
+    std::string error_;
 };
 
 class Worker {
 public:
+    // worker_threads == 0 sizes the task pool to the hardware concurrency
     Worker(const std::string& coordinator_host, int coordinator_port, 
-           int worker_port = 50052);
+           int worker_port = 50052, size_t worker_threads = 0);
     ~Worker();
     
     bool start();
     void stop();
     bool is_running() const;
     
-    // Task execution
-    ErrorCode execute_map_task(const Task& task);
+    // Queue a task for the executor; tasks run concurrently on the pool
+    void submit_task(const Task& task);
+    size_t thread_count() const { return pool_->thread_count(); }
+    
+    // Task execution. Map tasks of jobs whose hot keys can be salted return
+    // their output's key sketch in result.
+    ErrorCode execute_map_task(const Task& task, std::string& result);
     ErrorCode execute_reduce_task(const Task& task);
     
     // Communication with coordinator
     ErrorCode register_with_coordinator();
     ErrorCode send_heartbeat();
-    ErrorCode report_task_completion(const std::string& task_id, TaskStatus status);
+    // output is where the task's output ended up, if not its output_file
+    ErrorCode report_task_completion(const std::string& task_id, TaskStatus status,
+                                     const std::string& result = "", const std::string& output = "");
     
 private:
+    bool load_task_plugin(const Task& task);
+    ErrorCode execute_streaming_plugin(IStreamingPlugin& plugin, const Task& task,
+                                       const char* data_type);
+    ErrorCode execute_partial_reduce(const Task& task, RunMerger& merger, const std::string& hot_key);
+    void publish_to_task_cache(const Task& task, const std::string& result);
+    ErrorCode claim_task_output(const Task& task, const std::string& written, std::string& output);
+    void run_task(const Task& task);
     void run_heartbeat_sender();
     void run_task_executor();
+#ifdef USE_REAL_REDIS
+    void run_task_fetcher();
+#endif
     
     std::string coordinator_host_;
     int coordinator_port_;
@@ -95,135 +103,173 @@ private:
     std::atomic<bool> is_registered_;
     std::atomic<int> active_task_count_;
     std::chrono::steady_clock::time_point last_heartbeat_;
+    int64_t last_cpu_time_ms_;
+    
+    // Directories on this host's disks (DAF_LOCAL_DATA, ':'-separated), so
+    // the scheduler can send tasks to the data
+    std::string local_data_paths_;
     
     // Background threads
     std::thread heartbeat_thread_;
     std::thread executor_thread_;
     
+    // Tasks waiting for the executor
+    std::deque<Task> pending_tasks_;
+    std::mutex task_mutex_;
+    std::condition_variable task_ready_;
+    
+#ifdef USE_REAL_REDIS
+    // Tasks are taken from the shared Redis queue only while a pool thread
+    // is free; one connection blocks on the queue, the other reports status
+    std::unique_ptr<RedisConnectionPool> redis_pool_;
+    std::thread fetcher_thread_;
+    std::condition_variable slot_free_;
+#endif
+    
     Logger logger_;
+    
+    // Serves this worker's map output runs to reducers on worker_port_
+    ShuffleServer shuffle_server_;
+    
+    // Declared last so running tasks finish before the members they use go away
+    std::unique_ptr<WorkStealingPool> pool_;
 };
 
 } // namespace daf
 
 using namespace daf;
 
-// MapContextImpl implementation
-MapContextImpl::MapContextImpl(const std::vector<std::string>& input_files,
-                               const std::map<std::string, std::string>& parameters)
-    : input_files_(input_files), parameters_(parameters), current_file_index_(0) {
-    
-    if (!input_files_.empty()) {
-        current_file_.open(input_files_[0]);
-    }
+// Codec of spills, map output runs and shuffle traffic (parameter
+// intermediate_compression: none, lz4 or zstd; LZ4 when compiled in)
+static CompressionCodec intermediate_codec_for(const Task& task) {
+    auto codec = task.parameters.find("intermediate_compression");
+    return compression_codec_for(codec == task.parameters.end() ? "lz4" : codec->second);
 }
 
-MapContextImpl::~MapContextImpl() {
-    if (current_file_.is_open()) {
-        current_file_.close();
-    }
-}
-
-std::string MapContextImpl::read_input() {
-    if (!has_more_input()) {
-        return "";
-    }
+// Shuffle settings for a map task, taken from the job parameters
+static ShuffleBuffer::Options shuffle_options_for(const Task& task) {
+    ShuffleBuffer::Options options;
+    options.spill_prefix = task.output_file;
+    options.codec = intermediate_codec_for(task);
     
-    std::getline(current_file_, current_line_);
-    
-    // If we reached end of current file, try next file
-    if (current_file_.eof() && current_file_index_ + 1 < input_files_.size()) {
-        current_file_.close();
-        current_file_index_++;
-        current_file_.open(input_files_[current_file_index_]);
-        if (current_file_.is_open()) {
-            std::getline(current_file_, current_line_);
-        }
+    auto reducers = task.parameters.find("num_reduce_tasks");
+    if (reducers != task.parameters.end()) {
+        options.num_partitions = static_cast<uint32_t>(std::max(1, std::atoi(reducers->second.c_str())));
     }
     
-    return current_line_;
-}
-
-bool MapContextImpl::has_more_input() {
-    if (!current_file_.is_open()) {
-        return false;
+    // Spill once the buffer reaches 80% of its share of the memory budget
+    size_t budget_mb = MAX_MEMORY_MB / 2;
+    auto buffer_mb = task.parameters.find("shuffle_buffer_mb");
+    if (buffer_mb != task.parameters.end()) {
+        budget_mb = static_cast<size_t>(std::max(1, std::atoi(buffer_mb->second.c_str())));
     }
+    options.memory_limit_bytes = budget_mb * 1024 * 1024 * 8 / 10;
     
-    // Check if current file has more data or if there are more files
-    return !current_file_.eof() || (current_file_index_ + 1 < input_files_.size());
-}
-
-void MapContextImpl::emit(const std::string& key, const std::string& value) {
-    emitted_data_[key].push_back(value);
-}
-
-std::string MapContextImpl::get_parameter(const std::string& key) const {
-    auto it = parameters_.find(key);
-    return (it != parameters_.end()) ? it->second : "";
-}
-
-void MapContextImpl::set_status(const std::string& status) {
-    status_ = status;
+    return options;
 }
 
-size_t MapContextImpl::get_memory_usage() const {
-    return Utils::get_memory_usage();
+// Parameter plugin_instances=thread gives every pool thread its own plugin
+// instance, for plugins whose process() keeps per-call state
+static PluginInstance plugin_instance_mode_for(const Task& task) {
+    auto mode = task.parameters.find("plugin_instances");
+    return mode != task.parameters.end() && mode->second == "thread" ? PluginInstance::PER_THREAD
+                                                                      : PluginInstance::SHARED;
 }
 
-size_t MapContextImpl::get_memory_limit() const {
-    return MAX_MEMORY_MB;
+// Map outputs are sketched for hot keys when the coordinator can salt them:
+// with several reducers and a combiner to build the partial aggregates
+// (parameter skew_salting=false turns it off)
+static bool sketch_keys_for(const Task& task, CombineFunction combine_function,
+                            const ShuffleBuffer::Options& options) {
+    auto salting = task.parameters.find("skew_salting");
+    return combine_function && options.num_partitions > 1 &&
+           (salting == task.parameters.end() || salting->second != "false");
 }
 
-const std::map<std::string, std::vector<std::string>>& MapContextImpl::get_emitted_data() const {
-    return emitted_data_;
-}
-
-// ReduceContextImpl implementation
-ReduceContextImpl::ReduceContextImpl(const std::vector<std::string>& values,
-                                     const std::map<std::string, std::string>& parameters)
-    : values_(values), parameters_(parameters), current_value_index_(0) {
-}
-
-ReduceContextImpl::~ReduceContextImpl() {
-}
-
-std::vector<std::string> ReduceContextImpl::get_values() {
-    return values_;
-}
-
-bool ReduceContextImpl::has_more_values() {
-    return current_value_index_ < values_.size();
-}
-
-void ReduceContextImpl::emit(const std::string& value) {
-    emitted_data_.push_back(value);
-}
-
-std::string ReduceContextImpl::get_parameter(const std::string& key) const {
-    auto it = parameters_.find(key);
-    return (it != parameters_.end()) ? it->second : "";
+// Hot keys a reduce task leaves to the salted reducers (parameter
+// skip_keys, comma-separated hex)
+static std::unordered_set<std::string> skip_keys_for(const Task& task) {
+    std::unordered_set<std::string> keys;
+    auto param = task.parameters.find("skip_keys");
+    if (param == task.parameters.end()) {
+        return keys;
+    }
+    std::stringstream list(param->second);
+    std::string hex, key;
+    while (std::getline(list, hex, ',')) {
+        if (hex_decode_key(hex, key)) {
+            keys.insert(key);
+        }
+    }
+    return keys;
 }
 
-void ReduceContextImpl::set_status(const std::string& status) {
-    status_ = status;
+// Input splits of a map task, cut into sub-splits that idle pool threads can
+// steal. Parameter split_mb sets the piece size (0 keeps the task's splits
+// as they are); by default a multi-threaded pool gets a few pieces per thread.
+static std::vector<InputSplit> map_splits_for(const Task& task, size_t thread_count) {
+    constexpr uint64_t SUB_SPLITS_PER_THREAD = 4;
+    
+    std::vector<InputSplit> splits;
+    uint64_t total_bytes = 0;
+    for (const auto& input : task.input_files) {
+        splits.push_back(InputSplit::parse(input));
+        total_bytes += split_size_bytes(splits.back());
+    }
+    
+    uint64_t target_bytes = 0;
+    auto split_mb = task.parameters.find("split_mb");
+    if (split_mb != task.parameters.end()) {
+        target_bytes = static_cast<uint64_t>(std::max(0, std::atoi(split_mb->second.c_str()))) * 1024 * 1024;
+    } else if (thread_count > 1) {
+        uint64_t pieces = thread_count * SUB_SPLITS_PER_THREAD;
+        target_bytes = std::max<uint64_t>(MIN_SUB_SPLIT_SIZE, (total_bytes + pieces - 1) / pieces);
+    }
+    
+    if (target_bytes == 0) {
+        return splits;
+    }
+    
+    std::vector<InputSplit> pieces;
+    for (const auto& split : splits) {
+        auto cut = cut_input_split(split, target_bytes);
+        pieces.insert(pieces.end(), cut.begin(), cut.end());
+    }
+    return pieces;
 }
 
-size_t ReduceContextImpl::get_memory_usage() const {
-    return Utils::get_memory_usage();
+// FileTaskOutput implementation
+FileTaskOutput::FileTaskOutput(const std::string& path)
+    : buffer_(DEFAULT_BUFFER_SIZE), bytes_written_(0) {
+    out_.rdbuf()->pubsetbuf(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    out_.open(path, std::ios::binary | std::ios::trunc);
 }
 
-size_t ReduceContextImpl::get_memory_limit() const {
-    return MAX_MEMORY_MB;
+bool FileTaskOutput::write(const void* data, size_t size) {
+    if (!out_) {
+        return false;
+    }
+    out_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    if (!out_) {
+        return false;
+    }
+    bytes_written_ += size;
+    return true;
 }
 
-const std::vector<std::string>& ReduceContextImpl::get_emitted_data() const {
-    return emitted_data_;
+bool FileTaskOutput::close() {
+    out_.close();
+    return !out_.fail();
 }
 
 // Worker implementation
-Worker::Worker(const std::string& coordinator_host, int coordinator_port, int worker_port)
+Worker::Worker(const std::string& coordinator_host, int coordinator_port, int worker_port,
+               size_t worker_threads)
     : coordinator_host_(coordinator_host), coordinator_port_(coordinator_port), 
       worker_port_(worker_port), running_(false), is_registered_(false), 
-      active_task_count_(0) {
+      active_task_count_(0), last_cpu_time_ms_(Utils::get_process_cpu_time_ms()),
+      local_data_paths_(Utils::getenv_or_default("DAF_LOCAL_DATA", "")),
+      pool_(std::make_unique<WorkStealingPool>(worker_threads)) {
     
     // Generate unique worker ID
     worker_id_ = "worker_" + Utils::get_local_ip() + "_" + std::to_string(worker_port);
@@ -241,8 +287,8 @@ bool Worker::start() {
     
     logger_.info("Starting DAF Worker: " + worker_id_);
     
-    // Check if port is available
-    if (!Utils::is_port_available(worker_port_)) {
+    // Reducers fetch map output from the worker port
+    if (!shuffle_server_.start(worker_port_)) {
         logger_.error("Worker port " + std::to_string(worker_port_) + " is already in use");
         return false;
     }
@@ -253,14 +299,38 @@ bool Worker::start() {
     if (register_with_coordinator() != ErrorCode::SUCCESS) {
         logger_.error("Failed to register with coordinator");
         running_.store(false);
+        shuffle_server_.stop();
         return false;
     }
     
+#ifdef USE_REAL_REDIS
+    std::string redis_host = Utils::getenv_or_default("REDIS_HOST", "localhost");
+    int redis_port = std::atoi(Utils::getenv_or_default("REDIS_PORT", "6379").c_str());
+    redis_pool_ = std::make_unique<RedisConnectionPool>(redis_host, redis_port, 2);
+    if (redis_pool_->Initialize()) {
+        auto redis = redis_pool_->Acquire();
+        if (redis) {
+            // Tasks a previous run of this worker took but never finished
+            redis->RecoverWorkerTasks(worker_id_);
+            redis->RegisterWorker(worker_id_, Utils::get_local_ip(), worker_port_);
+        }
+    } else {
+        logger_.warning("Redis unavailable, only locally submitted tasks will run");
+        redis_pool_.reset();
+    }
+#endif
+    
     // Start background threads
     heartbeat_thread_ = std::thread(&Worker::run_heartbeat_sender, this);
     executor_thread_ = std::thread(&Worker::run_task_executor, this);
+#ifdef USE_REAL_REDIS
+    if (redis_pool_) {
+        fetcher_thread_ = std::thread(&Worker::run_task_fetcher, this);
+    }
+#endif
     
-    logger_.info("DAF Worker started successfully");
+    logger_.info("DAF Worker started successfully (" + std::to_string(pool_->thread_count()) +
+                " task threads)");
     return true;
 }
 
@@ -270,15 +340,28 @@ void Worker::stop() {
     }
     
     logger_.info("Stopping DAF Worker...");
-    running_.store(false);
+    {
+        std::lock_guard<std::mutex> lock(task_mutex_);
+        running_.store(false);
+    }
+    task_ready_.notify_all();
+#ifdef USE_REAL_REDIS
+    slot_free_.notify_all();
+#endif
     
     // Wait for threads to finish
     if (heartbeat_thread_.joinable()) {
         heartbeat_thread_.join();
     }
+#ifdef USE_REAL_REDIS
+    if (fetcher_thread_.joinable()) {
+        fetcher_thread_.join();
+    }
+#endif
     if (executor_thread_.joinable()) {
         executor_thread_.join();
     }
+    shuffle_server_.stop();
     
     logger_.info("DAF Worker stopped");
 }
@@ -287,10 +370,14 @@ bool Worker::is_running() const {
     return running_.load();
 }
 
-ErrorCode Worker::execute_map_task(const Task& task) {
-    logger_.info("Executing map task: " + task.id);
+bool Worker::load_task_plugin(const Task& task) {
+    // Plugins are keyed by the task's plugin name; once loaded, the lookup
+    // takes no lock and touches no file
+    auto& plugin_loader = PluginLoader::getInstance();
+    if (plugin_loader.isLoaded(task.plugin_name)) {
+        return true;
+    }
     
-    // Load plugin if not already loaded
     std::string plugin_path = task.plugin_name;
 #ifdef _WIN32
     plugin_path += ".dll";
@@ -298,26 +385,173 @@ ErrorCode Worker::execute_map_task(const Task& task) {
     plugin_path += ".so";
 #endif
     
-    auto& plugin_loader = PluginLoader::getInstance();
-    if (!plugin_loader.loadPlugin(plugin_path, "nerf_avatar")) {
+    if (!plugin_loader.loadPlugin(plugin_path, task.plugin_name)) {
         logger_.error("Failed to load plugin: " + plugin_path);
+        return false;
+    }
+    return true;
+}
+
+// Runs a plugin built against the streaming ABI on the task's first input
+// split, mapped read-only, writing its output straight to the output file
+ErrorCode Worker::execute_streaming_plugin(IStreamingPlugin& plugin, const Task& task,
+                                           const char* data_type) {
+    std::string input_path;
+    MappedFile input;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    if (!task.input_files.empty()) {
+        InputSplit split = InputSplit::parse(task.input_files[0]);
+        input_path = split.path;
+        if (!input.open(split.path)) {
+            logger_.error("Cannot map input file: " + split.path);
+            return ErrorCode::IO_ERROR;
+        }
+        size_t offset = static_cast<size_t>(std::min<uint64_t>(split.offset, input.size()));
+        size = static_cast<size_t>(std::min<uint64_t>(split.length, input.size() - offset));
+        if (size > 0) {
+            data = reinterpret_cast<const uint8_t*>(input.data()) + offset;
+        }
+    }
+    
+    FileTaskOutput output(task.output_file);
+    if (!output.is_open()) {
+        logger_.error("Cannot open task output: " + task.output_file);
+        return ErrorCode::IO_ERROR;
+    }
+    
+    TaskInput task_input{task.id, data_type, input_path, data, size, task.parameters};
+    if (!plugin.processStream(task_input, output)) {
+        logger_.error("Plugin processing failed: " + output.error());
         return ErrorCode::PLUGIN_ERROR;
     }
+    if (!output.close()) {
+        logger_.error("Failed to write task output: " + task.output_file);
+        return ErrorCode::IO_ERROR;
+    }
     
-    auto plugin = plugin_loader.getPlugin("nerf_avatar");
+    logger_.info("Streaming " + std::string(data_type) + " task completed: " + task.id + " (" +
+                std::to_string(output.bytesWritten()) + " bytes)");
+    return ErrorCode::SUCCESS;
+}
+
+ErrorCode Worker::execute_map_task(const Task& task, std::string& result) {
+    logger_.info("Executing map task: " + task.id);
+    
+    auto& plugin_loader = PluginLoader::getInstance();
+    if (!load_task_plugin(task)) {
+        return ErrorCode::PLUGIN_ERROR;
+    }
+    
+    // Prefer the plugin's MapMain entry point so it can consume typed sample batches
+    auto map_function = reinterpret_cast<MapFunction>(
+        plugin_loader.getSymbol(task.plugin_name, "MapMain"));
+    if (map_function) {
+        // Optional combiner collapses each key group before it is spilled or shipped
+        auto combine_function = reinterpret_cast<CombineFunction>(
+            plugin_loader.getSymbol(task.plugin_name, "CombineMain"));
+        auto combiner_param = task.parameters.find("combiner");
+        if (combiner_param != task.parameters.end() && combiner_param->second == "false") {
+            combine_function = nullptr;
+        }
+        
+        auto splits = map_splits_for(task, pool_->thread_count());
+        auto options = shuffle_options_for(task);
+        KeySketch sketch;
+        KeySketch* key_sketch = sketch_keys_for(task, combine_function, options) ? &sketch : nullptr;
+        
+        // Small inputs map straight into the output run (+ index sidecar)
+        if (splits.size() <= 1) {
+            if (!run_map_splits(map_function, combine_function, splits, task.parameters,
+                                options, task.output_file, key_sketch)) {
+                logger_.error("Failed to write map output: " + task.output_file);
+                return ErrorCode::IO_ERROR;
+            }
+            if (key_sketch) {
+                result = key_sketch->encode();
+            }
+            shuffle_server_.publish(task.output_file);
+            logger_.info("Map task completed: " + task.id);
+            return ErrorCode::SUCCESS;
+        }
+        
+        // Each sub-split maps into its own run with its own share of the
+        // shuffle budget; threads that run dry steal the remaining sub-splits
+        constexpr std::chrono::milliseconds SUB_SPLIT_HEADROOM_WAIT{2000};
+        size_t concurrency = std::min(splits.size(), pool_->thread_count());
+        ShuffleBuffer::Options part_options = options;
+        part_options.memory_limit_bytes = std::max<size_t>(options.memory_limit_bytes / concurrency,
+                                                           DEFAULT_BUFFER_SIZE);
+        
+        std::vector<std::string> part_files(splits.size());
+        std::vector<char> part_ok(splits.size(), 0);
+        {
+            TaskGroup group(*pool_);
+            for (size_t i = 0; i < splits.size(); ++i) {
+                part_files[i] = task.output_file + ".part" + std::to_string(i);
+                group.run([&, i]() {
+                    // Give spilling siblings a moment before reading more input
+                    MemoryGovernor::instance().wait_for_headroom(SUB_SPLIT_HEADROOM_WAIT);
+                    ShuffleBuffer::Options split_options = part_options;
+                    split_options.spill_prefix = part_files[i];
+                    part_ok[i] = run_map_splits(map_function, combine_function, {splits[i]},
+                                                task.parameters, split_options, part_files[i]);
+                });
+            }
+            group.wait();
+        }
+        
+        // Merge the sub-split runs in split order, combining across them
+        bool ok = std::all_of(part_ok.begin(), part_ok.end(), [](char part) { return part != 0; });
+        if (ok) {
+            ShuffleBuffer merge_buffer(options);
+            ReduceContextImpl combine_context({}, task.parameters, TaskArena::local().resource());
+            if (combine_function) {
+                merge_buffer.set_combiner(make_combiner(combine_function, combine_context));
+            }
+            merge_buffer.set_key_sketch(key_sketch);
+            ok = merge_buffer.merge_runs(part_files, task.output_file);
+        }
+        
+        for (const auto& part_file : part_files) {
+            std::remove(part_file.c_str());
+            std::remove(RunIndex::path_for(part_file).c_str());
+        }
+        
+        if (!ok) {
+            logger_.error("Failed to write map output: " + task.output_file);
+            return ErrorCode::IO_ERROR;
+        }
+        
+        if (key_sketch) {
+            result = key_sketch->encode();
+        }
+        shuffle_server_.publish(task.output_file);
+        logger_.info("Map task completed: " + task.id + " (" + std::to_string(splits.size()) +
+                    " sub-splits)");
+        return ErrorCode::SUCCESS;
+    }
+    
+    auto instance_mode = plugin_instance_mode_for(task);
+    auto streaming_plugin = plugin_loader.getStreamingPlugin(task.plugin_name, instance_mode);
+    if (streaming_plugin) {
+        return execute_streaming_plugin(*streaming_plugin, task, "map");
+    }
+    
+    auto plugin = plugin_loader.getPlugin(task.plugin_name, instance_mode);
     if (!plugin) {
-        logger_.error("Plugin not found: nerf_avatar");
+        logger_.error("Plugin not found: " + task.plugin_name);
         return ErrorCode::PLUGIN_ERROR;
     }
     
     // Create task data for plugin processing
-    TaskData task_data;
+    TaskData task_data{};
     task_data.task_id = task.id;
     task_data.data_type = "map";
     task_data.input_path = task.input_files.empty() ? "" : task.input_files[0];
     task_data.metadata = task.parameters;
     
-    TaskResult task_result;
+    TaskResult task_result{};
     if (!plugin->process(task_data, task_result)) {
         logger_.error("Plugin processing failed: " + task_result.error_message);
         return ErrorCode::PLUGIN_ERROR;
@@ -339,20 +573,142 @@ ErrorCode Worker::execute_reduce_task(const Task& task) {
     logger_.info("Executing reduce task: " + task.id);
     
     auto& plugin_loader = PluginLoader::getInstance();
-    auto plugin = plugin_loader.getPlugin("nerf_avatar");
+    if (!load_task_plugin(task)) {
+        return ErrorCode::PLUGIN_ERROR;
+    }
+    
+    // Streaming reduce over this task's partition of every map output run
+    auto reduce_function = reinterpret_cast<ReduceFunction>(
+        plugin_loader.getSymbol(task.plugin_name, "ReduceMain"));
+    if (reduce_function) {
+        auto partition_param = task.parameters.find("reduce_partition");
+        uint32_t partition = partition_param == task.parameters.end() ? 0 :
+            static_cast<uint32_t>(std::max(0, std::atoi(partition_param->second.c_str())));
+        
+        // A hot key salted across several reducers: this task combines it
+        // over its share of the map outputs into a partial run, and a merge
+        // task reduces the partials. Other reducers skip the key.
+        auto hot_key_param = task.parameters.find("reduce_key");
+        std::string hot_key;
+        bool partial = hot_key_param != task.parameters.end();
+        if (partial) {
+            auto reducers = task.parameters.find("num_reduce_tasks");
+            uint32_t num_partitions = reducers == task.parameters.end() ? 1 :
+                static_cast<uint32_t>(std::max(1, std::atoi(reducers->second.c_str())));
+            if (!hex_decode_key(hot_key_param->second, hot_key)) {
+                logger_.error("Invalid reduce_key for task " + task.id);
+                return ErrorCode::INVALID_ARGUMENT;
+            }
+            partition = partition_for_key(hot_key, num_partitions);
+        }
+        std::unordered_set<std::string> skip_keys = skip_keys_for(task);
+        
+        // Map outputs on other hosts are pulled from the workers that wrote them
+        auto fetches_param = task.parameters.find("shuffle_parallel_fetches");
+        size_t parallel_fetches = fetches_param == task.parameters.end() ? SHUFFLE_PARALLEL_FETCHES :
+            static_cast<size_t>(std::max(1, std::atoi(fetches_param->second.c_str())));
+        ShuffleFetcher fetcher(partition, task.output_file, parallel_fetches);
+        fetcher.set_compression(intermediate_codec_for(task));
+        for (const auto& input : task.input_files) {
+            fetcher.add(input);
+        }
+        if (!fetcher.run()) {
+            logger_.error("Shuffle fetch failed for task " + task.id + ": " + fetcher.error());
+            return ErrorCode::NETWORK_ERROR;
+        }
+        
+        RunMerger merger;
+        for (const auto& run : fetcher.runs()) {
+            auto reader = std::make_unique<RunReader>();
+            if (!reader->open(run, partition)) {
+                logger_.error("Cannot open map output run: " + run);
+                return ErrorCode::IO_ERROR;
+            }
+            merger.add_source(std::move(reader));
+        }
+        
+        if (partial) {
+            return execute_partial_reduce(task, merger, hot_key);
+        }
+        
+        std::vector<char> out_buffer(DEFAULT_BUFFER_SIZE);
+        std::ofstream out;
+        out.rdbuf()->pubsetbuf(out_buffer.data(), static_cast<std::streamsize>(out_buffer.size()));
+        out.open(task.output_file, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            logger_.error("Cannot open reduce output: " + task.output_file);
+            return ErrorCode::IO_ERROR;
+        }
+        
+        // Parameter output_compression writes .lz4 / .zst frames instead of
+        // plain records; compression_level tunes Zstd
+        auto output_param = task.parameters.find("output_compression");
+        CompressionCodec output_codec = compression_codec_for(
+            output_param == task.parameters.end() ? "none" : output_param->second);
+        auto level_param = task.parameters.find("compression_level");
+        int level = level_param == task.parameters.end() ? 0 : std::atoi(level_param->second.c_str());
+        std::unique_ptr<FrameOutputBuffer> frames;
+        std::ostream compressed_out(nullptr);
+        if (output_codec != CompressionCodec::NONE) {
+            frames = std::make_unique<FrameOutputBuffer>(out, output_codec, level);
+            compressed_out.rdbuf(frames.get());
+        }
+        
+        KeyGroupReader groups(merger);
+        ReduceContextImpl context({}, task.parameters, TaskArena::local().resource());
+        context.set_output(frames ? &compressed_out : static_cast<std::ostream*>(&out));
+        
+        uint64_t key_count = 0;
+        while (groups.next_group()) {
+            if (!skip_keys.empty() && skip_keys.count(groups.key())) {
+                continue;
+            }
+            ScopedStageTimer timer(Stage::REDUCE);
+            context.reset(groups.key(), &groups);
+            reduce_function(groups.key().c_str(), &context);
+            key_count++;
+        }
+        Metrics::counter(CounterId::REDUCE_KEYS).add(key_count);
+        if (merger.failed()) {
+            logger_.error("Corrupt map output run in reduce task " + task.id);
+            return ErrorCode::IO_ERROR;
+        }
+        
+        if (frames && !frames->finish()) {
+            logger_.error("Failed to compress reduce output: " + task.output_file);
+            return ErrorCode::IO_ERROR;
+        }
+        out.close();
+        if (out.fail()) {
+            logger_.error("Failed to write reduce output: " + task.output_file);
+            return ErrorCode::IO_ERROR;
+        }
+        
+        logger_.info("Reduce task completed: " + task.id + " (" + std::to_string(key_count) +
+                    " keys, " + std::to_string(context.emitted_count()) + " records)");
+        return ErrorCode::SUCCESS;
+    }
+    
+    auto instance_mode = plugin_instance_mode_for(task);
+    auto streaming_plugin = plugin_loader.getStreamingPlugin(task.plugin_name, instance_mode);
+    if (streaming_plugin) {
+        return execute_streaming_plugin(*streaming_plugin, task, "reduce");
+    }
+    
+    auto plugin = plugin_loader.getPlugin(task.plugin_name, instance_mode);
     if (!plugin) {
-        logger_.error("Plugin not found: nerf_avatar");
+        logger_.error("Plugin not found: " + task.plugin_name);
         return ErrorCode::PLUGIN_ERROR;
     }
     
     // Create task data for plugin processing
-    TaskData task_data;
+    TaskData task_data{};
     task_data.task_id = task.id;
     task_data.data_type = "reduce";
     task_data.input_path = task.input_files.empty() ? "" : task.input_files[0];
     task_data.metadata = task.parameters;
     
-    TaskResult task_result;
+    TaskResult task_result{};
     if (!plugin->process(task_data, task_result)) {
         logger_.error("Plugin processing failed: " + task_result.error_message);
         return ErrorCode::PLUGIN_ERROR;
@@ -370,6 +726,56 @@ ErrorCode Worker::execute_reduce_task(const Task& task) {
     return ErrorCode::SUCCESS;
 }
 
+ErrorCode Worker::execute_partial_reduce(const Task& task, RunMerger& merger, const std::string& hot_key) {
+    // Partials must merge with ReduceMain, so they are built by the combiner
+    auto combine_function = reinterpret_cast<CombineFunction>(
+        PluginLoader::getInstance().getSymbol(task.plugin_name, "CombineMain"));
+    if (!combine_function) {
+        logger_.error("Salted reduce task " + task.id + " needs CombineMain in " + task.plugin_name);
+        return ErrorCode::PLUGIN_ERROR;
+    }
+    
+    // A one-partition run, fetched by the merge task like a map output
+    RunWriter writer;
+    if (!writer.open(task.output_file, 1, intermediate_codec_for(task))) {
+        logger_.error("Cannot open partial reduce output: " + task.output_file);
+        return ErrorCode::IO_ERROR;
+    }
+    
+    KeyGroupReader groups(merger);
+    ReduceContextImpl context({}, task.parameters, TaskArena::local().resource());
+    size_t partial_count = 0;
+    while (groups.next_group()) {
+        // Keys are sorted within the partition, nothing past the hot key matters
+        if (groups.key() < hot_key) {
+            continue;
+        }
+        if (groups.key() != hot_key) {
+            break;
+        }
+        ScopedStageTimer timer(Stage::REDUCE);
+        context.reset(groups.key(), &groups);
+        combine_function(groups.key().c_str(), &context);
+        for (size_t i = 0; i < context.buffered_count(); ++i) {
+            writer.append(0, hot_key, context.buffered_value(i), groups.binary_key());
+        }
+        partial_count = context.buffered_count();
+    }
+    if (merger.failed()) {
+        logger_.error("Corrupt map output run in partial reduce task " + task.id);
+        return ErrorCode::IO_ERROR;
+    }
+    if (!writer.close()) {
+        logger_.error("Failed to write partial reduce output: " + task.output_file);
+        return ErrorCode::IO_ERROR;
+    }
+    shuffle_server_.publish(task.output_file);
+    
+    logger_.info("Partial reduce task completed: " + task.id + " (" + std::to_string(partial_count) +
+                " partial values)");
+    return ErrorCode::SUCCESS;
+}
+
 ErrorCode Worker::register_with_coordinator() {
     // Production implementation: HTTP-based registration
     logger_.info("Registering with coordinator at " + coordinator_host_ + ":" + 
@@ -410,29 +816,39 @@ ErrorCode Worker::register_with_coordinator() {
 }
 
 ErrorCode Worker::send_heartbeat() {
-    // Production implementation: HTTP-based heartbeat
+    // Production implementation: heartbeat hash in Redis
     if (!is_registered_) {
         return ErrorCode::INVALID_STATE;
     }
     
     try {
-        std::string worker_id = "worker_" + worker_id_;
         auto now = std::chrono::steady_clock::now();
-        auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(
-            now.time_since_epoch()).count();
         
-        // JSON heartbeat payload
-        std::string payload = "{"
-            "\"worker_id\":\"" + worker_id + "\","
-            "\"timestamp\":" + std::to_string(timestamp) + ","
-            "\"status\":\"alive\","
-            "\"active_tasks\":" + std::to_string(active_task_count_) +
-            "}";
+#ifdef USE_REAL_REDIS
+        // Load metrics for the scheduler: CPU is this process's share of
+        // all cores since the previous heartbeat
+        int64_t cpu_time_ms = Utils::get_process_cpu_time_ms();
+        auto wall_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_heartbeat_).count();
+        unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        int cpu_percent = wall_ms > 0 ? static_cast<int>(std::min<int64_t>(100,
+            (cpu_time_ms - last_cpu_time_ms_) * 100 / (wall_ms * cores))) : 0;
+        last_cpu_time_ms_ = cpu_time_ms;
+        size_t memory_mb = Utils::get_memory_usage();   // Live RSS, not the peak
         
-        std::string url = "http://" + coordinator_host_ + ":" + 
-                         std::to_string(coordinator_port_) + "/api/workers/heartbeat";
-        
-        logger_.debug("Sending heartbeat to: " + url);
+        if (redis_pool_) {
+            auto redis = redis_pool_->Acquire();
+            if (!redis || !redis->UpdateWorkerHeartbeat(worker_id_, {
+                    {"active_tasks", std::to_string(active_task_count_)},
+                    {"task_slots", std::to_string(pool_->thread_count())},
+                    {"memory_mb", std::to_string(memory_mb)},
+                    {"cpu_percent", std::to_string(cpu_percent)},
+                    {"local_paths", local_data_paths_},
+                    // Scraped by the coordinator's /api/metrics
+                    {"metrics", Metrics::snapshot().encode()}})) {
+                return ErrorCode::NETWORK_ERROR;
+            }
+        }
+#endif
         last_heartbeat_ = now;
         
         return ErrorCode::SUCCESS;
@@ -442,9 +858,24 @@ ErrorCode Worker::send_heartbeat() {
     }
 }
 
-ErrorCode Worker::report_task_completion(const std::string& task_id, TaskStatus status) {
+ErrorCode Worker::report_task_completion(const std::string& task_id, TaskStatus status,
+                                         [[maybe_unused]] const std::string& result,
+                                         [[maybe_unused]] const std::string& output) {
     logger_.info("Reporting task completion: " + task_id + " status: " + 
                 std::to_string(static_cast<int>(status)));
+#ifdef USE_REAL_REDIS
+    if (redis_pool_) {
+        auto redis = redis_pool_->Acquire();
+        bool reported = redis && (status == TaskStatus::COMPLETED
+                                      ? redis->CompleteTask(worker_id_, task_id, result, output)
+                                      : redis->FailTask(worker_id_, task_id, "task execution failed"));
+        if (!reported) {
+            // The task stays on our processing list and is recovered later
+            logger_.error("Failed to report task status to Redis: " + task_id);
+            return ErrorCode::NETWORK_ERROR;
+        }
+    }
+#endif
     return ErrorCode::SUCCESS;
 }
 
@@ -459,22 +890,260 @@ void Worker::run_heartbeat_sender() {
     logger_.info("Heartbeat sender stopped");
 }
 
+void Worker::submit_task(const Task& task) {
+    {
+        std::lock_guard<std::mutex> lock(task_mutex_);
+        pending_tasks_.push_back(task);
+    }
+    task_ready_.notify_one();
+}
+
+// The coordinator keys a cached task on everything but the plugin version,
+// which only a worker that loaded the plugin knows. A task that cannot be
+// published just stays uncached.
+void Worker::publish_to_task_cache(const Task& task, const std::string& result) {
+    auto plugin = PluginLoader::getInstance().getPlugin(task.plugin_name);
+    if (!plugin) {
+        return;
+    }
+    std::string version = plugin->getVersion();
+    std::string key = TaskCache::versioned_key(task.parameters.at("cache_key_base"), version);
+    
+    // Map runs carry their index and the digests their reducers are keyed on
+    TaskCacheEntry entry;
+    entry.result = result;
+    std::vector<std::string> files = {task.output_file};
+    std::string index_path = RunIndex::path_for(task.output_file);
+    if (task.type == TaskType::MAP && Utils::file_exists(index_path)) {
+        if (!run_partition_digests(task.output_file, entry.digests)) {
+            logger_.warning("Cannot digest map output for the task cache: " + task.output_file);
+            return;
+        }
+        files.push_back(index_path);
+    }
+    
+    TaskCache cache(task.parameters.at("task_cache_dir"));
+    if (!cache.publish(key, files, entry)) {
+        logger_.warning("Failed to publish task " + task.id + " to the task cache");
+        return;
+    }
+    logger_.debug("Published task " + task.id + " to the task cache as " + key);
+    
+#ifdef USE_REAL_REDIS
+    if (redis_pool_) {
+        auto redis = redis_pool_->Acquire();
+        if (redis) {
+            redis->SetHash("plugin_versions", task.plugin_name, version);
+        }
+    }
+#endif
+}
+
+// Both attempts of a speculated task race for the winner claim once their
+// output is written, and every task claims since a backup may start at any
+// time. Only this worker can touch its disk, so it also cleans up: a losing
+// attempt removes its output (INVALID_STATE) and a winning backup moves its
+// output to the original's path. written is the identity the output file
+// had when the task started. On shared storage a winning backup may have
+// renamed its file over a losing original's, and that file must stay.
+ErrorCode Worker::claim_task_output(const Task& task, [[maybe_unused]] const std::string& written,
+                                    std::string& output) {
+    output = task.output_file;
+#ifdef USE_REAL_REDIS
+    if (!redis_pool_) {
+        return ErrorCode::SUCCESS;
+    }
+    
+    auto attempt_of = task.parameters.find("attempt_of");
+    std::string task_id = attempt_of == task.parameters.end() ? task.id : attempt_of->second;
+    auto redis = redis_pool_->Acquire();
+    bool won = false;
+    if (!redis || !redis->ClaimTask(task_id, task.id, won)) {
+        logger_.error("Cannot claim the output of task " + task_id);
+        return ErrorCode::NETWORK_ERROR;
+    }
+    
+    std::string index_path = RunIndex::path_for(task.output_file);
+    if (!won) {
+        if (!written.empty() && Utils::get_file_identity(task.output_file) == written) {
+            std::remove(task.output_file.c_str());
+            std::remove(index_path.c_str());
+        }
+        logger_.info("Task " + task.id + " lost to the other attempt of " + task_id);
+        return ErrorCode::INVALID_STATE;
+    }
+    
+    auto final_output = task.parameters.find("final_output");
+    if (final_output == task.parameters.end() || final_output->second == task.output_file) {
+        return ErrorCode::SUCCESS;
+    }
+    // The index goes first and comes back if the data cannot follow, so the
+    // output stays whole under one name or the other
+    const std::string& target = final_output->second;
+    bool has_index = Utils::file_exists(index_path);
+    if (has_index && std::rename(index_path.c_str(), RunIndex::path_for(target).c_str()) != 0) {
+        logger_.warning("Cannot move backup output " + task.output_file + " to " + target);
+        return ErrorCode::SUCCESS;
+    }
+    if (std::rename(task.output_file.c_str(), target.c_str()) != 0) {
+        if (has_index) {
+            std::rename(RunIndex::path_for(target).c_str(), index_path.c_str());
+        }
+        logger_.warning("Cannot move backup output " + task.output_file + " to " + target);
+        return ErrorCode::SUCCESS;
+    }
+    output = target;
+    if (has_index) {
+        shuffle_server_.publish(output);
+    }
+#endif
+    return ErrorCode::SUCCESS;
+}
+
+void Worker::run_task(const Task& task) {
+    // Counted while the task actually runs on a pool thread
+    active_task_count_++;
+    
+    // Everything the task allocates from its arena goes away with it
+    TaskArenaScope arena;
+    
+    // Outputs are replaced rather than truncated: a previous one may be a
+    // hard link into a task cache
+    std::remove(task.output_file.c_str());
+    std::remove(RunIndex::path_for(task.output_file).c_str());
+    // Created up front, so its identity is known before another attempt
+    // could move a file over it (see claim_task_output)
+    std::ofstream(task.output_file, std::ios::binary | std::ios::trunc).close();
+    std::string written = Utils::get_file_identity(task.output_file);
+    
+    ErrorCode result = ErrorCode::INVALID_ARGUMENT;
+    std::string task_result;
+    switch (task.type) {
+        case TaskType::MAP:
+            result = execute_map_task(task, task_result);
+            break;
+        case TaskType::REDUCE:
+            result = execute_reduce_task(task);
+            break;
+        default:
+            logger_.error("Unsupported task type for task: " + task.id);
+            break;
+    }
+    
+    // A losing attempt still reports completed; the coordinator ignores it
+    Task finished = task;
+    bool won = result == ErrorCode::SUCCESS;
+    if (won) {
+        ErrorCode claim = claim_task_output(task, written, finished.output_file);
+        won = claim == ErrorCode::SUCCESS;
+        if (claim == ErrorCode::NETWORK_ERROR) {
+            result = claim;
+        }
+    }
+    
+    if (won && task.parameters.count("task_cache_dir") > 0 &&
+        task.parameters.count("cache_key_base") > 0) {
+        publish_to_task_cache(finished, task_result);
+    }
+    
+    Metrics::counter(result == ErrorCode::SUCCESS ? CounterId::TASKS_COMPLETED
+                                                  : CounterId::TASKS_FAILED).add();
+    report_task_completion(task.id, result == ErrorCode::SUCCESS ? TaskStatus::COMPLETED
+                                                                  : TaskStatus::FAILED, task_result,
+                           finished.output_file != task.output_file ? finished.output_file : "");
+    active_task_count_--;
+#ifdef USE_REAL_REDIS
+    slot_free_.notify_one();
+#endif
+}
+
 void Worker::run_task_executor() {
     logger_.info("Task executor started");
     
-    while (running_.load()) {
-        // In real implementation, would fetch tasks from coordinator
-        // For now, just sleep
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(task_mutex_);
+            task_ready_.wait(lock, [this]() { return !running_.load() || !pending_tasks_.empty(); });
+            if (!running_.load()) {
+                if (!pending_tasks_.empty()) {
+                    logger_.warning("Dropping " + std::to_string(pending_tasks_.size()) +
+                                   " queued tasks on shutdown");
+                    pending_tasks_.clear();
+                }
+                break;
+            }
+            task = std::move(pending_tasks_.front());
+            pending_tasks_.pop_front();
+        }
+        
+        // Whole tasks go through the pool's shared queue; their sub-splits
+        // stay on the thread that runs them unless someone steals them
+        pool_->submit([this, task = std::move(task)]() { run_task(task); });
     }
     
     logger_.info("Task executor stopped");
 }
 
+#ifdef USE_REAL_REDIS
+void Worker::run_task_fetcher() {
+    logger_.info("Task fetcher started");
+    
+    // Over the memory budget only an idle worker takes more work, so a task
+    // bigger than the budget still gets to run
+    auto has_free_slot = [this]() {
+        size_t busy = pending_tasks_.size() + static_cast<size_t>(active_task_count_.load());
+        return busy < pool_->thread_count() && (busy == 0 || !MemoryGovernor::instance().over_budget());
+    };
+    
+    while (running_.load()) {
+        // Tasks this worker cannot start yet stay on the shared queue for others
+        {
+            std::unique_lock<std::mutex> lock(task_mutex_);
+            slot_free_.wait_for(lock, std::chrono::seconds(1), [&]() {
+                return !running_.load() || has_free_slot();
+            });
+            if (!running_.load() || !has_free_slot()) {
+                continue;
+            }
+        }
+        
+        auto redis = redis_pool_->Acquire();
+        if (!redis) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            continue;
+        }
+        
+        // Blocks until the coordinator pushes a task; the short timeout
+        // only bounds how long stop() waits for this thread
+        std::string task_id;
+        std::string task_data;
+        if (!redis->GetNextTask(worker_id_, task_id, task_data, 1)) {
+            if (!redis->IsConnected()) {
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+            }
+            continue;
+        }
+        
+        Task task;
+        if (!decode_task(task_data, task)) {
+            logger_.error("Malformed task data for task: " + task_id);
+            redis->FailTask(worker_id_, task_id, "malformed task data");
+            continue;
+        }
+        task.id = task_id;
+        submit_task(task);
+    }
+    
+    logger_.info("Task fetcher stopped");
+}
+#endif
+
 int main(int argc, char* argv[]) {
     std::string coordinator_host = "localhost";
     int coordinator_port = 50051;
     int worker_port = 50052;
+    size_t worker_threads = 0;
     
     if (argc > 1) {
         coordinator_host = argv[1];
@@ -485,11 +1154,14 @@ int main(int argc, char* argv[]) {
     if (argc > 3) {
         worker_port = std::atoi(argv[3]);
     }
+    if (argc > 4) {
+        worker_threads = static_cast<size_t>(std::max(0, std::atoi(argv[4])));
+    }
     
     Logger::set_level(Logger::Level::INFO);
     Logger::info("Starting DAF Worker...");
     
-    Worker worker(coordinator_host, coordinator_port, worker_port);
+    Worker worker(coordinator_host, coordinator_port, worker_port, worker_threads);
     
     if (!worker.start()) {
         Logger::error("Failed to start worker");
@@ -0,0 +1,378 @@
+#include "shuffle_buffer.h"
+#include "../common/daf_utils.h"
+#include "../common/metrics.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <cstdio>
+
+namespace daf {
+
+namespace {
+
+constexpr size_t RECORD_HEADER_BYTES = 2 * sizeof(uint32_t);
+constexpr size_t MIN_CHUNK_BYTES = 64 * 1024;
+constexpr size_t RADIX_SORT_MIN_ENTRIES = 256;
+
+// Closes a finished run and counts its bytes
+bool close_run(RunWriter& writer) {
+    bool ok = writer.close();
+    Metrics::counter(CounterId::SPILLED_BYTES).add(writer.bytes_written());
+    return ok;
+}
+
+uint64_t key_prefix(std::string_view key) {
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        prefix <<= 8;
+        if (i < key.size()) {
+            prefix |= static_cast<unsigned char>(key[i]);
+        }
+    }
+    return prefix;
+}
+
+} // namespace
+
+ShuffleBuffer::ShuffleBuffer(const Options& options)
+    : options_(options) {
+    if (options_.num_partitions == 0) {
+        options_.num_partitions = 1;
+    }
+    // Small budgets get small chunks so a single chunk never blows the limit
+    chunk_size_ = std::min(DEFAULT_BUFFER_SIZE,
+                           std::max(MIN_CHUNK_BYTES, options_.memory_limit_bytes / 8));
+}
+
+ShuffleBuffer::~ShuffleBuffer() {
+    remove_spills();
+}
+
+std::string_view ShuffleBuffer::entry_key(const Entry& entry) {
+    uint32_t key_length;
+    std::memcpy(&key_length, entry.record, sizeof(key_length));
+    return std::string_view(entry.record + RECORD_HEADER_BYTES, key_length);
+}
+
+std::string_view ShuffleBuffer::entry_value(const Entry& entry) {
+    uint32_t lengths[2];
+    std::memcpy(lengths, entry.record, sizeof(lengths));
+    return std::string_view(entry.record + RECORD_HEADER_BYTES + lengths[0], lengths[1]);
+}
+
+char* ShuffleBuffer::allocate(size_t bytes) {
+    if (fits_current_chunk(bytes)) {
+        char* ptr = chunks_[current_chunk_].get() + chunk_offset_;
+        chunk_offset_ += bytes;
+        arena_used_ += bytes;
+        return ptr;
+    }
+
+    // Move on to the next reusable chunk that fits, or grow the arena
+    size_t next = chunks_.empty() ? 0 : current_chunk_ + 1;
+    while (next < chunks_.size() && chunk_sizes_[next] < bytes) {
+        ++next;
+    }
+    if (next == chunks_.size()) {
+        size_t size = std::max(chunk_size_, bytes);
+        chunks_.emplace_back(new char[size]);
+        chunk_sizes_.push_back(size);
+        arena_bytes_ += size;
+        update_charge();
+    }
+
+    current_chunk_ = next;
+    chunk_offset_ = bytes;
+    arena_used_ += bytes;
+    return chunks_[current_chunk_].get();
+}
+
+void ShuffleBuffer::reset_arena() {
+    entries_.clear();
+    fixed_width_keys_ = true;
+    current_chunk_ = 0;
+    chunk_offset_ = 0;
+    arena_used_ = 0;
+}
+
+void ShuffleBuffer::release_arena() {
+    reset_arena();
+    chunks_.clear();
+    chunk_sizes_.clear();
+    arena_bytes_ = 0;
+    std::vector<Entry>().swap(entries_);
+    std::vector<Entry>().swap(radix_scratch_);
+    update_charge();
+}
+
+bool ShuffleBuffer::add(std::string_view key, std::string_view value, bool binary_key) {
+    if (failed_) {
+        return false;
+    }
+
+    size_t bytes = RECORD_HEADER_BYTES + key.size() + value.size();
+    size_t projected = arena_used_ + bytes + (entries_.size() + 1) * index_bytes_per_entry();
+    bool over_limit = projected > options_.memory_limit_bytes;
+
+    // The governor is only consulted when the record starts a new chunk,
+    // and a buffer holding less than a chunk is not worth spilling
+    bool pressure = false;
+    if (!over_limit && !fits_current_chunk(bytes)) {
+        update_charge();
+        pressure = arena_used_ >= chunk_size_ && MemoryGovernor::instance().should_spill();
+    }
+
+    if (!entries_.empty() && (over_limit || pressure)) {
+        if (!spill()) {
+            failed_ = true;
+            return false;
+        }
+        if (pressure) {
+            release_arena();
+        }
+    }
+
+    char* record = allocate(bytes);
+    uint32_t lengths[2] = {static_cast<uint32_t>(key.size()), static_cast<uint32_t>(value.size())};
+    std::memcpy(record, lengths, sizeof(lengths));
+    std::memcpy(record + RECORD_HEADER_BYTES, key.data(), key.size());
+    std::memcpy(record + RECORD_HEADER_BYTES + key.size(), value.data(), value.size());
+
+    entries_.push_back(Entry{key_prefix(key), record, partition_for_key(key, options_.num_partitions),
+                             binary_key});
+    fixed_width_keys_ = fixed_width_keys_ && key.size() == BINARY_KEY_SIZE;
+    record_count_++;
+    return true;
+}
+
+void ShuffleBuffer::sort_entries() {
+    // Binary keys fit the prefix exactly, so (partition, prefix) is the whole
+    // sort key and a radix sort beats comparisons
+    if (fixed_width_keys_ && entries_.size() >= RADIX_SORT_MIN_ENTRIES) {
+        radix_sort_entries();
+        return;
+    }
+
+    std::sort(entries_.begin(), entries_.end(), [](const Entry& a, const Entry& b) {
+        if (a.partition != b.partition) {
+            return a.partition < b.partition;
+        }
+        if (a.key_prefix != b.key_prefix) {
+            return a.key_prefix < b.key_prefix;
+        }
+        return entry_key(a) < entry_key(b);
+    });
+}
+
+void ShuffleBuffer::radix_sort_entries() {
+    // LSD byte passes: 8 over the key prefix, then 4 over the partition
+    constexpr size_t DIGITS = 12;
+    std::vector<std::array<size_t, 256>> counts(DIGITS);
+    for (auto& count : counts) {
+        count.fill(0);
+    }
+
+    auto digit = [](const Entry& entry, size_t pass) -> uint8_t {
+        return pass < 8 ? static_cast<uint8_t>(entry.key_prefix >> (8 * pass))
+                        : static_cast<uint8_t>(entry.partition >> (8 * (pass - 8)));
+    };
+
+    for (const auto& entry : entries_) {
+        for (size_t pass = 0; pass < DIGITS; ++pass) {
+            counts[pass][digit(entry, pass)]++;
+        }
+    }
+
+    radix_scratch_.resize(entries_.size());
+    for (size_t pass = 0; pass < DIGITS; ++pass) {
+        auto& count = counts[pass];
+        // A digit every entry shares (high Morton bits, few partitions) would
+        // only copy the array
+        if (count[digit(entries_[0], pass)] == entries_.size()) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (auto& bucket : count) {
+            size_t bucket_size = bucket;
+            bucket = offset;
+            offset += bucket_size;
+        }
+        for (const auto& entry : entries_) {
+            radix_scratch_[count[digit(entry, pass)]++] = entry;
+        }
+        entries_.swap(radix_scratch_);
+    }
+}
+
+bool ShuffleBuffer::write_run(const std::string& path, KeySketch* sketch) {
+    ScopedStageTimer timer(Stage::SPILL);
+    sort_entries();
+
+    RunWriter writer;
+    if (!writer.open(path, options_.num_partitions, options_.codec)) {
+        Logger::error("Cannot open shuffle run for writing: " + path);
+        return false;
+    }
+    writer.set_key_sketch(sketch);
+
+    if (!combiner_) {
+        for (const auto& entry : entries_) {
+            writer.append(entry.partition, entry_key(entry), entry_value(entry), entry.binary_key);
+        }
+        return close_run(writer);
+    }
+
+    // Entries are sorted, so each key's values are contiguous
+    for (size_t i = 0; i < entries_.size();) {
+        uint32_t partition = entries_[i].partition;
+        std::string_view key = entry_key(entries_[i]);
+
+        group_values_.clear();
+        size_t j = i;
+        while (j < entries_.size() && entries_[j].partition == partition && entry_key(entries_[j]) == key) {
+            group_values_.push_back(entry_value(entries_[j++]));
+        }
+
+        write_group(writer, partition, key, entries_[i].binary_key, group_values_);
+        i = j;
+    }
+    return close_run(writer);
+}
+
+void ShuffleBuffer::write_group(RunWriter& writer, uint32_t partition, std::string_view key,
+                                bool binary_key, const std::vector<std::string_view>& values) {
+    // A single value has nothing to combine with
+    if (!combiner_ || values.size() < 2) {
+        for (const auto& value : values) {
+            writer.append(partition, key, value, binary_key);
+        }
+        return;
+    }
+
+    combiner_(key, binary_key, values, [&](std::string_view combined) {
+        writer.append(partition, key, combined, binary_key);
+    });
+}
+
+bool ShuffleBuffer::spill() {
+    std::string path = options_.spill_prefix + ".spill" + std::to_string(spill_files_.size());
+    if (!write_run(path, nullptr)) {
+        return false;
+    }
+
+    Logger::debug("Spilled " + std::to_string(entries_.size()) + " records to " + path);
+    spill_files_.push_back(path);
+    reset_arena();
+    update_charge();
+    return true;
+}
+
+bool ShuffleBuffer::finish(const std::string& output_path) {
+    if (failed_) {
+        return false;
+    }
+
+    // Everything fit in memory: one sorted run straight to the output
+    if (spill_files_.empty()) {
+        bool ok = write_run(output_path, key_sketch_);
+        release_arena();
+        return ok;
+    }
+
+    if (!entries_.empty() && !spill()) {
+        return false;
+    }
+
+    release_arena();
+    bool ok = merge_runs(spill_files_, output_path);
+    remove_spills();
+    return ok;
+}
+
+bool ShuffleBuffer::merge_runs(const std::vector<std::string>& runs, const std::string& output_path) {
+    RunMerger merger;
+    for (const auto& run : runs) {
+        auto reader = std::make_unique<RunReader>();
+        if (!reader->open(run)) {
+            Logger::error("Cannot open shuffle run: " + run);
+            return false;
+        }
+        merger.add_source(std::move(reader));
+    }
+
+    RunWriter writer;
+    if (!writer.open(output_path, options_.num_partitions, options_.codec)) {
+        Logger::error("Cannot open shuffle run for writing: " + output_path);
+        return false;
+    }
+    writer.set_key_sketch(key_sketch_);
+
+    ShuffleRecord record;
+    if (!combiner_) {
+        while (merger.next(record)) {
+            writer.append(record.partition, record.key, record.value, record.binary_key);
+        }
+        bool closed = close_run(writer);
+        if (merger.failed()) {
+            Logger::error("Corrupt shuffle run while merging into " + output_path);
+            return false;
+        }
+        return closed;
+    }
+
+    // Combine again across runs; merged views only live until the next
+    // record, so the current group is copied out (at most one value per run
+    // once the combiner ran on it)
+    std::string group_key;
+    std::vector<std::string> group_storage;
+    size_t group_size = 0;
+    uint32_t group_partition = 0;
+    bool group_binary_key = false;
+    bool has_group = false;
+
+    auto flush_group = [&]() {
+        group_values_.clear();
+        for (size_t i = 0; i < group_size; ++i) {
+            group_values_.push_back(group_storage[i]);
+        }
+        write_group(writer, group_partition, group_key, group_binary_key, group_values_);
+        group_size = 0;
+    };
+
+    while (merger.next(record)) {
+        if (has_group && (record.partition != group_partition || record.key != group_key)) {
+            flush_group();
+        }
+        if (group_size == 0) {
+            group_partition = record.partition;
+            group_key.assign(record.key.data(), record.key.size());
+            group_binary_key = record.binary_key;
+            has_group = true;
+        }
+        if (group_size == group_storage.size()) {
+            group_storage.emplace_back();
+        }
+        group_storage[group_size++].assign(record.value.data(), record.value.size());
+    }
+    if (group_size > 0 && !merger.failed()) {
+        flush_group();
+    }
+
+    bool closed = close_run(writer);
+    if (merger.failed()) {
+        Logger::error("Corrupt shuffle run while merging into " + output_path);
+        return false;
+    }
+    return closed;
+}
+
+void ShuffleBuffer::remove_spills() {
+    for (const auto& spill_file : spill_files_) {
+        std::remove(spill_file.c_str());
+        std::remove(RunIndex::path_for(spill_file).c_str());
+    }
+    spill_files_.clear();
+}
+
+} // namespace daf
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "shuffle_run.h"
+#include "../common/binary_key.h"
+#include "../common/memory_governor.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+namespace daf {
+
+// Map-side shuffle buffer
+//
+// Emitted records are appended to a chunked arena with a compact index entry
+// each. When the arena reaches its memory budget the index is sorted by
+// (partition, key) and written out as a spill run; finish() merges all runs
+// into the task's final sorted, partitioned map output.
+//
+// The arena and index are charged to MemoryPool::SHUFFLE. When a record
+// needs a new chunk while the worker as a whole is past the governor's soft
+// limit, the buffer spills early and gives its chunks back, however far it
+// is from its own budget.
+class ShuffleBuffer {
+public:
+    // Combines all values of one key into (ideally) a single partial aggregate
+    using CombineEmitter = std::function<void(std::string_view value)>;
+    using Combiner = std::function<void(std::string_view key, bool binary_key,
+                                        const std::vector<std::string_view>& values,
+                                        const CombineEmitter& emit)>;
+
+    struct Options {
+        uint32_t num_partitions = 1;
+        size_t memory_limit_bytes = (MAX_MEMORY_MB / 2) * 1024 * 1024;
+        std::string spill_prefix;   // Spill runs are written as <prefix>.spill<N>
+        CompressionCodec codec = CompressionCodec::NONE;   // Of spills and the merged output
+    };
+
+    explicit ShuffleBuffer(const Options& options);
+    ~ShuffleBuffer();
+
+    ShuffleBuffer(const ShuffleBuffer&) = delete;
+    ShuffleBuffer& operator=(const ShuffleBuffer&) = delete;
+
+    // binary_key marks keys from emit_binary(), which reducers decode back
+    bool add(std::string_view key, std::string_view value, bool binary_key = false);
+
+    // Optional combiner, run on each key group before it is spilled or written
+    void set_combiner(Combiner combiner) { combiner_ = std::move(combiner); }
+
+    // Optional sketch of the key groups of the final output (not of spills)
+    void set_key_sketch(KeySketch* sketch) { key_sketch_ = sketch; }
+
+    // Sort, spill and merge everything into output_path (+ index sidecar)
+    bool finish(const std::string& output_path);
+
+    // Merges finished runs (e.g. from parallel sub-splits) into output_path,
+    // re-running the combiner across them. The runs are left in place.
+    bool merge_runs(const std::vector<std::string>& runs, const std::string& output_path);
+
+    // Bytes currently held by the arena and the index
+    size_t memory_usage() const {
+        return arena_bytes_ + (entries_.capacity() + radix_scratch_.capacity()) * sizeof(Entry);
+    }
+    size_t spill_count() const { return spill_files_.size(); }
+    uint64_t record_count() const { return record_count_; }
+
+private:
+    struct Entry {
+        uint64_t key_prefix;   // First 8 key bytes, big-endian, for cheap comparisons
+        const char* record;    // [u32 key_len][u32 value_len][key][value] in the arena
+        uint32_t partition;
+        bool binary_key;       // Fits the padding, so the index does not grow
+    };
+
+    // Radix sorting needs a scratch copy of the index
+    size_t index_bytes_per_entry() const { return sizeof(Entry) * (fixed_width_keys_ ? 2 : 1); }
+
+    bool fits_current_chunk(size_t bytes) const {
+        return current_chunk_ < chunks_.size() && chunk_offset_ + bytes <= chunk_sizes_[current_chunk_];
+    }
+    char* allocate(size_t bytes);
+    void sort_entries();
+    void radix_sort_entries();
+    bool write_run(const std::string& path, KeySketch* sketch);
+    bool spill();
+    void write_group(RunWriter& writer, uint32_t partition, std::string_view key, bool binary_key,
+                     const std::vector<std::string_view>& values);
+    void reset_arena();
+    void release_arena();   // Also frees the chunks and the index
+    void update_charge() { charge_.set(memory_usage()); }
+    void remove_spills();
+
+    static std::string_view entry_key(const Entry& entry);
+    static std::string_view entry_value(const Entry& entry);
+
+    Options options_;
+    Combiner combiner_;
+    KeySketch* key_sketch_ = nullptr;
+
+    // Arena: fixed-size chunks reused across spills
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    std::vector<size_t> chunk_sizes_;
+    size_t current_chunk_ = 0;
+    size_t chunk_offset_ = 0;
+    size_t chunk_size_ = DEFAULT_BUFFER_SIZE;
+    size_t arena_bytes_ = 0;   // Allocated
+    size_t arena_used_ = 0;    // Filled since the last spill
+
+    std::vector<Entry> entries_;
+    std::vector<Entry> radix_scratch_;
+    bool fixed_width_keys_ = true;   // Every key in the current run is BINARY_KEY_SIZE bytes
+    std::vector<std::string_view> group_values_;
+    std::vector<std::string> spill_files_;
+    uint64_t record_count_ = 0;
+    bool failed_ = false;
+    MemoryCharge charge_{MemoryPool::SHUFFLE};
+};
+
+} // namespace daf
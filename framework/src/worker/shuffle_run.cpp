@@ -0,0 +1,472 @@
+#include "shuffle_run.h"
+#include "../common/task_cache.h"
+#include <algorithm>
+#include <cstring>
+
+namespace daf {
+
+namespace {
+
+struct RunIndexHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_partitions;
+    uint32_t flags;
+};
+
+struct RecordHeader {
+    uint32_t key_length;
+    uint32_t value_length;
+};
+
+struct BlockHeader {
+    uint32_t raw_length;
+    uint32_t stored_length;
+};
+
+} // namespace
+
+// RunIndex implementation
+bool RunIndex::load(const std::string& index_path) {
+    std::ifstream file(index_path, std::ios::binary);
+    RunIndexHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != RUN_INDEX_MAGIC || header.version == 0 || header.version > RUN_INDEX_VERSION) {
+        return false;
+    }
+
+    // Version 1 runs (task cache entries) never set RECORD_BINARY_KEY and
+    // read back as text keys; flags carries the codec of compressed runs
+    codec = static_cast<CompressionCodec>(header.flags);
+    if (!compression_available(codec)) {
+        return false;
+    }
+    segments.resize(header.num_partitions);
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(segments.data()),
+                                       segments.size() * sizeof(RunSegment)));
+}
+
+bool RunIndex::save(const std::string& index_path) const {
+    std::ofstream file(index_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    RunIndexHeader header{RUN_INDEX_MAGIC, RUN_INDEX_VERSION,
+                          static_cast<uint32_t>(segments.size()), static_cast<uint32_t>(codec)};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(segments.data()), segments.size() * sizeof(RunSegment));
+    return file.good();
+}
+
+uint32_t partition_for_key(std::string_view key, uint32_t num_partitions) {
+    if (num_partitions <= 1) {
+        return 0;
+    }
+
+    // FNV-1a: stable across processes and platforms, unlike std::hash
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return static_cast<uint32_t>(hash % num_partitions);
+}
+
+// RunWriter implementation
+RunWriter::~RunWriter() {
+    close();
+}
+
+bool RunWriter::open(const std::string& path, uint32_t num_partitions, CompressionCodec codec) {
+    close();
+
+    // The buffer has to be installed before the file is opened
+    file_buffer_.resize(DEFAULT_BUFFER_SIZE);
+    file_.rdbuf()->pubsetbuf(file_buffer_.data(), static_cast<std::streamsize>(file_buffer_.size()));
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) {
+        return false;
+    }
+
+    path_ = path;
+    offset_ = 0;
+    raw_bytes_ = 0;
+    index_.segments.assign(std::max<uint32_t>(num_partitions, 1), RunSegment{});
+    index_.codec = compression_available(codec) ? codec : CompressionCodec::NONE;
+    block_.clear();
+    if (index_.codec != CompressionCodec::NONE) {
+        block_.reserve(RUN_BLOCK_SIZE);
+    }
+    return true;
+}
+
+bool RunWriter::append(uint32_t partition, std::string_view key, std::string_view value,
+                       bool binary_key) {
+    if (!file_.is_open() || partition >= index_.segments.size() || key.size() >= RECORD_BINARY_KEY) {
+        return false;
+    }
+
+    if (key_sketch_) {
+        // Keys only repeat within a partition, so comparing keys is enough
+        if (group_records_ > 0 && key != group_key_) {
+            key_sketch_->add(group_key_, group_records_);
+            group_records_ = 0;
+        }
+        if (group_records_++ == 0) {
+            group_key_.assign(key.data(), key.size());
+        }
+    }
+
+    RecordHeader header{static_cast<uint32_t>(key.size()) | (binary_key ? RECORD_BINARY_KEY : 0),
+                        static_cast<uint32_t>(value.size())};
+    uint64_t bytes = sizeof(header) + key.size() + value.size();
+    raw_bytes_ += bytes;
+
+    RunSegment& segment = index_.segments[partition];
+    if (index_.codec == CompressionCodec::NONE) {
+        if (segment.records++ == 0) {
+            segment.offset = offset_;
+        }
+        file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file_.write(key.data(), static_cast<std::streamsize>(key.size()));
+        file_.write(value.data(), static_cast<std::streamsize>(value.size()));
+        offset_ += bytes;
+        segment.length += bytes;
+        return true;
+    }
+
+    // Blocks never span partitions, so every segment starts on a block
+    if (!block_.empty() && partition != block_partition_ && !flush_block()) {
+        return false;
+    }
+    if (segment.records++ == 0) {
+        segment.offset = offset_;
+    }
+    block_partition_ = partition;
+    const char* header_bytes = reinterpret_cast<const char*>(&header);
+    block_.insert(block_.end(), header_bytes, header_bytes + sizeof(header));
+    block_.insert(block_.end(), key.begin(), key.end());
+    block_.insert(block_.end(), value.begin(), value.end());
+    return block_.size() < RUN_BLOCK_SIZE || flush_block();
+}
+
+bool RunWriter::flush_block() {
+    if (block_.empty()) {
+        return true;
+    }
+
+    const char* stored = block_.data();
+    size_t stored_length = block_.size();
+    if (compress_block(index_.codec, block_.data(), block_.size(), compressed_)) {
+        stored = compressed_.data();
+        stored_length = compressed_.size();
+    }
+
+    BlockHeader header{static_cast<uint32_t>(block_.size()), static_cast<uint32_t>(stored_length)};
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file_.write(stored, static_cast<std::streamsize>(stored_length));
+
+    uint64_t bytes = sizeof(header) + stored_length;
+    offset_ += bytes;
+    index_.segments[block_partition_].length += bytes;
+    block_.clear();
+    return file_.good();
+}
+
+bool RunWriter::close() {
+    if (!file_.is_open()) {
+        return true;
+    }
+    bool flushed = flush_block();
+    if (key_sketch_ && group_records_ > 0) {
+        key_sketch_->add(group_key_, group_records_);
+    }
+    group_records_ = 0;
+
+    // Empty segments point at the end of the previous one
+    uint64_t end = 0;
+    for (auto& segment : index_.segments) {
+        if (segment.records == 0) {
+            segment.offset = end;
+        }
+        end = segment.offset + segment.length;
+    }
+
+    file_.close();
+    bool ok = flushed && !file_.fail() && index_.save(RunIndex::path_for(path_));
+    file_.clear();
+    return ok;
+}
+
+// RunReader implementation
+bool RunReader::open(const std::string& path) {
+    return open_segments(path, 0, UINT32_MAX);
+}
+
+bool RunReader::open(const std::string& path, uint32_t partition) {
+    return open_segments(path, partition, partition);
+}
+
+bool RunReader::open_segments(const std::string& path, uint32_t first, uint32_t last) {
+    close();
+
+    if (!index_.load(RunIndex::path_for(path)) || !file_.open(path, MappedFile::Access::SEQUENTIAL)) {
+        close();
+        return false;
+    }
+
+    uint32_t partitions = static_cast<uint32_t>(index_.segments.size());
+    if (partitions == 0 || first >= partitions) {
+        // Nothing to read, but not an error: the run simply has no such partition
+        last_partition_ = 0;
+        partition_ = 1;
+        return true;
+    }
+
+    readahead_.reset();
+    partition_ = first;
+    last_partition_ = std::min(last, partitions - 1);
+    offset_ = index_.segments[partition_].offset;
+    segment_end_ = offset_ + index_.segments[partition_].length;
+    segment_records_ = 0;
+    block_size_ = 0;
+    block_pos_ = 0;
+    return segment_end_ <= file_.size();
+}
+
+void RunReader::close() {
+    file_.close();
+    index_.segments.clear();
+    partition_ = 0;
+    last_partition_ = 0;
+    offset_ = 0;
+    segment_end_ = 0;
+    segment_records_ = 0;
+    failed_ = false;
+    block_ = nullptr;
+    block_size_ = 0;
+    block_pos_ = 0;
+}
+
+bool RunReader::load_block() {
+    readahead_.advance(file_, offset_);
+
+    if (index_.codec == CompressionCodec::NONE) {
+        // The whole segment is one block straight out of the mapping
+        block_ = file_.data() + offset_;
+        block_size_ = segment_end_ - offset_;
+        block_file_offset_ = offset_;
+        block_pos_ = 0;
+        offset_ = segment_end_;
+        return true;
+    }
+
+    BlockHeader header;
+    if (offset_ + sizeof(header) > segment_end_) {
+        return false;
+    }
+    std::memcpy(&header, file_.data() + offset_, sizeof(header));
+    uint64_t block_end = offset_ + sizeof(header) + header.stored_length;
+    if (block_end > segment_end_ || header.stored_length > header.raw_length) {
+        return false;
+    }
+
+    const char* stored = file_.data() + offset_ + sizeof(header);
+    if (header.stored_length == header.raw_length) {
+        block_ = stored;
+    } else {
+        block_buffer_.resize(header.raw_length);
+        if (!decompress_block(index_.codec, stored, header.stored_length,
+                              block_buffer_.data(), header.raw_length)) {
+            return false;
+        }
+        block_ = block_buffer_.data();
+    }
+    block_size_ = header.raw_length;
+    block_pos_ = 0;
+    offset_ = block_end;
+    return true;
+}
+
+bool RunReader::next(ShuffleRecord& record) {
+    if (failed_) {
+        return false;
+    }
+
+    while (partition_ <= last_partition_) {
+        if (block_pos_ + sizeof(RecordHeader) <= block_size_) {
+            if (index_.codec == CompressionCodec::NONE) {
+                readahead_.advance(file_, block_file_offset_ + block_pos_);
+            }
+
+            RecordHeader header;
+            std::memcpy(&header, block_ + block_pos_, sizeof(header));
+            uint32_t key_length = header.key_length & ~RECORD_BINARY_KEY;
+
+            uint64_t record_end = block_pos_ + sizeof(header) +
+                                  static_cast<uint64_t>(key_length) + header.value_length;
+            if (record_end > block_size_) {
+                return fail(); // Truncated run
+            }
+
+            const char* key = block_ + block_pos_ + sizeof(header);
+            record.partition = partition_;
+            record.key = std::string_view(key, key_length);
+            record.value = std::string_view(key + key_length, header.value_length);
+            record.binary_key = (header.key_length & RECORD_BINARY_KEY) != 0;
+            block_pos_ = static_cast<size_t>(record_end);
+            segment_records_++;
+            return true;
+        }
+        if (block_pos_ != block_size_) {
+            return fail(); // Truncated run
+        }
+
+        // Block used up, load the next one of the segment
+        if (offset_ < segment_end_) {
+            if (!load_block()) {
+                return fail(); // Bad block header or block that does not decompress
+            }
+            continue;
+        }
+
+        // Segment exhausted: it must have held what the index promised
+        if (segment_records_ != index_.segments[partition_].records) {
+            return fail();
+        }
+
+        // Move on to the next partition
+        if (++partition_ > last_partition_) {
+            break;
+        }
+        offset_ = index_.segments[partition_].offset;
+        segment_end_ = offset_ + index_.segments[partition_].length;
+        segment_records_ = 0;
+        if (segment_end_ > file_.size()) {
+            return fail();
+        }
+    }
+
+    return false;
+}
+
+bool run_partition_digests(const std::string& path, std::vector<std::string>& digests) {
+    RunIndex index;
+    if (!index.load(RunIndex::path_for(path))) {
+        return false;
+    }
+
+    digests.clear();
+    for (uint32_t partition = 0; partition < index.segments.size(); ++partition) {
+        RunReader reader;
+        if (!reader.open(path, partition)) {
+            return false;
+        }
+        ContentHash hash;
+        ShuffleRecord record;
+        while (reader.next(record)) {
+            hash.update_field(record.key);
+            hash.update_field(record.value);
+            hash.update_field(record.binary_key ? "b" : "t");
+        }
+        if (reader.failed()) {
+            return false;
+        }
+        digests.push_back(hash.hex());
+    }
+    return true;
+}
+
+// RunMerger implementation
+void RunMerger::add_source(std::unique_ptr<RunReader> reader) {
+    sources_.push_back(std::move(reader));
+}
+
+bool RunMerger::after(const HeapEntry& a, const HeapEntry& b) {
+    // std::push_heap builds a max-heap, so "after" puts the smallest record on top
+    if (shuffle_less(a.record.partition, a.record.key, b.record.partition, b.record.key)) {
+        return false;
+    }
+    if (shuffle_less(b.record.partition, b.record.key, a.record.partition, a.record.key)) {
+        return true;
+    }
+    return a.source > b.source;
+}
+
+bool RunMerger::next(ShuffleRecord& record) {
+    if (!started_) {
+        started_ = true;
+        for (size_t i = 0; i < sources_.size(); ++i) {
+            HeapEntry entry{ShuffleRecord{}, i};
+            if (sources_[i]->next(entry.record)) {
+                heap_.push_back(entry);
+            } else if (sources_[i]->failed()) {
+                failed_ = true;
+            }
+        }
+        std::make_heap(heap_.begin(), heap_.end(), after);
+    } else if (pending_source_ != SIZE_MAX) {
+        // Advance the source we returned from last time only now, so the
+        // previously returned views stayed valid until this call
+        HeapEntry entry{ShuffleRecord{}, pending_source_};
+        if (sources_[pending_source_]->next(entry.record)) {
+            heap_.push_back(entry);
+            std::push_heap(heap_.begin(), heap_.end(), after);
+        } else if (sources_[pending_source_]->failed()) {
+            failed_ = true;
+        }
+    }
+    pending_source_ = SIZE_MAX;
+
+    if (failed_ || heap_.empty()) {
+        return false;
+    }
+
+    std::pop_heap(heap_.begin(), heap_.end(), after);
+    record = heap_.back().record;
+    pending_source_ = heap_.back().source;
+    heap_.pop_back();
+    return true;
+}
+
+// KeyGroupReader implementation
+bool KeyGroupReader::fill() {
+    // The merger's views die on its next call, so only advance once the
+    // caller is done with the pending record
+    if (!has_pending_ || consumed_) {
+        has_pending_ = merger_.next(pending_);
+        consumed_ = false;
+    }
+    return has_pending_;
+}
+
+bool KeyGroupReader::has_more_values() {
+    return in_group_ && fill() && pending_.partition == partition_ && pending_.key == key_;
+}
+
+bool KeyGroupReader::next_value(std::string_view& value) {
+    if (!has_more_values()) {
+        return false;
+    }
+    value = pending_.value;
+    consumed_ = true;
+    return true;
+}
+
+bool KeyGroupReader::next_group() {
+    while (has_more_values()) {
+        consumed_ = true;
+    }
+
+    in_group_ = fill();
+    if (!in_group_) {
+        return false;
+    }
+    key_.assign(pending_.key.data(), pending_.key.size());
+    partition_ = pending_.partition;
+    binary_key_ = pending_.binary_key;
+    return true;
+}
+
+} // namespace daf
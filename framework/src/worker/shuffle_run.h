@@ -0,0 +1,219 @@
+#pragma once
+
+#include "../common/daf_types.h"
+#include "../common/mapped_file.h"
+#include "../common/compression.h"
+#include "../common/key_sketch.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <cstdint>
+
+namespace daf {
+
+// Sorted run files
+//
+// Map output, spills and fetched shuffle segments all share one layout: a
+// data file of records sorted by (partition, key) and a "<path>.index"
+// sidecar describing where each partition's segment starts. A record is
+//   [u32 key_len][u32 value_len][key bytes][value bytes]
+// so readers can walk a segment straight out of a memory mapping. The top
+// bit of key_len marks keys emitted with emit_binary().
+//
+// A compressed run (codec recorded in the index) stores each segment as
+// blocks of whole records, [u32 raw_len][u32 stored_len][stored bytes];
+// blocks that did not shrink are stored raw (stored_len == raw_len).
+// Segment offsets and lengths count stored bytes.
+constexpr uint32_t RUN_INDEX_MAGIC = 0x49464144; // "DAFI"
+constexpr uint32_t RUN_INDEX_VERSION = 2;        // 2: key_len carries RECORD_BINARY_KEY
+constexpr uint32_t RECORD_BINARY_KEY = 0x80000000u;
+constexpr size_t RUN_BLOCK_SIZE = 64 * 1024;     // Raw bytes per compressed block
+
+struct RunSegment {
+    uint64_t offset = 0;
+    uint64_t length = 0;
+    uint64_t records = 0;
+};
+
+struct RunIndex {
+    std::vector<RunSegment> segments;
+    CompressionCodec codec = CompressionCodec::NONE;
+
+    bool load(const std::string& index_path);
+    bool save(const std::string& index_path) const;
+
+    static std::string path_for(const std::string& run_path) { return run_path + ".index"; }
+};
+
+struct ShuffleRecord {
+    uint32_t partition = 0;
+    std::string_view key;
+    std::string_view value;
+    bool binary_key = false;   // Emitted with emit_binary()
+};
+
+// Stable partitioner shared by every map task of a job
+uint32_t partition_for_key(std::string_view key, uint32_t num_partitions);
+
+// Writes records (already in (partition, key) order) plus the index sidecar
+class RunWriter {
+public:
+    RunWriter() = default;
+    ~RunWriter();
+
+    RunWriter(const RunWriter&) = delete;
+    RunWriter& operator=(const RunWriter&) = delete;
+
+    // Codecs that are not compiled in write an uncompressed run
+    bool open(const std::string& path, uint32_t num_partitions,
+              CompressionCodec codec = CompressionCodec::NONE);
+    bool append(uint32_t partition, std::string_view key, std::string_view value,
+                bool binary_key = false);
+    bool close();
+
+    // Adds every key group written from now on, with its record count, to
+    // sketch (the caller keeps it alive until close)
+    void set_key_sketch(KeySketch* sketch) { key_sketch_ = sketch; }
+
+    const RunIndex& index() const { return index_; }
+    uint64_t raw_bytes() const { return raw_bytes_; }
+    uint64_t bytes_written() const { return offset_; }
+
+private:
+    bool flush_block();
+
+    std::string path_;
+    std::ofstream file_;
+    std::vector<char> file_buffer_;
+    RunIndex index_;
+    uint64_t offset_ = 0;
+    uint64_t raw_bytes_ = 0;
+
+    // Records of the block being filled, all from block_partition_
+    std::vector<char> block_;
+    std::vector<char> compressed_;
+    uint32_t block_partition_ = 0;
+
+    // Key group being counted for key_sketch_
+    KeySketch* key_sketch_ = nullptr;
+    std::string group_key_;
+    uint64_t group_records_ = 0;
+};
+
+// Walks one partition segment, or the whole run, of a run file in place
+class RunReader {
+public:
+    // Read every partition of the run in order
+    bool open(const std::string& path);
+    // Read a single partition segment
+    bool open(const std::string& path, uint32_t partition);
+    void close();
+
+    // Views stay valid until the next call (until the reader is closed
+    // for uncompressed runs)
+    bool next(ShuffleRecord& record);
+
+    // next() stopped on a corrupt run (truncated record, segment past the
+    // end of the file, record count not matching the index, compressed
+    // block out of bounds or not decompressing) rather than at the end of
+    // the data
+    bool failed() const { return failed_; }
+
+private:
+    bool open_segments(const std::string& path, uint32_t first, uint32_t last);
+    bool load_block();
+    bool fail() { failed_ = true; return false; }
+
+    MappedFile file_;
+    // Small window: a reduce task merges one reader per map output
+    MappedReadahead readahead_{DEFAULT_BUFFER_SIZE / 4};
+    RunIndex index_;
+    uint32_t partition_ = 0;
+    uint32_t last_partition_ = 0;
+    uint64_t offset_ = 0;
+    uint64_t segment_end_ = 0;
+    uint64_t segment_records_ = 0;   // Read so far from the current segment
+    bool failed_ = false;
+
+    // Records are parsed out of the current block: the mapped segment
+    // itself when uncompressed, else the decompressed (or stored raw) block
+    const char* block_ = nullptr;
+    size_t block_size_ = 0;
+    size_t block_pos_ = 0;
+    uint64_t block_file_offset_ = 0;
+    std::vector<char> block_buffer_;
+};
+
+// Digest of the records of every partition of a run, whatever its codec:
+// what the task cache keys reducers on (see task_cache.h)
+bool run_partition_digests(const std::string& path, std::vector<std::string>& digests);
+
+// K-way merge of sorted runs by (partition, key). Records with equal keys
+// come out in source order. Returned views stay valid until the next call.
+class RunMerger {
+public:
+    void add_source(std::unique_ptr<RunReader> reader);
+    bool next(ShuffleRecord& record);
+    size_t source_count() const { return sources_.size(); }
+
+    // A source failed; next() returns false from then on, so callers must
+    // check this before treating the end of the merge as success
+    bool failed() const { return failed_; }
+
+private:
+    struct HeapEntry {
+        ShuffleRecord record;
+        size_t source;
+    };
+
+    static bool after(const HeapEntry& a, const HeapEntry& b);
+
+    std::vector<std::unique_ptr<RunReader>> sources_;
+    std::vector<HeapEntry> heap_;
+    bool started_ = false;
+    bool failed_ = false;
+    size_t pending_source_ = SIZE_MAX;
+};
+
+// Splits a merged record stream into key groups. Values are pulled from the
+// merger one at a time, so a group never has to fit in memory.
+class KeyGroupReader {
+public:
+    explicit KeyGroupReader(RunMerger& merger) : merger_(merger) {}
+
+    // Moves to the next key, skipping whatever is left of the current group
+    bool next_group();
+    const std::string& key() const { return key_; }
+    uint32_t partition() const { return partition_; }
+    // Type of the group's first record; a key is normally emitted one way
+    bool binary_key() const { return binary_key_; }
+
+    // Values of the current group; a view stays valid until the next call
+    bool next_value(std::string_view& value);
+    bool has_more_values();
+
+private:
+    bool fill();
+
+    RunMerger& merger_;
+    ShuffleRecord pending_;
+    bool has_pending_ = false;
+    bool consumed_ = false;
+    bool in_group_ = false;
+    std::string key_;
+    uint32_t partition_ = 0;
+    bool binary_key_ = false;
+};
+
+// Lexicographic (partition, key) ordering used by both sort and merge
+inline bool shuffle_less(uint32_t partition_a, std::string_view key_a,
+                         uint32_t partition_b, std::string_view key_b) {
+    if (partition_a != partition_b) {
+        return partition_a < partition_b;
+    }
+    return key_a < key_b;
+}
+
+} // namespace daf
@@ -0,0 +1,570 @@
+#include "shuffle_service.h"
+#include "../common/daf_utils.h"
+#include "../common/metrics.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace daf {
+
+namespace {
+
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;    // A reducer hanging up must not kill the worker
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+
+uint32_t codec_bit(CompressionCodec codec) {
+    return 1u << static_cast<uint32_t>(codec);
+}
+
+// Zstd is only asked for by jobs that want the ratio
+CompressionCodec pick_wire_codec(uint32_t accepted_codecs) {
+    for (CompressionCodec codec : {CompressionCodec::ZSTD, CompressionCodec::LZ4}) {
+        if ((accepted_codecs & codec_bit(codec)) && compression_available(codec)) {
+            return codec;
+        }
+    }
+    return CompressionCodec::NONE;
+}
+
+bool send_all(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t sent = ::send(fd, bytes, size, SEND_FLAGS);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        bytes += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool recv_all(int fd, void* data, size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t received = ::recv(fd, bytes, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        bytes += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+// A stalled peer fails the transfer instead of pinning a thread
+void set_socket_options(int fd) {
+    timeval timeout{};
+    timeout.tv_sec = SHUFFLE_IO_TIMEOUT_SECONDS;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    int no_delay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+}
+
+int connect_to(const std::string& host, int port, std::string& error) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    int status = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses);
+    if (status != 0) {
+        error = "cannot resolve " + host + ": " + gai_strerror(status);
+        return -1;
+    }
+
+    int fd = -1;
+    for (addrinfo* address = addresses; address; address = address->ai_next) {
+        fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        set_socket_options(fd);
+        if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+            break;
+        }
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addresses);
+
+    if (fd < 0) {
+        error = "cannot connect to " + host + ":" + std::to_string(port) + ": " + std::strerror(errno);
+    }
+    return fd;
+}
+
+void remove_run(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove(RunIndex::path_for(path).c_str());
+}
+
+} // namespace
+
+// ShuffleServer implementation
+ShuffleServer::~ShuffleServer() {
+    stop();
+}
+
+bool ShuffleServer::start(int port, size_t threads) {
+    if (running_.load()) {
+        return true;
+    }
+
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listen_fd_, SOMAXCONN) != 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    running_.store(true);
+    for (size_t i = 0; i < std::max<size_t>(1, threads); ++i) {
+        handlers_.emplace_back(&ShuffleServer::handler_loop, this);
+    }
+    accept_thread_ = std::thread(&ShuffleServer::accept_loop, this);
+    Logger::info("Shuffle server listening on port " + std::to_string(port));
+    return true;
+}
+
+void ShuffleServer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(connection_mutex_);
+        if (!running_.load()) {
+            return;
+        }
+        running_.store(false);
+    }
+    connection_ready_.notify_all();
+
+    if (accept_thread_.joinable()) {
+        accept_thread_.join();
+    }
+    for (auto& handler : handlers_) {
+        handler.join();
+    }
+    handlers_.clear();
+
+    for (int fd : connections_) {
+        ::close(fd);
+    }
+    connections_.clear();
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+}
+
+void ShuffleServer::publish(const std::string& run_path) {
+    std::lock_guard<std::mutex> lock(published_mutex_);
+    published_.insert(run_path);
+}
+
+bool ShuffleServer::is_published(const std::string& run_path) {
+    std::lock_guard<std::mutex> lock(published_mutex_);
+    return published_.count(run_path) > 0;
+}
+
+void ShuffleServer::accept_loop() {
+    while (running_.load()) {
+        // The poll timeout bounds how long stop() waits for this thread
+        pollfd listener{listen_fd_, POLLIN, 0};
+        if (::poll(&listener, 1, 200) <= 0) {
+            continue;
+        }
+        int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+        set_socket_options(fd);
+
+        {
+            std::lock_guard<std::mutex> lock(connection_mutex_);
+            connections_.push_back(fd);
+        }
+        connection_ready_.notify_one();
+    }
+}
+
+void ShuffleServer::handler_loop() {
+    while (true) {
+        int fd;
+        {
+            std::unique_lock<std::mutex> lock(connection_mutex_);
+            connection_ready_.wait(lock, [this]() { return !running_.load() || !connections_.empty(); });
+            if (!running_.load()) {
+                return;
+            }
+            fd = connections_.front();
+            connections_.pop_front();
+        }
+        serve(fd);
+        ::close(fd);
+    }
+}
+
+void ShuffleServer::serve(int fd) {
+    ShuffleRequestHeader request{};
+    if (!recv_all(fd, &request, sizeof(request))) {
+        return;
+    }
+
+    ShuffleResponseHeader response{SHUFFLE_MAGIC, static_cast<uint32_t>(ShuffleStatus::OK), 0, 0, 0, 0};
+    auto reply = [&](ShuffleStatus status) {
+        response.status = static_cast<uint32_t>(status);
+        send_all(fd, &response, sizeof(response));
+    };
+
+    if (request.magic != SHUFFLE_MAGIC || request.version != SHUFFLE_PROTOCOL_VERSION ||
+        request.path_length == 0 || request.path_length > SHUFFLE_MAX_PATH) {
+        reply(ShuffleStatus::BAD_REQUEST);
+        return;
+    }
+    std::string path(request.path_length, '\0');
+    if (!recv_all(fd, &path[0], path.size())) {
+        return;
+    }
+
+    RunIndex index;
+    if (!is_published(path) || !index.load(RunIndex::path_for(path))) {
+        reply(ShuffleStatus::NOT_FOUND);
+        return;
+    }
+    if (request.partition >= index.segments.size()) {
+        reply(ShuffleStatus::NO_PARTITION);
+        return;
+    }
+    const RunSegment& segment = index.segments[request.partition];
+
+    std::ifstream run(path, std::ios::binary);
+    if (!run.seekg(static_cast<std::streamoff>(segment.offset))) {
+        reply(ShuffleStatus::IO_ERROR);
+        return;
+    }
+
+    response.run_codec = static_cast<uint32_t>(index.codec);
+    response.records = segment.records;
+    response.length = segment.length;
+    if (!send_all(fd, &response, sizeof(response))) {
+        return;
+    }
+
+    // Blocks that are already compressed are not compressed twice
+    CompressionCodec wire_codec = index.codec == CompressionCodec::NONE
+                                  ? pick_wire_codec(request.accepted_codecs) : CompressionCodec::NONE;
+    std::vector<char> chunk(SHUFFLE_CHUNK_SIZE);
+    std::vector<char> compressed;
+    uint64_t remaining = segment.length;
+    while (remaining > 0) {
+        size_t size = static_cast<size_t>(std::min<uint64_t>(remaining, chunk.size()));
+        if (!run.read(chunk.data(), static_cast<std::streamsize>(size))) {
+            // Already streaming; the client sees the short transfer
+            Logger::error("Shuffle server cannot read run: " + path);
+            return;
+        }
+
+        const char* payload = chunk.data();
+        ShuffleChunkHeader header{static_cast<uint32_t>(CompressionCodec::NONE),
+                                  static_cast<uint32_t>(size), static_cast<uint32_t>(size)};
+        if (compress_block(wire_codec, chunk.data(), size, compressed)) {
+            payload = compressed.data();
+            header.codec = static_cast<uint32_t>(wire_codec);
+            header.wire_length = static_cast<uint32_t>(compressed.size());
+        }
+        if (!send_all(fd, &header, sizeof(header)) || !send_all(fd, payload, header.wire_length)) {
+            return;
+        }
+        remaining -= size;
+        bytes_served_ += sizeof(header) + header.wire_length;
+    }
+}
+
+bool fetch_shuffle_segment(const ShuffleLocation& location, uint32_t partition,
+                           const std::string& local_path, std::string& error,
+                           CompressionCodec wire_codec) {
+    int fd = connect_to(location.host, location.port, error);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct SocketCloser {
+        int fd;
+        ~SocketCloser() { ::close(fd); }
+    } closer{fd};
+
+    uint32_t accepted = codec_bit(CompressionCodec::NONE);
+    if (compression_available(wire_codec)) {
+        accepted |= codec_bit(wire_codec);
+    }
+    ShuffleRequestHeader request{SHUFFLE_MAGIC, SHUFFLE_PROTOCOL_VERSION, partition, accepted,
+                                 static_cast<uint32_t>(location.path.size())};
+    ShuffleResponseHeader response{};
+    if (!send_all(fd, &request, sizeof(request)) || !send_all(fd, location.path.data(), location.path.size()) ||
+        !recv_all(fd, &response, sizeof(response))) {
+        error = "connection to " + location.host + " lost";
+        return false;
+    }
+    if (response.magic != SHUFFLE_MAGIC || response.status != static_cast<uint32_t>(ShuffleStatus::OK)) {
+        error = location.to_string() + " refused (status " + std::to_string(response.status) + ")";
+        return false;
+    }
+    auto run_codec = static_cast<CompressionCodec>(response.run_codec);
+    if (!compression_available(run_codec)) {
+        error = location.to_string() + " is compressed with an unsupported codec";
+        return false;
+    }
+
+    std::vector<char> file_buffer(DEFAULT_BUFFER_SIZE);
+    std::ofstream out;
+    out.rdbuf()->pubsetbuf(file_buffer.data(), static_cast<std::streamsize>(file_buffer.size()));
+    out.open(local_path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        error = "cannot write " + local_path;
+        return false;
+    }
+
+    std::vector<char> chunk(SHUFFLE_CHUNK_SIZE);
+    std::vector<char> wire(SHUFFLE_CHUNK_SIZE);
+    uint64_t received = 0;
+    while (received < response.length) {
+        ShuffleChunkHeader header{};
+        if (!recv_all(fd, &header, sizeof(header))) {
+            error = "transfer from " + location.host + " cut short";
+            return false;
+        }
+        bool raw = header.codec == static_cast<uint32_t>(CompressionCodec::NONE);
+        if ((!raw && header.codec != static_cast<uint32_t>(wire_codec)) ||
+            (raw && header.wire_length != header.raw_length) || header.wire_length > header.raw_length ||
+            header.raw_length == 0 || header.raw_length > chunk.size() ||
+            header.raw_length > response.length - received) {
+            error = "malformed chunk from " + location.host;
+            return false;
+        }
+        if (!recv_all(fd, raw ? chunk.data() : wire.data(), header.wire_length)) {
+            error = "transfer from " + location.host + " cut short";
+            return false;
+        }
+        if (!raw && !decompress_block(wire_codec, wire.data(), header.wire_length,
+                                      chunk.data(), header.raw_length)) {
+            error = "corrupt chunk from " + location.host;
+            return false;
+        }
+        out.write(chunk.data(), header.raw_length);
+        received += header.raw_length;
+    }
+
+    out.close();
+    if (out.fail()) {
+        error = "cannot write " + local_path;
+        return false;
+    }
+
+    // The segment becomes the only non-empty partition of a local run
+    RunIndex index;
+    index.codec = run_codec;
+    index.segments.resize(partition + 1);
+    index.segments[partition] = RunSegment{0, response.length, response.records};
+    if (!index.save(RunIndex::path_for(local_path))) {
+        error = "cannot write " + RunIndex::path_for(local_path);
+        return false;
+    }
+    return true;
+}
+
+// ShuffleFetcher implementation
+ShuffleFetcher::ShuffleFetcher(uint32_t partition, std::string temp_prefix,
+                               size_t parallelism, size_t merge_factor)
+    : partition_(partition), temp_prefix_(std::move(temp_prefix)),
+      parallelism_(std::max<size_t>(1, parallelism)),
+      merge_factor_(std::max<size_t>(2, merge_factor)) {
+}
+
+ShuffleFetcher::~ShuffleFetcher() {
+    for (const auto& path : temporaries_) {
+        remove_run(path);
+    }
+}
+
+void ShuffleFetcher::add(const std::string& spec) {
+    ShuffleLocation location = ShuffleLocation::parse(spec);
+    // Runs on this host or a shared filesystem need no copy
+    if (!location.is_remote() || Utils::file_exists(RunIndex::path_for(location.path))) {
+        runs_.push_back(location.path);
+    } else {
+        remote_.push_back(std::move(location));
+    }
+}
+
+std::string ShuffleFetcher::temp_path(const char* kind) {
+    std::string path = temp_prefix_ + kind + std::to_string(temp_counter_++);
+    temporaries_.push_back(path);
+    return path;
+}
+
+void ShuffleFetcher::fetch_loop() {
+    while (true) {
+        size_t index = next_fetch_++;
+        std::string local_path;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (index >= remote_.size() || failed_) {
+                return;
+            }
+            local_path = temp_path(".fetch");
+        }
+
+        const ShuffleLocation& location = remote_[index];
+        std::string error;
+        bool ok = false;
+        auto started = std::chrono::steady_clock::now();
+        for (int attempt = 0; attempt < SHUFFLE_FETCH_ATTEMPTS && !ok; ++attempt) {
+            if (attempt > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(200 << attempt));
+            }
+            ok = fetch_shuffle_segment(location, partition_, local_path, error, codec_);
+        }
+        if (ok) {
+            Metrics::stage(Stage::SHUFFLE_FETCH).record(std::chrono::steady_clock::now() - started);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            finished_++;
+            if (ok) {
+                fetched_.push_back(local_path);
+                uint64_t bytes = Utils::get_file_size(local_path);
+                bytes_fetched_ += bytes;
+                Metrics::counter(CounterId::SHUFFLE_FETCHED_BYTES).add(bytes);
+            } else if (!failed_) {
+                failed_ = true;
+                error_ = "cannot fetch " + location.to_string() + ": " + error;
+            }
+        }
+        fetched_ready_.notify_one();
+    }
+}
+
+bool ShuffleFetcher::run() {
+    if (remote_.empty()) {
+        return true;
+    }
+
+    std::vector<std::thread> fetchers;
+    for (size_t i = 0; i < std::min(parallelism_, remote_.size()); ++i) {
+        fetchers.emplace_back(&ShuffleFetcher::fetch_loop, this);
+    }
+
+    // Merge batches of fetched segments while the rest is in flight
+    std::vector<std::string> merged;
+    bool ok = true;
+    while (ok) {
+        std::vector<std::string> batch;
+        std::string output;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            fetched_ready_.wait(lock, [this]() {
+                return failed_ || finished_ == remote_.size() || fetched_.size() >= merge_factor_;
+            });
+            if (failed_ || finished_ == remote_.size()) {
+                break;
+            }
+            batch.assign(fetched_.begin(), fetched_.begin() + merge_factor_);
+            fetched_.erase(fetched_.begin(), fetched_.begin() + merge_factor_);
+            output = temp_path(".merge");
+        }
+
+        ok = merge(batch, output);
+        if (ok) {
+            merged.push_back(output);
+        }
+    }
+
+    if (!ok) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        failed_ = true;
+        if (error_.empty()) {
+            error_ = "cannot merge fetched segments";
+        }
+    }
+    for (auto& fetcher : fetchers) {
+        fetcher.join();
+    }
+    if (failed_) {
+        return false;
+    }
+
+    runs_.insert(runs_.end(), merged.begin(), merged.end());
+    runs_.insert(runs_.end(), fetched_.begin(), fetched_.end());
+    fetched_.clear();
+    return true;
+}
+
+bool ShuffleFetcher::merge(const std::vector<std::string>& sources, const std::string& output) {
+    RunMerger merger;
+    for (const auto& source : sources) {
+        auto reader = std::make_unique<RunReader>();
+        if (!reader->open(source, partition_)) {
+            return false;
+        }
+        merger.add_source(std::move(reader));
+    }
+
+    RunWriter writer;
+    if (!writer.open(output, partition_ + 1, codec_)) {
+        return false;
+    }
+    ShuffleRecord record;
+    while (merger.next(record)) {
+        if (!writer.append(record.partition, record.key, record.value, record.binary_key)) {
+            return false;
+        }
+    }
+    if (merger.failed()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (error_.empty()) {
+            error_ = "corrupt fetched segment";
+        }
+        return false;
+    }
+    if (!writer.close()) {
+        return false;
+    }
+
+    // Merged segments are not needed again
+    for (const auto& source : sources) {
+        remove_run(source);
+    }
+    return true;
+}
+
+} // namespace daf
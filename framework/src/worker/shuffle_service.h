@@ -0,0 +1,178 @@
+#pragma once
+
+#include "shuffle_run.h"
+#include "../common/shuffle_location.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace daf {
+
+// Worker-to-worker shuffle transport
+//
+// Every worker serves the map output runs it wrote on its worker port, and
+// reduce tasks pull their partition segment of each run straight from the
+// mapper instead of through Redis or a shared filesystem. One connection
+// carries one request:
+//   client  ShuffleRequestHeader, run path
+//   server  ShuffleResponseHeader, then the segment as chunks of
+//           ShuffleChunkHeader + payload until `length` bytes arrived
+// Integers are in host byte order like the run files themselves. The client
+// lists the codecs it accepts as a bitmask of (1 << CompressionCodec). Runs
+// that are compressed on disk are sent as they are, with their codec in the
+// response; uncompressed runs are compressed chunk by chunk on the wire, and
+// chunks that would not shrink go raw.
+constexpr uint32_t SHUFFLE_MAGIC = 0x48464144; // "DAFH"
+constexpr uint32_t SHUFFLE_PROTOCOL_VERSION = 2;
+constexpr size_t SHUFFLE_CHUNK_SIZE = 256 * 1024;
+constexpr size_t SHUFFLE_MAX_PATH = 4096;
+constexpr size_t SHUFFLE_SERVER_THREADS = 4;
+constexpr size_t SHUFFLE_PARALLEL_FETCHES = 4;   // Connections per reduce task
+constexpr size_t SHUFFLE_MERGE_FACTOR = 16;      // Fetched segments per background merge
+constexpr int SHUFFLE_IO_TIMEOUT_SECONDS = 30;
+constexpr int SHUFFLE_FETCH_ATTEMPTS = 3;
+
+enum class ShuffleStatus : uint32_t {
+    OK = 0,
+    NOT_FOUND = 1,      // Not a run this worker published
+    BAD_REQUEST = 2,
+    NO_PARTITION = 3,
+    IO_ERROR = 4
+};
+
+struct ShuffleRequestHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t partition;
+    uint32_t accepted_codecs;
+    uint32_t path_length;
+};
+
+struct ShuffleResponseHeader {
+    uint32_t magic;
+    uint32_t status;
+    uint32_t run_codec;     // Codec of the segment's blocks (see shuffle_run.h)
+    uint32_t reserved;
+    uint64_t records;
+    uint64_t length;        // Segment bytes as stored in the run
+};
+
+struct ShuffleChunkHeader {
+    uint32_t codec;
+    uint32_t raw_length;
+    uint32_t wire_length;
+};
+
+// Serves published runs on the worker port
+class ShuffleServer {
+public:
+    ShuffleServer() = default;
+    ~ShuffleServer();
+
+    ShuffleServer(const ShuffleServer&) = delete;
+    ShuffleServer& operator=(const ShuffleServer&) = delete;
+
+    // Fails if the port cannot be bound
+    bool start(int port, size_t threads = SHUFFLE_SERVER_THREADS);
+    void stop();
+    bool is_running() const { return running_.load(); }
+
+    // Only runs published by a finished map task are served
+    void publish(const std::string& run_path);
+
+    uint64_t bytes_served() const { return bytes_served_.load(); }   // On the wire
+
+private:
+    void accept_loop();
+    void handler_loop();
+    void serve(int fd);
+    bool is_published(const std::string& run_path);
+
+    int listen_fd_ = -1;
+    std::atomic<bool> running_{false};
+    std::thread accept_thread_;
+    std::vector<std::thread> handlers_;
+
+    std::mutex connection_mutex_;
+    std::condition_variable connection_ready_;
+    std::deque<int> connections_;
+
+    std::mutex published_mutex_;
+    std::unordered_set<std::string> published_;
+
+    std::atomic<uint64_t> bytes_served_{0};
+};
+
+// Fetches one partition segment of a served run into local_path plus its
+// index sidecar, so it reads like any local run. wire_codec is accepted on
+// top of uncompressed chunks.
+bool fetch_shuffle_segment(const ShuffleLocation& location, uint32_t partition,
+                           const std::string& local_path, std::string& error,
+                           CompressionCodec wire_codec = CompressionCodec::NONE);
+
+// Gathers one reduce partition from every map output
+//
+// Runs that are readable here (bare paths, or runs on this host or a shared
+// filesystem) are used in place. The rest is fetched by up to `parallelism`
+// connections into "<temp_prefix>.fetch<N>"; while fetches are still
+// running, every merge_factor fetched segments are merged into one
+// "<temp_prefix>.merge<N>" run, so merging overlaps the transfer and the
+// final merge opens few files. Temporaries go away with the fetcher.
+class ShuffleFetcher {
+public:
+    ShuffleFetcher(uint32_t partition, std::string temp_prefix,
+                   size_t parallelism = SHUFFLE_PARALLEL_FETCHES,
+                   size_t merge_factor = SHUFFLE_MERGE_FACTOR);
+    ~ShuffleFetcher();
+
+    ShuffleFetcher(const ShuffleFetcher&) = delete;
+    ShuffleFetcher& operator=(const ShuffleFetcher&) = delete;
+
+    // Codec asked for on the wire and used for the background merges
+    void set_compression(CompressionCodec codec) { codec_ = codec; }
+
+    // A map output as listed in the reduce task's input files
+    void add(const std::string& spec);
+
+    // Blocks until every input is readable locally; false once one fails
+    bool run();
+
+    // Inputs for the final merge, each opened with RunReader::open(path, partition)
+    const std::vector<std::string>& runs() const { return runs_; }
+    const std::string& error() const { return error_; }
+    uint64_t bytes_fetched() const { return bytes_fetched_; }
+
+private:
+    void fetch_loop();
+    bool merge(const std::vector<std::string>& sources, const std::string& output);
+    std::string temp_path(const char* kind);
+
+    uint32_t partition_;
+    std::string temp_prefix_;
+    size_t parallelism_;
+    size_t merge_factor_;
+    CompressionCodec codec_ = CompressionCodec::NONE;
+
+    std::vector<ShuffleLocation> remote_;
+    std::vector<std::string> runs_;
+    std::vector<std::string> temporaries_;
+    size_t temp_counter_ = 0;
+    uint64_t bytes_fetched_ = 0;
+
+    // Shared with the fetch threads
+    std::mutex mutex_;
+    std::condition_variable fetched_ready_;
+    std::atomic<size_t> next_fetch_{0};
+    std::vector<std::string> fetched_;
+    size_t finished_ = 0;
+    bool failed_ = false;
+    std::string error_;
+};
+
+} // namespace daf
@@ -0,0 +1,77 @@
+#include "task_arena.h"
+
+#include <new>
+
+namespace daf {
+
+namespace {
+
+// Nesting depth of TaskArenaScope on this thread
+thread_local int arena_depth = 0;
+
+} // namespace
+
+// TaskArena implementation
+TaskArena::TaskArena() : arena_(INITIAL_BLOCK_SIZE, &cache_) {
+}
+
+void TaskArena::reset() {
+    arena_.release();
+}
+
+TaskArena& TaskArena::local() {
+    thread_local TaskArena arena;
+    return arena;
+}
+
+TaskArena::BlockCache::~BlockCache() {
+    for (const auto& block : free_) {
+        ::operator delete(block.data, block.size, std::align_val_t(block.alignment));
+    }
+}
+
+void* TaskArena::BlockCache::do_allocate(size_t bytes, size_t alignment) {
+    for (size_t i = 0; i < free_.size(); ++i) {
+        if (free_[i].size == bytes && free_[i].alignment == alignment) {
+            void* data = free_[i].data;
+            free_[i] = free_.back();
+            free_.pop_back();
+            cached_bytes_ -= bytes;
+            bytes_in_use_ += bytes;
+            return data;
+        }
+    }
+
+    void* data = ::operator new(bytes, std::align_val_t(alignment));
+    bytes_in_use_ += bytes;
+    charge_.set(bytes_in_use_ + cached_bytes_);
+    return data;
+}
+
+void TaskArena::BlockCache::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    bytes_in_use_ -= bytes;
+    if (cached_bytes_ + bytes > BLOCK_CACHE_LIMIT) {
+        ::operator delete(p, bytes, std::align_val_t(alignment));
+        charge_.set(bytes_in_use_ + cached_bytes_);
+        return;
+    }
+    free_.push_back({p, bytes, alignment});
+    cached_bytes_ += bytes;
+}
+
+bool TaskArena::BlockCache::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+// TaskArenaScope implementation
+TaskArenaScope::TaskArenaScope() : arena_(TaskArena::local()) {
+    arena_depth++;
+}
+
+TaskArenaScope::~TaskArenaScope() {
+    if (--arena_depth == 0) {
+        arena_.reset();
+    }
+}
+
+} // namespace daf
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "../common/memory_governor.h"
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace daf {
+
+// Per-task memory arena
+//
+// Scratch memory of a running task (values buffered by combiner contexts,
+// whatever the plugin allocates through get_task_memory()) is
+// bump-allocated and dropped wholesale when the task ends, instead of being
+// freed piece by piece. The arena's blocks go back to a small per-thread
+// cache rather than the heap, so the next task on the thread reuses them and
+// long-lived workers do not fragment.
+//
+// An arena is single-threaded: each pool thread has its own (local()), and
+// nothing allocated from it may outlive the task or cross to another thread.
+class TaskArena {
+public:
+    static constexpr size_t INITIAL_BLOCK_SIZE = 64 * 1024;
+    static constexpr size_t BLOCK_CACHE_LIMIT = 16 * 1024 * 1024;   // Kept between tasks
+
+    TaskArena();
+    ~TaskArena() = default;
+
+    TaskArena(const TaskArena&) = delete;
+    TaskArena& operator=(const TaskArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &arena_; }
+
+    // Frees everything allocated since the last reset
+    void reset();
+
+    // Bytes of blocks the arena holds right now
+    size_t bytes_in_use() const { return cache_.bytes_in_use(); }
+
+    // The calling thread's arena
+    static TaskArena& local();
+
+private:
+    // Upstream of the arena: keeps released blocks for the next task, up to
+    // BLOCK_CACHE_LIMIT bytes. The arena asks for the same growing block
+    // sizes after every reset, so blocks are matched by exact size. Blocks
+    // taken from the heap, cached or not, are charged to MemoryPool::ARENA.
+    class BlockCache : public std::pmr::memory_resource {
+    public:
+        ~BlockCache() override;
+
+        size_t bytes_in_use() const { return bytes_in_use_; }
+
+    private:
+        struct Block {
+            void* data;
+            size_t size;
+            size_t alignment;
+        };
+
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+        std::vector<Block> free_;
+        size_t cached_bytes_ = 0;
+        size_t bytes_in_use_ = 0;
+        MemoryCharge charge_{MemoryPool::ARENA};
+    };
+
+    BlockCache cache_;
+    std::pmr::monotonic_buffer_resource arena_;
+};
+
+// Marks a task running on the current thread's arena. Scopes nest when a
+// thread runs stolen sub-splits while it waits for them; the arena is reset
+// when the outermost scope ends.
+class TaskArenaScope {
+public:
+    TaskArenaScope();
+    ~TaskArenaScope();
+
+    TaskArenaScope(const TaskArenaScope&) = delete;
+    TaskArenaScope& operator=(const TaskArenaScope&) = delete;
+
+    std::pmr::memory_resource* resource() { return arena_.resource(); }
+
+private:
+    TaskArena& arena_;
+};
+
+} // namespace daf
@@ -0,0 +1,432 @@
+#include "task_context.h"
+#include "task_arena.h"
+#include "../common/metrics.h"
+#include <algorithm>
+#include <cstring>
+
+namespace daf {
+
+// MapContextImpl implementation
+MapContextImpl::MapContextImpl(const std::vector<InputSplit>& input_splits,
+                               const std::map<std::string, std::string>& parameters,
+                               const ShuffleBuffer::Options& shuffle_options,
+                               std::pmr::memory_resource* memory)
+    : parameters_(parameters), memory_(memory), shuffle_buffer_(shuffle_options),
+      current_file_index_(0), file_offset_(0), current_sample_file_index_(0),
+      records_read_(0), records_emitted_(0), metric_calls_(0),
+      use_mmap_(false), map_offset_(0), map_end_(0) {
+    
+    auto mode = parameters_.find("input_mode");
+    use_mmap_ = mode != parameters_.end() && mode->second == "mmap";
+    
+    // Binary sample files are served through read_samples(), everything else as text lines
+    for (const auto& split : input_splits) {
+        if (SampleFileReader::is_sample_file(split.path)) {
+            sample_files_.push_back(split);
+        } else {
+            input_files_.push_back(split);
+        }
+    }
+    
+    if (!input_files_.empty()) {
+        if (use_mmap_) {
+            open_mapped_file(0);
+        } else {
+            open_text_file(0);
+        }
+    }
+    if (!sample_files_.empty()) {
+        open_sample_file(0);
+    }
+}
+
+MapContextImpl::~MapContextImpl() {
+    if (current_file_.is_open()) {
+        current_file_.close();
+    }
+    Metrics::counter(CounterId::MAP_RECORDS_READ).add(records_read_);
+    Metrics::counter(CounterId::MAP_RECORDS_EMITTED).add(records_emitted_);
+}
+
+std::string MapContextImpl::read_input() {
+    std::string_view record;
+    if (!read_record(record)) {
+        return "";
+    }
+    
+    return std::string(record);
+}
+
+bool MapContextImpl::read_record(std::string_view& record) {
+    ScopedStageTimer timer(Stage::MAP_PARSE, ++metric_calls_ % METRIC_SAMPLE_INTERVAL == 0);
+    if (!next_record(record)) {
+        return false;
+    }
+    records_read_++;
+    return true;
+}
+
+bool MapContextImpl::next_record(std::string_view& record) {
+    if (use_mmap_) {
+        return read_mapped_record(record);
+    }
+    
+    while (current_file_.is_open()) {
+        // The line starting at the split end belongs to the next split
+        if (file_offset_ < input_files_[current_file_index_].end() &&
+            std::getline(current_file_, current_line_)) {
+            file_offset_ += current_line_.size() + 1;
+            record = current_line_;
+            return true;
+        }
+        
+        // Current split exhausted, move to the next one
+        if (!open_text_file(current_file_index_ + 1)) {
+            return false;
+        }
+    }
+    
+    return false;
+}
+
+bool MapContextImpl::open_text_file(size_t index) {
+    if (current_file_.is_open()) {
+        current_file_.close();
+    }
+    current_file_.clear();
+    
+    for (; index < input_files_.size(); ++index) {
+        current_file_index_ = index;
+        const auto& split = input_files_[index];
+        current_file_.open(split.path);
+        if (!current_file_.is_open()) {
+            Logger::error("Cannot open input file: " + split.path);
+            current_file_.clear();
+            continue;
+        }
+        
+        // Mid-file splits start after the line that crosses their offset;
+        // looking from offset - 1 keeps a line that starts exactly on it
+        file_offset_ = split.offset;
+        if (split.offset > 0) {
+            current_file_.seekg(static_cast<std::streamoff>(split.offset - 1));
+            std::getline(current_file_, current_line_);
+            file_offset_ = split.offset + current_line_.size();
+        }
+        return true;
+    }
+    
+    return false;
+}
+
+bool MapContextImpl::read_mapped_record(std::string_view& record) {
+    while (current_map_.is_open()) {
+        size_t size = current_map_.size();
+        if (map_offset_ < map_end_) {
+            readahead_.advance(current_map_, map_offset_);
+            
+            // Records are the bytes up to the next newline, directly in the mapping
+            const char* begin = current_map_.data() + map_offset_;
+            const char* newline = static_cast<const char*>(std::memchr(begin, '\n', size - map_offset_));
+            size_t length = newline ? static_cast<size_t>(newline - begin) : size - map_offset_;
+            
+            record = std::string_view(begin, length);
+            map_offset_ += length + (newline ? 1 : 0);
+            return true;
+        }
+        
+        // Current split exhausted, move to the next one
+        if (!open_mapped_file(current_file_index_ + 1)) {
+            return false;
+        }
+    }
+    
+    return false;
+}
+
+bool MapContextImpl::open_mapped_file(size_t index) {
+    current_map_.close();
+    
+    for (; index < input_files_.size(); ++index) {
+        current_file_index_ = index;
+        readahead_.reset();
+        const auto& split = input_files_[index];
+        if (!current_map_.open(split.path, MappedFile::Access::SEQUENTIAL)) {
+            Logger::error("Cannot map input file: " + split.path);
+            continue;
+        }
+        
+        // Same line ownership rule as the stream reader
+        size_t size = current_map_.size();
+        map_end_ = static_cast<size_t>(std::min<uint64_t>(split.end(), size));
+        map_offset_ = static_cast<size_t>(std::min<uint64_t>(split.offset, size));
+        if (map_offset_ > 0) {
+            const char* from = current_map_.data() + map_offset_ - 1;
+            const char* newline = static_cast<const char*>(std::memchr(from, '\n', size - map_offset_ + 1));
+            map_offset_ = newline ? static_cast<size_t>(newline - current_map_.data()) + 1 : size;
+        }
+        return true;
+    }
+    
+    return false;
+}
+
+bool MapContextImpl::has_more_input() {
+    if (use_mmap_) {
+        return current_map_.is_open() &&
+               (map_offset_ < map_end_ || current_file_index_ + 1 < input_files_.size());
+    }
+    
+    if (!current_file_.is_open()) {
+        return false;
+    }
+    
+    // Check if current split has more lines or if there are more splits
+    bool split_has_more = file_offset_ < input_files_[current_file_index_].end() &&
+                          current_file_.peek() != std::char_traits<char>::eof();
+    return split_has_more || (current_file_index_ + 1 < input_files_.size());
+}
+
+void MapContextImpl::emit(const std::string& key, const std::string& value) {
+    ScopedStageTimer timer(Stage::MAP_EMIT, ++metric_calls_ % METRIC_SAMPLE_INTERVAL == 0);
+    records_emitted_++;
+    if (!shuffle_buffer_.add(key, value)) {
+        Logger::error("Failed to buffer emitted record for key: " + key);
+    }
+}
+
+void MapContextImpl::emit_binary(uint64_t key, const void* value, size_t size) {
+    ScopedStageTimer timer(Stage::MAP_EMIT, ++metric_calls_ % METRIC_SAMPLE_INTERVAL == 0);
+    records_emitted_++;
+    char key_bytes[BINARY_KEY_SIZE];
+    encode_binary_key(key, key_bytes);
+    if (!shuffle_buffer_.add(std::string_view(key_bytes, sizeof(key_bytes)),
+                             std::string_view(static_cast<const char*>(value), size), true)) {
+        Logger::error("Failed to buffer emitted record for key: " + std::to_string(key));
+    }
+}
+
+std::string MapContextImpl::get_parameter(const std::string& key) const {
+    auto it = parameters_.find(key);
+    return (it != parameters_.end()) ? it->second : "";
+}
+
+void MapContextImpl::set_status(const std::string& status) {
+    status_ = status;
+}
+
+size_t MapContextImpl::get_memory_usage() const {
+    return Utils::get_memory_usage();
+}
+
+size_t MapContextImpl::get_memory_limit() const {
+    return MAX_MEMORY_MB;
+}
+
+bool MapContextImpl::read_samples(SampleBatch& batch) {
+    // Batches are large enough to time every one
+    ScopedStageTimer timer(Stage::MAP_PARSE);
+    if (!next_samples(batch)) {
+        return false;
+    }
+    records_read_++;
+    return true;
+}
+
+bool MapContextImpl::next_samples(SampleBatch& batch) {
+    while (current_sample_file_index_ < sample_files_.size()) {
+        if (sample_reader_.next(batch)) {
+            return true;
+        }
+        
+        // Current sample split exhausted, move to the next one
+        sample_reader_.close();
+        open_sample_file(current_sample_file_index_ + 1);
+    }
+    
+    return false;
+}
+
+bool MapContextImpl::open_sample_file(size_t index) {
+    for (; index < sample_files_.size(); ++index) {
+        current_sample_file_index_ = index;
+        const auto& split = sample_files_[index];
+        if (sample_reader_.open(split.path, use_mmap_, split.offset, split.length)) {
+            return true;
+        }
+        Logger::error("Cannot open sample file: " + split.path);
+    }
+    
+    current_sample_file_index_ = sample_files_.size();
+    return false;
+}
+
+bool MapContextImpl::finish_output(const std::string& output_path) {
+    return shuffle_buffer_.finish(output_path);
+}
+
+std::pmr::memory_resource* MapContextImpl::get_task_memory() {
+    return memory_;
+}
+
+void MapContextImpl::set_combiner(ShuffleBuffer::Combiner combiner) {
+    shuffle_buffer_.set_combiner(std::move(combiner));
+}
+
+void MapContextImpl::set_key_sketch(KeySketch* sketch) {
+    shuffle_buffer_.set_key_sketch(sketch);
+}
+
+// ReduceContextImpl implementation
+ReduceContextImpl::ReduceContextImpl(const std::vector<std::string>& values,
+                                     const std::map<std::string, std::string>& parameters,
+                                     std::pmr::memory_resource* memory)
+    : owned_values_(values), values_(owned_values_.begin(), owned_values_.end()),
+      group_(nullptr), parameters_(parameters), memory_(memory), emitted_bytes_(memory),
+      emitted_ends_(memory), output_(nullptr),
+      emitted_count_(0), current_value_index_(0) {
+}
+
+ReduceContextImpl::~ReduceContextImpl() {
+}
+
+std::vector<std::string> ReduceContextImpl::get_values() {
+    // Materializes whatever next_value() has not consumed yet
+    std::vector<std::string> values;
+    std::string_view value;
+    while (next_value(value)) {
+        values.emplace_back(value);
+    }
+    return values;
+}
+
+bool ReduceContextImpl::has_more_values() {
+    if (group_) {
+        return group_->has_more_values();
+    }
+    return current_value_index_ < values_.size();
+}
+
+bool ReduceContextImpl::next_value(std::string_view& value) {
+    if (group_) {
+        return group_->next_value(value);
+    }
+    if (current_value_index_ >= values_.size()) {
+        return false;
+    }
+    value = values_[current_value_index_++];
+    return true;
+}
+
+void ReduceContextImpl::emit(const std::string& value) {
+    emitted_count_++;
+    if (output_) {
+        output_->write(value.data(), static_cast<std::streamsize>(value.size()));
+        output_->put('\n');
+        return;
+    }
+    emitted_bytes_.append(value);
+    emitted_ends_.push_back(emitted_bytes_.size());
+}
+
+std::string ReduceContextImpl::get_parameter(const std::string& key) const {
+    auto it = parameters_.find(key);
+    return (it != parameters_.end()) ? it->second : "";
+}
+
+void ReduceContextImpl::set_status(const std::string& status) {
+    status_ = status;
+}
+
+size_t ReduceContextImpl::get_memory_usage() const {
+    return Utils::get_memory_usage();
+}
+
+size_t ReduceContextImpl::get_memory_limit() const {
+    return MAX_MEMORY_MB;
+}
+
+bool ReduceContextImpl::get_binary_key(uint64_t& key) const {
+    return binary_key_ && decode_binary_key(key_, key);
+}
+
+void ReduceContextImpl::emit_binary(const void* value, size_t size) {
+    emitted_count_++;
+    if (output_) {
+        uint32_t length = static_cast<uint32_t>(size);
+        output_->write(reinterpret_cast<const char*>(&length), sizeof(length));
+        output_->write(static_cast<const char*>(value), static_cast<std::streamsize>(size));
+        return;
+    }
+    emitted_bytes_.append(static_cast<const char*>(value), size);
+    emitted_ends_.push_back(emitted_bytes_.size());
+}
+
+std::pmr::memory_resource* ReduceContextImpl::get_task_memory() {
+    return memory_;
+}
+
+std::string_view ReduceContextImpl::buffered_value(size_t index) const {
+    size_t begin = index == 0 ? 0 : emitted_ends_[index - 1];
+    return std::string_view(emitted_bytes_).substr(begin, emitted_ends_[index] - begin);
+}
+
+void ReduceContextImpl::reset(std::string_view key, bool binary_key,
+                              const std::vector<std::string_view>& values) {
+    key_.assign(key.data(), key.size());
+    binary_key_ = binary_key;
+    owned_values_.clear();
+    values_.assign(values.begin(), values.end());
+    group_ = nullptr;
+    emitted_bytes_.clear();
+    emitted_ends_.clear();
+    current_value_index_ = 0;
+}
+
+void ReduceContextImpl::reset(std::string_view key, KeyGroupReader* group) {
+    key_.assign(key.data(), key.size());
+    binary_key_ = group->binary_key();
+    owned_values_.clear();
+    values_.clear();
+    group_ = group;
+    emitted_bytes_.clear();
+    emitted_ends_.clear();
+    current_value_index_ = 0;
+}
+
+void ReduceContextImpl::set_output(std::ostream* out) {
+    output_ = out;
+}
+
+// Map task helpers
+ShuffleBuffer::Combiner make_combiner(CombineFunction combine_function,
+                                      ReduceContextImpl& combine_context) {
+    return [combine_function, &combine_context](std::string_view key, bool binary_key,
+                                                const std::vector<std::string_view>& values,
+                                                const ShuffleBuffer::CombineEmitter& emit) {
+        combine_context.reset(key, binary_key, values);
+        combine_function(std::string(key).c_str(), &combine_context);
+        for (size_t i = 0; i < combine_context.buffered_count(); ++i) {
+            emit(combine_context.buffered_value(i));
+        }
+    };
+}
+
+bool run_map_splits(MapFunction map_function, CombineFunction combine_function,
+                    const std::vector<InputSplit>& splits,
+                    const std::map<std::string, std::string>& parameters,
+                    const ShuffleBuffer::Options& options, const std::string& output_path,
+                    KeySketch* key_sketch) {
+    TaskArenaScope arena;
+    MapContextImpl context(splits, parameters, options, arena.resource());
+    ReduceContextImpl combine_context({}, parameters, arena.resource());
+    if (combine_function) {
+        context.set_combiner(make_combiner(combine_function, combine_context));
+    }
+    context.set_key_sketch(key_sketch);
+    
+    map_function(&context);
+    return context.finish_output(output_path);
+}
+
+} // namespace daf
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "../common/daf_types.h"
+#include "../common/daf_utils.h"
+#include "../common/input_split.h"
+#include "../common/mapped_file.h"
+#include "../common/sample_format.h"
+#include "shuffle_buffer.h"
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory_resource>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace daf {
+
+// Worker-side implementations of the plugin task contexts
+
+class MapContextImpl : public MapContext {
+public:
+    MapContextImpl(const std::vector<InputSplit>& input_splits,
+                   const std::map<std::string, std::string>& parameters,
+                   const ShuffleBuffer::Options& shuffle_options,
+                   std::pmr::memory_resource* memory);
+    ~MapContextImpl();
+    
+    // MapContext interface
+    std::string read_input() override;
+    bool has_more_input() override;
+    void emit(const std::string& key, const std::string& value) override;
+    std::string get_parameter(const std::string& key) const override;
+    void set_status(const std::string& status) override;
+    size_t get_memory_usage() const override;
+    size_t get_memory_limit() const override;
+    bool read_samples(SampleBatch& batch) override;
+    bool read_record(std::string_view& record) override;
+    void emit_binary(uint64_t key, const void* value, size_t size) override;
+    std::pmr::memory_resource* get_task_memory() override;
+    
+    // Sort, spill and merge emitted data into the partitioned map output
+    bool finish_output(const std::string& output_path);
+    void set_combiner(ShuffleBuffer::Combiner combiner);
+    void set_key_sketch(KeySketch* sketch);
+    
+private:
+    bool next_record(std::string_view& record);
+    bool next_samples(SampleBatch& batch);
+    bool read_mapped_record(std::string_view& record);
+    bool open_mapped_file(size_t index);
+    bool open_text_file(size_t index);
+    bool open_sample_file(size_t index);
+    
+    std::vector<InputSplit> input_files_;
+    std::vector<InputSplit> sample_files_;
+    std::map<std::string, std::string> parameters_;
+    std::pmr::memory_resource* memory_;
+    ShuffleBuffer shuffle_buffer_;
+    size_t current_file_index_;
+    std::ifstream current_file_;
+    std::string current_line_;
+    uint64_t file_offset_;   // Start of the next line in current_file_
+    size_t current_sample_file_index_;
+    SampleFileReader sample_reader_;
+    std::string status_;
+    
+    // Added to the process metrics when the context goes away; per-call
+    // timings are sampled
+    uint64_t records_read_;
+    uint64_t records_emitted_;
+    uint32_t metric_calls_;
+    
+    // Memory-mapped input mode (parameter input_mode=mmap)
+    bool use_mmap_;
+    MappedFile current_map_;
+    MappedReadahead readahead_;
+    size_t map_offset_;
+    size_t map_end_;   // Lines starting before this offset belong to the split
+};
+
+class ReduceContextImpl : public ReduceContext {
+public:
+    ReduceContextImpl(const std::vector<std::string>& values,
+                      const std::map<std::string, std::string>& parameters,
+                      std::pmr::memory_resource* memory);
+    ~ReduceContextImpl();
+    
+    // ReduceContext interface
+    std::vector<std::string> get_values() override;
+    bool has_more_values() override;
+    void emit(const std::string& value) override;
+    std::string get_parameter(const std::string& key) const override;
+    void set_status(const std::string& status) override;
+    size_t get_memory_usage() const override;
+    size_t get_memory_limit() const override;
+    bool get_binary_key(uint64_t& key) const override;
+    void emit_binary(const void* value, size_t size) override;
+    bool next_value(std::string_view& value) override;
+    std::pmr::memory_resource* get_task_memory() override;
+    
+    // Values emitted for the current key when there is no output stream
+    size_t buffered_count() const { return emitted_ends_.size(); }
+    std::string_view buffered_value(size_t index) const;
+    
+    // Reuse the context for the next key group. The combiner hands over
+    // in-memory values, reduce tasks stream them from the merged runs.
+    void reset(std::string_view key, bool binary_key, const std::vector<std::string_view>& values);
+    void reset(std::string_view key, KeyGroupReader* group);
+    
+    // Write emitted records straight to out instead of buffering them:
+    // text values as lines, binary values as [u32 length][bytes]
+    void set_output(std::ostream* out);
+    uint64_t emitted_count() const { return emitted_count_; }
+    
+private:
+    std::string key_;
+    bool binary_key_ = false;   // key_ came from emit_binary()
+    std::vector<std::string> owned_values_;
+    std::vector<std::string_view> values_;
+    KeyGroupReader* group_;
+    std::map<std::string, std::string> parameters_;
+    std::pmr::memory_resource* memory_;
+    // Buffered values back to back in the task arena; the capacity carries
+    // over from one key group to the next
+    std::pmr::string emitted_bytes_;
+    std::pmr::vector<size_t> emitted_ends_;
+    std::ostream* output_;
+    uint64_t emitted_count_;
+    size_t current_value_index_;
+    std::string status_;
+};
+
+// Runs the plugin combiner on each key group through a reusable context
+ShuffleBuffer::Combiner make_combiner(CombineFunction combine_function,
+                                      ReduceContextImpl& combine_context);
+
+// Maps splits into one sorted, partitioned run. Every call has its own
+// context, shuffle buffer and combiner state, so calls run concurrently
+// without sharing an emit buffer. Sub-splits stolen by another pool thread
+// allocate from that thread's arena. key_sketch, if given, sketches the run.
+bool run_map_splits(MapFunction map_function, CombineFunction combine_function,
+                    const std::vector<InputSplit>& splits,
+                    const std::map<std::string, std::string>& parameters,
+                    const ShuffleBuffer::Options& options, const std::string& output_path,
+                    KeySketch* key_sketch = nullptr);
+
+} // namespace daf
@@ -0,0 +1,201 @@
+#include "thread_pool.h"
+#include "../common/daf_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace daf {
+
+namespace {
+
+// Set on pool threads so submit() and run_pending_job() can find their deque
+thread_local const WorkStealingPool* current_pool = nullptr;
+thread_local size_t current_queue = SIZE_MAX;
+
+} // namespace
+
+// WorkStealingPool implementation
+WorkStealingPool::WorkStealingPool(size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (size_t i = 0; i < thread_count; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back(&WorkStealingPool::worker_loop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    // Threads drain every queued job before they exit
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void WorkStealingPool::submit(Job job) {
+    // Count first: a thread that sees the count before the push just retries
+    queued_.fetch_add(1);
+
+    size_t index = current_index();
+    if (index != SIZE_MAX) {
+        auto& queue = *queues_[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_front(std::move(job));
+    } else {
+        std::lock_guard<std::mutex> lock(mutex_);
+        injected_.push_back(std::move(job));
+    }
+
+    // Taking the lock orders the push before a sleeper's predicate check
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    wake_.notify_one();
+}
+
+bool WorkStealingPool::run_pending_job() {
+    size_t index = current_index();
+    Job job;
+    if ((index != SIZE_MAX && pop_local(index, job)) || steal(index, job)) {
+        run_job(job);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::worker_loop(size_t index) {
+    current_pool = this;
+    current_queue = index;
+
+    while (true) {
+        Job job;
+        if (pop_local(index, job) || steal(index, job) || pop_injected(job)) {
+            run_job(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [this]() { return stopping_ || queued_.load() > 0; });
+        if (stopping_ && queued_.load() == 0) {
+            break;
+        }
+    }
+
+    current_pool = nullptr;
+    current_queue = SIZE_MAX;
+}
+
+bool WorkStealingPool::pop_local(size_t index, Job& job) {
+    auto& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty()) {
+        return false;
+    }
+    job = std::move(queue.jobs.front());
+    queue.jobs.pop_front();
+    queued_.fetch_sub(1);
+    return true;
+}
+
+bool WorkStealingPool::steal(size_t thief, Job& job) {
+    // Walk the other deques starting next to the thief so victims spread out
+    size_t count = queues_.size();
+    size_t start = thief == SIZE_MAX ? 0 : thief + 1;
+    for (size_t i = 0; i < count; ++i) {
+        size_t victim = (start + i) % count;
+        if (victim == thief) {
+            continue;
+        }
+
+        auto& queue = *queues_[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+            queued_.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WorkStealingPool::pop_injected(Job& job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (injected_.empty()) {
+        return false;
+    }
+    job = std::move(injected_.front());
+    injected_.pop_front();
+    queued_.fetch_sub(1);
+    return true;
+}
+
+void WorkStealingPool::run_job(Job& job) {
+    try {
+        job();
+    } catch (const std::exception& e) {
+        Logger::error("Worker pool job failed: " + std::string(e.what()));
+    } catch (...) {
+        Logger::error("Worker pool job failed with an unknown exception");
+    }
+}
+
+size_t WorkStealingPool::current_index() const {
+    return current_pool == this ? current_queue : SIZE_MAX;
+}
+
+// TaskGroup implementation
+void TaskGroup::run(WorkStealingPool::Job job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        outstanding_++;
+    }
+
+    pool_.submit([this, job = std::move(job)]() {
+        // Signal under the lock: once wait() sees zero it may destroy the group
+        auto finish = [this]() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--outstanding_ == 0) {
+                done_.notify_all();
+            }
+        };
+
+        try {
+            job();
+        } catch (...) {
+            finish();
+            throw;
+        }
+        finish();
+    });
+}
+
+void TaskGroup::wait() {
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (outstanding_ == 0) {
+                return;
+            }
+        }
+
+        // Help with queued sub-jobs (possibly our own) instead of blocking
+        if (pool_.run_pending_job()) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait_for(lock, std::chrono::milliseconds(1), [this]() { return outstanding_ == 0; });
+    }
+}
+
+} // namespace daf
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace daf {
+
+// Work-stealing thread pool
+//
+// Every pool thread owns a deque: jobs submitted from a pool thread go to
+// the front of its own deque and are popped LIFO (hot in cache), idle
+// threads steal the oldest job from the back of someone else's. Jobs from
+// outside the pool (whole tasks) go through a shared injection queue, which
+// only idle threads take from, so a thread helping out while it waits for
+// its own sub-jobs never starts an unrelated task.
+class WorkStealingPool {
+public:
+    using Job = std::function<void()>;
+
+    // thread_count == 0 uses the hardware concurrency
+    explicit WorkStealingPool(size_t thread_count = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(Job job);
+
+    // Runs one queued sub-job (own deque first, then stealing) on the
+    // calling thread; false if there was nothing to run
+    bool run_pending_job();
+
+    size_t thread_count() const { return threads_.size(); }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void worker_loop(size_t index);
+    bool pop_local(size_t index, Job& job);
+    bool steal(size_t thief, Job& job);
+    bool pop_injected(Job& job);
+    void run_job(Job& job);
+
+    // Deque of the calling thread, or SIZE_MAX if it is not one of ours
+    size_t current_index() const;
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::deque<Job> injected_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> queued_{0};
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
+
+// Fork/join helper: wait() returns once every job started through run() has
+// finished, running queued sub-jobs meanwhile so that waiting from a pool
+// thread cannot deadlock the pool
+class TaskGroup {
+public:
+    explicit TaskGroup(WorkStealingPool& pool) : pool_(pool) {}
+    ~TaskGroup() { wait(); }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void run(WorkStealingPool::Job job);
+    void wait();
+
+private:
+    WorkStealingPool& pool_;
+    size_t outstanding_ = 0;   // Guarded by mutex_
+    std::mutex mutex_;
+    std::condition_variable done_;
+};
+
+} // namespace daf
@@ -0,0 +1,83 @@
+#include "../src/common/key_sketch.h"
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace daf;
+
+namespace {
+
+// One run's worth of keys: "hot" heavy, the rest light
+KeySketch run_sketch(uint64_t hot_records, int light_keys, const std::string& prefix) {
+    KeySketch sketch;
+    sketch.add("hot", hot_records);
+    for (int i = 0; i < light_keys; ++i) {
+        sketch.add(prefix + std::to_string(i), 1);
+    }
+    return sketch;
+}
+
+} // namespace
+
+TEST(KeySketch, EstimatesNeverUndercount) {
+    KeySketch sketch = run_sketch(500, 2000, "k");
+    EXPECT_EQ(sketch.total(), 2500u);
+    EXPECT_GE(sketch.estimate("hot"), 500u);
+    for (int i = 0; i < 2000; i += 97) {
+        EXPECT_GE(sketch.estimate("k" + std::to_string(i)), 1u);
+    }
+}
+
+TEST(KeySketch, EncodeDecodeRoundTrip) {
+    KeySketch sketch = run_sketch(300, 100, std::string("bin\0key", 7));
+    KeySketch decoded;
+    ASSERT_TRUE(KeySketch::decode(sketch.encode(), decoded));
+    EXPECT_EQ(decoded.total(), sketch.total());
+    EXPECT_EQ(decoded.estimate("hot"), sketch.estimate("hot"));
+    EXPECT_EQ(decoded.heavy_keys(100), sketch.heavy_keys(100));
+    EXPECT_EQ(decoded.encode(), sketch.encode());
+    // Varint counters: about a byte for each of the mostly small counts
+    EXPECT_LT(sketch.encode().size(), 2 * KEY_SKETCH_DEPTH * KEY_SKETCH_WIDTH);
+}
+
+TEST(KeySketch, DecodeRejectsGarbage) {
+    KeySketch sketch;
+    EXPECT_FALSE(KeySketch::decode("", sketch));
+    EXPECT_FALSE(KeySketch::decode("not a sketch", sketch));
+    std::string encoded = run_sketch(10, 10, "k").encode();
+    EXPECT_FALSE(KeySketch::decode(encoded.substr(0, encoded.size() / 2), sketch));
+}
+
+TEST(KeySketch, MergeAddsCountsAcrossRuns) {
+    KeySketch merged = run_sketch(200, 500, "a");
+    merged.merge(run_sketch(300, 500, "b"));
+    EXPECT_EQ(merged.total(), 1500u);
+    EXPECT_GE(merged.estimate("hot"), 500u);
+
+    auto heavy = merged.heavy_keys(400);
+    ASSERT_FALSE(heavy.empty());
+    EXPECT_EQ(heavy.front().first, "hot");
+    EXPECT_GE(heavy.front().second, 500u);
+}
+
+TEST(KeySketch, FindsHotKeysWorthSalting) {
+    KeySketch sketch = run_sketch(4000, 4000, "k");   // "hot" is half of all records
+
+    auto hot = find_hot_keys(sketch, 4, 0.5, 8);
+    ASSERT_EQ(hot.size(), 1u);
+    EXPECT_EQ(hot.front().key, "hot");
+    EXPECT_GE(hot.front().salts, 2u);
+    EXPECT_LE(hot.front().salts, 8u);
+
+    EXPECT_TRUE(find_hot_keys(sketch, 1, 0.5, 8).empty());   // Nothing to spread over
+    EXPECT_TRUE(find_hot_keys(sketch, 4, 0.5, 1).empty());
+    EXPECT_TRUE(find_hot_keys(KeySketch(), 4, 0.5, 8).empty());
+}
+
+TEST(KeySketch, HexKeysRoundTrip) {
+    std::string key("\x00\x7f\xff hot", 7);
+    std::string decoded;
+    ASSERT_TRUE(hex_decode_key(hex_encode_key(key), decoded));
+    EXPECT_EQ(decoded, key);
+    EXPECT_FALSE(hex_decode_key("abc", decoded));
+    EXPECT_FALSE(hex_decode_key("zz", decoded));
+}
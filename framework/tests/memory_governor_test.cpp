@@ -0,0 +1,166 @@
+#include "../src/common/memory_governor.h"
+#include "../src/common/mapped_file.h"
+#include "../src/worker/shuffle_buffer.h"
+#include "../src/worker/shuffle_run.h"
+#include "../src/worker/task_arena.h"
+#include "test_dir.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace daf;
+
+namespace {
+
+constexpr size_t MB = 1024 * 1024;
+
+// The governor is process-wide: tests work relative to what is accounted
+// when they start and put the budget back when they end
+class MemoryGovernorTest : public ::testing::Test {
+protected:
+    MemoryGovernorTest() : governor_(MemoryGovernor::instance()), budget_(governor_.budget()) {}
+    ~MemoryGovernorTest() override { governor_.set_budget(budget_); }
+
+    size_t accounted_since_start() const { return governor_.accounted_bytes() - baseline_; }
+
+    MemoryGovernor& governor_;
+    size_t budget_;
+    size_t baseline_ = MemoryGovernor::instance().accounted_bytes();
+};
+
+uint64_t count_records(const std::string& path) {
+    RunReader reader;
+    if (!reader.open(path)) {
+        return 0;
+    }
+    uint64_t records = 0;
+    ShuffleRecord record;
+    while (reader.next(record)) {
+        records++;
+    }
+    return records;
+}
+
+} // namespace
+
+TEST_F(MemoryGovernorTest, ChargesFollowTheirOwner) {
+    {
+        MemoryCharge charge(MemoryPool::SHUFFLE);
+        charge.set(10 * MB);
+        EXPECT_EQ(accounted_since_start(), 10 * MB);
+        charge.set(4 * MB);
+        EXPECT_EQ(accounted_since_start(), 4 * MB);
+
+        MemoryCharge moved(std::move(charge));
+        EXPECT_EQ(moved.bytes(), 4 * MB);
+        EXPECT_EQ(charge.bytes(), 0u);
+        EXPECT_EQ(accounted_since_start(), 4 * MB);
+
+        MemoryCharge other(MemoryPool::INPUT);
+        other.set(1 * MB);
+        other = std::move(moved);   // Gives back its own charge first
+        EXPECT_EQ(accounted_since_start(), 4 * MB);
+    }
+    EXPECT_EQ(governor_.accounted_bytes(), baseline_);
+}
+
+TEST_F(MemoryGovernorTest, SoftLimitAndBudget) {
+    governor_.set_budget(baseline_ + 100 * MB);
+    EXPECT_FALSE(governor_.should_spill());
+
+    MemoryCharge charge(MemoryPool::ARENA);
+    charge.set(governor_.soft_limit() - baseline_ + 1);
+    EXPECT_TRUE(governor_.should_spill());
+
+    charge.set(governor_.budget() - baseline_ + 1);
+    EXPECT_TRUE(governor_.over_budget());
+    EXPECT_FALSE(governor_.wait_for_headroom(std::chrono::milliseconds(20)));
+
+    // Headroom comes back as soon as the charge is released
+    std::thread release([&charge]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        charge.set(0);
+    });
+    EXPECT_TRUE(governor_.wait_for_headroom(std::chrono::seconds(10)));
+    release.join();
+}
+
+TEST_F(MemoryGovernorTest, ShuffleBuffersSpillEarlyUnderPressure) {
+    TestDir dir;
+    constexpr int BUFFERS = 4;
+    constexpr int RECORDS = 40000;   // About 8 MB per buffer, 32 MB in all
+    governor_.set_budget(baseline_ + 16 * MB);
+
+    // Each buffer alone stays under its own limit; together they would
+    // hold twice the budget
+    std::vector<std::unique_ptr<ShuffleBuffer>> buffers;
+    for (int i = 0; i < BUFFERS; ++i) {
+        ShuffleBuffer::Options options;
+        options.num_partitions = 4;
+        options.memory_limit_bytes = 12 * MB;
+        options.spill_prefix = dir.file("map" + std::to_string(i));
+        buffers.push_back(std::make_unique<ShuffleBuffer>(options));
+    }
+
+    std::string value(200, 'v');
+    size_t peak = 0;
+    for (int record = 0; record < RECORDS; ++record) {
+        for (auto& buffer : buffers) {
+            ASSERT_TRUE(buffer->add("key" + std::to_string(record * 7919 % 10007), value));
+        }
+        peak = std::max(peak, accounted_since_start());
+    }
+
+    // Past the soft limit by at most a chunk and an index per buffer
+    EXPECT_LT(peak, 16 * MB);
+    size_t spills = 0;
+    for (auto& buffer : buffers) {
+        spills += buffer->spill_count();
+    }
+    EXPECT_GT(spills, 0u);
+
+    for (int i = 0; i < BUFFERS; ++i) {
+        std::string output = dir.file("map" + std::to_string(i) + ".out");
+        ASSERT_TRUE(buffers[i]->finish(output));
+        EXPECT_EQ(count_records(output), static_cast<uint64_t>(RECORDS));
+    }
+    buffers.clear();
+    EXPECT_EQ(governor_.accounted_bytes(), baseline_);
+}
+
+TEST_F(MemoryGovernorTest, ArenaBlocksAreCharged) {
+    size_t before = governor_.pool_bytes(MemoryPool::ARENA);
+    {
+        TaskArenaScope scope;
+        EXPECT_NE(scope.resource()->allocate(MB), nullptr);
+        EXPECT_GE(governor_.pool_bytes(MemoryPool::ARENA), before + MB);
+    }
+    // Released blocks stay cached for the next task, and stay charged
+    EXPECT_LE(TaskArena::local().bytes_in_use(), governor_.pool_bytes(MemoryPool::ARENA));
+}
+
+TEST_F(MemoryGovernorTest, ReadersChargeTheInputTheyHold) {
+    TestDir dir;
+    std::string path = dir.file("input");
+    std::ofstream(path, std::ios::binary) << std::string(4 * MB, 'x');
+
+    MappedFile file;
+    ASSERT_TRUE(file.open(path));
+    size_t before = governor_.pool_bytes(MemoryPool::INPUT);
+    {
+        MappedReadahead readahead(MB);
+        readahead.advance(file, 0);
+        EXPECT_EQ(governor_.pool_bytes(MemoryPool::INPUT), before + 2 * MB);   // Two windows ahead
+        readahead.advance(file, 3 * MB);
+        EXPECT_EQ(governor_.pool_bytes(MemoryPool::INPUT), before + 2 * MB);   // One behind, one to the end
+        readahead.reset();
+        EXPECT_EQ(governor_.pool_bytes(MemoryPool::INPUT), before);
+        readahead.advance(file, 0);
+    }
+    EXPECT_EQ(governor_.pool_bytes(MemoryPool::INPUT), before);
+}
@@ -0,0 +1,297 @@
+#include "../src/worker/shuffle_run.h"
+#include "test_dir.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace daf;
+
+namespace {
+
+using Record = std::tuple<uint32_t, std::string, std::string>;
+
+// Three partitions, the middle one empty, keys in order within each
+const std::vector<Record> RECORDS = {
+    {0, "apple", "1"},
+    {0, "banana", "22"},
+    {0, "banana", "333"},
+    {2, "cherry", ""},
+    {2, "date", std::string(100000, 'd')},   // Spans compressed blocks
+};
+
+bool write_run(const std::string& path, CompressionCodec codec, const std::vector<Record>& records) {
+    RunWriter writer;
+    if (!writer.open(path, 3, codec)) {
+        return false;
+    }
+    for (const auto& [partition, key, value] : records) {
+        if (!writer.append(partition, key, value)) {
+            return false;
+        }
+    }
+    return writer.close();
+}
+
+std::vector<Record> read_all(RunReader& reader) {
+    std::vector<Record> records;
+    ShuffleRecord record;
+    while (reader.next(record)) {
+        records.emplace_back(record.partition, std::string(record.key), std::string(record.value));
+    }
+    return records;
+}
+
+class RunRoundTrip : public ::testing::TestWithParam<CompressionCodec> {};
+
+} // namespace
+
+TEST_P(RunRoundTrip, ReadsBackEveryRecord) {
+    TestDir dir;
+    std::string path = dir.file("run");
+    ASSERT_TRUE(write_run(path, GetParam(), RECORDS));
+
+    RunReader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_EQ(read_all(reader), RECORDS);
+}
+
+TEST_P(RunRoundTrip, ReadsSinglePartitions) {
+    TestDir dir;
+    std::string path = dir.file("run");
+    ASSERT_TRUE(write_run(path, GetParam(), RECORDS));
+
+    for (uint32_t partition = 0; partition < 3; ++partition) {
+        std::vector<Record> expected;
+        for (const auto& record : RECORDS) {
+            if (std::get<0>(record) == partition) {
+                expected.push_back(record);
+            }
+        }
+        RunReader reader;
+        ASSERT_TRUE(reader.open(path, partition));
+        EXPECT_EQ(read_all(reader), expected) << "partition " << partition;
+    }
+}
+
+TEST_P(RunRoundTrip, IndexDescribesEverySegment) {
+    TestDir dir;
+    std::string path = dir.file("run");
+    ASSERT_TRUE(write_run(path, GetParam(), RECORDS));
+
+    RunIndex index;
+    ASSERT_TRUE(index.load(RunIndex::path_for(path)));
+    // Codecs that are not compiled in fall back to uncompressed runs
+    EXPECT_EQ(index.codec, compression_available(GetParam()) ? GetParam() : CompressionCodec::NONE);
+    ASSERT_EQ(index.segments.size(), 3u);
+    EXPECT_EQ(index.segments[0].records, 3u);
+    EXPECT_EQ(index.segments[1].records, 0u);
+    EXPECT_EQ(index.segments[1].length, 0u);
+    EXPECT_EQ(index.segments[2].records, 2u);
+    EXPECT_EQ(index.segments[0].offset, 0u);
+    EXPECT_EQ(index.segments[2].offset, index.segments[0].length);
+    EXPECT_EQ(index.segments[2].offset + index.segments[2].length,
+              std::filesystem::file_size(path));
+}
+
+TEST_P(RunRoundTrip, KeepsTheKeyType) {
+    // An 8-byte text key looks exactly like an encoded binary key
+    TestDir dir;
+    std::string path = dir.file("run");
+    {
+        RunWriter writer;
+        ASSERT_TRUE(writer.open(path, 1, GetParam()));
+        ASSERT_TRUE(writer.append(0, "abcdefgh", "text"));
+        ASSERT_TRUE(writer.append(0, "abcdefgi", "binary", true));
+        ASSERT_TRUE(writer.close());
+    }
+
+    RunReader reader;
+    ASSERT_TRUE(reader.open(path));
+    ShuffleRecord record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.key, "abcdefgh");
+    EXPECT_FALSE(record.binary_key);
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.key, "abcdefgi");
+    EXPECT_EQ(record.value, "binary");
+    EXPECT_TRUE(record.binary_key);
+    EXPECT_FALSE(reader.next(record));
+}
+
+TEST_P(RunRoundTrip, FailsOnACorruptBlockHeader) {
+    if (GetParam() == CompressionCodec::NONE || !compression_available(GetParam())) {
+        GTEST_SKIP() << "needs a compressed run";
+    }
+    TestDir dir;
+    std::string path = dir.file("run");
+    ASSERT_TRUE(write_run(path, GetParam(), RECORDS));
+    {
+        // stored_length of the first block, now past the end of its segment
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        uint32_t stored_length = 0xFFFFFFF0u;
+        file.seekp(sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(&stored_length), sizeof(stored_length));
+    }
+
+    RunReader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_TRUE(read_all(reader).empty());
+    EXPECT_TRUE(reader.failed());
+}
+
+INSTANTIATE_TEST_SUITE_P(Codecs, RunRoundTrip,
+                         ::testing::Values(CompressionCodec::NONE, CompressionCodec::LZ4, CompressionCodec::ZSTD),
+                         [](const auto& info) { return std::string(compression_codec_name(info.param)); });
+
+TEST(RunIndex, SaveLoadRoundTrip) {
+    TestDir dir;
+    RunIndex index;
+    index.codec = CompressionCodec::NONE;
+    index.segments = {{0, 10, 2}, {10, 0, 0}, {10, 5, 1}};
+    ASSERT_TRUE(index.save(dir.file("run.index")));
+
+    RunIndex loaded;
+    ASSERT_TRUE(loaded.load(dir.file("run.index")));
+    ASSERT_EQ(loaded.segments.size(), 3u);
+    for (size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(loaded.segments[i].offset, index.segments[i].offset);
+        EXPECT_EQ(loaded.segments[i].length, index.segments[i].length);
+        EXPECT_EQ(loaded.segments[i].records, index.segments[i].records);
+    }
+}
+
+TEST(RunIndex, RejectsMissingAndForeignFiles) {
+    TestDir dir;
+    RunIndex index;
+    EXPECT_FALSE(index.load(dir.file("missing.index")));
+
+    std::ofstream(dir.file("foreign.index")) << "not an index";
+    EXPECT_FALSE(index.load(dir.file("foreign.index")));
+}
+
+TEST(RunMerger, MergesRunsByPartitionAndKey) {
+    TestDir dir;
+    ASSERT_TRUE(write_run(dir.file("a"), CompressionCodec::NONE, {{0, "b", "a1"}, {1, "a", "a2"}}));
+    ASSERT_TRUE(write_run(dir.file("b"), CompressionCodec::NONE, {{0, "a", "b1"}, {0, "b", "b2"}, {2, "z", "b3"}}));
+
+    RunMerger merger;
+    for (const auto& name : {"a", "b"}) {
+        auto reader = std::make_unique<RunReader>();
+        ASSERT_TRUE(reader->open(dir.file(name)));
+        merger.add_source(std::move(reader));
+    }
+    std::vector<Record> merged;
+    ShuffleRecord record;
+    while (merger.next(record)) {
+        merged.emplace_back(record.partition, std::string(record.key), std::string(record.value));
+    }
+    // Equal keys keep source order
+    std::vector<Record> expected = {{0, "a", "b1"}, {0, "b", "a1"}, {0, "b", "b2"}, {1, "a", "a2"}, {2, "z", "b3"}};
+    EXPECT_EQ(merged, expected);
+}
+
+TEST(KeyGroupReader, ReportsTheKeyTypeOfEachGroup) {
+    TestDir dir;
+    std::string path = dir.file("run");
+    {
+        RunWriter writer;
+        ASSERT_TRUE(writer.open(path, 1));
+        ASSERT_TRUE(writer.append(0, "12345678", "a", true));
+        ASSERT_TRUE(writer.append(0, "12345678", "b", true));
+        ASSERT_TRUE(writer.append(0, "textkey!", "c"));
+        ASSERT_TRUE(writer.close());
+    }
+
+    RunMerger merger;
+    auto reader = std::make_unique<RunReader>();
+    ASSERT_TRUE(reader->open(path));
+    merger.add_source(std::move(reader));
+    KeyGroupReader groups(merger);
+    ASSERT_TRUE(groups.next_group());
+    EXPECT_EQ(groups.key(), "12345678");
+    EXPECT_TRUE(groups.binary_key());
+    ASSERT_TRUE(groups.next_group());
+    EXPECT_EQ(groups.key(), "textkey!");
+    EXPECT_FALSE(groups.binary_key());
+    EXPECT_FALSE(groups.next_group());
+}
+
+TEST(RunReader, FailsOnATruncatedRun) {
+    TestDir dir;
+    std::string path = dir.file("run");
+    ASSERT_TRUE(write_run(path, CompressionCodec::NONE, RECORDS));
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 10);
+    // Shorten the last segment to match, so only the record is cut
+    RunIndex index;
+    ASSERT_TRUE(index.load(RunIndex::path_for(path)));
+    index.segments[2].length -= 10;
+    ASSERT_TRUE(index.save(RunIndex::path_for(path)));
+
+    RunReader reader;
+    ASSERT_TRUE(reader.open(path));
+    read_all(reader);
+    EXPECT_TRUE(reader.failed());
+}
+
+TEST(RunReader, FailsWhenRecordsAreMissingFromASegment) {
+    TestDir dir;
+    std::string path = dir.file("run");
+    ASSERT_TRUE(write_run(path, CompressionCodec::NONE, RECORDS));
+    RunIndex index;
+    ASSERT_TRUE(index.load(RunIndex::path_for(path)));
+    index.segments[0].records++;
+    ASSERT_TRUE(index.save(RunIndex::path_for(path)));
+
+    RunReader reader;
+    ASSERT_TRUE(reader.open(path, 0));
+    EXPECT_EQ(read_all(reader).size(), 3u);
+    EXPECT_TRUE(reader.failed());
+}
+
+TEST(RunReader, DoesNotFailAtTheEndOfAGoodRun) {
+    TestDir dir;
+    std::string path = dir.file("run");
+    ASSERT_TRUE(write_run(path, CompressionCodec::NONE, RECORDS));
+
+    RunReader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_EQ(read_all(reader), RECORDS);
+    EXPECT_FALSE(reader.failed());
+}
+
+TEST(RunMerger, ReportsAFailedSource) {
+    TestDir dir;
+    ASSERT_TRUE(write_run(dir.file("good"), CompressionCodec::NONE, RECORDS));
+    ASSERT_TRUE(write_run(dir.file("bad"), CompressionCodec::NONE, RECORDS));
+    RunIndex index;
+    ASSERT_TRUE(index.load(RunIndex::path_for(dir.file("bad"))));
+    index.segments[0].records--;
+    ASSERT_TRUE(index.save(RunIndex::path_for(dir.file("bad"))));
+
+    RunMerger merger;
+    for (const auto& name : {"good", "bad"}) {
+        auto reader = std::make_unique<RunReader>();
+        ASSERT_TRUE(reader->open(dir.file(name)));
+        merger.add_source(std::move(reader));
+    }
+    ShuffleRecord record;
+    size_t merged = 0;
+    while (merger.next(record)) {
+        merged++;
+    }
+    EXPECT_TRUE(merger.failed());
+    EXPECT_LT(merged, 2 * RECORDS.size());
+}
+
+TEST(PartitionForKey, IsStableAndInRange) {
+    for (const std::string key : {"", "a", "some longer key"}) {
+        uint32_t partition = partition_for_key(key, 7);
+        EXPECT_LT(partition, 7u);
+        EXPECT_EQ(partition, partition_for_key(key, 7));
+    }
+    EXPECT_EQ(partition_for_key("anything", 1), 0u);
+}
@@ -0,0 +1,82 @@
+#include "../src/coordinator/speculation.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace daf;
+
+namespace {
+
+constexpr int64_t NOW = 10000;
+
+TaskTiming finished(const std::string& id, int64_t runtime) {
+    TaskTiming timing;
+    timing.task_id = id;
+    timing.started_at = NOW - 1000;
+    timing.runtime_seconds = runtime;
+    return timing;
+}
+
+TaskTiming running(const std::string& id, int64_t seconds, bool has_backup = false) {
+    TaskTiming timing;
+    timing.task_id = id;
+    timing.started_at = NOW - seconds;
+    timing.has_backup = has_backup;
+    return timing;
+}
+
+SpeculationPolicy policy_with(double slowdown, int64_t min_runtime, double min_completed) {
+    SpeculationPolicy policy;
+    policy.slowdown = slowdown;
+    policy.min_runtime_seconds = min_runtime;
+    policy.min_completed = min_completed;
+    return policy;
+}
+
+} // namespace
+
+TEST(Speculation, PolicyReadsJobParameters) {
+    auto policy = SpeculationPolicy::FromParameters({{"speculative", "false"},
+                                                     {"speculative_slowdown", "0.5"},
+                                                     {"speculative_min_runtime_s", "-3"},
+                                                     {"speculative_min_completed", "2"}});
+    EXPECT_FALSE(policy.enabled);
+    EXPECT_EQ(policy.slowdown, 1.0);         // Never below the median
+    EXPECT_EQ(policy.min_runtime_seconds, 0);
+    EXPECT_EQ(policy.min_completed, 1.0);
+
+    auto defaults = SpeculationPolicy::FromParameters({{"speculative_slowdown", ""}});
+    EXPECT_TRUE(defaults.enabled);
+    EXPECT_EQ(defaults.slowdown, SpeculationPolicy{}.slowdown);
+}
+
+TEST(Speculation, FlagsTasksPastSlowdownTimesTheMedian) {
+    std::vector<TaskTiming> tasks = {
+        finished("a", 100), finished("b", 120), finished("c", 110),
+        running("slow", 200), running("fine", 150), running("queued", 0),
+    };
+    tasks.back().started_at = 0;
+
+    auto stragglers = FindStragglers(tasks, policy_with(1.5, 30, 0.25), NOW);
+    EXPECT_EQ(stragglers, std::vector<std::string>{"slow"});   // 200 s > 1.5 * 110 s
+}
+
+TEST(Speculation, WaitsForEnoughFinishedTasks) {
+    std::vector<TaskTiming> tasks = {finished("a", 10), running("b", 500), running("c", 500), running("d", 500)};
+    EXPECT_TRUE(FindStragglers(tasks, policy_with(1.5, 30, 0.5), NOW).empty());
+    EXPECT_EQ(FindStragglers(tasks, policy_with(1.5, 30, 0.25), NOW).size(), 3u);
+}
+
+TEST(Speculation, HonoursMinimumRuntimeAndExistingBackups) {
+    std::vector<TaskTiming> tasks = {finished("a", 1), finished("b", 1), running("short", 20),
+                                     running("backed_up", 500, true), running("long", 40)};
+    EXPECT_EQ(FindStragglers(tasks, policy_with(1.5, 30, 0.25), NOW), std::vector<std::string>{"long"});
+}
+
+TEST(Speculation, DisabledPolicyFindsNothing) {
+    std::vector<TaskTiming> tasks = {finished("a", 1), running("b", 1000)};
+    SpeculationPolicy policy = policy_with(1.5, 0, 0);
+    policy.enabled = false;
+    EXPECT_TRUE(FindStragglers(tasks, policy, NOW).empty());
+    EXPECT_TRUE(FindStragglers({}, policy_with(1.5, 0, 0), NOW).empty());
+}
@@ -0,0 +1,139 @@
+#include "../src/common/input_split.h"
+#include "../src/common/split_planner.h"
+#include "test_dir.h"
+#include <gtest/gtest.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace daf;
+
+namespace {
+
+void write_file(const std::string& path, uint64_t size) {
+    std::ofstream out(path, std::ios::binary);
+    out << std::string(static_cast<size_t>(size), 'x');
+}
+
+JobConfig job_with(const std::vector<std::string>& inputs, int map_tasks = 0, int reduce_tasks = 0) {
+    JobConfig config;
+    config.input_files = inputs;
+    config.num_map_tasks = map_tasks;
+    config.num_reduce_tasks = reduce_tasks;
+    return config;
+}
+
+} // namespace
+
+TEST(InputSplit, ParsesBothForms) {
+    InputSplit whole = InputSplit::parse("/data/in.txt");
+    EXPECT_TRUE(whole.is_whole_file());
+    EXPECT_EQ(whole.to_string(), "/data/in.txt");
+
+    InputSplit range = InputSplit::parse("/data/in.txt@100+50");
+    EXPECT_EQ(range.path, "/data/in.txt");
+    EXPECT_EQ(range.offset, 100u);
+    EXPECT_EQ(range.length, 50u);
+    EXPECT_EQ(range.end(), 150u);
+    EXPECT_EQ(InputSplit::parse(range.to_string()).to_string(), "/data/in.txt@100+50");
+}
+
+TEST(InputSplit, KeepsInvalidSuffixInPath) {
+    EXPECT_EQ(InputSplit::parse("/data/a@b+c").path, "/data/a@b+c");
+    EXPECT_EQ(InputSplit::parse("/data/a@1").path, "/data/a@1");
+    EXPECT_TRUE(InputSplit::parse("/data/a@-1+2").is_whole_file());
+}
+
+TEST(CutInputSplit, CoversTheRangeExactlyOnce) {
+    TestDir dir;
+    std::string path = dir.file("input");
+    write_file(path, 1000);
+
+    auto pieces = cut_input_split(InputSplit::parse(path), 300);
+    ASSERT_EQ(pieces.size(), 4u);
+    uint64_t next = 0;
+    for (const auto& piece : pieces) {
+        EXPECT_EQ(piece.offset, next);
+        EXPECT_LE(piece.length, 300u);
+        next = piece.end();
+    }
+    EXPECT_EQ(next, 1000u);
+
+    // A range is cut within its own bounds only
+    auto ranged = cut_input_split(InputSplit::parse(path + "@250+500"), 200);
+    ASSERT_EQ(ranged.size(), 3u);
+    EXPECT_EQ(ranged.front().offset, 250u);
+    EXPECT_EQ(ranged.back().end(), 750u);
+}
+
+TEST(CutInputSplit, LeavesSmallAndUnreadableSplitsAlone) {
+    TestDir dir;
+    std::string path = dir.file("input");
+    write_file(path, 100);
+
+    EXPECT_EQ(cut_input_split(InputSplit::parse(path), 100).size(), 1u);
+    EXPECT_EQ(cut_input_split(InputSplit::parse(path), 0).size(), 1u);
+    auto missing = cut_input_split(InputSplit::parse(dir.file("missing")), 10);
+    ASSERT_EQ(missing.size(), 1u);
+    EXPECT_TRUE(missing.front().is_whole_file());
+}
+
+TEST(SplitPlanner, SplitTargetFollowsTheTaskCount) {
+    EXPECT_EQ(map_split_target(123, 0), DEFAULT_MAP_SPLIT_SIZE);
+    EXPECT_EQ(map_split_target(1, 4), DEFAULT_BUFFER_SIZE);
+    EXPECT_EQ(map_split_target(10 * DEFAULT_BUFFER_SIZE, 2), 5 * DEFAULT_BUFFER_SIZE);
+    EXPECT_EQ(map_split_target(10 * DEFAULT_BUFFER_SIZE + 1, 2), 6 * DEFAULT_BUFFER_SIZE);
+}
+
+TEST(SplitPlanner, ReducersDefaultToOnePerWorker) {
+    EXPECT_EQ(plan_reduce_tasks(5, 3), 5u);
+    EXPECT_EQ(plan_reduce_tasks(0, 3), 3u);
+    EXPECT_EQ(plan_reduce_tasks(0, 0), 1u);
+}
+
+TEST(SplitPlanner, PacksSmallFilesAndFansOutLargeOnes) {
+    TestDir dir;
+    std::vector<std::string> inputs;
+    for (int i = 0; i < 4; ++i) {
+        inputs.push_back(dir.file("small" + std::to_string(i)));
+        write_file(inputs.back(), 1000);
+    }
+    inputs.push_back(dir.file("large"));
+    write_file(inputs.back(), 3 * DEFAULT_BUFFER_SIZE);
+
+    // Four tasks: a one-buffer target, so the small files share a task
+    // and each buffer-sized piece of the large file gets its own
+    JobPlan plan = plan_job(job_with(inputs, 4, 2), 8);
+    EXPECT_EQ(plan.num_reduce_tasks, 2u);
+    EXPECT_EQ(plan.total_bytes, 4000u + 3 * DEFAULT_BUFFER_SIZE);
+    EXPECT_TRUE(plan.unreadable_inputs.empty());
+
+    uint64_t planned = 0;
+    for (const auto& task : plan.map_tasks) {
+        uint64_t task_bytes = 0;
+        for (const auto& split : task) {
+            task_bytes += split_size_bytes(split);
+        }
+        EXPECT_LE(task_bytes, DEFAULT_BUFFER_SIZE + 4000u);
+        planned += task_bytes;
+    }
+    EXPECT_EQ(planned, plan.total_bytes);
+    ASSERT_EQ(plan.map_tasks.size(), 4u);
+    EXPECT_EQ(plan.map_tasks.front().size(), 4u);
+    for (size_t i = 1; i < plan.map_tasks.size(); ++i) {
+        ASSERT_EQ(plan.map_tasks[i].size(), 1u);
+        EXPECT_EQ(plan.map_tasks[i].front().path, inputs.back());
+    }
+}
+
+TEST(SplitPlanner, ReportsUnreadableInputs) {
+    TestDir dir;
+    std::string present = dir.file("present");
+    write_file(present, 10);
+
+    JobPlan plan = plan_job(job_with({present, dir.file("missing")}), 1);
+    ASSERT_EQ(plan.unreadable_inputs.size(), 1u);
+    EXPECT_EQ(plan.unreadable_inputs.front(), dir.file("missing"));
+    ASSERT_EQ(plan.map_tasks.size(), 1u);
+    EXPECT_EQ(plan.total_bytes, 10u);
+}
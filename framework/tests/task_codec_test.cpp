@@ -0,0 +1,87 @@
+#include "../src/common/task_codec.h"
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace daf;
+
+namespace {
+
+Task sample_task() {
+    Task task;
+    task.id = "job_1_map_3";
+    task.type = TaskType::REDUCE;
+    task.status = TaskStatus::PENDING;
+    task.plugin_name = "nerf_avatar";
+    task.input_files = {"/data/a.dafs@0+4096", "/data/b.txt", ""};
+    task.output_file = "/out/part-3";
+    task.parameters = {{"num_reduce_tasks", "4"},
+                       {"multi\nline", "back\\slash"},
+                       {"binary", std::string("\0\x80\xff", 3)}};
+    task.created_time = -1234567890123;
+    task.started_time = 0;
+    task.completed_time = 0;
+    return task;
+}
+
+void expect_same_task(const Task& actual, const Task& expected) {
+    EXPECT_EQ(actual.id, expected.id);
+    EXPECT_EQ(actual.type, expected.type);
+    EXPECT_EQ(actual.plugin_name, expected.plugin_name);
+    EXPECT_EQ(actual.input_files, expected.input_files);
+    EXPECT_EQ(actual.output_file, expected.output_file);
+    EXPECT_EQ(actual.parameters, expected.parameters);
+    EXPECT_EQ(actual.created_time, expected.created_time);
+}
+
+} // namespace
+
+TEST(TaskCodec, BinaryRoundTrip) {
+    Task task = sample_task();
+    std::string encoded = encode_task(task);
+    ASSERT_GE(encoded.size(), sizeof(TASK_CODEC_MAGIC) + 1);
+    EXPECT_EQ(encoded.compare(0, sizeof(TASK_CODEC_MAGIC), TASK_CODEC_MAGIC, sizeof(TASK_CODEC_MAGIC)), 0);
+
+    Task decoded;
+    ASSERT_TRUE(decode_task(encoded, decoded));
+    expect_same_task(decoded, task);
+    EXPECT_EQ(decoded.status, TaskStatus::PENDING);
+}
+
+TEST(TaskCodec, DecodingResetsThePreviousTask) {
+    Task minimal;
+    minimal.id = "t";
+    minimal.type = TaskType::MAP;
+    minimal.created_time = 0;
+
+    Task decoded = sample_task();
+    ASSERT_TRUE(decode_task(encode_task(minimal), decoded));
+    EXPECT_EQ(decoded.id, "t");
+    EXPECT_TRUE(decoded.input_files.empty());
+    EXPECT_TRUE(decoded.parameters.empty());
+    EXPECT_TRUE(decoded.plugin_name.empty());
+}
+
+TEST(TaskCodec, SkipsFieldsAppendedByLaterRevisions) {
+    Task task = sample_task();
+    Task decoded;
+    ASSERT_TRUE(decode_task(encode_task(task) + std::string("\x05later", 6), decoded));
+    expect_same_task(decoded, task);
+}
+
+TEST(TaskCodec, RejectsTruncatedAndInvalidData) {
+    std::string encoded = encode_task(sample_task());
+    Task decoded;
+    for (size_t size = 0; size < encoded.size(); size += 7) {
+        EXPECT_FALSE(decode_task(std::string_view(encoded).substr(0, size), decoded)) << "size " << size;
+    }
+
+    std::string newer = encoded;
+    newer[sizeof(TASK_CODEC_MAGIC)] = static_cast<char>(TASK_CODEC_VERSION + 1);
+    EXPECT_FALSE(decode_task(newer, decoded));
+
+    Task no_id = sample_task();
+    no_id.id.clear();
+    EXPECT_FALSE(decode_task(encode_task(no_id), decoded));
+
+    EXPECT_FALSE(decode_task("id=x\ntype=1\n", decoded));   // Not an encoded task
+}
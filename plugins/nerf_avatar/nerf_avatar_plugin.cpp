@@ -1,10 +1,16 @@
 #include "../../src/common/daf_types.h"
 #include "../../src/common/daf_utils.h"
 #include "../../src/common/plugin_loader.h"
+#include "nerf_kernel.h"
+#include "nerf_octree.h"
+#include "nerf_voxel.h"
 #include <iostream>
 #include <sstream>
 #include <cmath>
 #include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <string_view>
 
 #ifdef min
 #undef min
@@ -16,6 +22,380 @@
 // NeRF Avatar Plugin for MapReduce Framework
 // This plugin processes 3D avatar data using NeRF (Neural Radiance Fields)
 
+namespace {
+
+std::string partition_name(int grid_x, int grid_y, int grid_z) {
+    return "partition_" + std::to_string(grid_x) + "_" + 
+           std::to_string(grid_y) + "_" + std::to_string(grid_z);
+}
+
+// Emits one evaluated sample to its spatial partition
+void emit_sample(daf::MapContext* context, float x, float y, float z,
+                 float r, float g, float b, float alpha,
+                 int grid_x, int grid_y, int grid_z) {
+    std::string key = partition_name(grid_x, grid_y, grid_z);
+    
+    // Create output value
+    std::stringstream output;
+    output << x << "," << y << "," << z << "," 
+           << r << "," << g << "," << b << "," << alpha;
+    
+    context->emit(key, output.str());
+}
+
+// Parses up to max_values comma separated floats without allocating; invalid
+// fields are skipped like the stringstream parser did
+size_t parse_floats(std::string_view line, float* values, size_t max_values) {
+    size_t parsed = 0;
+    const char* cursor = line.data();
+    const char* end = line.data() + line.size();
+    
+    while (parsed < max_values) {
+        const char* comma = std::find(cursor, end, ',');
+        const char* field = cursor;
+        while (field < comma && (*field == ' ' || *field == '\t')) {
+            ++field; // std::stof tolerated leading whitespace
+        }
+        if (field < comma && *field == '+') {
+            ++field;
+        }
+        
+        float value;
+        auto result = std::from_chars(field, comma, value);
+        if (result.ec == std::errc() && result.ptr != field) {
+            values[parsed++] = value;
+        }
+        if (comma == end) {
+            break;
+        }
+        cursor = comma + 1;
+    }
+    
+    return parsed;
+}
+
+// Parses "x,y,z,r,g,b,density"
+bool parse_sample_line(std::string_view line, float (&values)[7]) {
+    return parse_floats(line, values, 7) == 7;
+}
+
+// Commutative per-partition aggregate. CombineMain ships it between stages as
+// a "PARTIAL,..." value; ReduceMain accepts both partials and raw samples.
+constexpr std::string_view PARTIAL_PREFIX = "PARTIAL,";
+
+struct PartitionAggregate {
+    float total_r = 0.0f, total_g = 0.0f, total_b = 0.0f, total_alpha = 0.0f;
+    int64_t count = 0;
+    
+    float min_x = 1e6f, max_x = -1e6f;
+    float min_y = 1e6f, max_y = -1e6f;
+    float min_z = 1e6f, max_z = -1e6f;
+    
+    void add_sample(float x, float y, float z, float r, float g, float b, float alpha) {
+        // Update bounding box
+        min_x = std::min(min_x, x); max_x = std::max(max_x, x);
+        min_y = std::min(min_y, y); max_y = std::max(max_y, y);
+        min_z = std::min(min_z, z); max_z = std::max(max_z, z);
+        
+        // Accumulate color and alpha values
+        total_r += r * alpha;
+        total_g += g * alpha;
+        total_b += b * alpha;
+        total_alpha += alpha;
+        count++;
+    }
+    
+    void merge(const PartitionAggregate& other) {
+        min_x = std::min(min_x, other.min_x); max_x = std::max(max_x, other.max_x);
+        min_y = std::min(min_y, other.min_y); max_y = std::max(max_y, other.max_y);
+        min_z = std::min(min_z, other.min_z); max_z = std::max(max_z, other.max_z);
+        
+        total_r += other.total_r;
+        total_g += other.total_g;
+        total_b += other.total_b;
+        total_alpha += other.total_alpha;
+        count += other.count;
+    }
+    
+    // Adds one binary value: a VoxelSample or a VoxelPartial, told apart by size
+    bool add_binary_value(std::string_view value) {
+        if (value.size() == sizeof(nerf_avatar::VoxelSample)) {
+            nerf_avatar::VoxelSample sample;
+            std::memcpy(&sample, value.data(), sizeof(sample));
+            add_sample(sample.x, sample.y, sample.z, sample.r, sample.g, sample.b, sample.alpha);
+            return true;
+        }
+        if (value.size() == sizeof(nerf_avatar::VoxelPartial)) {
+            nerf_avatar::VoxelPartial wire;
+            std::memcpy(&wire, value.data(), sizeof(wire));
+            
+            PartitionAggregate partial;
+            partial.count = static_cast<int64_t>(wire.count);
+            partial.total_r = wire.total_r; partial.total_g = wire.total_g;
+            partial.total_b = wire.total_b; partial.total_alpha = wire.total_alpha;
+            partial.min_x = wire.min_x; partial.max_x = wire.max_x;
+            partial.min_y = wire.min_y; partial.max_y = wire.max_y;
+            partial.min_z = wire.min_z; partial.max_z = wire.max_z;
+            merge(partial);
+            return true;
+        }
+        return false;
+    }
+    
+    nerf_avatar::VoxelPartial to_binary_partial() const {
+        return nerf_avatar::VoxelPartial{static_cast<uint64_t>(count),
+                                         total_r, total_g, total_b, total_alpha,
+                                         min_x, max_x, min_y, max_y, min_z, max_z};
+    }
+    
+    // Adds one shuffled value: a raw "x,y,z,r,g,b,alpha" sample or a partial
+    bool add_value(std::string_view value) {
+        if (value.substr(0, PARTIAL_PREFIX.size()) == PARTIAL_PREFIX) {
+            value.remove_prefix(PARTIAL_PREFIX.size());
+            
+            PartitionAggregate partial;
+            auto result = std::from_chars(value.data(), value.data() + value.size(), partial.count);
+            if (result.ec != std::errc() || result.ptr == value.data() + value.size()) {
+                return false;
+            }
+            value.remove_prefix(result.ptr - value.data() + 1);
+            
+            float fields[10];
+            if (parse_floats(value, fields, 10) != 10) {
+                return false;
+            }
+            partial.total_r = fields[0]; partial.total_g = fields[1];
+            partial.total_b = fields[2]; partial.total_alpha = fields[3];
+            partial.min_x = fields[4]; partial.max_x = fields[5];
+            partial.min_y = fields[6]; partial.max_y = fields[7];
+            partial.min_z = fields[8]; partial.max_z = fields[9];
+            merge(partial);
+            return true;
+        }
+        
+        float vals[7];
+        if (!parse_sample_line(value, vals)) {
+            return false;
+        }
+        add_sample(vals[0], vals[1], vals[2], vals[3], vals[4], vals[5], vals[6]);
+        return true;
+    }
+    
+    // Shortest round-trip formatting so partial sums lose no precision
+    std::string to_partial() const {
+        char buffer[512];
+        char* cursor = buffer;
+        char* end = buffer + sizeof(buffer);
+        
+        std::memcpy(cursor, PARTIAL_PREFIX.data(), PARTIAL_PREFIX.size());
+        cursor += PARTIAL_PREFIX.size();
+        cursor = std::to_chars(cursor, end, count).ptr;
+        
+        const float fields[10] = {total_r, total_g, total_b, total_alpha,
+                                  min_x, max_x, min_y, max_y, min_z, max_z};
+        for (float field : fields) {
+            *cursor++ = ',';
+            cursor = std::to_chars(cursor, end, field).ptr;
+        }
+        
+        return std::string(buffer, cursor);
+    }
+};
+
+// Occupied voxels of one brick, from BrickSamples and brick partials
+class BrickAggregate {
+public:
+    BrickAggregate() : voxels_(nerf_avatar::BRICK_VOXELS) {}
+    
+    bool add_value(std::string_view value) {
+        if (value.size() == sizeof(nerf_avatar::BrickSample)) {
+            nerf_avatar::BrickSample sample;
+            std::memcpy(&sample, value.data(), sizeof(sample));
+            if (sample.voxel >= nerf_avatar::BRICK_VOXELS) {
+                return false;
+            }
+            const nerf_avatar::VoxelSample& s = sample.sample;
+            voxels_[sample.voxel].add_sample(s.x, s.y, s.z, s.r, s.g, s.b, s.alpha);
+            return true;
+        }
+        if (value.empty() || value.size() % sizeof(nerf_avatar::BrickVoxel) != 0) {
+            return false;
+        }
+        for (size_t offset = 0; offset < value.size(); offset += sizeof(nerf_avatar::BrickVoxel)) {
+            nerf_avatar::BrickVoxel voxel;
+            std::memcpy(&voxel, value.data() + offset, sizeof(voxel));
+            if (voxel.voxel >= nerf_avatar::BRICK_VOXELS) {
+                return false;
+            }
+            voxels_[voxel.voxel].add_binary_value(std::string_view(
+                reinterpret_cast<const char*>(&voxel.partial), sizeof(voxel.partial)));
+        }
+        return true;
+    }
+    
+    // Sorted by voxel
+    std::vector<nerf_avatar::BrickVoxel> occupied() const {
+        std::vector<nerf_avatar::BrickVoxel> voxels;
+        for (uint32_t v = 0; v < nerf_avatar::BRICK_VOXELS; ++v) {
+            if (voxels_[v].count > 0) {
+                voxels.push_back(nerf_avatar::BrickVoxel{voxels_[v].to_binary_partial(), v, 0});
+            }
+        }
+        return voxels;
+    }
+    
+private:
+    std::vector<PartitionAggregate> voxels_;
+};
+
+// Parameter resolution: voxels per axis, a power of two from one brick up
+// to the Morton code range
+int grid_resolution(const std::string& parameter) {
+    if (parameter.empty()) {
+        return nerf_avatar::GRID_RESOLUTION;
+    }
+    int resolution = 0;
+    auto result = std::from_chars(parameter.data(), parameter.data() + parameter.size(), resolution);
+    bool power_of_two = result.ec == std::errc() && resolution > 0 && (resolution & (resolution - 1)) == 0;
+    if (!power_of_two || resolution < (1 << nerf_avatar::BRICK_AXIS_BITS) ||
+        resolution > (1 << nerf_avatar::OCTREE_MAX_GRID_BITS)) {
+        daf::Logger::warning("Invalid resolution '" + parameter + "', using " +
+                             std::to_string(nerf_avatar::GRID_RESOLUTION));
+        return nerf_avatar::GRID_RESOLUTION;
+    }
+    return resolution;
+}
+
+uint32_t grid_bits_for(int resolution) {
+    uint32_t bits = 0;
+    while ((1 << bits) < resolution) {
+        bits++;
+    }
+    return bits;
+}
+
+// How map output is keyed: readable partition names, voxel Morton codes,
+// or brick Morton codes for the octree output
+enum class KeyMode {
+    TEXT,
+    VOXEL,
+    BRICK
+};
+
+// Memory management - check usage every 1000 items
+void report_progress(daf::MapContext* context, int processed_items) {
+    if (processed_items % 1000 != 0) {
+        return;
+    }
+    
+    size_t memory_usage = context->get_memory_usage();
+    size_t memory_limit = context->get_memory_limit();
+    
+    if (memory_usage > memory_limit * 0.8) { // 80% threshold
+        daf::Logger::warning("High memory usage: " + std::to_string(memory_usage) + 
+                            "MB / " + std::to_string(memory_limit) + "MB");
+    }
+    
+    context->set_status("Processed " + std::to_string(processed_items) + " items");
+}
+
+// Runs the batched NeRF kernel over sample blocks and emits the results.
+// Text samples are staged into the same column layout first.
+class SampleProcessor {
+public:
+    SampleProcessor(daf::MapContext* context, nerf_avatar::KernelIsa isa, int resolution, KeyMode key_mode)
+        : context_(context), isa_(isa), resolution_(resolution), key_mode_(key_mode) {}
+    
+    void process(const daf::SampleBatch& batch) {
+        if (alpha_.size() < batch.count) {
+            alpha_.resize(batch.count);
+            grid_x_.resize(batch.count);
+            grid_y_.resize(batch.count);
+            grid_z_.resize(batch.count);
+        }
+        
+        nerf_avatar::SampleResults results{alpha_.data(), grid_x_.data(), grid_y_.data(), grid_z_.data()};
+        nerf_avatar::evaluate_samples(isa_, batch, resolution_, results);
+        
+        for (size_t i = 0; i < batch.count; ++i) {
+            // Samples outside the grid belong to no voxel
+            if (grid_x_[i] == nerf_avatar::OUT_OF_GRID || grid_y_[i] == nerf_avatar::OUT_OF_GRID ||
+                grid_z_[i] == nerf_avatar::OUT_OF_GRID) {
+                outside_grid_++;
+                continue;
+            }
+            if (key_mode_ != KeyMode::TEXT) {
+                nerf_avatar::VoxelSample sample{batch.x[i], batch.y[i], batch.z[i],
+                                                batch.r[i], batch.g[i], batch.b[i], alpha_[i]};
+                uint64_t voxel_code = nerf_avatar::morton_encode(grid_x_[i], grid_y_[i], grid_z_[i]);
+                if (key_mode_ == KeyMode::BRICK) {
+                    nerf_avatar::BrickSample brick_sample{sample, nerf_avatar::brick_voxel(voxel_code)};
+                    context_->emit_binary(nerf_avatar::brick_key(voxel_code), &brick_sample, sizeof(brick_sample));
+                } else {
+                    context_->emit_binary(voxel_code, &sample, sizeof(sample));
+                }
+            } else {
+                emit_sample(context_, batch.x[i], batch.y[i], batch.z[i],
+                            batch.r[i], batch.g[i], batch.b[i], alpha_[i],
+                            grid_x_[i], grid_y_[i], grid_z_[i]);
+            }
+            report_progress(context_, ++processed_items_);
+        }
+    }
+    
+    void stage(const float (&values)[7]) {
+        if (staged_ == 0) {
+            staging_.resize(static_cast<size_t>(daf::SAMPLE_CHANNELS) * daf::DEFAULT_SAMPLE_BLOCK_CAPACITY);
+        }
+        for (size_t c = 0; c < daf::SAMPLE_CHANNELS; ++c) {
+            staging_[c * daf::DEFAULT_SAMPLE_BLOCK_CAPACITY + staged_] = values[c];
+        }
+        if (++staged_ == daf::DEFAULT_SAMPLE_BLOCK_CAPACITY) {
+            flush();
+        }
+    }
+    
+    void flush() {
+        if (staged_ == 0) {
+            return;
+        }
+        
+        const float* columns = staging_.data();
+        const size_t capacity = daf::DEFAULT_SAMPLE_BLOCK_CAPACITY;
+        daf::SampleBatch batch;
+        batch.count = staged_;
+        batch.x = columns;
+        batch.y = columns + capacity;
+        batch.z = columns + 2 * capacity;
+        batch.r = columns + 3 * capacity;
+        batch.g = columns + 4 * capacity;
+        batch.b = columns + 5 * capacity;
+        batch.density = columns + 6 * capacity;
+        
+        staged_ = 0;
+        process(batch);
+    }
+    
+    int processed_items() const { return processed_items_; }
+    int outside_grid() const { return outside_grid_; }
+    
+private:
+    daf::MapContext* context_;
+    nerf_avatar::KernelIsa isa_;
+    int resolution_;
+    KeyMode key_mode_;
+    int processed_items_ = 0;
+    int outside_grid_ = 0;
+    
+    std::vector<float> alpha_;
+    std::vector<int32_t> grid_x_, grid_y_, grid_z_;
+    
+    std::vector<float> staging_;
+    size_t staged_ = 0;
+};
+
+} // namespace
+
 extern "C" {
 
 // Map function: Process input data chunks
@@ -26,148 +406,173 @@ DAF_EXPORT void DAF_API_CALL MapMain(daf::MapContext* context) {
     
     daf::Logger::info("NeRF Avatar Map task started");
     
-    int processed_items = 0;
-    std::string resolution = context->get_parameter("resolution");
-    std::string samples = context->get_parameter("samples");
+    int resolution = grid_resolution(context->get_parameter("resolution"));
+    
+    // Widest SIMD path this CPU supports, unless the job pins one
+    nerf_avatar::KernelIsa isa = nerf_avatar::best_kernel_isa();
+    std::string kernel = context->get_parameter("nerf_kernel");
+    if (!kernel.empty()) {
+        nerf_avatar::KernelIsa requested;
+        if (nerf_avatar::parse_kernel_isa(kernel, requested) && nerf_avatar::kernel_isa_available(requested)) {
+            isa = requested;
+        } else {
+            daf::Logger::warning("NeRF kernel '" + kernel + "' not available, using " +
+                                 nerf_avatar::kernel_isa_name(isa));
+        }
+    }
+    daf::Logger::info(std::string("NeRF sample kernel: ") + nerf_avatar::kernel_isa_name(isa));
+    
+    // Morton keys and POD values by default; key_format=text keeps the
+    // readable "partition_x_y_z" keys and CSV values. The octree output
+    // shuffles whole bricks.
+    KeyMode key_mode = context->get_parameter("key_format") == "text" ? KeyMode::TEXT : KeyMode::VOXEL;
+    if (context->get_parameter("output_format") == "octree") {
+        if (key_mode == KeyMode::TEXT) {
+            daf::Logger::warning("output_format=octree needs binary keys, writing flat voxels");
+        } else {
+            key_mode = KeyMode::BRICK;
+        }
+    }
     
-    int res = resolution.empty() ? 512 : std::stoi(resolution);
-    int smp = samples.empty() ? 64 : std::stoi(samples);
+    SampleProcessor processor(context, isa, resolution, key_mode);
     
-    // Process input data
-    while (context->has_more_input()) {
-        std::string input_line = context->read_input();
-        
+    // Binary sample input: columns arrive ready to use, no parsing
+    daf::SampleBatch batch;
+    while (context->read_samples(batch)) {
+        processor.process(batch);
+    }
+    
+    // Text input, parsed in place from zero-copy records
+    std::string_view input_line;
+    while (context->read_record(input_line)) {
         if (input_line.empty()) {
             continue;
         }
         
         // Parse input (format: "x,y,z,r,g,b,density")
-        std::stringstream ss(input_line);
-        std::string token;
-        std::vector<float> values;
-        
-        while (std::getline(ss, token, ',')) {
-            try {
-                values.push_back(std::stof(token));
-            } catch (const std::exception&) {
-                continue; // Skip invalid data
-            }
-        }
-        
-        if (values.size() >= 7) {
-            float x = values[0], y = values[1], z = values[2];
-            float r = values[3], g = values[4], b = values[5];
-            float density = values[6];
-            
-            // Production NeRF processing: Advanced volumetric rendering
-            float distance = std::sqrt(x*x + y*y + z*z);
-            
-            // Production neural network approximation with multi-layer processing
-            // Layer 1: Positional encoding
-            float pos_encoding = std::sin(distance * 15.0f) * 0.5f + 0.5f;
-            
-            // Layer 2: Density prediction with non-linear activation
-            float base_density = density * std::tanh(distance * 0.2f);
-            
-            // Layer 3: View-dependent effects
-            float view_dependency = std::cos(distance * 8.0f) * 0.3f + 0.7f;
-            
-            // Layer 4: Final alpha composition
-            float alpha = base_density * view_dependency * pos_encoding;
-            alpha = 1.0f - std::exp(-alpha * 2.0f); // Exponential falloff
-            alpha = std::min(1.0f, std::max(0.0f, alpha));
-            
-            // Production spatial partitioning with hierarchical octree structure
-            int resolution = 128; // High-resolution grid
-            int grid_x = static_cast<int>((x + 1.0f) * 0.5f * resolution) % resolution;
-            int grid_y = static_cast<int>((y + 1.0f) * 0.5f * resolution) % resolution;
-            int grid_z = static_cast<int>((z + 1.0f) * 0.5f * resolution) % resolution;
-            
-            std::string key = "partition_" + std::to_string(grid_x) + "_" + 
-                             std::to_string(grid_y) + "_" + std::to_string(grid_z);
-            
-            // Create output value
-            std::stringstream output;
-            output << x << "," << y << "," << z << "," 
-                   << r << "," << g << "," << b << "," << alpha;
-            
-            context->emit(key, output.str());
-            processed_items++;
-            
-            // Memory management - check usage every 1000 items
-            if (processed_items % 1000 == 0) {
-                size_t memory_usage = context->get_memory_usage();
-                size_t memory_limit = context->get_memory_limit();
-                
-                if (memory_usage > memory_limit * 0.8) { // 80% threshold
-                    daf::Logger::warning("High memory usage: " + std::to_string(memory_usage) + 
-                                        "MB / " + std::to_string(memory_limit) + "MB");
-                }
-                
-                context->set_status("Processed " + std::to_string(processed_items) + " items");
-            }
+        float values[7];
+        if (parse_sample_line(input_line, values)) {
+            processor.stage(values);
         }
     }
+    processor.flush();
     
     daf::Logger::info("NeRF Avatar Map task completed. Processed " + 
-                     std::to_string(processed_items) + " items");
+                     std::to_string(processor.processed_items()) + " items, " +
+                     std::to_string(processor.outside_grid()) + " outside the grid");
 }
 
-// Reduce function: Aggregate and render final output
-DAF_EXPORT void DAF_API_CALL ReduceMain(const char* key, daf::ReduceContext* context) {
+// Combine function: collapse a map task's samples into one partial per partition
+DAF_EXPORT void DAF_API_CALL CombineMain(const char* key, daf::ReduceContext* context) {
     if (!context || !key) {
         return;
     }
     
-    daf::Logger::info("NeRF Avatar Reduce task started for key: " + std::string(key));
+    uint64_t voxel_key;
+    bool binary = context->get_binary_key(voxel_key);
+    std::string_view value;
     
-    std::vector<std::string> values = context->get_values();
+    // A worker's part of a brick: its occupied voxels in one value
+    if (binary && context->get_parameter("output_format") == "octree") {
+        BrickAggregate brick;
+        while (context->next_value(value)) {
+            brick.add_value(value);
+        }
+        std::vector<nerf_avatar::BrickVoxel> voxels = brick.occupied();
+        if (!voxels.empty()) {
+            context->emit_binary(voxels.data(), voxels.size() * sizeof(nerf_avatar::BrickVoxel));
+        }
+        return;
+    }
     
-    // Aggregate density values for this spatial partition
-    float total_r = 0.0f, total_g = 0.0f, total_b = 0.0f, total_alpha = 0.0f;
-    int count = 0;
+    PartitionAggregate aggregate;
+    while (context->next_value(value)) {
+        if (binary) {
+            aggregate.add_binary_value(value);
+        } else {
+            aggregate.add_value(value);
+        }
+    }
     
-    float min_x = 1e6f, max_x = -1e6f;
-    float min_y = 1e6f, max_y = -1e6f;
-    float min_z = 1e6f, max_z = -1e6f;
+    if (aggregate.count > 0) {
+        if (binary) {
+            nerf_avatar::VoxelPartial partial = aggregate.to_binary_partial();
+            context->emit_binary(&partial, sizeof(partial));
+        } else {
+            context->emit(aggregate.to_partial());
+        }
+    }
+}
+
+// Reduce function: Aggregate and render final output
+DAF_EXPORT void DAF_API_CALL ReduceMain(const char* key, daf::ReduceContext* context) {
+    if (!context || !key) {
+        return;
+    }
     
-    for (const std::string& value : values) {
-        std::stringstream ss(value);
-        std::string token;
-        std::vector<float> vals;
-        
-        while (std::getline(ss, token, ',')) {
-            try {
-                vals.push_back(std::stof(token));
-            } catch (const std::exception&) {
-                continue;
-            }
+    // Binary keys are Morton voxel ids; logs and text output use the readable name
+    uint64_t voxel_key;
+    bool binary = context->get_binary_key(voxel_key);
+    
+    // Octree output: the brick's adaptive subtree as one record, nodes
+    // split while they hold octree_refine_samples samples or more
+    if (binary && context->get_parameter("output_format") == "octree") {
+        BrickAggregate brick;
+        std::string_view value;
+        while (context->next_value(value)) {
+            brick.add_value(value);
+        }
+        std::vector<nerf_avatar::BrickVoxel> voxels = brick.occupied();
+        if (voxels.empty()) {
+            return;
         }
         
-        if (vals.size() >= 7) {
-            float x = vals[0], y = vals[1], z = vals[2];
-            float r = vals[3], g = vals[4], b = vals[5], alpha = vals[6];
-            
-            // Update bounding box
-            min_x = std::min(min_x, x); max_x = std::max(max_x, x);
-            min_y = std::min(min_y, y); max_y = std::max(max_y, y);
-            min_z = std::min(min_z, z); max_z = std::max(max_z, z);
-            
-            // Accumulate color and alpha values
-            total_r += r * alpha;
-            total_g += g * alpha;
-            total_b += b * alpha;
-            total_alpha += alpha;
-            count++;
+        std::string refine = context->get_parameter("octree_refine_samples");
+        uint32_t refine_samples = refine.empty() ? nerf_avatar::OCTREE_REFINE_SAMPLES
+                                                 : static_cast<uint32_t>(std::max(1, std::atoi(refine.c_str())));
+        uint32_t grid_bits = grid_bits_for(grid_resolution(context->get_parameter("resolution")));
+        std::vector<nerf_avatar::OctreeNode> nodes;
+        nerf_avatar::build_brick_subtree(voxels, grid_bits, refine_samples, nodes);
+        
+        nerf_avatar::OctreeBrickRecord header{voxel_key, grid_bits, static_cast<uint32_t>(nodes.size())};
+        std::string record(sizeof(header) + nodes.size() * sizeof(nerf_avatar::OctreeNode), '\0');
+        std::memcpy(&record[0], &header, sizeof(header));
+        std::memcpy(&record[sizeof(header)], nodes.data(), nodes.size() * sizeof(nerf_avatar::OctreeNode));
+        context->emit_binary(record.data(), record.size());
+        
+        context->set_status("Processed brick " + std::to_string(voxel_key) + " with " +
+                           std::to_string(voxels.size()) + " voxels");
+        return;
+    }
+    
+    std::string partition = key;
+    if (binary) {
+        int32_t grid_x, grid_y, grid_z;
+        nerf_avatar::morton_decode(voxel_key, grid_x, grid_y, grid_z);
+        partition = partition_name(grid_x, grid_y, grid_z);
+    }
+    
+    DAF_LOG_DEBUG("NeRF Avatar Reduce task started for key: " + partition);
+    
+    // Aggregate density values for this spatial partition, streaming so hot
+    // voxels never have to fit in memory
+    PartitionAggregate aggregate;
+    std::string_view value;
+    while (context->next_value(value)) {
+        if (binary) {
+            aggregate.add_binary_value(value);
+        } else {
+            aggregate.add_value(value);
         }
     }
     
-    if (count > 0) {
+    if (aggregate.count > 0) {
         // Compute average color with alpha blending
-        float avg_r = total_alpha > 0 ? total_r / total_alpha : 0.0f;
-        float avg_g = total_alpha > 0 ? total_g / total_alpha : 0.0f;
-        float avg_b = total_alpha > 0 ? total_b / total_alpha : 0.0f;
-        float avg_alpha = total_alpha / count;
+        float total_alpha = aggregate.total_alpha;
+        float avg_r = total_alpha > 0 ? aggregate.total_r / total_alpha : 0.0f;
+        float avg_g = total_alpha > 0 ? aggregate.total_g / total_alpha : 0.0f;
+        float avg_b = total_alpha > 0 ? aggregate.total_b / total_alpha : 0.0f;
+        float avg_alpha = total_alpha / aggregate.count;
         
         // Clamp values
         avg_r = std::min(1.0f, std::max(0.0f, avg_r));
@@ -175,20 +580,31 @@ DAF_EXPORT void DAF_API_CALL ReduceMain(const char* key, daf::ReduceContext* con
         avg_b = std::min(1.0f, std::max(0.0f, avg_b));
         avg_alpha = std::min(1.0f, std::max(0.0f, avg_alpha));
         
-        // Generate final output
-        std::stringstream output;
-        output << "NERF_VOXEL," << key << ","
-               << (min_x + max_x) / 2.0f << "," << (min_y + max_y) / 2.0f << "," << (min_z + max_z) / 2.0f << ","
-               << avg_r << "," << avg_g << "," << avg_b << "," << avg_alpha << ","
-               << count;
+        float center_x = (aggregate.min_x + aggregate.max_x) / 2.0f;
+        float center_y = (aggregate.min_y + aggregate.max_y) / 2.0f;
+        float center_z = (aggregate.min_z + aggregate.max_z) / 2.0f;
         
-        context->emit(output.str());
+        if (binary && context->get_parameter("output_format") == "binary") {
+            nerf_avatar::VoxelRecord record{voxel_key, static_cast<uint64_t>(aggregate.count),
+                                            center_x, center_y, center_z,
+                                            avg_r, avg_g, avg_b, avg_alpha, 0};
+            context->emit_binary(&record, sizeof(record));
+        } else {
+            // Generate final output
+            std::stringstream output;
+            output << "NERF_VOXEL," << partition << ","
+                   << center_x << "," << center_y << "," << center_z << ","
+                   << avg_r << "," << avg_g << "," << avg_b << "," << avg_alpha << ","
+                   << aggregate.count;
+            
+            context->emit(output.str());
+        }
         
-        context->set_status("Processed partition " + std::string(key) + " with " + 
-                           std::to_string(count) + " voxels");
+        context->set_status("Processed partition " + partition + " with " + 
+                           std::to_string(aggregate.count) + " voxels");
     }
     
-    daf::Logger::info("NeRF Avatar Reduce task completed for key: " + std::string(key));
+    DAF_LOG_DEBUG("NeRF Avatar Reduce task completed for key: " + partition);
 }
 
 } // extern "C"
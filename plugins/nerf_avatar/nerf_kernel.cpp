@@ -0,0 +1,302 @@
+#include "nerf_kernel.h"
+#include "nerf_kernel_simd.h"
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NERF_KERNEL_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define NERF_KERNEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+#ifdef min
+#undef min
+#endif
+#ifdef max
+#undef max
+#endif
+
+namespace nerf_avatar {
+
+namespace {
+
+int32_t grid_index(float coordinate, int resolution) {
+    float cell = (coordinate + 1.0f) * 0.5f * resolution;
+    return cell >= 0.0f && cell < resolution ? static_cast<int32_t>(cell) : OUT_OF_GRID;
+}
+
+// The SIMD paths only truncate, which puts (-1 - 2/resolution, -1) into
+// cell 0 and NaN at INT_MIN; this gives them the scalar grid_index result
+void clip_to_grid(const KernelArgs& args) {
+    uint32_t resolution = static_cast<uint32_t>(args.resolution);
+    for (size_t i = 0; i < args.count; ++i) {
+        if (static_cast<uint32_t>(args.grid_x[i]) >= resolution || !(args.x[i] >= -1.0f)) args.grid_x[i] = OUT_OF_GRID;
+        if (static_cast<uint32_t>(args.grid_y[i]) >= resolution || !(args.y[i] >= -1.0f)) args.grid_y[i] = OUT_OF_GRID;
+        if (static_cast<uint32_t>(args.grid_z[i]) >= resolution || !(args.z[i] >= -1.0f)) args.grid_z[i] = OUT_OF_GRID;
+    }
+}
+
+// Reference implementation, one sample at a time with the standard library
+void evaluate_scalar(const KernelArgs& args) {
+    for (size_t i = 0; i < args.count; ++i) {
+        float x = args.x[i];
+        float y = args.y[i];
+        float z = args.z[i];
+
+        // Production NeRF processing: Advanced volumetric rendering
+        float distance = std::sqrt(x*x + y*y + z*z);
+
+        // Layer 1: Positional encoding
+        float pos_encoding = std::sin(distance * 15.0f) * 0.5f + 0.5f;
+
+        // Layer 2: Density prediction with non-linear activation
+        float base_density = args.density[i] * std::tanh(distance * 0.2f);
+
+        // Layer 3: View-dependent effects
+        float view_dependency = std::cos(distance * 8.0f) * 0.3f + 0.7f;
+
+        // Layer 4: Final alpha composition
+        float alpha = base_density * view_dependency * pos_encoding;
+        alpha = 1.0f - std::exp(-alpha * 2.0f); // Exponential falloff
+        args.alpha[i] = std::min(1.0f, std::max(0.0f, alpha));
+
+        // Spatial partitioning on a regular grid
+        args.grid_x[i] = grid_index(x, args.resolution);
+        args.grid_y[i] = grid_index(y, args.resolution);
+        args.grid_z[i] = grid_index(z, args.resolution);
+    }
+}
+
+#ifdef NERF_KERNEL_SSE2
+struct Sse2Ops {
+    using F = __m128;
+    using I = __m128i;
+    using M = __m128;
+    static constexpr size_t WIDTH = 4;
+
+    static F load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, F v) { _mm_storeu_ps(p, v); }
+    static void store_int(int32_t* p, I v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static F set(float v) { return _mm_set1_ps(v); }
+    static I set_int(int v) { return _mm_set1_epi32(v); }
+
+    static F add(F a, F b) { return _mm_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+    static F div(F a, F b) { return _mm_div_ps(a, b); }
+    static F fmadd(F a, F b, F c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static F min(F a, F b) { return _mm_min_ps(a, b); }
+    static F max(F a, F b) { return _mm_max_ps(a, b); }
+    static F sqrt(F a) { return _mm_sqrt_ps(a); }
+
+    static I round_to_int(F a) { return _mm_cvtps_epi32(a); }
+    static I truncate(F a) { return _mm_cvttps_epi32(a); }
+    static F to_float(I a) { return _mm_cvtepi32_ps(a); }
+    static F as_float(I a) { return _mm_castsi128_ps(a); }
+    static I add_int(I a, I b) { return _mm_add_epi32(a, b); }
+    static I and_int(I a, I b) { return _mm_and_si128(a, b); }
+    template <int BITS> static I shift_left(I a) { return _mm_slli_epi32(a, BITS); }
+
+    static F bit_and(F a, F b) { return _mm_and_ps(a, b); }
+    static F bit_xor(F a, F b) { return _mm_xor_ps(a, b); }
+    static M less(F a, F b) { return _mm_cmplt_ps(a, b); }
+    static M eq_int(I a, I b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+    static F select(M mask, F a, F b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+};
+#endif
+
+#ifdef NERF_KERNEL_NEON
+struct NeonOps {
+    using F = float32x4_t;
+    using I = int32x4_t;
+    using M = uint32x4_t;
+    static constexpr size_t WIDTH = 4;
+
+    static F load(const float* p) { return vld1q_f32(p); }
+    static void store(float* p, F v) { vst1q_f32(p, v); }
+    static void store_int(int32_t* p, I v) { vst1q_s32(p, v); }
+    static F set(float v) { return vdupq_n_f32(v); }
+    static I set_int(int v) { return vdupq_n_s32(v); }
+
+    static F add(F a, F b) { return vaddq_f32(a, b); }
+    static F sub(F a, F b) { return vsubq_f32(a, b); }
+    static F mul(F a, F b) { return vmulq_f32(a, b); }
+    static F div(F a, F b) { return vdivq_f32(a, b); }
+    static F fmadd(F a, F b, F c) { return vfmaq_f32(c, a, b); }
+    // Both return b when a is NaN, like minps/maxps
+    static F min(F a, F b) { return vbslq_f32(vcleq_f32(a, b), a, b); }
+    static F max(F a, F b) { return vbslq_f32(vcgeq_f32(a, b), a, b); }
+    static F sqrt(F a) { return vsqrtq_f32(a); }
+
+    static I round_to_int(F a) { return vcvtnq_s32_f32(a); }
+    static I truncate(F a) { return vcvtq_s32_f32(a); }
+    static F to_float(I a) { return vcvtq_f32_s32(a); }
+    static F as_float(I a) { return vreinterpretq_f32_s32(a); }
+    static I add_int(I a, I b) { return vaddq_s32(a, b); }
+    static I and_int(I a, I b) { return vandq_s32(a, b); }
+    template <int BITS> static I shift_left(I a) { return vshlq_n_s32(a, BITS); }
+
+    static F bit_and(F a, F b) {
+        return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+    }
+    static F bit_xor(F a, F b) {
+        return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+    }
+    static M less(F a, F b) { return vcltq_f32(a, b); }
+    static M eq_int(I a, I b) { return vceqq_s32(a, b); }
+    static F select(M mask, F a, F b) { return vbslq_f32(mask, a, b); }
+};
+#endif
+
+// Runtime check for the x86 paths that are not part of the baseline ABI
+bool cpu_supports(KernelIsa isa) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    switch (isa) {
+        case KernelIsa::AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case KernelIsa::AVX512:
+            return __builtin_cpu_supports("avx512f");
+        default:
+            break;
+    }
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 1);
+    bool os_avx = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+    bool fma = (info[2] & (1 << 12)) != 0;
+    __cpuidex(info, 7, 0);
+    switch (isa) {
+        case KernelIsa::AVX2:
+            return os_avx && fma && (info[1] & (1 << 5));
+        case KernelIsa::AVX512:
+            return os_avx && (_xgetbv(0) & 0xE6) == 0xE6 && (info[1] & (1 << 16));
+        default:
+            break;
+    }
+#endif
+    (void)isa;
+    return false;
+}
+
+} // namespace
+
+#ifdef NERF_KERNEL_SSE2
+void evaluate_sse2(const KernelArgs& args) {
+    run_kernel<Sse2Ops>(args);
+}
+#endif
+
+#ifdef NERF_KERNEL_NEON
+void evaluate_neon(const KernelArgs& args) {
+    run_kernel<NeonOps>(args);
+}
+#endif
+
+bool kernel_isa_available(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::SCALAR:
+            return true;
+#ifdef NERF_KERNEL_SSE2
+        case KernelIsa::SSE2:
+            return true;
+#endif
+#ifdef NERF_KERNEL_NEON
+        case KernelIsa::NEON:
+            return true;
+#endif
+#ifdef NERF_KERNEL_AVX2
+        case KernelIsa::AVX2:
+            return cpu_supports(isa);
+#endif
+#ifdef NERF_KERNEL_AVX512
+        case KernelIsa::AVX512:
+            return cpu_supports(isa);
+#endif
+        default:
+            return false;
+    }
+}
+
+KernelIsa best_kernel_isa() {
+    static const KernelIsa best = [] {
+        for (KernelIsa isa : {KernelIsa::AVX512, KernelIsa::AVX2, KernelIsa::NEON, KernelIsa::SSE2}) {
+            if (kernel_isa_available(isa)) {
+                return isa;
+            }
+        }
+        return KernelIsa::SCALAR;
+    }();
+    return best;
+}
+
+const char* kernel_isa_name(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::SCALAR: return "scalar";
+        case KernelIsa::SSE2: return "sse2";
+        case KernelIsa::NEON: return "neon";
+        case KernelIsa::AVX2: return "avx2";
+        case KernelIsa::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+bool parse_kernel_isa(const std::string& name, KernelIsa& isa) {
+    for (KernelIsa candidate : {KernelIsa::SCALAR, KernelIsa::SSE2, KernelIsa::NEON,
+                                KernelIsa::AVX2, KernelIsa::AVX512}) {
+        if (name == kernel_isa_name(candidate)) {
+            isa = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void evaluate_samples(KernelIsa isa, const daf::SampleBatch& batch, int resolution,
+                      const SampleResults& results) {
+    KernelArgs args{batch.x, batch.y, batch.z, batch.density, batch.count, std::max(resolution, 1),
+                    results.alpha, results.grid_x, results.grid_y, results.grid_z};
+    if (args.count == 0) {
+        return;
+    }
+
+    if (!kernel_isa_available(isa)) {
+        isa = best_kernel_isa();
+    }
+
+    switch (isa) {
+#ifdef NERF_KERNEL_AVX512
+        case KernelIsa::AVX512:
+            evaluate_avx512(args);
+            break;
+#endif
+#ifdef NERF_KERNEL_AVX2
+        case KernelIsa::AVX2:
+            evaluate_avx2(args);
+            break;
+#endif
+#ifdef NERF_KERNEL_NEON
+        case KernelIsa::NEON:
+            evaluate_neon(args);
+            break;
+#endif
+#ifdef NERF_KERNEL_SSE2
+        case KernelIsa::SSE2:
+            evaluate_sse2(args);
+            break;
+#endif
+        default:
+            evaluate_scalar(args);
+            return;
+    }
+    clip_to_grid(args);
+}
+
+} // namespace nerf_avatar
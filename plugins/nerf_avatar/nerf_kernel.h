@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../../src/common/sample_format.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace nerf_avatar {
+
+// Batched NeRF sample kernel
+//
+// Evaluates the per-sample density model (alpha) and the voxel coordinates of
+// a whole SampleBatch at once. The scalar path is the reference; SIMD paths
+// use polynomial sin/cos/tanh/exp approximations and process 4, 8 or 16
+// samples per step. The widest path the CPU supports is picked at runtime.
+//
+// The grid spans [-1, 1) on each axis at `resolution` voxels; samples
+// outside it get OUT_OF_GRID on the axes they leave.
+constexpr int GRID_RESOLUTION = 128;
+constexpr int32_t OUT_OF_GRID = -1;
+
+enum class KernelIsa {
+    SCALAR,
+    SSE2,
+    NEON,
+    AVX2,
+    AVX512
+};
+
+// Output columns, each with room for batch.count entries
+struct SampleResults {
+    float* alpha = nullptr;
+    int32_t* grid_x = nullptr;
+    int32_t* grid_y = nullptr;
+    int32_t* grid_z = nullptr;
+};
+
+// Fastest path compiled into the plugin and supported by this CPU
+KernelIsa best_kernel_isa();
+bool kernel_isa_available(KernelIsa isa);
+
+const char* kernel_isa_name(KernelIsa isa);
+bool parse_kernel_isa(const std::string& name, KernelIsa& isa);
+
+void evaluate_samples(KernelIsa isa, const daf::SampleBatch& batch, int resolution,
+                      const SampleResults& results);
+
+} // namespace nerf_avatar
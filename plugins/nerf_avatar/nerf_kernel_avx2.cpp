@@ -0,0 +1,52 @@
+// AVX2 + FMA path, 8 samples per step. Built with -mavx2 -mfma (/arch:AVX2)
+// and only entered after a runtime CPU check.
+#include "nerf_kernel_simd.h"
+#include <immintrin.h>
+
+namespace nerf_avatar {
+
+namespace {
+
+struct Avx2Ops {
+    using F = __m256;
+    using I = __m256i;
+    using M = __m256;
+    static constexpr size_t WIDTH = 8;
+
+    static F load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, F v) { _mm256_storeu_ps(p, v); }
+    static void store_int(int32_t* p, I v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static F set(float v) { return _mm256_set1_ps(v); }
+    static I set_int(int v) { return _mm256_set1_epi32(v); }
+
+    static F add(F a, F b) { return _mm256_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+    static F div(F a, F b) { return _mm256_div_ps(a, b); }
+    static F fmadd(F a, F b, F c) { return _mm256_fmadd_ps(a, b, c); }
+    static F min(F a, F b) { return _mm256_min_ps(a, b); }
+    static F max(F a, F b) { return _mm256_max_ps(a, b); }
+    static F sqrt(F a) { return _mm256_sqrt_ps(a); }
+
+    static I round_to_int(F a) { return _mm256_cvtps_epi32(a); }
+    static I truncate(F a) { return _mm256_cvttps_epi32(a); }
+    static F to_float(I a) { return _mm256_cvtepi32_ps(a); }
+    static F as_float(I a) { return _mm256_castsi256_ps(a); }
+    static I add_int(I a, I b) { return _mm256_add_epi32(a, b); }
+    static I and_int(I a, I b) { return _mm256_and_si256(a, b); }
+    template <int BITS> static I shift_left(I a) { return _mm256_slli_epi32(a, BITS); }
+
+    static F bit_and(F a, F b) { return _mm256_and_ps(a, b); }
+    static F bit_xor(F a, F b) { return _mm256_xor_ps(a, b); }
+    static M less(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static M eq_int(I a, I b) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+    static F select(M mask, F a, F b) { return _mm256_blendv_ps(b, a, mask); }
+};
+
+} // namespace
+
+void evaluate_avx2(const KernelArgs& args) {
+    run_kernel<Avx2Ops>(args);
+}
+
+} // namespace nerf_avatar
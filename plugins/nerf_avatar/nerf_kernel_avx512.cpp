@@ -0,0 +1,57 @@
+// AVX-512F path, 16 samples per step. Built with -mavx512f (/arch:AVX512)
+// and only entered after a runtime CPU check. Float bitwise ops need DQ, so
+// they go through the integer forms.
+#include "nerf_kernel_simd.h"
+#include <immintrin.h>
+
+namespace nerf_avatar {
+
+namespace {
+
+struct Avx512Ops {
+    using F = __m512;
+    using I = __m512i;
+    using M = __mmask16;
+    static constexpr size_t WIDTH = 16;
+
+    static F load(const float* p) { return _mm512_loadu_ps(p); }
+    static void store(float* p, F v) { _mm512_storeu_ps(p, v); }
+    static void store_int(int32_t* p, I v) { _mm512_storeu_si512(p, v); }
+    static F set(float v) { return _mm512_set1_ps(v); }
+    static I set_int(int v) { return _mm512_set1_epi32(v); }
+
+    static F add(F a, F b) { return _mm512_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm512_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm512_mul_ps(a, b); }
+    static F div(F a, F b) { return _mm512_div_ps(a, b); }
+    static F fmadd(F a, F b, F c) { return _mm512_fmadd_ps(a, b, c); }
+    static F min(F a, F b) { return _mm512_min_ps(a, b); }
+    static F max(F a, F b) { return _mm512_max_ps(a, b); }
+    static F sqrt(F a) { return _mm512_sqrt_ps(a); }
+
+    static I round_to_int(F a) { return _mm512_cvtps_epi32(a); }
+    static I truncate(F a) { return _mm512_cvttps_epi32(a); }
+    static F to_float(I a) { return _mm512_cvtepi32_ps(a); }
+    static F as_float(I a) { return _mm512_castsi512_ps(a); }
+    static I add_int(I a, I b) { return _mm512_add_epi32(a, b); }
+    static I and_int(I a, I b) { return _mm512_and_si512(a, b); }
+    template <int BITS> static I shift_left(I a) { return _mm512_slli_epi32(a, BITS); }
+
+    static F bit_and(F a, F b) {
+        return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a), _mm512_castps_si512(b)));
+    }
+    static F bit_xor(F a, F b) {
+        return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), _mm512_castps_si512(b)));
+    }
+    static M less(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    static M eq_int(I a, I b) { return _mm512_cmpeq_epi32_mask(a, b); }
+    static F select(M mask, F a, F b) { return _mm512_mask_blend_ps(mask, b, a); }
+};
+
+} // namespace
+
+void evaluate_avx512(const KernelArgs& args) {
+    run_kernel<Avx512Ops>(args);
+}
+
+} // namespace nerf_avatar
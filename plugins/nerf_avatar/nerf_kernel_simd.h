@@ -0,0 +1,186 @@
+#pragma once
+
+// Width-generic body of the NeRF sample kernel. Only the kernel translation
+// units include this: each one is compiled for a different instruction set,
+// so everything here has internal linkage and sticks to plain arithmetic on
+// purpose - an inline function shared across those units could be emitted
+// with the wrong instructions.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nerf_avatar {
+
+struct KernelArgs {
+    const float* x;
+    const float* y;
+    const float* z;
+    const float* density;
+    size_t count;
+    int resolution;
+    float* alpha;
+    int32_t* grid_x;
+    int32_t* grid_y;
+    int32_t* grid_z;
+};
+
+// Per instruction set entry points, defined by the kernel translation units
+void evaluate_sse2(const KernelArgs& args);
+void evaluate_neon(const KernelArgs& args);
+void evaluate_avx2(const KernelArgs& args);
+void evaluate_avx512(const KernelArgs& args);
+
+namespace {
+
+// V supplies the vector types F (float), I (int32) and M (lane mask), a
+// WIDTH, and the primitive operations used below. fmadd(a, b, c) is a*b+c;
+// min(a, b) and max(a, b)
+// must return b when a is NaN, as the SSE/AVX instructions do.
+
+// sin for quadrant_offset 0, cos for 1. Cody-Waite reduction by pi/2 and the
+// Cephes minimax polynomials on [-pi/4, pi/4]; about 2 ulp for |x| < 8192.
+template <class V>
+typename V::F sin_cos(typename V::F x, int quadrant_offset) {
+    using F = typename V::F;
+    using I = typename V::I;
+
+    I quadrant = V::round_to_int(V::mul(x, V::set(0.636619772f)));
+    F q = V::to_float(quadrant);
+    F r = V::fmadd(q, V::set(-1.5703125f), x);
+    r = V::fmadd(q, V::set(-4.837512969970703125e-4f), r);
+    r = V::fmadd(q, V::set(-7.54978995489188216e-8f), r);
+    quadrant = V::add_int(quadrant, V::set_int(quadrant_offset));
+
+    F r2 = V::mul(r, r);
+    F s = V::fmadd(V::set(-1.9515295891e-4f), r2, V::set(8.3321608736e-3f));
+    s = V::fmadd(s, r2, V::set(-1.6666654611e-1f));
+    s = V::fmadd(V::mul(s, r2), r, r);
+
+    F c = V::fmadd(V::set(2.443315711809948e-5f), r2, V::set(-1.388731625493765e-3f));
+    c = V::fmadd(c, r2, V::set(4.166664568298827e-2f));
+    c = V::fmadd(V::mul(c, r2), r2, V::fmadd(r2, V::set(-0.5f), V::set(1.0f)));
+
+    // Odd quadrants use the cosine polynomial, quadrants 2 and 3 flip the sign
+    I one = V::set_int(1);
+    F result = V::select(V::eq_int(V::and_int(quadrant, one), one), c, s);
+    F sign = V::as_float(V::template shift_left<30>(V::and_int(quadrant, V::set_int(2))));
+    return V::bit_xor(result, sign);
+}
+
+// Cephes expf: n = round(x / ln2), exp(x) = 2^n * p(x - n ln2). Inputs are
+// clamped so 2^n stays a normal float.
+template <class V>
+typename V::F exp_approx(typename V::F x) {
+    using F = typename V::F;
+    using I = typename V::I;
+
+    x = V::min(V::set(88.0f), V::max(V::set(-87.0f), x));
+
+    I n = V::round_to_int(V::mul(x, V::set(1.44269504088896341f)));
+    F nf = V::to_float(n);
+    F r = V::fmadd(nf, V::set(-0.693359375f), x);
+    r = V::fmadd(nf, V::set(2.12194440e-4f), r);
+
+    F p = V::fmadd(V::set(1.9875691500e-4f), r, V::set(1.3981999507e-3f));
+    p = V::fmadd(p, r, V::set(8.3334519073e-3f));
+    p = V::fmadd(p, r, V::set(4.1665795894e-2f));
+    p = V::fmadd(p, r, V::set(1.6666665459e-1f));
+    p = V::fmadd(p, r, V::set(5.0000001201e-1f));
+    p = V::fmadd(p, V::mul(r, r), V::add(r, V::set(1.0f)));
+
+    F scale = V::as_float(V::template shift_left<23>(V::add_int(n, V::set_int(127))));
+    return V::mul(p, scale);
+}
+
+// Cephes tanhf: odd polynomial below 0.625, 1 - 2 / (exp(2|x|) + 1) above
+template <class V>
+typename V::F tanh_approx(typename V::F x) {
+    using F = typename V::F;
+
+    F sign = V::bit_and(x, V::set(-0.0f));
+    F ax = V::bit_xor(x, sign);
+
+    F z = V::mul(x, x);
+    F p = V::fmadd(V::set(-5.70498872745e-3f), z, V::set(2.06390887954e-2f));
+    p = V::fmadd(p, z, V::set(-5.37397155531e-2f));
+    p = V::fmadd(p, z, V::set(1.33314422036e-1f));
+    p = V::fmadd(p, z, V::set(-3.33332819422e-1f));
+    F small = V::fmadd(V::mul(p, z), x, x);
+
+    F e = exp_approx<V>(V::add(ax, ax));
+    F large = V::sub(V::set(1.0f), V::div(V::set(2.0f), V::add(e, V::set(1.0f))));
+    large = V::bit_xor(large, sign);
+
+    return V::select(V::less(ax, V::set(0.625f)), small, large);
+}
+
+// Same model as the scalar reference in nerf_kernel.cpp
+template <class V>
+void evaluate_block(const float* xs, const float* ys, const float* zs, const float* densities,
+                    int resolution, float* alphas, int32_t* grid_x, int32_t* grid_y, int32_t* grid_z) {
+    using F = typename V::F;
+
+    F x = V::load(xs);
+    F y = V::load(ys);
+    F z = V::load(zs);
+    F density = V::load(densities);
+
+    // Summed in the scalar order: the sin/cos arguments are large multiples
+    // of the distance, so one ulp here shows up in alpha
+    F distance = V::sqrt(V::add(V::add(V::mul(x, x), V::mul(y, y)), V::mul(z, z)));
+
+    F pos_encoding = V::fmadd(sin_cos<V>(V::mul(distance, V::set(15.0f)), 0), V::set(0.5f), V::set(0.5f));
+    F base_density = V::mul(density, tanh_approx<V>(V::mul(distance, V::set(0.2f))));
+    F view_dependency = V::fmadd(sin_cos<V>(V::mul(distance, V::set(8.0f)), 1), V::set(0.3f), V::set(0.7f));
+
+    F alpha = V::mul(V::mul(base_density, view_dependency), pos_encoding);
+    alpha = V::sub(V::set(1.0f), exp_approx<V>(V::mul(alpha, V::set(-2.0f))));
+    alpha = V::min(V::max(alpha, V::set(0.0f)), V::set(1.0f));
+    V::store(alphas, alpha);
+
+    F half = V::set(0.5f);
+    F one = V::set(1.0f);
+    F scale = V::set(static_cast<float>(resolution));
+    V::store_int(grid_x, V::truncate(V::mul(V::mul(V::add(x, one), half), scale)));
+    V::store_int(grid_y, V::truncate(V::mul(V::mul(V::add(y, one), half), scale)));
+    V::store_int(grid_z, V::truncate(V::mul(V::mul(V::add(z, one), half), scale)));
+}
+
+template <class V>
+void run_kernel(const KernelArgs& args) {
+    constexpr size_t WIDTH = V::WIDTH;
+
+    size_t i = 0;
+    for (; i + WIDTH <= args.count; i += WIDTH) {
+        evaluate_block<V>(args.x + i, args.y + i, args.z + i, args.density + i, args.resolution,
+                          args.alpha + i, args.grid_x + i, args.grid_y + i, args.grid_z + i);
+    }
+
+    // Pad the tail to a full vector so every sample takes the same path
+    // wherever it falls in the batch
+    if (i < args.count) {
+        size_t tail = args.count - i;
+        float x[WIDTH] = {}, y[WIDTH] = {}, z[WIDTH] = {}, density[WIDTH] = {};
+        float alpha[WIDTH];
+        int32_t grid_x[WIDTH], grid_y[WIDTH], grid_z[WIDTH];
+        for (size_t k = 0; k < tail; ++k) {
+            x[k] = args.x[i + k];
+            y[k] = args.y[i + k];
+            z[k] = args.z[i + k];
+            density[k] = args.density[i + k];
+        }
+
+        evaluate_block<V>(x, y, z, density, args.resolution, alpha, grid_x, grid_y, grid_z);
+
+        for (size_t k = 0; k < tail; ++k) {
+            args.alpha[i + k] = alpha[k];
+            args.grid_x[i + k] = grid_x[k];
+            args.grid_y[i + k] = grid_y[k];
+            args.grid_z[i + k] = grid_z[k];
+        }
+    }
+}
+
+} // namespace
+
+} // namespace nerf_avatar
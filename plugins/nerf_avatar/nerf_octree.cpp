@@ -0,0 +1,338 @@
+#include "nerf_octree.h"
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <fstream>
+
+#ifdef min
+#undef min
+#endif
+#ifdef max
+#undef max
+#endif
+
+namespace nerf_avatar {
+
+namespace {
+
+// What the tree is built over: the voxels of a brick, or the bricks when
+// the levels above them are built. Sorted by Morton code.
+struct Entry {
+    uint64_t code;
+    uint64_t count;
+    double total_r, total_g, total_b, total_alpha;
+};
+
+Entry node_totals(const OctreeNode& node, uint64_t code) {
+    double total_alpha = static_cast<double>(node.alpha) * static_cast<double>(node.count);
+    return Entry{code, node.count, node.r * total_alpha, node.g * total_alpha, node.b * total_alpha, total_alpha};
+}
+
+Entry sum_entries(const Entry* begin, const Entry* end) {
+    Entry sum{0, 0, 0.0, 0.0, 0.0, 0.0};
+    for (const Entry* entry = begin; entry != end; ++entry) {
+        sum.count += entry->count;
+        sum.total_r += entry->total_r;
+        sum.total_g += entry->total_g;
+        sum.total_b += entry->total_b;
+        sum.total_alpha += entry->total_alpha;
+    }
+    return sum;
+}
+
+float clamp_unit(double value) {
+    return static_cast<float>(std::min(1.0, std::max(0.0, value)));
+}
+
+// Same averages as the flat voxel output of ReduceMain
+OctreeNode make_node(const Entry& totals, uint8_t level) {
+    OctreeNode node{};
+    node.count = totals.count;
+    node.level = level;
+    if (totals.total_alpha > 0.0) {
+        node.r = clamp_unit(totals.total_r / totals.total_alpha);
+        node.g = clamp_unit(totals.total_g / totals.total_alpha);
+        node.b = clamp_unit(totals.total_b / totals.total_alpha);
+    }
+    if (totals.count > 0) {
+        node.alpha = clamp_unit(totals.total_alpha / static_cast<double>(totals.count));
+    }
+    return node;
+}
+
+// Splits nodes[index], which covers entries [begin, end) agreeing on every
+// code bit above `bits`, into its occupied octants and recurses. A node
+// under refine_samples samples stays a leaf; nodes of single entries
+// (bits == 0) are appended to leaves, in code order.
+void split_node(std::vector<OctreeNode>& nodes, size_t index, const Entry* begin, const Entry* end,
+                uint32_t bits, uint64_t refine_samples, std::vector<size_t>* leaves) {
+    if (bits == 0) {
+        if (leaves) {
+            leaves->push_back(index);
+        }
+        return;
+    }
+    if (nodes[index].count < refine_samples) {
+        return;
+    }
+    bits -= 3;
+
+    const Entry* octant_begin[8];
+    const Entry* octant_end[8];
+    size_t children = 0;
+    uint8_t mask = 0;
+    for (const Entry* entry = begin; entry != end; ) {
+        uint32_t octant = static_cast<uint32_t>((entry->code >> bits) & 7);
+        const Entry* next = entry;
+        while (next != end && ((next->code >> bits) & 7) == octant) {
+            ++next;
+        }
+        octant_begin[children] = entry;
+        octant_end[children] = next;
+        children++;
+        mask |= static_cast<uint8_t>(1u << octant);
+        entry = next;
+    }
+
+    size_t first_child = nodes.size();
+    uint8_t level = static_cast<uint8_t>(nodes[index].level + 1);
+    nodes[index].first_child = static_cast<uint32_t>(first_child);
+    nodes[index].child_mask = mask;
+    for (size_t i = 0; i < children; ++i) {
+        nodes.push_back(make_node(sum_entries(octant_begin[i], octant_end[i]), level));
+    }
+    for (size_t i = 0; i < children; ++i) {
+        split_node(nodes, first_child + i, octant_begin[i], octant_end[i], bits, refine_samples, leaves);
+    }
+}
+
+// Child indices all point inside the brick's own nodes
+bool valid_subtree(const std::vector<OctreeNode>& nodes) {
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const OctreeNode& node = nodes[i];
+        if (node.child_mask == 0) {
+            continue;
+        }
+        size_t children = std::bitset<8>(node.child_mask).count();
+        if (node.first_child <= i || node.first_child + children > nodes.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct PartBrick {
+    uint64_t key;
+    std::vector<OctreeNode> nodes;
+};
+
+// Brick records of one reduce output: a uint32 length before every record
+bool read_part(const std::string& path, uint32_t& grid_bits, std::vector<PartBrick>& bricks, std::string& error) {
+    daf::MappedFile part;
+    if (!part.open(path)) {
+        error = "Cannot open " + path;
+        return false;
+    }
+
+    size_t offset = 0;
+    while (offset < part.size()) {
+        uint32_t length = 0;
+        OctreeBrickRecord record{};
+        if (part.size() - offset < sizeof(length)) {
+            error = path + ": truncated record";
+            return false;
+        }
+        std::memcpy(&length, part.data() + offset, sizeof(length));
+        offset += sizeof(length);
+        if (length < sizeof(record) || part.size() - offset < length) {
+            error = path + ": truncated or compressed record";
+            return false;
+        }
+        std::memcpy(&record, part.data() + offset, sizeof(record));
+        if (record.node_count == 0 ||
+            length != sizeof(record) + static_cast<size_t>(record.node_count) * sizeof(OctreeNode)) {
+            error = path + ": not an octree brick record";
+            return false;
+        }
+        if (grid_bits == 0) {
+            grid_bits = record.grid_bits;
+        }
+        if (record.grid_bits != grid_bits || grid_bits < BRICK_AXIS_BITS || grid_bits > OCTREE_MAX_GRID_BITS) {
+            error = path + ": bricks of different grid resolutions";
+            return false;
+        }
+
+        PartBrick brick;
+        brick.key = record.key;
+        brick.nodes.resize(record.node_count);
+        std::memcpy(brick.nodes.data(), part.data() + offset + sizeof(record), length - sizeof(record));
+        if (!valid_subtree(brick.nodes)) {
+            error = path + ": corrupt brick " + std::to_string(record.key);
+            return false;
+        }
+        bricks.push_back(std::move(brick));
+        offset += length;
+    }
+    return true;
+}
+
+} // namespace
+
+void build_brick_subtree(const std::vector<BrickVoxel>& voxels, uint32_t grid_bits,
+                         uint32_t refine_samples, std::vector<OctreeNode>& nodes) {
+    std::vector<Entry> entries;
+    entries.reserve(voxels.size());
+    for (const auto& voxel : voxels) {
+        entries.push_back(Entry{voxel.voxel, voxel.partial.count, voxel.partial.total_r, voxel.partial.total_g,
+                                voxel.partial.total_b, voxel.partial.total_alpha});
+    }
+
+    const Entry* begin = entries.data();
+    const Entry* end = entries.data() + entries.size();
+    nodes.clear();
+    nodes.push_back(make_node(sum_entries(begin, end), static_cast<uint8_t>(grid_bits - BRICK_AXIS_BITS)));
+    split_node(nodes, 0, begin, end, 3 * BRICK_AXIS_BITS, refine_samples, nullptr);
+}
+
+bool pack_octree(const std::vector<std::string>& part_files, const std::string& path, std::string& error) {
+    uint32_t grid_bits = 0;
+    std::vector<PartBrick> bricks;
+    for (const auto& part : part_files) {
+        if (!read_part(part, grid_bits, bricks, error)) {
+            return false;
+        }
+    }
+    std::sort(bricks.begin(), bricks.end(), [](const PartBrick& a, const PartBrick& b) { return a.key < b.key; });
+    for (size_t i = 1; i < bricks.size(); ++i) {
+        if (bricks[i].key == bricks[i - 1].key) {
+            error = "Brick " + std::to_string(bricks[i].key) + " is in more than one part";
+            return false;
+        }
+    }
+
+    // Levels above the bricks, split all the way down so every brick gets
+    // a node, which then becomes the brick's subtree root
+    std::vector<OctreeNode> nodes;
+    std::vector<OctreeBrick> table;
+    if (!bricks.empty()) {
+        std::vector<Entry> entries;
+        entries.reserve(bricks.size());
+        for (const auto& brick : bricks) {
+            entries.push_back(node_totals(brick.nodes[0], brick.key));
+        }
+        const Entry* begin = entries.data();
+        const Entry* end = entries.data() + entries.size();
+        nodes.push_back(make_node(sum_entries(begin, end), 0));
+        std::vector<size_t> leaves;
+        split_node(nodes, 0, begin, end, 3 * (grid_bits - BRICK_AXIS_BITS), 0, &leaves);
+
+        for (size_t i = 0; i < bricks.size(); ++i) {
+            // Brick nodes after the root move to the end of the file's nodes
+            const auto& brick_nodes = bricks[i].nodes;
+            uint32_t base = static_cast<uint32_t>(nodes.size()) - 1;
+            for (size_t j = 0; j < brick_nodes.size(); ++j) {
+                OctreeNode node = brick_nodes[j];
+                if (node.child_mask != 0) {
+                    node.first_child += base;
+                }
+                if (j == 0) {
+                    nodes[leaves[i]] = node;
+                } else {
+                    nodes.push_back(node);
+                }
+            }
+            table.push_back(OctreeBrick{bricks[i].key, static_cast<uint32_t>(leaves[i]),
+                                        static_cast<uint32_t>(brick_nodes.size())});
+        }
+    }
+
+    OctreeFileHeader header{};
+    std::memcpy(header.magic, OCTREE_MAGIC, sizeof(header.magic));
+    header.version = OCTREE_VERSION;
+    header.grid_bits = grid_bits;
+    header.brick_count = table.size();
+    header.node_count = nodes.size();
+    header.bricks_offset = sizeof(header);
+    header.nodes_offset = header.bricks_offset + table.size() * sizeof(OctreeBrick);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        error = "Cannot create " + path;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(OctreeBrick)));
+    out.write(reinterpret_cast<const char*>(nodes.data()), static_cast<std::streamsize>(nodes.size() * sizeof(OctreeNode)));
+    out.close();
+    if (out.fail()) {
+        error = "Failed to write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool OctreeFile::open(const std::string& path, std::string& error) {
+    if (!file_.open(path, daf::MappedFile::Access::RANDOM)) {
+        error = "Cannot open " + path;
+        return false;
+    }
+
+    const OctreeFileHeader* header = reinterpret_cast<const OctreeFileHeader*>(file_.data());
+    uint64_t size = file_.size();
+    bool valid = size >= sizeof(OctreeFileHeader) &&
+                 std::memcmp(header->magic, OCTREE_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->version == OCTREE_VERSION &&
+                 header->bricks_offset % alignof(OctreeBrick) == 0 &&
+                 header->nodes_offset % alignof(OctreeNode) == 0 &&
+                 header->bricks_offset <= size && header->nodes_offset <= size &&
+                 header->brick_count <= (size - header->bricks_offset) / sizeof(OctreeBrick) &&
+                 header->node_count <= (size - header->nodes_offset) / sizeof(OctreeNode) &&
+                 (header->node_count == 0 ||
+                  (header->grid_bits >= BRICK_AXIS_BITS && header->grid_bits <= OCTREE_MAX_GRID_BITS));
+    if (!valid) {
+        file_.close();
+        error = path + " is not a version " + std::to_string(OCTREE_VERSION) + " octree file";
+        return false;
+    }
+    return true;
+}
+
+const OctreeNode* OctreeFile::nodes() const {
+    return reinterpret_cast<const OctreeNode*>(file_.data() + header().nodes_offset);
+}
+
+const OctreeBrick* OctreeFile::bricks() const {
+    return reinterpret_cast<const OctreeBrick*>(file_.data() + header().bricks_offset);
+}
+
+const OctreeBrick* OctreeFile::find_brick(uint64_t key) const {
+    const OctreeBrick* begin = bricks();
+    const OctreeBrick* end = begin + brick_count();
+    const OctreeBrick* brick = std::lower_bound(begin, end, key,
+        [](const OctreeBrick& entry, uint64_t value) { return entry.key < value; });
+    return brick != end && brick->key == key ? brick : nullptr;
+}
+
+const OctreeNode* OctreeFile::lookup(uint32_t x, uint32_t y, uint32_t z) const {
+    uint32_t grid_bits = header().grid_bits;
+    if (node_count() == 0 || x >= resolution() || y >= resolution() || z >= resolution()) {
+        return nullptr;
+    }
+
+    const OctreeNode* node = nodes();
+    for (uint32_t level = 0; level < grid_bits && node->child_mask != 0; ++level) {
+        uint32_t shift = grid_bits - level - 1;
+        uint32_t octant = ((x >> shift) & 1) | (((y >> shift) & 1) << 1) | (((z >> shift) & 1) << 2);
+        if ((node->child_mask & (1u << octant)) == 0) {
+            return nullptr;
+        }
+        size_t child = node->first_child + std::bitset<8>(node->child_mask & ((1u << octant) - 1)).count();
+        if (child >= node_count()) {
+            return nullptr;
+        }
+        node = nodes() + child;
+    }
+    return node;
+}
+
+} // namespace nerf_avatar
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "../../src/common/mapped_file.h"
+#include "nerf_voxel.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace nerf_avatar {
+
+// Sparse voxel octree (output_format=octree)
+//
+// Reducers turn every brick into an adaptive subtree: a node is split into
+// its occupied octants only while it holds at least refine_samples
+// samples, so sparse regions end in coarse leaves and dense ones go down
+// to single voxels. Their part files hold one brick record per brick
+// (OctreeBrickRecord followed by its nodes); pack_octree() sorts the
+// bricks of all parts, builds the levels above them and writes one file
+// that is used straight from a memory mapping:
+//
+//   OctreeFileHeader | OctreeBrick[brick_count] | OctreeNode[node_count]
+//
+// Node 0 is the root covering the whole grid. The children of a node are
+// stored together in octant order (octant bits x | y << 1 | z << 2, as in
+// the Morton codes), so child k is at first_child plus the number of
+// child_mask bits set below bit k.
+constexpr char OCTREE_MAGIC[8] = {'D', 'A', 'F', 'O', 'C', 'T', 'R', 'E'};
+constexpr uint32_t OCTREE_VERSION = 1;
+constexpr uint32_t OCTREE_REFINE_SAMPLES = 8;
+constexpr uint32_t OCTREE_MAX_GRID_BITS = 20;   // Coordinates stay in the 21-bit Morton range
+
+struct OctreeNode {
+    uint64_t count;          // Samples under the node
+    uint32_t first_child;    // 0 for a leaf
+    uint8_t child_mask;
+    uint8_t level;           // 0 at the root; a node spans resolution >> level voxels
+    uint16_t reserved;
+    float r, g, b;           // Alpha-weighted mean colour
+    float alpha;             // Mean alpha
+};
+
+// Reduce output record of one brick, followed by node_count nodes with the
+// brick's root first and first_child relative to it
+struct OctreeBrickRecord {
+    uint64_t key;            // Brick Morton code
+    uint32_t grid_bits;      // log2 of the grid resolution
+    uint32_t node_count;
+};
+
+struct OctreeFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t grid_bits;
+    uint64_t brick_count;
+    uint64_t node_count;
+    uint64_t bricks_offset;
+    uint64_t nodes_offset;
+};
+
+// Brick table entry, sorted by key for direct lookups
+struct OctreeBrick {
+    uint64_t key;
+    uint32_t root;           // Node of the brick's subtree root
+    uint32_t node_count;
+};
+
+static_assert(sizeof(OctreeNode) == 32, "OctreeNode is part of the octree file format");
+static_assert(sizeof(OctreeBrickRecord) == 16, "OctreeBrickRecord is part of the output format");
+static_assert(sizeof(OctreeFileHeader) == 48, "OctreeFileHeader is part of the octree file format");
+static_assert(sizeof(OctreeBrick) == 16, "OctreeBrick is part of the octree file format");
+static_assert(std::is_trivially_copyable<OctreeNode>::value &&
+              std::is_trivially_copyable<OctreeBrickRecord>::value &&
+              std::is_trivially_copyable<OctreeFileHeader>::value &&
+              std::is_trivially_copyable<OctreeBrick>::value, "octree records must be PODs");
+
+// Subtree of one brick from its occupied voxels, sorted by voxel. Replaces
+// nodes; the root is nodes[0] and first_child indices are into nodes.
+void build_brick_subtree(const std::vector<BrickVoxel>& voxels, uint32_t grid_bits,
+                         uint32_t refine_samples, std::vector<OctreeNode>& nodes);
+
+// Builds the octree file from the (uncompressed) reduce outputs of a job
+bool pack_octree(const std::vector<std::string>& part_files, const std::string& path, std::string& error);
+
+// Memory-mapped octree file; nothing is copied or parsed on open beyond
+// checking that the tables fit the file
+class OctreeFile {
+public:
+    bool open(const std::string& path, std::string& error);
+
+    const OctreeFileHeader& header() const { return *reinterpret_cast<const OctreeFileHeader*>(file_.data()); }
+    uint32_t resolution() const { return 1u << header().grid_bits; }
+
+    const OctreeNode* nodes() const;
+    size_t node_count() const { return static_cast<size_t>(header().node_count); }
+    const OctreeBrick* bricks() const;
+    size_t brick_count() const { return static_cast<size_t>(header().brick_count); }
+
+    const OctreeBrick* find_brick(uint64_t key) const;
+
+    // Deepest node containing voxel (x, y, z); nullptr in empty space
+    const OctreeNode* lookup(uint32_t x, uint32_t y, uint32_t z) const;
+
+private:
+    daf::MappedFile file_;
+};
+
+} // namespace nerf_avatar
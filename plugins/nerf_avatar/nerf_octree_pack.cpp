@@ -0,0 +1,28 @@
+// Packs the reduce outputs of an output_format=octree job into one octree
+// file for renderers:
+//   nerf_octree_pack <output.oct> <part-0> [<part-1> ...]
+#include "nerf_octree.h"
+#include <iostream>
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <output.oct> <part-file>..." << std::endl;
+        return 2;
+    }
+
+    std::vector<std::string> parts(argv + 2, argv + argc);
+    std::string error;
+    if (!nerf_avatar::pack_octree(parts, argv[1], error)) {
+        std::cerr << "[ERROR] " << error << std::endl;
+        return 1;
+    }
+
+    nerf_avatar::OctreeFile octree;
+    if (!octree.open(argv[1], error)) {
+        std::cerr << "[ERROR] " << error << std::endl;
+        return 1;
+    }
+    std::cout << "[INFO] Wrote " << argv[1] << ": " << octree.brick_count() << " bricks, "
+              << octree.node_count() << " nodes, grid " << octree.resolution() << "^3" << std::endl;
+    return 0;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+namespace nerf_avatar {
+
+// Binary shuffle records
+//
+// With binary keys (the default) map tasks emit each sample under the Morton
+// code of its voxel, and values are the PODs below. Reducers tell the value
+// kinds apart by size, so these layouts are part of the job's wire format.
+
+constexpr uint32_t MORTON_AXIS_BITS = 21;
+
+namespace detail {
+
+// Spreads the low 21 bits of v so they land on every third bit
+inline uint64_t spread_bits(uint32_t v) {
+    uint64_t x = v & 0x1FFFFF;
+    x = (x | (x << 32)) & 0x1F00000000FFFFULL;
+    x = (x | (x << 16)) & 0x1F0000FF0000FFULL;
+    x = (x | (x << 8)) & 0x100F00F00F00F00FULL;
+    x = (x | (x << 4)) & 0x10C30C30C30C30C3ULL;
+    x = (x | (x << 2)) & 0x1249249249249249ULL;
+    return x;
+}
+
+inline uint32_t compact_bits(uint64_t x) {
+    x &= 0x1249249249249249ULL;
+    x = (x | (x >> 2)) & 0x10C30C30C30C30C3ULL;
+    x = (x | (x >> 4)) & 0x100F00F00F00F00FULL;
+    x = (x | (x >> 8)) & 0x1F0000FF0000FFULL;
+    x = (x | (x >> 16)) & 0x1F00000000FFFFULL;
+    x = (x | (x >> 32)) & 0x1FFFFF;
+    return static_cast<uint32_t>(x);
+}
+
+// Two's complement, 21 bits
+inline int32_t sign_extend(uint32_t v) {
+    return static_cast<int32_t>(v << (32 - MORTON_AXIS_BITS)) >> (32 - MORTON_AXIS_BITS);
+}
+
+} // namespace detail
+
+// Z-order voxel id; coordinates are 21-bit two's complement so negative
+// grid indices survive the round trip
+inline uint64_t morton_encode(int32_t x, int32_t y, int32_t z) {
+    return detail::spread_bits(static_cast<uint32_t>(x)) |
+           (detail::spread_bits(static_cast<uint32_t>(y)) << 1) |
+           (detail::spread_bits(static_cast<uint32_t>(z)) << 2);
+}
+
+inline void morton_decode(uint64_t code, int32_t& x, int32_t& y, int32_t& z) {
+    x = detail::sign_extend(detail::compact_bits(code));
+    y = detail::sign_extend(detail::compact_bits(code >> 1));
+    z = detail::sign_extend(detail::compact_bits(code >> 2));
+}
+
+// One evaluated sample, map -> reduce
+struct VoxelSample {
+    float x, y, z;
+    float r, g, b;
+    float alpha;
+};
+
+// Combiner partial aggregate for one voxel
+struct VoxelPartial {
+    uint64_t count;
+    float total_r, total_g, total_b, total_alpha;
+    float min_x, max_x;
+    float min_y, max_y;
+    float min_z, max_z;
+};
+
+// Brick map records (output_format=octree)
+//
+// Voxels are grouped into bricks of 8^3; a brick's key is its voxel Morton
+// codes without the low 9 bits, so empty space has no keys at all and a
+// voxel's index within its brick is its local Morton code. Map tasks emit
+// BrickSamples under the brick key, the combiner folds them into one
+// array of BrickVoxels per brick, and reducers build the brick's subtree.
+constexpr uint32_t BRICK_AXIS_BITS = 3;
+constexpr uint32_t BRICK_VOXELS = 1u << (3 * BRICK_AXIS_BITS);
+
+inline uint64_t brick_key(uint64_t voxel_code) { return voxel_code >> (3 * BRICK_AXIS_BITS); }
+inline uint32_t brick_voxel(uint64_t voxel_code) { return static_cast<uint32_t>(voxel_code & (BRICK_VOXELS - 1)); }
+
+struct BrickSample {
+    VoxelSample sample;
+    uint32_t voxel;   // Local Morton code within the brick
+};
+
+// Combiner partial aggregate of one occupied voxel of a brick; a brick
+// partial is an array of these sorted by voxel
+struct BrickVoxel {
+    VoxelPartial partial;
+    uint32_t voxel;
+    uint32_t reserved;
+};
+
+// Binary reduce output (output_format=binary)
+struct VoxelRecord {
+    uint64_t key;
+    uint64_t count;
+    float center_x, center_y, center_z;
+    float r, g, b;
+    float alpha;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(VoxelSample) == 28, "VoxelSample is part of the shuffle format");
+static_assert(sizeof(VoxelPartial) == 48, "VoxelPartial is part of the shuffle format");
+static_assert(sizeof(VoxelRecord) == 48, "VoxelRecord is part of the output format");
+static_assert(sizeof(BrickSample) == 32, "BrickSample is part of the shuffle format");
+static_assert(sizeof(BrickVoxel) == 56, "BrickVoxel is part of the shuffle format");
+static_assert(std::is_trivially_copyable<VoxelSample>::value &&
+              std::is_trivially_copyable<VoxelPartial>::value &&
+              std::is_trivially_copyable<VoxelRecord>::value &&
+              std::is_trivially_copyable<BrickSample>::value &&
+              std::is_trivially_copyable<BrickVoxel>::value, "shuffle records must be PODs");
+
+} // namespace nerf_avatar